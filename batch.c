@@ -0,0 +1,431 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Static geometry batches
+ *
+ *  Geometry that never moves is baked once into one shared set of
+ *  vertex arrays and one index array, each object placed by its
+ *  own transform on the way in so none is needed when drawing.
+ *  Every object becomes a draw record, a range of triangle
+ *  indices and the material class it is drawn with.  A frame
+ *  queues the records it wants and submits a class at a time,
+ *  binding the material once and drawing every queued range in a
+ *  single glMultiDrawElements call, with neighbouring ranges
+ *  merged first.  Where multi-draw is missing the ranges are drawn
+ *  one glDrawElements at a time from the same arrays.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+    #include <GL/glx.h>
+#endif
+
+// GL call counters when built with COUNTERS=1
+#include "glCounters.h"
+
+// single precision matrix stack
+#include "matrix.h"
+
+// prototypes and definitions
+#include "batch.h"
+
+// multi-draw for the current context, NULL to draw range by range
+#ifndef __APPLE__
+PFNGLMULTIDRAWELEMENTSPROC batchMultiDrawElements = NULL;
+#endif
+
+#if !defined(__APPLE__) && !defined(CAPTURE_GL)
+// test for at least OpenGL major.minor
+static bool batchVersion(int major, int minor)
+{
+    int maj = 0, min = 0;
+    const char *version = (const char*)glGetString(GL_VERSION);
+
+    if ((version == NULL) || (sscanf(version, "%d.%d", &maj, &min) != 2))
+        return false;
+
+    return (maj > major) || ((maj == major) && (min >= minor));
+}
+#endif
+
+// find multi-draw for the current context
+// must be called again whenever the context is recreated
+void batchInit()
+{
+#if !defined(__APPLE__) && !defined(CAPTURE_GL)
+    // captures leave it out, each range then goes through the
+    // wrapped glDrawElements and is written to the trace
+    batchMultiDrawElements = NULL;
+    if (batchVersion(1, 4))
+        batchMultiDrawElements = (PFNGLMULTIDRAWELEMENTSPROC)
+            glXGetProcAddressARB((const GLubyte*)"glMultiDrawElements");
+    else if (glutExtensionSupported("GL_EXT_multi_draw_arrays"))
+        batchMultiDrawElements = (PFNGLMULTIDRAWELEMENTSPROC)
+            glXGetProcAddressARB((const GLubyte*)"glMultiDrawElementsEXT");
+#endif
+}
+
+// start an empty batch
+void batchCreate(batch *b, int flags)
+{
+    memset(b, 0, sizeof(batch));
+    b->flags = flags;
+    matIdentity(&b->place);
+}
+
+// release a batch's arrays
+void batchFree(batch *b)
+{
+    int i;
+
+    free(b->pos);
+    free(b->normals);
+    free(b->tex);
+    free(b->colors);
+    free(b->indices);
+    free(b->draws);
+    for (i = 0; i < BATCH_MAX_CLASSES; ++i) {
+        free(b->counts[i]);
+        free(b->offsets[i]);
+    }
+    batchCreate(b, b->flags);
+}
+
+// make room for n more of something, doubling as it goes
+static void *batchGrow(batch *b, void *p, int used, int n, int *max, size_t size)
+{
+    void *grown;
+    int   want = *max;
+
+    if (used+n <= *max)
+        return p;
+
+    while (want < used+n)
+        want = (want > 0) ? want*2 : 1024;
+
+    grown = realloc(p, want*size);
+    // keep what was there, the batch is given up on
+    if (grown == NULL) {
+        b->failed = true;
+        return p;
+    }
+
+    *max = want;
+    return grown;
+}
+
+// start an object placed by m, identity when NULL
+void batchBegin(batch *b, int cls, const matrix *m)
+{
+    if (m != NULL)
+        b->place = *m;
+    else
+        matIdentity(&b->place);
+
+    b->cls   = cls;
+    b->first = b->numIndices;
+    memset(b->color, 255, sizeof(b->color));
+}
+
+// color of the object's vertices
+void batchColor(batch *b, GLfloat r, GLfloat g, GLfloat bl, GLfloat a)
+{
+    b->color[0] = (GLubyte)(r*255.0f + 0.5f);
+    b->color[1] = (GLubyte)(g*255.0f + 0.5f);
+    b->color[2] = (GLubyte)(bl*255.0f + 0.5f);
+    b->color[3] = (GLubyte)(a*255.0f + 0.5f);
+}
+
+// add a vertex in object space, returns its index
+int batchVertex(batch *b, const GLfloat *pos, const GLfloat *normal, const GLfloat *tex)
+{
+    const float *m = b->place.m;
+    float p[4], n[3], len;
+    int max, i, v = b->numVerts;
+
+    if (b->failed)
+        return 0;
+
+    // every array grows together
+    if (v == b->maxVerts) {
+        max = b->maxVerts;
+        b->pos = batchGrow(b, b->pos, v, 1, &max, 3*sizeof(GLfloat));
+        max = b->maxVerts;
+        b->normals = batchGrow(b, b->normals, v, 1, &max, 4*sizeof(GLbyte));
+        if (b->flags & BATCH_TEXCOORDS) {
+            max = b->maxVerts;
+            b->tex = batchGrow(b, b->tex, v, 1, &max, 2*sizeof(GLfloat));
+        }
+        if (b->flags & BATCH_COLORS) {
+            max = b->maxVerts;
+            b->colors = batchGrow(b, b->colors, v, 1, &max, 4*sizeof(GLubyte));
+        }
+        if (b->failed)
+            return 0;
+        b->maxVerts = max;
+    }
+
+    matTransformPoint(&b->place, pos, p);
+    memcpy(b->pos + 3*v, p, 3*sizeof(GLfloat));
+
+    // placements only turn and move, so the normal needs no inverse
+    for (i = 0; i < 3; ++i)
+        n[i] = m[0*4+i]*normal[0] + m[1*4+i]*normal[1] + m[2*4+i]*normal[2];
+    len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if (len > 0.0f)
+        len = 127.0f / len;
+    for (i = 0; i < 3; ++i)
+        b->normals[4*v+i] = (GLbyte)lrintf(n[i]*len);
+    b->normals[4*v+3] = 0;
+
+    if (b->flags & BATCH_TEXCOORDS) {
+        b->tex[2*v+0] = (tex != NULL) ? tex[0] : 0.0f;
+        b->tex[2*v+1] = (tex != NULL) ? tex[1] : 0.0f;
+    }
+
+    if (b->flags & BATCH_COLORS)
+        memcpy(b->colors + 4*v, b->color, sizeof(b->color));
+
+    return b->numVerts++;
+}
+
+// add a counter-clockwise triangle
+void batchTriangle(batch *b, int i, int j, int k)
+{
+    GLuint *t;
+
+    b->indices = batchGrow(b, b->indices, b->numIndices, 3, &b->maxIndices, sizeof(GLuint));
+    if (b->failed)
+        return;
+
+    t = b->indices + b->numIndices;
+    t[0] = i;
+    t[1] = j;
+    t[2] = k;
+    b->numIndices += 3;
+}
+
+// add the triangles of a grid of (slices+1) by (stacks+1) vertices,
+// skipping those that close up at a pole
+static void batchGrid(batch *b, int base, int slices, int stacks, bool poles)
+{
+    int i, j, a, c;
+
+    for (j = 0; j < stacks; ++j) {
+        for (i = 0; i < slices; ++i) {
+            a = base + j*(slices+1) + i;
+            c = a + (slices+1) + 1;
+            if (!poles || (j < stacks-1))
+                batchTriangle(b, a, a+(slices+1), c);
+            if (!poles || (j > 0))
+                batchTriangle(b, a, c, a+1);
+        }
+    }
+}
+
+// add a sphere about the origin like gluSphere, stacks run down from +z
+void batchSphere(batch *b, GLfloat rad, int slices, int stacks)
+{
+    GLfloat n[3], p[3];
+    double rho, theta;
+    int i, j, base = b->numVerts;
+
+    for (j = 0; j <= stacks; ++j) {
+        rho = j*M_PI/stacks;
+        for (i = 0; i <= slices; ++i) {
+            theta = i*2.0*M_PI/slices;
+            n[0] = cos(theta)*sin(rho);
+            n[1] = sin(theta)*sin(rho);
+            n[2] = cos(rho);
+            p[0] = rad*n[0];
+            p[1] = rad*n[1];
+            p[2] = rad*n[2];
+            batchVertex(b, p, n, NULL);
+        }
+    }
+
+    batchGrid(b, base, slices, stacks, true);
+}
+
+// add an open tube like gluCylinder, from the origin up to h along +z
+void batchCylinder(batch *b, GLfloat rad, GLfloat h, int slices, int stacks)
+{
+    GLfloat n[3], p[3];
+    double theta;
+    int i, j, base = b->numVerts;
+
+    // rings from the top down, so the grid winds the same as a sphere's
+    for (j = stacks; j >= 0; --j) {
+        for (i = 0; i <= slices; ++i) {
+            theta = i*2.0*M_PI/slices;
+            n[0] = cos(theta);
+            n[1] = sin(theta);
+            n[2] = 0.0f;
+            p[0] = rad*n[0];
+            p[1] = rad*n[1];
+            p[2] = h*j/stacks;
+            batchVertex(b, p, n, NULL);
+        }
+    }
+
+    batchGrid(b, base, slices, stacks, false);
+}
+
+// finish the object, returns its record
+int batchEnd(batch *b)
+{
+    batchDraw *d;
+
+    b->draws = batchGrow(b, b->draws, b->numDraws, 1, &b->maxDraws, sizeof(batchDraw));
+    if (b->failed)
+        return -1;
+
+    d = &b->draws[b->numDraws];
+    d->first = b->first;
+    d->count = b->numIndices - b->first;
+    d->cls   = b->cls;
+
+    return b->numDraws++;
+}
+
+// done baking, room for every record to be queued at once
+// false if out of memory at any point
+bool batchFinish(batch *b)
+{
+    int i;
+
+    for (i = 0; (i < BATCH_MAX_CLASSES) && !b->failed; ++i) {
+        b->counts[i]  = (GLsizei*)malloc((b->numDraws+1) * sizeof(GLsizei));
+        b->offsets[i] = (const GLvoid**)malloc((b->numDraws+1) * sizeof(GLvoid*));
+        b->numQueued[i] = 0;
+        if ((b->counts[i] == NULL) || (b->offsets[i] == NULL))
+            b->failed = true;
+    }
+
+    return !b->failed;
+}
+
+// draw a record this frame, merged with the last one queued
+// in its class when they follow on from each other
+void batchQueue(batch *b, int draw)
+{
+    batchDraw *d;
+    int n;
+
+    if ((draw < 0) || (draw >= b->numDraws) || (b->counts[0] == NULL))
+        return;
+
+    d = &b->draws[draw];
+    n = b->numQueued[d->cls];
+    if ((n > 0) && ((const GLuint*)b->offsets[d->cls][n-1] + b->counts[d->cls][n-1] ==
+                    b->indices + d->first)) {
+        b->counts[d->cls][n-1] += d->count;
+        return;
+    }
+
+    b->counts[d->cls][n]  = d->count;
+    b->offsets[d->cls][n] = b->indices + d->first;
+    b->numQueued[d->cls]++;
+}
+
+// draw every record this frame
+void batchQueueAll(batch *b)
+{
+    int i;
+
+    for (i = 0; i < b->numDraws; ++i)
+        batchQueue(b, i);
+}
+
+// point the vertex arrays at the batch
+void batchBind(batch *b)
+{
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, b->pos);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_BYTE, 4*sizeof(GLbyte), b->normals);
+    if (b->flags & BATCH_TEXCOORDS) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, b->tex);
+    }
+    if (b->flags & BATCH_COLORS) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, b->colors);
+    }
+}
+
+// draw a class's queued records, in one call when multi-draw is there
+void batchSubmit(batch *b, int cls)
+{
+    int i, n = b->numQueued[cls];
+
+    if (n == 0)
+        return;
+
+    if (n == 1)
+        glDrawElements(GL_TRIANGLES, b->counts[cls][0], GL_UNSIGNED_INT, b->offsets[cls][0]);
+#ifndef __APPLE__
+    else if (batchMultiDrawElements != NULL) {
+#ifdef COUNT_GL_CALLS
+        GLC_ADD(GLC_DRAWS, 1);
+        for (i = 0; i < n; ++i)
+            GLC_ADD(GLC_VERTICES, b->counts[cls][i]);
+#endif
+        batchMultiDrawElements(GL_TRIANGLES, b->counts[cls], GL_UNSIGNED_INT, b->offsets[cls], n);
+    }
+#endif
+    else {
+        for (i = 0; i < n; ++i)
+            glDrawElements(GL_TRIANGLES, b->counts[cls][i], GL_UNSIGNED_INT, b->offsets[cls][i]);
+    }
+
+    b->numQueued[cls] = 0;
+}
+
+// turn the arrays off
+void batchUnbind(batch *b)
+{
+    if (b->flags & BATCH_COLORS)
+        glDisableClientState(GL_COLOR_ARRAY);
+    if (b->flags & BATCH_TEXCOORDS)
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
@@ -0,0 +1,133 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Static geometry batches
+ *
+ *  Geometry that never moves is baked once into one shared set of
+ *  vertex arrays and one index array, each object placed by its
+ *  own transform on the way in so none is needed when drawing.
+ *  Every object becomes a draw record, a range of triangle
+ *  indices and the material class it is drawn with.  A frame
+ *  queues the records it wants and submits a class at a time,
+ *  binding the material once and drawing every queued range in a
+ *  single glMultiDrawElements call, with neighbouring ranges
+ *  merged first.  Where multi-draw is missing the ranges are drawn
+ *  one glDrawElements at a time from the same arrays.
+ */
+
+#ifndef BATCH_H
+    #define BATCH_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // single precision matrix stack
+    #include "matrix.h"
+
+    // arrays a batch carries besides positions and normals
+    #define BATCH_TEXCOORDS 1
+    #define BATCH_COLORS    2
+
+    // material classes a batch can be split into
+    #define BATCH_MAX_CLASSES 4
+
+    /* one object, a range of triangle indices */
+    typedef struct {
+        int      first;
+        int      count;
+        int      cls;                      /* material class */
+    } batchDraw;
+
+    /* shared arrays and the records drawn from them */
+    typedef struct {
+        int        flags;                  /* BATCH_TEXCOORDS, BATCH_COLORS */
+        bool       failed;                 /* ran out of memory baking */
+
+        int        numVerts, maxVerts;
+        GLfloat   *pos;                    /* 3 per vertex */
+        GLbyte    *normals;                /* 4 per vertex, the last is padding */
+        GLfloat   *tex;                    /* 2 per vertex */
+        GLubyte   *colors;                 /* 4 per vertex */
+
+        int        numIndices, maxIndices;
+        GLuint    *indices;
+
+        int        numDraws, maxDraws;
+        batchDraw *draws;
+
+        matrix     place;                  /* object being baked */
+        GLubyte    color[4];
+        int        cls;
+        int        first;
+
+        GLsizei   *counts[BATCH_MAX_CLASSES];    /* ranges queued this frame */
+        const GLvoid **offsets[BATCH_MAX_CLASSES];
+        int        numQueued[BATCH_MAX_CLASSES];
+    } batch;
+
+    void batchInit();                                    // find multi-draw for the current context
+    void batchCreate(batch *b, int flags);               // start an empty batch
+    void batchFree(batch *b);                            // release a batch's arrays
+    void batchBegin(batch *b, int cls,                   // start an object placed by m,
+                    const matrix *m);                    // identity when NULL
+    void batchColor(batch *b, GLfloat r, GLfloat g,      // color of the object's vertices
+                    GLfloat bl, GLfloat a);
+    int  batchVertex(batch *b, const GLfloat *pos,       // add a vertex in object space,
+                     const GLfloat *normal,              // returns its index
+                     const GLfloat *tex);
+    void batchTriangle(batch *b, int i, int j, int k);   // add a counter-clockwise triangle
+    void batchSphere(batch *b, GLfloat rad,              // add a sphere like gluSphere
+                     int slices, int stacks);
+    void batchCylinder(batch *b, GLfloat rad, GLfloat h, // add a tube like gluCylinder
+                       int slices, int stacks);
+    int  batchEnd(batch *b);                             // finish the object, returns its record
+    bool batchFinish(batch *b);                          // done baking, false if out of memory
+    void batchQueue(batch *b, int draw);                 // draw a record this frame
+    void batchQueueAll(batch *b);                        // draw every record this frame
+    void batchBind(batch *b);                            // point the vertex arrays at the batch
+    void batchSubmit(batch *b, int cls);                 // draw a class's queued records
+    void batchUnbind(batch *b);                          // turn the arrays off
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,359 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Deterministic flythrough benchmark
+ *
+ *  Drives the navigator camera along a scripted spline path
+ *  with a fixed animation clock and reports frame-time
+ *  statistics as JSON.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// 3d navigation
+#include "navigator.h"
+
+// high resolution timers
+#include "timing.h"
+
+// demand driven redraws
+#include "redraw.h"
+
+// prototypes and definitions
+#include "benchmark.h"
+
+// scripted camera path
+benchPoint benchPath[BENCH_MAX_POINTS];
+int        benchNumPoints = 0;
+char       benchPathName[256] = "";
+
+// run configuration
+bool   benchRunning = false;
+int    benchFrames  = BENCH_DEFAULT_FRAMES;
+int    benchWarmup  = BENCH_WARMUP_FRAMES;
+char  *benchOut     = NULL;
+
+// progress and measurements
+int     benchFrame    = 0;
+double  benchLastSwap = 0.0;
+double *benchTimes    = NULL;
+
+// fixed animation step
+void (*benchStep)(void) = NULL;
+
+// load a camera path from file
+// each non-comment line holds: x y z hrot vrot
+bool benchLoadPath(char *fileName)
+{
+    FILE *fp;
+    char line[256];
+    benchPoint p;
+
+    fp = fopen(fileName, "r");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open path \"%s\"!\n", fileName);
+        return false;
+    }
+
+    benchNumPoints = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if ((line[0] == '#') || (line[0] == '\n'))
+            continue;
+
+        if (sscanf(line, "%lf %lf %lf %lf %lf", &p.x, &p.y, &p.z, &p.h, &p.v) != 5) {
+            fprintf(stderr, "error: malformed path point in \"%s\": %s", fileName, line);
+            fclose(fp);
+            return false;
+        }
+
+        if (benchNumPoints == BENCH_MAX_POINTS) {
+            fprintf(stderr, "error: path \"%s\" exceeds %d points!\n", fileName, BENCH_MAX_POINTS);
+            fclose(fp);
+            return false;
+        }
+
+        benchPath[benchNumPoints++] = p;
+    }
+    fclose(fp);
+
+    if (benchNumPoints < 2) {
+        fprintf(stderr, "error: path \"%s\" needs at least 2 points!\n", fileName);
+        return false;
+    }
+
+    strncpy(benchPathName, fileName, sizeof(benchPathName)-1);
+
+    return true;
+}
+
+// use a camera path built by the caller
+bool benchSetPath(benchPoint *points, int n, char *name)
+{
+    if (n > BENCH_MAX_POINTS) {
+        fprintf(stderr, "error: path \"%s\" exceeds %d points!\n", name, BENCH_MAX_POINTS);
+        return false;
+    }
+
+    if (n < 2) {
+        fprintf(stderr, "error: path \"%s\" needs at least 2 points!\n", name);
+        return false;
+    }
+
+    memcpy(benchPath, points, sizeof(benchPoint) * n);
+    benchNumPoints = n;
+
+    strncpy(benchPathName, name, sizeof(benchPathName)-1);
+
+    return true;
+}
+
+// configure the benchmark run
+// vsync is disabled through the environment since
+// this must happen before the context is created
+void benchInit(int frames, char *outFile)
+{
+    if (frames > 0)
+        benchFrames = frames;
+
+    benchOut = outFile;
+
+    benchTimes = malloc(sizeof(double) * benchFrames);
+    if (benchTimes == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d frame times.\n", benchFrames);
+        exit(EXIT_FAILURE);
+    }
+
+    setenv("vblank_mode", "0", 0);
+    setenv("__GL_SYNC_TO_VBLANK", "0", 0);
+
+    benchRunning = true;
+}
+
+// register the function that advances animation by one step
+void benchStepFunc(void (*func)(void))
+{
+    benchStep = func;
+}
+
+// catmull-rom interpolation between b and c
+static GLdouble benchSpline(GLdouble a, GLdouble b, GLdouble c, GLdouble d, GLdouble t)
+{
+    return 0.5 * ((2.0*b) + (-a+c)*t +
+                  (2.0*a - 5.0*b + 4.0*c - d)*t*t +
+                  (-a + 3.0*b - 3.0*c + d)*t*t*t);
+}
+
+// place the camera at parameter u along the path, 0 <= u <= 1
+static void benchPlaceCamera(double u)
+{
+    int i, i0, i2, i3;
+    double s, t;
+    benchPoint *a, *b, *c, *d;
+
+    s = u * (benchNumPoints-1);
+    i = (int)s;
+    if (i >= benchNumPoints-1)
+        i = benchNumPoints-2;
+    t = s - i;
+
+    // clamp the neighbouring control points at the path ends
+    i0 = (i > 0) ? i-1 : 0;
+    i2 = i+1;
+    i3 = (i+2 < benchNumPoints) ? i+2 : benchNumPoints-1;
+
+    a = &benchPath[i0];
+    b = &benchPath[i];
+    c = &benchPath[i2];
+    d = &benchPath[i3];
+
+    navSetCamera(benchSpline(a->x, b->x, c->x, d->x, t),
+                 benchSpline(a->y, b->y, c->y, d->y, t),
+                 benchSpline(a->z, b->z, c->z, d->z, t),
+                 benchSpline(a->h, b->h, c->h, d->h, t),
+                 benchSpline(a->v, b->v, c->v, d->v, t));
+}
+
+// set up the camera and animation for the next frame
+static void benchPrepareFrame()
+{
+    int measured = benchFrame - benchWarmup;
+
+    if (measured < 0)
+        benchPlaceCamera(0.0);
+    else if (benchFrames > 1)
+        benchPlaceCamera((double)measured / (benchFrames-1));
+    else
+        benchPlaceCamera(0.0);
+
+    if (benchStep != NULL)
+        benchStep();
+
+    redrawPost(REDRAW_BENCHMARK);
+}
+
+// begin driving the camera
+void benchStart()
+{
+    navSetSwapInterval(0);
+
+    benchFrame = 0;
+    benchPrepareFrame();
+}
+
+// record the frame that was just swapped and prepare the next
+void benchFrameDone()
+{
+    double now = timeNow();
+    int measured = benchFrame - benchWarmup;
+
+    if (!benchRunning)
+        return;
+
+    // the warm-up guarantees a previous swap for the first measurement
+    if (measured >= 0)
+        benchTimes[measured] = now - benchLastSwap;
+
+    benchLastSwap = now;
+    ++benchFrame;
+
+    if (measured+1 >= benchFrames) {
+        benchRunning = false;
+        benchReport();
+        exit(EXIT_SUCCESS);
+    }
+
+    benchPrepareFrame();
+}
+
+// is a benchmark running
+bool benchActive()
+{
+    return benchRunning;
+}
+
+// write a string as a quoted JSON string
+static void benchWriteString(FILE *fp, const char *str)
+{
+    const unsigned char *c;
+
+    fputc('"', fp);
+    for (c = (const unsigned char *)str; *c != '\0'; ++c) {
+        if ((*c == '"') || (*c == '\\'))
+            fprintf(fp, "\\%c", *c);
+        else if (*c < 0x20)
+            fprintf(fp, "\\u%04x", *c);
+        else
+            fputc(*c, fp);
+    }
+    fputc('"', fp);
+}
+
+// write results as JSON
+void benchReport()
+{
+    int i, j, worst;
+    int order[BENCH_WORST_FRAMES];
+    double total = 0.0;
+    double *sorted;
+    FILE *fp = stdout;
+
+    sorted = malloc(sizeof(double) * benchFrames);
+    if (sorted == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d frame times.\n", benchFrames);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(sorted, benchTimes, sizeof(double) * benchFrames);
+    timeSort(sorted, benchFrames);
+
+    for (i = 0; i < benchFrames; ++i)
+        total += benchTimes[i];
+
+    // select the slowest frames, slowest first
+    worst = (benchFrames < BENCH_WORST_FRAMES) ? benchFrames : BENCH_WORST_FRAMES;
+    for (i = 0; i < worst; ++i) {
+        order[i] = -1;
+        for (j = 0; j < benchFrames; ++j) {
+            int k;
+            bool taken = false;
+
+            for (k = 0; k < i; ++k)
+                if (order[k] == j)
+                    taken = true;
+
+            if (!taken && ((order[i] < 0) || (benchTimes[j] > benchTimes[order[i]])))
+                order[i] = j;
+        }
+    }
+
+    if ((benchOut != NULL) && (strcmp(benchOut, "-") != 0)) {
+        fp = fopen(benchOut, "w");
+        if (!fp) {
+            fprintf(stderr, "error: couldn't open \"%s\"!\n", benchOut);
+            fp = stdout;
+        }
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"path\": ");
+    benchWriteString(fp, benchPathName);
+    fprintf(fp, ",\n");
+    fprintf(fp, "  \"warmup_frames\": %d,\n", benchWarmup);
+    fprintf(fp, "  \"frames\": %d,\n", benchFrames);
+    fprintf(fp, "  \"total_ms\": %.3f,\n", total);
+    fprintf(fp, "  \"avg_fps\": %.2f,\n", (total > 0.0) ? 1000.0*benchFrames/total : 0.0);
+    fprintf(fp, "  \"avg_ms\": %.3f,\n", total/benchFrames);
+    fprintf(fp, "  \"min_ms\": %.3f,\n", sorted[0]);
+    fprintf(fp, "  \"p50_ms\": %.3f,\n", timePercentile(sorted, benchFrames, 50.0));
+    fprintf(fp, "  \"p95_ms\": %.3f,\n", timePercentile(sorted, benchFrames, 95.0));
+    fprintf(fp, "  \"p99_ms\": %.3f,\n", timePercentile(sorted, benchFrames, 99.0));
+    fprintf(fp, "  \"max_ms\": %.3f,\n", sorted[benchFrames-1]);
+    fprintf(fp, "  \"worst_frames\": [");
+    for (i = 0; i < worst; ++i)
+        fprintf(fp, "%s\n    {\"frame\": %d, \"ms\": %.3f}", (i > 0) ? "," : "",
+                order[i], benchTimes[order[i]]);
+    fprintf(fp, "\n  ]\n");
+    fprintf(fp, "}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+
+    free(sorted);
+}
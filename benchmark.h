@@ -0,0 +1,87 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Deterministic flythrough benchmark
+ *
+ *  Drives the navigator camera along a scripted spline path
+ *  with a fixed animation clock and reports frame-time
+ *  statistics as JSON.
+ */
+
+#ifndef BENCHMARK_H
+    #define BENCHMARK_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // maximum number of control points in a path
+    #define BENCH_MAX_POINTS 256
+
+    // default number of measured frames
+    #define BENCH_DEFAULT_FRAMES 1000
+
+    // frames rendered before measuring begins
+    #define BENCH_WARMUP_FRAMES  60
+
+    // number of slowest frames reported
+    #define BENCH_WORST_FRAMES   10
+
+    /* camera control point */
+    typedef struct {
+        GLdouble x, y, z;   /* location */
+        GLdouble h, v;      /* horizontal and vertical rotation */
+    } benchPoint;
+
+    bool benchLoadPath(char *fileName);                  // load a scripted camera path
+    bool benchSetPath(benchPoint *points, int n,         // use a generated camera path
+                      char *name);
+    void benchInit(int frames, char *outFile);           // configure the benchmark run
+    void benchStepFunc(void (*func)(void));              // register fixed animation step
+    void benchStart();                                   // begin driving the camera
+    void benchFrameDone();                               // post-swap call-back
+    bool benchActive();                                  // is a benchmark running
+    void benchReport();                                  // write results as JSON
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
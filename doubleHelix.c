@@ -43,79 +43,120 @@
 #endif
 
 // standard c libraries
+#include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 // protypes and definitons
 #include "doubleHelix.h"
 
-GLUquadric *helix_qdrc;
+// single precision matrix stack
+#include "matrix.h"
+
+// static geometry batches
+#include "batch.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// per-frame gl call counters, must follow the OpenGL headers
+#include "glCounters.h"
+
+// the whole helix, baked once with every shape already in place
+batch helixBatch;
+bool  helixBaked = false;
 
 // initialize draw routine
 void initDoubleHelix()
 {
-    // used for glu predefined shapes
-    helix_qdrc = gluNewQuadric();
-    gluQuadricOrientation(helix_qdrc, GLU_OUTSIDE);
-    gluQuadricNormals(helix_qdrc, GLU_SMOOTH);
-
     // seed random number generator for colors
     // srand(779);
+
+    bakeDoubleHelix();
 }
 
-// assign random material properties
+// assign random material properties, ambient and diffuse follow
+// the color of each vertex and the rest is the same for every shape
 void genRandColor()
 {
     GLfloat r = ((GLfloat)(rand()%10))/10.0f;
     GLfloat g = ((GLfloat)(rand()%10))/10.0f;
     GLfloat b = ((GLfloat)(rand()%10))/10.0f;
 
-    GLfloat colorA[4] = {r, g, b, 0.75f};
-    GLfloat colorD[4] = {r, g, b, 0.75f};
-    //GLfloat colorS[4] = {r, g, b, 1.0f};
-    GLfloat colorS[4] = {0.9, 0.9, 0.9, 0.75f};
-
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    batchColor(&helixBatch, r, g, b, 0.75f);
 }
 
-// draw a sphere at tx, ty, tz, with radius rad
+// add a sphere at tx, ty, tz, with radius rad
 void drawMolicule(GLdouble tx, GLdouble ty, GLdouble tz, GLdouble rad)
 {
-    glPushMatrix();
+    matPush();
+    matLoadIdentity();
+    matTranslate(tx, ty, tz);
 
-    glTranslated(tx, ty, tz);
+    batchBegin(&helixBatch, HELIX_CLASS, matTop(MAT_MODELVIEW));
     genRandColor();
-    gluSphere(helix_qdrc, rad, MOLI_RES, MOLI_RES);
+    batchSphere(&helixBatch, rad, MOLI_RES, MOLI_RES);
+    batchEnd(&helixBatch);
 
-    glPopMatrix();
+    matPop();
 }
 
-// draw a cylinder at tx, ty, tz with rotation rr in radians about rx, ry, tz and radius rad and height h
+// add a cylinder at tx, ty, tz with rotation rr in radians about rx, ry, tz and radius rad and height h
 void drawBond(GLdouble tx, GLdouble ty, GLdouble tz, GLdouble rr, GLdouble rx, GLdouble ry, GLdouble rz, GLdouble rad, GLdouble h)
 {
-    glPushMatrix();
+    matPush();
+    matLoadIdentity();
+    matTranslate(tx, ty, tz);
+    matRotate((180.0/M_PI)*rr, rx, ry, rz);
+    matRotate(-90.0, 1.0, 0.0, 0.0);
+    matTranslate(0.0, 0.0, -h/2.0);
 
-    glTranslated(tx, ty, tz);
-    glRotated((180.0/M_PI)*rr, rx, ry, rz);
-    glRotated(-90.0, 1.0, 0.0, 0.0);
-    glTranslated(0.0, 0.0, -h/2.0);
+    batchBegin(&helixBatch, HELIX_CLASS, matTop(MAT_MODELVIEW));
     genRandColor();
-    gluCylinder(helix_qdrc, rad, rad, h, BOND_RES, BOND_RES);
+    batchCylinder(&helixBatch, rad, h, BOND_RES, BOND_RES);
+    batchEnd(&helixBatch);
 
-    glPopMatrix();
+    matPop();
 }
 
-// draw this tremendous double helix
+// draw this tremendous double helix, one draw for every shape
 void drawDoubleHelix()
 {
+    TRACE_FUNC();
+
+    GLfloat const colorS[4] = {0.9, 0.9, 0.9, 0.75f};
+
+    if (!helixBaked)
+        return;
+
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
+    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    glEnable(GL_COLOR_MATERIAL);
+
+    matMode(MAT_MODELVIEW);
+    matUpload();
+
+    batchBind(&helixBatch);
+    batchQueueAll(&helixBatch);
+    batchSubmit(&helixBatch, HELIX_CLASS);
+    batchUnbind(&helixBatch);
+
+    glDisable(GL_COLOR_MATERIAL);
+}
+
+// place every shape of the helix, in the order they were once drawn
+void bakeDoubleHelix()
+{
+    TRACE_FUNC();
+
+    batchCreate(&helixBatch, BATCH_COLORS);
+
     // same colors
     srand(779);
 
-    // each call updated modelview
-    glMatrixMode(GL_MODELVIEW);
+    matMode(MAT_MODELVIEW);
 
     // Atoms and NICS cubes
     drawMolicule(-0.808, -8.873, -17.29, 0.23 );
@@ -1958,4 +1999,10 @@ void drawDoubleHelix()
     drawBond( -5.90475, 6.61675, -9.3625, 1.35268284821, -0.617813307915, 0.0, -0.0569982600206 , 0.17, 0.797178461826 );
     drawBond( -1.0465, 8.726, -11.9675, 1.44755259042, -0.617821328338, 0.0, -0.126753020911 , 0.17, 0.797188810759 );
     drawBond( -0.8875, 8.824, -12.7425, 1.44755259042, -0.617821328338, 0.0, -0.126753020911 , 0.17, 0.797188810759 );
+
+    helixBaked = batchFinish(&helixBatch);
+    if (!helixBaked) {
+        fprintf(stderr, "warning: out of memory baking the double helix\n");
+        batchFree(&helixBatch);
+    }
 }
@@ -54,20 +54,26 @@
     #define MOLI_RES 8
     #define BOND_RES 8
 
-    // initialize draw routines
+    // every atom and bond shares one material class
+    #define HELIX_CLASS 0
+
+    // initialize draw routines, bakes the helix
     void initDoubleHelix();
 
     // generate random material properties
     void genRandColor();
 
-    // draw a sphere
+    // add a sphere to the helix
     void drawMolicule(GLdouble tx, GLdouble ty, GLdouble tz, GLdouble rad);
 
-    // draw a cylinder
+    // add a cylinder to the helix
     void drawBond(GLdouble tx, GLdouble ty, GLdouble tz,
                   GLdouble rr, GLdouble rx, GLdouble ry, GLdouble rz,
                   GLdouble rad, GLdouble h);
 
+    // place every atom and bond of the helix in its batch
+    void bakeDoubleHelix();
+
     // draw the double helix
     void drawDoubleHelix();
 
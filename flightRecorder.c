@@ -0,0 +1,231 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Frame hitch flight recorder
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// 3d navigation
+#include "navigator.h"
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "flightRecorder.h"
+
+// ring of recent frames
+recFrame recRing[REC_FRAMES];
+long     recNext = 0;
+
+// the frame being accumulated, noted on the glut thread and taken
+// when a frame is swapped, on the render thread if there is one,
+// guarded by recLock like the ring
+recFrame recCurrent;
+pthread_mutex_t recLock = PTHREAD_MUTEX_INITIALIZER;
+
+// configuration
+double recThreshold = REC_DEFAULT_THRESHOLD;
+char  *recDir       = ".";
+
+// bookkeeping
+double recStart     = -1.0;
+double recLastDump  = -1.0e9;
+long   recLastTicks = 0;
+
+// configure threshold and dump directory
+// a threshold of 0 disables automatic dumps
+void recInit(double threshold, char *dir)
+{
+    recThreshold = threshold;
+
+    if (dir != NULL)
+        recDir = dir;
+}
+
+// note an input event for the current frame
+void recNoteInput(int type, int key, int mods)
+{
+    recInput *in;
+
+    pthread_mutex_lock(&recLock);
+    if (recCurrent.numInputs < REC_MAX_INPUTS) {
+        in = &recCurrent.inputs[recCurrent.numInputs++];
+        in->type = type;
+        in->mods = mods;
+        in->key  = key;
+    }
+    pthread_mutex_unlock(&recLock);
+}
+
+// note timer or upload activity for the current frame
+void recCount(int counter)
+{
+    pthread_mutex_lock(&recLock);
+    ++recCurrent.counts[counter];
+    pthread_mutex_unlock(&recLock);
+}
+
+// capture the frame that was just swapped
+void recFrameEnd()
+{
+    int i;
+    long ticks;
+    recFrame *f;
+    double now = timeNow();
+
+    if (recStart < 0.0)
+        recStart = now;
+
+    pthread_mutex_lock(&recLock);
+
+    f = &recRing[recNext % REC_FRAMES];
+    *f = recCurrent;
+
+    f->frame    = recNext;
+    f->time     = now - recStart;
+    f->interval = profFrameTime();
+    f->work     = profFrameWork();
+
+    for (i = 0; i < PROF_NUM_PHASES; ++i) {
+        f->cpu[i] = profCPUTime(i);
+        f->gpu[i] = profGPUTime(i);
+    }
+
+    navGetCamera(&f->camera[0], &f->camera[1], &f->camera[2],
+                 &f->camera[3], &f->camera[4]);
+
+    // the navigator counts its own timer steps
+    ticks = navMotionTicks();
+    f->counts[REC_MOTION_TICKS] = ticks - recLastTicks;
+    recLastTicks = ticks;
+
+    memset(&recCurrent, 0, sizeof(recCurrent));
+    ++recNext;
+
+    pthread_mutex_unlock(&recLock);
+
+    if ((recThreshold > 0.0) && (f->frame >= REC_SETTLE_FRAMES) &&
+        (f->work > recThreshold) && (now - recLastDump > REC_DUMP_COOLDOWN)) {
+        char reason[64];
+
+        sprintf(reason, "frame %ld took %.2f ms", f->frame, f->work);
+        recDump(reason);
+        recLastDump = now;
+    }
+}
+
+// write the ring to disk as json, oldest frame first
+bool recDump(char *reason)
+{
+    int i, j;
+    long k, start;
+    FILE *fp;
+    char fileName[512];
+
+    // frames keep being captured on the render thread meanwhile
+    pthread_mutex_lock(&recLock);
+
+    start = (recNext > REC_FRAMES) ? recNext - REC_FRAMES : 0;
+
+    snprintf(fileName, sizeof(fileName), "%s/hitch-%ld-%ld.json",
+             recDir, (long)time(NULL), recNext-1);
+
+    fp = fopen(fileName, "w");
+    if (!fp) {
+        pthread_mutex_unlock(&recLock);
+        fprintf(stderr, "error: couldn't open \"%s\"!\n", fileName);
+        return false;
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"reason\": \"%s\",\n", reason);
+    fprintf(fp, "  \"threshold_ms\": %.2f,\n", recThreshold);
+    fprintf(fp, "  \"gpu_timers\": %s,\n", profGPUTimers() ? "true" : "false");
+
+    fprintf(fp, "  \"phases\": [");
+    for (i = 0; i < PROF_NUM_PHASES; ++i)
+        fprintf(fp, "%s\"%s\"", (i > 0) ? ", " : "", profPhaseName(i));
+    fprintf(fp, "],\n");
+
+    fprintf(fp, "  \"frames\": [");
+    for (k = start; k < recNext; ++k) {
+        recFrame *f = &recRing[k % REC_FRAMES];
+
+        fprintf(fp, "%s\n    {\"frame\": %ld, \"t_ms\": %.3f, \"interval_ms\": %.3f, \"work_ms\": %.3f,\n",
+                (k > start) ? "," : "",
+                f->frame, f->time, f->interval, f->work);
+
+        fprintf(fp, "     \"camera\": [%.2f, %.2f, %.2f, %.2f, %.2f],\n",
+                f->camera[0], f->camera[1], f->camera[2], f->camera[3], f->camera[4]);
+
+        fprintf(fp, "     \"cpu_ms\": [");
+        for (j = 0; j < PROF_NUM_PHASES; ++j)
+            fprintf(fp, "%s%.3f", (j > 0) ? ", " : "", f->cpu[j]);
+        fprintf(fp, "],\n");
+
+        fprintf(fp, "     \"gpu_ms\": [");
+        for (j = 0; j < PROF_NUM_PHASES; ++j)
+            fprintf(fp, "%s%.3f", (j > 0) ? ", " : "", f->gpu[j]);
+        fprintf(fp, "],\n");
+
+        fprintf(fp, "     \"inputs\": [");
+        for (j = 0; j < f->numInputs; ++j)
+            fprintf(fp, "%s{\"type\": %d, \"key\": %d, \"mods\": %d}", (j > 0) ? ", " : "",
+                    f->inputs[j].type, f->inputs[j].key, f->inputs[j].mods);
+        fprintf(fp, "],\n");
+
+        fprintf(fp, "     \"animate_ticks\": %d, \"motion_ticks\": %d, \"texture_uploads\": %d}",
+                f->counts[REC_ANIMATE_TICKS], f->counts[REC_MOTION_TICKS],
+                f->counts[REC_TEXTURE_UPLOADS]);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    fclose(fp);
+    pthread_mutex_unlock(&recLock);
+
+    fprintf(stderr, "flight recorder: %s, wrote %s\n", reason, fileName);
+
+    return true;
+}
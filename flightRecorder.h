@@ -0,0 +1,111 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Frame hitch flight recorder
+ *
+ *  Keeps the last few hundred frames of per-phase timings, camera
+ *  pose, input and timer activity in a ring buffer.  Whenever a
+ *  frame takes longer than the threshold the ring is written to
+ *  disk so every stutter comes with the frames that led up to it.
+ */
+
+#ifndef FLIGHTRECORDER_H
+    #define FLIGHTRECORDER_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // phase names and count
+    #include "profiler.h"
+
+    // frames held in the ring
+    #define REC_FRAMES 300
+
+    // input events kept per frame
+    #define REC_MAX_INPUTS 8
+
+    // default hitch threshold in ms of draw and swap time
+    #define REC_DEFAULT_THRESHOLD 50.0
+
+    // startup frames that never trigger a dump
+    #define REC_SETTLE_FRAMES 10
+
+    // minimum ms between two dumps
+    #define REC_DUMP_COOLDOWN 2000.0
+
+    // counted activity between frames
+    #define REC_ANIMATE_TICKS   0
+    #define REC_MOTION_TICKS    1
+    #define REC_TEXTURE_UPLOADS 2
+    #define REC_NUM_COUNTS      3
+
+    /* one input event */
+    typedef struct {
+        unsigned char type;
+        unsigned char mods;
+        short key;
+    } recInput;
+
+    /* one recorded frame */
+    typedef struct {
+        long     frame;
+        double   time;                        /* ms since the recorder started */
+        float    interval;                    /* ms since the previous swap */
+        float    work;                        /* ms drawing and swapping */
+        float    cpu[PROF_NUM_PHASES];
+        float    gpu[PROF_NUM_PHASES];        /* resolved a frame late, -1 if unknown */
+        GLdouble camera[5];                   /* x, y, z, hrot, vrot */
+        int      numInputs;
+        recInput inputs[REC_MAX_INPUTS];
+        int      counts[REC_NUM_COUNTS];
+    } recFrame;
+
+    void recInit(double threshold, char *dir);           // configure threshold and dump directory
+    void recNoteInput(int type, int key, int mods);      // note an input event
+    void recCount(int counter);                          // note timer or upload activity
+    void recFrameEnd();                                  // capture the frame just swapped
+    bool recDump(char *reason);                          // write the ring to disk now
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,242 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  GL command-stream capture
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// prototypes and definitions
+#include "glCapture.h"
+
+// trace being written, NULL once the range is done
+FILE     *capFp = NULL;
+char      capName[256] = "";
+capHeader capHdr;
+
+// frames swapped since capture began
+int capFrame = 0;
+
+// quadrics seen so far
+void *capQuadrics[CAP_MAX_QUADRICS];
+int   capNumQuadrics = 0;
+
+// were the wrappers linked in
+bool capEnabled()
+{
+#ifdef CAPTURE_GL
+    return true;
+#else
+    return false;
+#endif
+}
+
+// capture frames first..first+count-1
+// everything before them is captured as state only
+bool capOpen(char *fileName, int first, int count)
+{
+    if (!capEnabled()) {
+        fprintf(stderr, "error: gl capture not compiled in, rebuild with CAPTURE=1\n");
+        return false;
+    }
+
+    capFp = fopen(fileName, "wb");
+    if (!capFp) {
+        fprintf(stderr, "error: couldn't open \"%s\" for capture!\n", fileName);
+        return false;
+    }
+    setvbuf(capFp, NULL, _IOFBF, 1<<20);
+
+    strncpy(capName, fileName, sizeof(capName)-1);
+
+    memset(&capHdr, 0, sizeof(capHdr));
+    capHdr.magic   = CAP_MAGIC;
+    capHdr.version = CAP_VERSION;
+    capHdr.first   = (first >= 0) ? first : CAP_DEFAULT_FIRST;
+    capHdr.count   = (count >  0) ? count : CAP_DEFAULT_COUNT;
+
+    // the viewport is filled in when the trace is finished
+    fwrite(&capHdr, sizeof(capHdr), 1, capFp);
+
+    capFrame = 0;
+    atexit(capClose);
+
+    return true;
+}
+
+// finish the trace
+void capClose()
+{
+    long bytes;
+
+    if (capFp == NULL)
+        return;
+
+    bytes = ftell(capFp);
+
+    // frames that never happened are not in the trace
+    if (capFrame < capHdr.first + capHdr.count)
+        capHdr.count = (capFrame > capHdr.first) ? capFrame - capHdr.first : 0;
+
+    fseek(capFp, 0, SEEK_SET);
+    fwrite(&capHdr, sizeof(capHdr), 1, capFp);
+    fclose(capFp);
+    capFp = NULL;
+
+    if (capHdr.count > 0)
+        fprintf(stderr, "captured frames %d-%d to \"%s\", %ld bytes\n",
+                capHdr.first, capHdr.first + capHdr.count - 1, capName, bytes);
+    else
+        fprintf(stderr, "warning: exited before frame %d, \"%s\" holds no frames\n",
+                capHdr.first, capName);
+}
+
+// are state changes being captured
+bool capState()
+{
+    return capFp != NULL;
+}
+
+// is geometry being captured
+bool capGeometry()
+{
+    return (capFp != NULL) && (capFrame >= capHdr.first);
+}
+
+// note a buffer swap, closes the trace after the last frame
+void capSwap()
+{
+    if (capFp == NULL)
+        return;
+
+    capOp(CAP_SWAP);
+
+    if (++capFrame >= capHdr.first + capHdr.count)
+        capClose();
+}
+
+// index of a quadric, adding it if new
+int capQuadric(void *quadric)
+{
+    int i;
+
+    for (i = 0; i < capNumQuadrics; ++i)
+        if (capQuadrics[i] == quadric)
+            return i;
+
+    if (capNumQuadrics == CAP_MAX_QUADRICS) {
+        fprintf(stderr, "Fatal Error:  More than %d quadrics to capture.\n", CAP_MAX_QUADRICS);
+        exit(EXIT_FAILURE);
+    }
+
+    capQuadrics[capNumQuadrics] = quadric;
+
+    return capNumQuadrics++;
+}
+
+// index of a font
+int capFont(void *font)
+{
+    if (font == GLUT_BITMAP_9_BY_15)        return CAP_FONT_9_BY_15;
+    if (font == GLUT_BITMAP_TIMES_ROMAN_10) return CAP_FONT_TIMES_ROMAN_10;
+    if (font == GLUT_BITMAP_TIMES_ROMAN_24) return CAP_FONT_TIMES_ROMAN_24;
+    if (font == GLUT_BITMAP_HELVETICA_10)   return CAP_FONT_HELVETICA_10;
+    if (font == GLUT_BITMAP_HELVETICA_12)   return CAP_FONT_HELVETICA_12;
+    if (font == GLUT_BITMAP_HELVETICA_18)   return CAP_FONT_HELVETICA_18;
+
+    return CAP_FONT_8_BY_13;
+}
+
+// note the window size for the replayer
+void capViewport(int width, int height)
+{
+    capHdr.width  = width;
+    capHdr.height = height;
+}
+
+// raw writers used by the wrappers
+void capOp(uint8_t op)
+{
+    putc_unlocked(op, capFp);
+}
+
+void capU8(uint8_t v)
+{
+    putc_unlocked(v, capFp);
+}
+
+void capU32(uint32_t v)
+{
+    fwrite_unlocked(&v, sizeof(v), 1, capFp);
+}
+
+void capI32(int32_t v)
+{
+    fwrite_unlocked(&v, sizeof(v), 1, capFp);
+}
+
+void capF32(float v)
+{
+    fwrite_unlocked(&v, sizeof(v), 1, capFp);
+}
+
+void capF64(double v)
+{
+    fwrite_unlocked(&v, sizeof(v), 1, capFp);
+}
+
+void capFloats(const float *v, int n)
+{
+    capU8(n);
+    fwrite_unlocked(v, sizeof(float), n, capFp);
+}
+
+void capBytes(const void *data, uint32_t n)
+{
+    capU32(n);
+    fwrite_unlocked(data, 1, n, capFp);
+}
+
+void capRaw(const void *data, uint32_t n)
+{
+    fwrite_unlocked(data, 1, n, capFp);
+}
@@ -0,0 +1,164 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  GL command-stream capture
+ *
+ *  Serializes the GL, GLU and GLUT drawing calls of a range of
+ *  frames into a compact binary trace that glReplay re-executes
+ *  against any context.  Frames before the range contribute only
+ *  their state changes (matrices, lights, materials, textures)
+ *  so the trace starts in the right state without carrying their
+ *  geometry.  The wrappers are linked in with make CAPTURE=1,
+ *  otherwise capture is unavailable and costs nothing.
+ */
+
+#ifndef GLCAPTURE_H
+    #define GLCAPTURE_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdio.h>
+    #include <stdbool.h>
+    #include <stdint.h>
+
+    // file identification, "GLCT" and format version
+    #define CAP_MAGIC   0x54434c47
+    #define CAP_VERSION 4
+
+    // default frame range
+    #define CAP_DEFAULT_FIRST 60
+    #define CAP_DEFAULT_COUNT 1
+
+    // quadrics and fonts told apart in a trace
+    #define CAP_MAX_QUADRICS 16
+
+    // fonts, by index
+    #define CAP_FONT_8_BY_13         0
+    #define CAP_FONT_9_BY_15         1
+    #define CAP_FONT_TIMES_ROMAN_10  2
+    #define CAP_FONT_TIMES_ROMAN_24  3
+    #define CAP_FONT_HELVETICA_10    4
+    #define CAP_FONT_HELVETICA_12    5
+    #define CAP_FONT_HELVETICA_18    6
+    #define CAP_NUM_FONTS            7
+
+    // opcodes, each followed by its arguments in host byte order
+    #define CAP_SWAP                 1    // end of frame
+    #define CAP_BEGIN                2    // u32 mode
+    #define CAP_END                  3
+    #define CAP_VERTEX3I             4    // 3 i32
+    #define CAP_VERTEX3D             5    // 3 f64
+    #define CAP_NORMAL3F             6    // 3 f32
+    #define CAP_TEXCOORD2I           7    // 2 i32
+    #define CAP_RASTERPOS2I          8    // 2 i32
+    #define CAP_RASTERPOS3I          9    // 3 i32
+    #define CAP_BITMAPCHARACTER     10    // u8 font, i32 char
+    #define CAP_SPHERE              11    // u8 quadric, f64 radius, 2 i32
+    #define CAP_CYLINDER            12    // u8 quadric, 3 f64, 2 i32
+    #define CAP_DISK                13    // u8 quadric, 2 f64, 2 i32
+    #define CAP_TEAPOT              14    // f64 size
+    #define CAP_TORUS               15    // 2 f64, 2 i32
+    #define CAP_CLEAR               16    // u32 mask
+    #define CAP_DRAWARRAYS          17    // u32 format, u32 mode, i32 count, u32 bytes, bytes
+
+    #define CAP_COLOR4D             32    // 4 f64
+    #define CAP_MATERIALF           33    // u32 face, u32 pname, f32
+    #define CAP_MATERIALFV          34    // u32 face, u32 pname, u8 n, n f32
+    #define CAP_LIGHTF              35    // u32 light, u32 pname, f32
+    #define CAP_LIGHTFV             36    // u32 light, u32 pname, u8 n, n f32
+    #define CAP_LIGHTMODELI         37    // u32 pname, i32
+    #define CAP_LIGHTMODELFV        38    // u32 pname, u8 n, n f32
+    #define CAP_SHADEMODEL          39    // u32 mode
+    #define CAP_MATRIXMODE          40    // u32 mode
+    #define CAP_LOADIDENTITY        41
+    #define CAP_PUSHMATRIX          42
+    #define CAP_POPMATRIX           43
+    #define CAP_TRANSLATED          44    // 3 f64
+    #define CAP_ROTATED             45    // 4 f64
+    #define CAP_SCALED              46    // 3 f64
+    #define CAP_FRUSTUM             47    // 6 f64
+    #define CAP_ORTHO2D             48    // 4 f64
+    #define CAP_VIEWPORT            49    // 4 i32
+    #define CAP_PUSHATTRIB          50    // u32 mask
+    #define CAP_POPATTRIB           51
+    #define CAP_ENABLE              52    // u32 cap
+    #define CAP_DISABLE             53    // u32 cap
+    #define CAP_BLENDFUNC           54    // 2 u32
+    #define CAP_CULLFACE            55    // u32
+    #define CAP_POLYGONMODE         56    // 2 u32
+    #define CAP_HINT                57    // 2 u32
+    #define CAP_CLEARCOLOR          58    // 4 f32
+    #define CAP_GENTEXTURES         59    // i32 n, n u32
+    #define CAP_BINDTEXTURE         60    // u32 target, u32 texture
+    #define CAP_TEXPARAMETERI       61    // 2 u32, i32
+    #define CAP_TEXIMAGE2D          62    // u32 target, 5 i32, 2 u32, u32 bytes, bytes
+    #define CAP_NEWQUADRIC          63    // u8 quadric
+    #define CAP_QUADRICNORMALS      64    // u8 quadric, u32
+    #define CAP_QUADRICORIENTATION  65    // u8 quadric, u32
+    #define CAP_DISABLECLIENTSTATE  66    // u32 array
+    #define CAP_LOADMATRIXF         67    // 16 f32
+    #define CAP_COLORMATERIAL       68    // u32 face, u32 mode
+
+    /* trace header, host byte order */
+    typedef struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        int32_t  width, height;               /* last viewport */
+        int32_t  first, count;                /* captured frame range */
+    } capHeader;
+
+    bool capEnabled();                                   // were the wrappers linked in
+    bool capOpen(char *fileName, int first, int count);  // capture frames first..first+count-1
+    void capClose();                                     // finish the trace
+    bool capState();                                     // are state changes being captured
+    bool capGeometry();                                  // is geometry being captured
+    void capSwap();                                      // note a buffer swap
+    int  capQuadric(void *quadric);                      // index of a quadric, adding it if new
+    int  capFont(void *font);                            // index of a font
+
+    // raw writers used by the wrappers
+    void capOp(uint8_t op);
+    void capU8(uint8_t v);
+    void capU32(uint32_t v);
+    void capI32(int32_t v);
+    void capF32(float v);
+    void capF64(double v);
+    void capFloats(const float *v, int n);
+    void capBytes(const void *data, uint32_t n);
+    void capRaw(const void *data, uint32_t n);
+    void capViewport(int width, int height);
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,816 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  GL command-stream capture wrappers
+ *
+ *  Linked with -Wl,--wrap for every entry point below so calls
+ *  from any module reach these first, get serialized while a
+ *  capture is running and are then passed on to the real call.
+ *  Only built by make CAPTURE=1.
+ */
+
+// standard c headers
+#include <stdbool.h>
+#include <stdint.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// capture state and writers
+#include "glCapture.h"
+
+// the real entry points, resolved by the linker
+void __real_glBegin(GLenum mode);
+void __real_glEnd();
+void __real_glVertex3i(GLint x, GLint y, GLint z);
+void __real_glVertex3d(GLdouble x, GLdouble y, GLdouble z);
+void __real_glNormal3f(GLfloat x, GLfloat y, GLfloat z);
+void __real_glTexCoord2i(GLint s, GLint t);
+void __real_glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer);
+void __real_glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void __real_glDisableClientState(GLenum array);
+void __real_glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void __real_glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void __real_glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer);
+void __real_glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
+void __real_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+void __real_glRasterPos2i(GLint x, GLint y);
+void __real_glRasterPos3i(GLint x, GLint y, GLint z);
+void __real_glutBitmapCharacter(void *font, int c);
+void __real_gluSphere(GLUquadric *q, GLdouble radius, GLint slices, GLint stacks);
+void __real_gluCylinder(GLUquadric *q, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks);
+void __real_gluDisk(GLUquadric *q, GLdouble inner, GLdouble outer, GLint slices, GLint loops);
+void __real_glutSolidTeapot(double size);
+void __real_glutSolidTorus(double inner, double outer, GLint sides, GLint rings);
+void __real_glClear(GLbitfield mask);
+void __real_glColor4d(GLdouble r, GLdouble g, GLdouble b, GLdouble a);
+void __real_glMaterialf(GLenum face, GLenum pname, GLfloat param);
+void __real_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params);
+void __real_glLightf(GLenum light, GLenum pname, GLfloat param);
+void __real_glLightfv(GLenum light, GLenum pname, const GLfloat *params);
+void __real_glLightModeli(GLenum pname, GLint param);
+void __real_glLightModelfv(GLenum pname, const GLfloat *params);
+void __real_glShadeModel(GLenum mode);
+void __real_glColorMaterial(GLenum face, GLenum mode);
+void __real_glMatrixMode(GLenum mode);
+void __real_glLoadIdentity();
+void __real_glLoadMatrixf(const GLfloat *m);
+void __real_glPushMatrix();
+void __real_glPopMatrix();
+void __real_glTranslated(GLdouble x, GLdouble y, GLdouble z);
+void __real_glRotated(GLdouble a, GLdouble x, GLdouble y, GLdouble z);
+void __real_glScaled(GLdouble x, GLdouble y, GLdouble z);
+void __real_glFrustum(GLdouble l, GLdouble r, GLdouble b, GLdouble t, GLdouble n, GLdouble f);
+void __real_gluOrtho2D(GLdouble l, GLdouble r, GLdouble b, GLdouble t);
+void __real_glViewport(GLint x, GLint y, GLsizei w, GLsizei h);
+void __real_glPushAttrib(GLbitfield mask);
+void __real_glPopAttrib();
+void __real_glEnable(GLenum cap);
+void __real_glDisable(GLenum cap);
+void __real_glBlendFunc(GLenum s, GLenum d);
+void __real_glCullFace(GLenum mode);
+void __real_glPolygonMode(GLenum face, GLenum mode);
+void __real_glHint(GLenum target, GLenum mode);
+void __real_glClearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a);
+void __real_glGenTextures(GLsizei n, GLuint *textures);
+void __real_glBindTexture(GLenum target, GLuint texture);
+void __real_glTexParameteri(GLenum target, GLenum pname, GLint param);
+void __real_glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                         GLint border, GLenum format, GLenum type, const GLvoid *pixels);
+GLUquadric *__real_gluNewQuadric();
+void __real_gluQuadricNormals(GLUquadric *q, GLenum normal);
+void __real_gluQuadricOrientation(GLUquadric *q, GLenum orientation);
+void __real_glutSwapBuffers();
+
+// interleaved array in use, its vertices are written out per draw
+GLenum      capArrayFormat  = 0;
+GLsizei     capArrayStride  = 0;
+const char *capArrayPointer = NULL;
+
+// separate arrays in use, indexed draws are written out
+// as interleaved float vertices so replay needs nothing new
+GLenum      capVertexType    = 0;
+GLsizei     capVertexStride  = 0;
+const char *capVertexPointer = NULL;
+GLenum      capTexType       = 0;
+GLsizei     capTexStride     = 0;
+const char *capTexPointer    = NULL;
+GLenum      capNormalType    = 0;
+GLsizei     capNormalStride  = 0;
+const char *capNormalPointer = NULL;
+GLenum      capColorType     = 0;
+GLsizei     capColorStride   = 0;
+const char *capColorPointer  = NULL;
+
+// bytes per vertex of an interleaved array format
+static GLsizei capFormatStride(GLenum format)
+{
+    switch (format) {
+        case GL_V2F:             return 2*sizeof(GLfloat);
+        case GL_V3F:             return 3*sizeof(GLfloat);
+        case GL_N3F_V3F:         return 6*sizeof(GLfloat);
+        case GL_T2F_V3F:         return 5*sizeof(GLfloat);
+        case GL_T2F_N3F_V3F:     return 8*sizeof(GLfloat);
+        case GL_C4F_N3F_V3F:     return 10*sizeof(GLfloat);
+        case GL_T2F_C4F_N3F_V3F: return 12*sizeof(GLfloat);
+        default:                 return 0;
+    }
+}
+
+// one component of a short or float array as a float
+static GLfloat capComponent(const char *p, GLenum type, int i)
+{
+    return (type == GL_SHORT) ? ((const GLshort*)p)[i] : ((const GLfloat*)p)[i];
+}
+
+// one component of a normal or color array, bytes scaled to one
+static GLfloat capUnit(const char *p, GLenum type, int i)
+{
+    switch (type) {
+        case GL_BYTE:          return ((const GLbyte*)p)[i] / 127.0f;
+        case GL_UNSIGNED_BYTE: return ((const GLubyte*)p)[i] / 255.0f;
+        default:               return ((const GLfloat*)p)[i];
+    }
+}
+
+// interleaved format an indexed draw is written out as, colors
+// only go with normals as no float format has one without the other
+static GLenum capElementFormat()
+{
+    bool tex = (capTexPointer != NULL), normal = (capNormalPointer != NULL);
+
+    if (normal && (capColorPointer != NULL))
+        return tex ? GL_T2F_C4F_N3F_V3F : GL_C4F_N3F_V3F;
+    if (normal)
+        return tex ? GL_T2F_N3F_V3F : GL_N3F_V3F;
+    return tex ? GL_T2F_V3F : GL_V3F;
+}
+
+// number of values behind a vector parameter
+static int capParamCount(GLenum pname)
+{
+    switch (pname) {
+        case GL_SHININESS:
+        case GL_SPOT_EXPONENT:
+        case GL_SPOT_CUTOFF:
+        case GL_CONSTANT_ATTENUATION:
+        case GL_LINEAR_ATTENUATION:
+        case GL_QUADRATIC_ATTENUATION:
+        case GL_LIGHT_MODEL_LOCAL_VIEWER:
+        case GL_LIGHT_MODEL_TWO_SIDE:
+            return 1;
+
+        case GL_SPOT_DIRECTION:
+        case GL_COLOR_INDEXES:
+            return 3;
+
+        default:
+            return 4;
+    }
+}
+
+// bytes of unsigned byte pixels with the default unpack alignment of 4
+static uint32_t capPixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    int components;
+
+    if (type != GL_UNSIGNED_BYTE)
+        return 0;
+
+    switch (format) {
+        case GL_RGBA:            components = 4; break;
+        case GL_RGB:             components = 3; break;
+        case GL_LUMINANCE_ALPHA: components = 2; break;
+        default:                 components = 1; break;
+    }
+
+    return (uint32_t)(((width*components + 3) & ~3) * height);
+}
+
+/*
+ *  geometry, captured within the frame range only
+ */
+
+void __wrap_glBegin(GLenum mode)
+{
+    if (capGeometry()) {
+        capOp(CAP_BEGIN);
+        capU32(mode);
+    }
+    __real_glBegin(mode);
+}
+
+void __wrap_glEnd()
+{
+    if (capGeometry())
+        capOp(CAP_END);
+    __real_glEnd();
+}
+
+void __wrap_glVertex3i(GLint x, GLint y, GLint z)
+{
+    if (capGeometry()) {
+        capOp(CAP_VERTEX3I);
+        capI32(x); capI32(y); capI32(z);
+    }
+    __real_glVertex3i(x, y, z);
+}
+
+void __wrap_glVertex3d(GLdouble x, GLdouble y, GLdouble z)
+{
+    if (capGeometry()) {
+        capOp(CAP_VERTEX3D);
+        capF64(x); capF64(y); capF64(z);
+    }
+    __real_glVertex3d(x, y, z);
+}
+
+void __wrap_glNormal3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    if (capGeometry()) {
+        capOp(CAP_NORMAL3F);
+        capF32(x); capF32(y); capF32(z);
+    }
+    __real_glNormal3f(x, y, z);
+}
+
+void __wrap_glTexCoord2i(GLint s, GLint t)
+{
+    if (capGeometry()) {
+        capOp(CAP_TEXCOORD2I);
+        capI32(s); capI32(t);
+    }
+    __real_glTexCoord2i(s, t);
+}
+
+void __wrap_glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer)
+{
+    capArrayFormat  = format;
+    capArrayStride  = (stride > 0) ? stride : capFormatStride(format);
+    capArrayPointer = (const char*)pointer;
+    capVertexPointer = NULL;
+    capTexPointer    = NULL;
+    capNormalPointer = NULL;
+    capColorPointer  = NULL;
+    __real_glInterleavedArrays(format, stride, pointer);
+}
+
+void __wrap_glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    capVertexType    = type;
+    capVertexStride  = (stride > 0) ? stride : 3*((type == GL_SHORT) ? sizeof(GLshort) : sizeof(GLfloat));
+    capVertexPointer = (size == 3) ? (const char*)pointer : NULL;
+    __real_glVertexPointer(size, type, stride, pointer);
+}
+
+void __wrap_glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    capTexType    = type;
+    capTexStride  = (stride > 0) ? stride : 2*((type == GL_SHORT) ? sizeof(GLshort) : sizeof(GLfloat));
+    capTexPointer = (size == 2) ? (const char*)pointer : NULL;
+    __real_glTexCoordPointer(size, type, stride, pointer);
+}
+
+void __wrap_glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    capNormalType    = type;
+    capNormalStride  = (stride > 0) ? stride : 3*((type == GL_BYTE) ? sizeof(GLbyte) : sizeof(GLfloat));
+    capNormalPointer = (const char*)pointer;
+    __real_glNormalPointer(type, stride, pointer);
+}
+
+void __wrap_glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    capColorType    = type;
+    capColorStride  = (stride > 0) ? stride : 4*((type == GL_UNSIGNED_BYTE) ? sizeof(GLubyte) : sizeof(GLfloat));
+    capColorPointer = (size == 4) ? (const char*)pointer : NULL;
+    __real_glColorPointer(size, type, stride, pointer);
+}
+
+void __wrap_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+    // the indexed vertices go in the trace as floats, in index order
+    if (capGeometry() && (capVertexPointer != NULL)) {
+        GLenum format = capElementFormat();
+        GLsizei size = capFormatStride(format);
+        GLfloat v[12];
+        GLuint index;
+        GLsizei i;
+        int n, j;
+
+        capOp(CAP_DRAWARRAYS);
+        capU32(format); capU32(mode); capI32(count);
+        capU32(size*count);
+        for (i = 0; i < count; ++i) {
+            index = (type == GL_UNSIGNED_SHORT) ? ((const GLushort*)indices)[i] : ((const GLuint*)indices)[i];
+            n = 0;
+            if (capTexPointer != NULL) {
+                v[n++] = capComponent(capTexPointer + index*capTexStride, capTexType, 0);
+                v[n++] = capComponent(capTexPointer + index*capTexStride, capTexType, 1);
+            }
+            if ((format == GL_C4F_N3F_V3F) || (format == GL_T2F_C4F_N3F_V3F))
+                for (j = 0; j < 4; ++j)
+                    v[n++] = capUnit(capColorPointer + index*capColorStride, capColorType, j);
+            if (capNormalPointer != NULL)
+                for (j = 0; j < 3; ++j)
+                    v[n++] = capUnit(capNormalPointer + index*capNormalStride, capNormalType, j);
+            v[n++] = capComponent(capVertexPointer + index*capVertexStride, capVertexType, 0);
+            v[n++] = capComponent(capVertexPointer + index*capVertexStride, capVertexType, 1);
+            v[n++] = capComponent(capVertexPointer + index*capVertexStride, capVertexType, 2);
+            capRaw(v, size);
+        }
+    }
+    __real_glDrawElements(mode, count, type, indices);
+}
+
+void __wrap_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    // the drawn vertices go in the trace, packed from zero
+    if (capGeometry() && (capArrayPointer != NULL) && (capFormatStride(capArrayFormat) > 0)) {
+        GLsizei size = capFormatStride(capArrayFormat);
+        GLsizei i;
+
+        capOp(CAP_DRAWARRAYS);
+        capU32(capArrayFormat); capU32(mode); capI32(count);
+        capU32(size*count);
+        for (i = 0; i < count; ++i)
+            capRaw(capArrayPointer + (first+i)*capArrayStride, size);
+    }
+    __real_glDrawArrays(mode, first, count);
+}
+
+void __wrap_glDisableClientState(GLenum array)
+{
+    if (array == GL_VERTEX_ARRAY)
+        capVertexPointer = NULL;
+    else if (array == GL_TEXTURE_COORD_ARRAY)
+        capTexPointer = NULL;
+    else if (array == GL_NORMAL_ARRAY)
+        capNormalPointer = NULL;
+    else if (array == GL_COLOR_ARRAY)
+        capColorPointer = NULL;
+
+    if (capState()) {
+        capOp(CAP_DISABLECLIENTSTATE);
+        capU32(array);
+    }
+    __real_glDisableClientState(array);
+}
+
+void __wrap_glRasterPos2i(GLint x, GLint y)
+{
+    if (capGeometry()) {
+        capOp(CAP_RASTERPOS2I);
+        capI32(x); capI32(y);
+    }
+    __real_glRasterPos2i(x, y);
+}
+
+void __wrap_glRasterPos3i(GLint x, GLint y, GLint z)
+{
+    if (capGeometry()) {
+        capOp(CAP_RASTERPOS3I);
+        capI32(x); capI32(y); capI32(z);
+    }
+    __real_glRasterPos3i(x, y, z);
+}
+
+void __wrap_glutBitmapCharacter(void *font, int c)
+{
+    if (capGeometry()) {
+        capOp(CAP_BITMAPCHARACTER);
+        capU8(capFont(font)); capI32(c);
+    }
+    __real_glutBitmapCharacter(font, c);
+}
+
+void __wrap_gluSphere(GLUquadric *q, GLdouble radius, GLint slices, GLint stacks)
+{
+    if (capGeometry()) {
+        capOp(CAP_SPHERE);
+        capU8(capQuadric(q)); capF64(radius); capI32(slices); capI32(stacks);
+    }
+    __real_gluSphere(q, radius, slices, stacks);
+}
+
+void __wrap_gluCylinder(GLUquadric *q, GLdouble base, GLdouble top, GLdouble height, GLint slices, GLint stacks)
+{
+    if (capGeometry()) {
+        capOp(CAP_CYLINDER);
+        capU8(capQuadric(q)); capF64(base); capF64(top); capF64(height);
+        capI32(slices); capI32(stacks);
+    }
+    __real_gluCylinder(q, base, top, height, slices, stacks);
+}
+
+void __wrap_gluDisk(GLUquadric *q, GLdouble inner, GLdouble outer, GLint slices, GLint loops)
+{
+    if (capGeometry()) {
+        capOp(CAP_DISK);
+        capU8(capQuadric(q)); capF64(inner); capF64(outer); capI32(slices); capI32(loops);
+    }
+    __real_gluDisk(q, inner, outer, slices, loops);
+}
+
+void __wrap_glutSolidTeapot(double size)
+{
+    if (capGeometry()) {
+        capOp(CAP_TEAPOT);
+        capF64(size);
+    }
+    __real_glutSolidTeapot(size);
+}
+
+void __wrap_glutSolidTorus(double inner, double outer, GLint sides, GLint rings)
+{
+    if (capGeometry()) {
+        capOp(CAP_TORUS);
+        capF64(inner); capF64(outer); capI32(sides); capI32(rings);
+    }
+    __real_glutSolidTorus(inner, outer, sides, rings);
+}
+
+void __wrap_glClear(GLbitfield mask)
+{
+    if (capGeometry()) {
+        capOp(CAP_CLEAR);
+        capU32(mask);
+    }
+    __real_glClear(mask);
+}
+
+/*
+ *  state, captured from the start
+ */
+
+void __wrap_glColor4d(GLdouble r, GLdouble g, GLdouble b, GLdouble a)
+{
+    if (capState()) {
+        capOp(CAP_COLOR4D);
+        capF64(r); capF64(g); capF64(b); capF64(a);
+    }
+    __real_glColor4d(r, g, b, a);
+}
+
+void __wrap_glMaterialf(GLenum face, GLenum pname, GLfloat param)
+{
+    if (capState()) {
+        capOp(CAP_MATERIALF);
+        capU32(face); capU32(pname); capF32(param);
+    }
+    __real_glMaterialf(face, pname, param);
+}
+
+void __wrap_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
+{
+    if (capState()) {
+        capOp(CAP_MATERIALFV);
+        capU32(face); capU32(pname); capFloats(params, capParamCount(pname));
+    }
+    __real_glMaterialfv(face, pname, params);
+}
+
+void __wrap_glLightf(GLenum light, GLenum pname, GLfloat param)
+{
+    if (capState()) {
+        capOp(CAP_LIGHTF);
+        capU32(light); capU32(pname); capF32(param);
+    }
+    __real_glLightf(light, pname, param);
+}
+
+void __wrap_glLightfv(GLenum light, GLenum pname, const GLfloat *params)
+{
+    if (capState()) {
+        capOp(CAP_LIGHTFV);
+        capU32(light); capU32(pname); capFloats(params, capParamCount(pname));
+    }
+    __real_glLightfv(light, pname, params);
+}
+
+void __wrap_glLightModeli(GLenum pname, GLint param)
+{
+    if (capState()) {
+        capOp(CAP_LIGHTMODELI);
+        capU32(pname); capI32(param);
+    }
+    __real_glLightModeli(pname, param);
+}
+
+void __wrap_glLightModelfv(GLenum pname, const GLfloat *params)
+{
+    if (capState()) {
+        capOp(CAP_LIGHTMODELFV);
+        capU32(pname); capFloats(params, capParamCount(pname));
+    }
+    __real_glLightModelfv(pname, params);
+}
+
+void __wrap_glShadeModel(GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_SHADEMODEL);
+        capU32(mode);
+    }
+    __real_glShadeModel(mode);
+}
+
+void __wrap_glColorMaterial(GLenum face, GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_COLORMATERIAL);
+        capU32(face); capU32(mode);
+    }
+    __real_glColorMaterial(face, mode);
+}
+
+void __wrap_glMatrixMode(GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_MATRIXMODE);
+        capU32(mode);
+    }
+    __real_glMatrixMode(mode);
+}
+
+void __wrap_glLoadIdentity()
+{
+    if (capState())
+        capOp(CAP_LOADIDENTITY);
+    __real_glLoadIdentity();
+}
+
+void __wrap_glLoadMatrixf(const GLfloat *m)
+{
+    if (capState()) {
+        capOp(CAP_LOADMATRIXF);
+        capFloats(m, 16);
+    }
+    __real_glLoadMatrixf(m);
+}
+
+void __wrap_glPushMatrix()
+{
+    if (capState())
+        capOp(CAP_PUSHMATRIX);
+    __real_glPushMatrix();
+}
+
+void __wrap_glPopMatrix()
+{
+    if (capState())
+        capOp(CAP_POPMATRIX);
+    __real_glPopMatrix();
+}
+
+void __wrap_glTranslated(GLdouble x, GLdouble y, GLdouble z)
+{
+    if (capState()) {
+        capOp(CAP_TRANSLATED);
+        capF64(x); capF64(y); capF64(z);
+    }
+    __real_glTranslated(x, y, z);
+}
+
+void __wrap_glRotated(GLdouble a, GLdouble x, GLdouble y, GLdouble z)
+{
+    if (capState()) {
+        capOp(CAP_ROTATED);
+        capF64(a); capF64(x); capF64(y); capF64(z);
+    }
+    __real_glRotated(a, x, y, z);
+}
+
+void __wrap_glScaled(GLdouble x, GLdouble y, GLdouble z)
+{
+    if (capState()) {
+        capOp(CAP_SCALED);
+        capF64(x); capF64(y); capF64(z);
+    }
+    __real_glScaled(x, y, z);
+}
+
+void __wrap_glFrustum(GLdouble l, GLdouble r, GLdouble b, GLdouble t, GLdouble n, GLdouble f)
+{
+    if (capState()) {
+        capOp(CAP_FRUSTUM);
+        capF64(l); capF64(r); capF64(b); capF64(t); capF64(n); capF64(f);
+    }
+    __real_glFrustum(l, r, b, t, n, f);
+}
+
+void __wrap_gluOrtho2D(GLdouble l, GLdouble r, GLdouble b, GLdouble t)
+{
+    if (capState()) {
+        capOp(CAP_ORTHO2D);
+        capF64(l); capF64(r); capF64(b); capF64(t);
+    }
+    __real_gluOrtho2D(l, r, b, t);
+}
+
+void __wrap_glViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+{
+    if (capState()) {
+        capOp(CAP_VIEWPORT);
+        capI32(x); capI32(y); capI32(w); capI32(h);
+        capViewport(x+w, y+h);
+    }
+    __real_glViewport(x, y, w, h);
+}
+
+void __wrap_glPushAttrib(GLbitfield mask)
+{
+    if (capState()) {
+        capOp(CAP_PUSHATTRIB);
+        capU32(mask);
+    }
+    __real_glPushAttrib(mask);
+}
+
+void __wrap_glPopAttrib()
+{
+    if (capState())
+        capOp(CAP_POPATTRIB);
+    __real_glPopAttrib();
+}
+
+void __wrap_glEnable(GLenum cap)
+{
+    if (capState()) {
+        capOp(CAP_ENABLE);
+        capU32(cap);
+    }
+    __real_glEnable(cap);
+}
+
+void __wrap_glDisable(GLenum cap)
+{
+    if (capState()) {
+        capOp(CAP_DISABLE);
+        capU32(cap);
+    }
+    __real_glDisable(cap);
+}
+
+void __wrap_glBlendFunc(GLenum s, GLenum d)
+{
+    if (capState()) {
+        capOp(CAP_BLENDFUNC);
+        capU32(s); capU32(d);
+    }
+    __real_glBlendFunc(s, d);
+}
+
+void __wrap_glCullFace(GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_CULLFACE);
+        capU32(mode);
+    }
+    __real_glCullFace(mode);
+}
+
+void __wrap_glPolygonMode(GLenum face, GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_POLYGONMODE);
+        capU32(face); capU32(mode);
+    }
+    __real_glPolygonMode(face, mode);
+}
+
+void __wrap_glHint(GLenum target, GLenum mode)
+{
+    if (capState()) {
+        capOp(CAP_HINT);
+        capU32(target); capU32(mode);
+    }
+    __real_glHint(target, mode);
+}
+
+void __wrap_glClearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a)
+{
+    if (capState()) {
+        capOp(CAP_CLEARCOLOR);
+        capF32(r); capF32(g); capF32(b); capF32(a);
+    }
+    __real_glClearColor(r, g, b, a);
+}
+
+void __wrap_glGenTextures(GLsizei n, GLuint *textures)
+{
+    int i;
+
+    __real_glGenTextures(n, textures);
+
+    if (capState()) {
+        capOp(CAP_GENTEXTURES);
+        capI32(n);
+        for (i = 0; i < n; ++i)
+            capU32(textures[i]);
+    }
+}
+
+void __wrap_glBindTexture(GLenum target, GLuint texture)
+{
+    if (capState()) {
+        capOp(CAP_BINDTEXTURE);
+        capU32(target); capU32(texture);
+    }
+    __real_glBindTexture(target, texture);
+}
+
+void __wrap_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+    if (capState()) {
+        capOp(CAP_TEXPARAMETERI);
+        capU32(target); capU32(pname); capI32(param);
+    }
+    __real_glTexParameteri(target, pname, param);
+}
+
+void __wrap_glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                         GLint border, GLenum format, GLenum type, const GLvoid *pixels)
+{
+    if (capState()) {
+        uint32_t bytes = (pixels != NULL) ? capPixelBytes(width, height, format, type) : 0;
+
+        capOp(CAP_TEXIMAGE2D);
+        capU32(target); capI32(level); capI32(internalFormat);
+        capI32(width); capI32(height); capI32(border);
+        capU32(format); capU32(type);
+        capBytes(pixels, bytes);
+    }
+    __real_glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+GLUquadric *__wrap_gluNewQuadric()
+{
+    GLUquadric *q = __real_gluNewQuadric();
+
+    if (capState()) {
+        capOp(CAP_NEWQUADRIC);
+        capU8(capQuadric(q));
+    }
+
+    return q;
+}
+
+void __wrap_gluQuadricNormals(GLUquadric *q, GLenum normal)
+{
+    if (capState()) {
+        capOp(CAP_QUADRICNORMALS);
+        capU8(capQuadric(q)); capU32(normal);
+    }
+    __real_gluQuadricNormals(q, normal);
+}
+
+void __wrap_gluQuadricOrientation(GLUquadric *q, GLenum orientation)
+{
+    if (capState()) {
+        capOp(CAP_QUADRICORIENTATION);
+        capU8(capQuadric(q)); capU32(orientation);
+    }
+    __real_gluQuadricOrientation(q, orientation);
+}
+
+/*
+ *  frame boundary
+ */
+
+void __wrap_glutSwapBuffers()
+{
+    __real_glutSwapBuffers();
+    capSwap();
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Per-frame OpenGL call counters
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+// prototypes and definitions
+#include "glCounters.h"
+
+// counts for the frame being drawn and the last finished frame
+unsigned long glcCounts[GLC_NUM_BUCKETS][GLC_NUM_COUNTERS];
+unsigned long glcLastCounts[GLC_NUM_BUCKETS][GLC_NUM_COUNTERS];
+
+// bucket calls are attributed to
+int glcBucket = GLC_OTHER;
+
+char *glcNames[GLC_NUM_COUNTERS] = {
+    "draws", "begins", "vertices", "materials",
+    "binds", "pushpops", "transforms", "enables"
+};
+
+// were counters compiled in
+bool glcEnabled()
+{
+#ifdef COUNT_GL_CALLS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// attribute following calls to bucket
+void glcSetBucket(int bucket)
+{
+    glcBucket = bucket;
+}
+
+// latch this frame's counts and start over
+void glcFrameEnd()
+{
+    memcpy(glcLastCounts, glcCounts, sizeof(glcCounts));
+    memset(glcCounts, 0, sizeof(glcCounts));
+}
+
+// count from the last frame
+unsigned long glcLast(int bucket, int counter)
+{
+    return glcLastCounts[bucket][counter];
+}
+
+// total over all buckets from the last frame
+unsigned long glcTotal(int counter)
+{
+    int i;
+    unsigned long total = 0;
+
+    for (i = 0; i < GLC_NUM_BUCKETS; ++i)
+        total += glcLastCounts[i][counter];
+
+    return total;
+}
+
+// name of a counter
+char *glcCounterName(int counter)
+{
+    return glcNames[counter];
+}
+
+// name of a bucket
+static char *glcBucketName(int bucket)
+{
+    return (bucket == GLC_OTHER) ? "other" : profPhaseName(bucket);
+}
+
+// print the last frame's counts per bucket
+void glcDump(FILE *fp)
+{
+    int i, j;
+
+    if (!glcEnabled()) {
+        fprintf(fp, "gl call counters not compiled in, rebuild with COUNTERS=1\n");
+        return;
+    }
+
+    fprintf(fp, "%-11s", "bucket");
+    for (j = 0; j < GLC_NUM_COUNTERS; ++j)
+        fprintf(fp, " %10s", glcNames[j]);
+    fprintf(fp, "\n");
+
+    for (i = 0; i < GLC_NUM_BUCKETS; ++i) {
+        fprintf(fp, "%-11s", glcBucketName(i));
+        for (j = 0; j < GLC_NUM_COUNTERS; ++j)
+            fprintf(fp, " %10lu", glcLastCounts[i][j]);
+        fprintf(fp, "\n");
+    }
+
+    fprintf(fp, "%-11s", "total");
+    for (j = 0; j < GLC_NUM_COUNTERS; ++j)
+        fprintf(fp, " %10lu", glcTotal(j));
+    fprintf(fp, "\n");
+}
+
+// draw the last frame's totals and the busiest buckets
+int glcDrawHUD(int y, void (*text)(int x, int y, char *t))
+{
+    int i;
+    char line[80];
+
+    if (!glcEnabled())
+        return y;
+
+    y -= PROF_HUD_LINE;
+    for (i = 0; i < GLC_NUM_COUNTERS; ++i) {
+        sprintf(line, "%-11s %10lu", glcNames[i], glcTotal(i));
+        text(10, y, line);
+        y -= PROF_HUD_LINE;
+    }
+
+    y -= PROF_HUD_LINE;
+    sprintf(line, "%-11s %8s %8s %8s", "bucket", "draws", "verts", "mtls");
+    text(10, y, line);
+    y -= PROF_HUD_LINE;
+
+    for (i = 0; i < GLC_NUM_BUCKETS; ++i) {
+        if (glcLastCounts[i][GLC_DRAWS] == 0)
+            continue;
+
+        sprintf(line, "%-11s %8lu %8lu %8lu", glcBucketName(i),
+                glcLastCounts[i][GLC_DRAWS], glcLastCounts[i][GLC_VERTICES],
+                glcLastCounts[i][GLC_MATERIALS]);
+        text(10, y, line);
+        y -= PROF_HUD_LINE;
+    }
+
+    return y;
+}
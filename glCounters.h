@@ -0,0 +1,138 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Per-frame OpenGL call counters
+ *
+ *  Include after the OpenGL headers in a module to count its draw
+ *  submissions, glBegin/glEnd pairs, vertices, material changes,
+ *  texture binds, matrix operations and enable/disable calls.
+ *  Counts are kept per frame phase, which breaks them down by
+ *  exhibit.  Build with -DCOUNT_GL_CALLS (make COUNTERS=1) to
+ *  enable counting, otherwise every call is left untouched.
+ */
+
+#ifndef GLCOUNTERS_H
+    #define GLCOUNTERS_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdio.h>
+    #include <stdbool.h>
+
+    // phases double as exhibit buckets
+    #include "profiler.h"
+
+    // calls made outside of any phase
+    #define GLC_OTHER        PROF_NUM_PHASES
+    #define GLC_NUM_BUCKETS  (PROF_NUM_PHASES+1)
+
+    // counters
+    #define GLC_DRAWS        0    // glBegin pairs and glu/glut shapes
+    #define GLC_BEGINS       1    // glBegin/glEnd pairs
+    #define GLC_VERTICES     2    // vertices, estimated for glu/glut shapes
+    #define GLC_MATERIALS    3    // glMaterial calls
+    #define GLC_BINDS        4    // texture binds
+    #define GLC_PUSHPOPS     5    // matrix pushes and pops
+    #define GLC_TRANSFORMS   6    // matrix loads, translations, rotations and scales
+    #define GLC_ENABLES      7    // glEnable and glDisable calls
+    #define GLC_NUM_COUNTERS 8
+
+    // glutSolidTeapot hides its tessellation, this is an estimate
+    #define GLC_TEAPOT_VERTICES 4096
+
+    extern unsigned long glcCounts[GLC_NUM_BUCKETS][GLC_NUM_COUNTERS];
+    extern int glcBucket;
+
+    bool glcEnabled();                                   // were counters compiled in
+    void glcSetBucket(int bucket);                       // attribute calls to a bucket
+    void glcFrameEnd();                                  // latch this frame's counts
+    unsigned long glcLast(int bucket, int counter);      // count from the last frame
+    unsigned long glcTotal(int counter);                 // total from the last frame
+    char *glcCounterName(int counter);                   // name of a counter
+    void glcDump(FILE *fp);                              // print last frame per bucket
+    int  glcDrawHUD(int y,                               // draw hud lines, returns next y
+                    void (*text)(int x, int y, char *t));
+
+    #ifdef COUNT_GL_CALLS
+        #define GLC_ADD(c, n) (glcCounts[glcBucket][c] += (n))
+
+        #define glBegin(mode)                 (GLC_ADD(GLC_DRAWS, 1), GLC_ADD(GLC_BEGINS, 1), glBegin(mode))
+        #define glVertex3i(x, y, z)           (GLC_ADD(GLC_VERTICES, 1), glVertex3i(x, y, z))
+        #define glVertex3d(x, y, z)           (GLC_ADD(GLC_VERTICES, 1), glVertex3d(x, y, z))
+        #define glMaterialf(f, p, v)          (GLC_ADD(GLC_MATERIALS, 1), glMaterialf(f, p, v))
+        #define glMaterialfv(f, p, v)         (GLC_ADD(GLC_MATERIALS, 1), glMaterialfv(f, p, v))
+        #define glBindTexture(t, id)          (GLC_ADD(GLC_BINDS, 1), glBindTexture(t, id))
+        #define glPushMatrix()                (GLC_ADD(GLC_PUSHPOPS, 1), glPushMatrix())
+        #define glPopMatrix()                 (GLC_ADD(GLC_PUSHPOPS, 1), glPopMatrix())
+        #define glTranslated(x, y, z)         (GLC_ADD(GLC_TRANSFORMS, 1), glTranslated(x, y, z))
+        #define glRotated(a, x, y, z)         (GLC_ADD(GLC_TRANSFORMS, 1), glRotated(a, x, y, z))
+        #define glScaled(x, y, z)             (GLC_ADD(GLC_TRANSFORMS, 1), glScaled(x, y, z))
+        #define glLoadMatrixf(m)              (GLC_ADD(GLC_TRANSFORMS, 1), glLoadMatrixf(m))
+        #define glEnable(cap)                 (GLC_ADD(GLC_ENABLES, 1), glEnable(cap))
+        #define glDisable(cap)                (GLC_ADD(GLC_ENABLES, 1), glDisable(cap))
+        #define glDrawArrays(m, f, n)         (GLC_ADD(GLC_DRAWS, 1), GLC_ADD(GLC_VERTICES, (n)), \
+                                               glDrawArrays(m, f, n))
+        #define glDrawElements(m, n, t, i)    (GLC_ADD(GLC_DRAWS, 1), GLC_ADD(GLC_VERTICES, (n)), \
+                                               glDrawElements(m, n, t, i))
+
+        // glu and glu shapes are one submission of many strips,
+        // slices and stacks are evaluated twice so keep them simple
+        #define gluSphere(q, r, sl, st)       (GLC_ADD(GLC_DRAWS, 1), \
+                                               GLC_ADD(GLC_VERTICES, (st)*((sl)+1)*2), \
+                                               gluSphere(q, r, sl, st))
+        #define gluCylinder(q, b, t, h, sl, st) (GLC_ADD(GLC_DRAWS, 1), \
+                                               GLC_ADD(GLC_VERTICES, (st)*((sl)+1)*2), \
+                                               gluCylinder(q, b, t, h, sl, st))
+        #define gluDisk(q, i, o, sl, lp)      (GLC_ADD(GLC_DRAWS, 1), \
+                                               GLC_ADD(GLC_VERTICES, (lp)*((sl)+1)*2), \
+                                               gluDisk(q, i, o, sl, lp))
+        #define glutSolidTorus(i, o, sd, rg)  (GLC_ADD(GLC_DRAWS, 1), \
+                                               GLC_ADD(GLC_VERTICES, (rg)*((sd)+1)*2), \
+                                               glutSolidTorus(i, o, sd, rg))
+        #define glutSolidTeapot(s)            (GLC_ADD(GLC_DRAWS, 1), \
+                                               GLC_ADD(GLC_VERTICES, GLC_TEAPOT_VERTICES), \
+                                               glutSolidTeapot(s))
+    #endif
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
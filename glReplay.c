@@ -0,0 +1,532 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  glreplay - re-execute a captured GL command stream
+ *
+ *  Loads a trace written by scimus --capture, replays the state
+ *  leading up to the captured frames once, then draws the frames
+ *  in a loop against whatever context glut provides and reports
+ *  submission and frame times as JSON.  No museum input or
+ *  animation logic runs, so a problem frame can be profiled on
+ *  any driver.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// high resolution timers
+#include "timing.h"
+
+// trace format
+#include "glCapture.h"
+
+// default times the captured frames are drawn
+#define REPLAY_LOOPS 100
+
+// the loaded trace
+uint8_t  *trace    = NULL;
+long      traceLen = 0;
+capHeader header;
+char     *traceName = NULL;
+
+// replay position, the captured frames start at frameStart
+long     pos        = 0;
+long     frameStart = 0;
+
+// names in the trace mapped to names in this context
+GLuint     *textures    = NULL;
+uint32_t    numTextures = 0;
+GLUquadric *quadrics[CAP_MAX_QUADRICS];
+void       *fonts[CAP_NUM_FONTS];
+
+// run configuration and measurements
+int     loops    = REPLAY_LOOPS;
+char   *outFile  = NULL;
+int     frame    = 0;
+double *submits  = NULL;
+double *times    = NULL;
+unsigned long commands = 0;
+
+// print usage and exit
+void usage(char *prog)
+{
+    fprintf(stderr, "usage: %s [-l loops] [-o file] trace\n", prog);
+    fprintf(stderr, "  -l  times the captured frames are drawn, default %d\n", REPLAY_LOOPS);
+    fprintf(stderr, "  -o  write JSON to file instead of standard output\n");
+    exit(EXIT_FAILURE);
+}
+
+// read the whole trace into memory
+bool load(char *fileName)
+{
+    FILE *fp;
+
+    fp = fopen(fileName, "rb");
+    if (!fp) {
+        fprintf(stderr, "glreplay: couldn't open \"%s\"!\n", fileName);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    traceLen = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    trace = malloc(traceLen);
+    if ((trace == NULL) || (fread(trace, 1, traceLen, fp) != (size_t)traceLen)) {
+        fprintf(stderr, "glreplay: couldn't read \"%s\"!\n", fileName);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    if ((traceLen < (long)sizeof(capHeader)) ||
+        (memcpy(&header, trace, sizeof(header)), header.magic != CAP_MAGIC) ||
+        (header.version != CAP_VERSION)) {
+        fprintf(stderr, "glreplay: \"%s\" is not a gl capture!\n", fileName);
+        return false;
+    }
+
+    if (header.count < 1) {
+        fprintf(stderr, "glreplay: \"%s\" holds no frames!\n", fileName);
+        return false;
+    }
+
+    pos = sizeof(capHeader);
+
+    return true;
+}
+
+// stop on a trace that ends part way through a command
+static void need(long n)
+{
+    if ((n < 0) || (pos + n > traceLen)) {
+        fprintf(stderr, "glreplay: truncated trace at offset %ld!\n", pos);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// readers, advance through the trace
+static uint8_t u8()
+{
+    need(1);
+    return trace[pos++];
+}
+
+static uint32_t u32()
+{
+    uint32_t v;
+    need(sizeof(v));
+    memcpy(&v, trace+pos, sizeof(v));
+    pos += sizeof(v);
+    return v;
+}
+
+static int32_t i32()
+{
+    int32_t v;
+    need(sizeof(v));
+    memcpy(&v, trace+pos, sizeof(v));
+    pos += sizeof(v);
+    return v;
+}
+
+static float f32()
+{
+    float v;
+    need(sizeof(v));
+    memcpy(&v, trace+pos, sizeof(v));
+    pos += sizeof(v);
+    return v;
+}
+
+static double f64()
+{
+    double v;
+    need(sizeof(v));
+    memcpy(&v, trace+pos, sizeof(v));
+    pos += sizeof(v);
+    return v;
+}
+
+// a vector of at most 16 floats
+static void floats(GLfloat *v)
+{
+    int i, n = u8();
+
+    if (n > 16) {
+        fprintf(stderr, "glreplay: %d values in a vector at offset %ld, limit is 16!\n", n, pos-1);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; ++i)
+        v[i] = f32();
+}
+
+// bytes per vertex of an interleaved array format, 0 if unknown
+static long formatStride(GLenum format)
+{
+    switch (format) {
+        case GL_V2F:             return 2*sizeof(GLfloat);
+        case GL_V3F:             return 3*sizeof(GLfloat);
+        case GL_N3F_V3F:         return 6*sizeof(GLfloat);
+        case GL_T2F_V3F:         return 5*sizeof(GLfloat);
+        case GL_T2F_N3F_V3F:     return 8*sizeof(GLfloat);
+        case GL_C4F_N3F_V3F:     return 10*sizeof(GLfloat);
+        case GL_T2F_C4F_N3F_V3F: return 12*sizeof(GLfloat);
+        default:                 return 0;
+    }
+}
+
+// font in this context
+static void *font(int i)
+{
+    if (i >= CAP_NUM_FONTS) {
+        fprintf(stderr, "glreplay: font %d at offset %ld, limit is %d!\n", i, pos-1, CAP_NUM_FONTS);
+        exit(EXIT_FAILURE);
+    }
+
+    return fonts[i];
+}
+
+// texture name in this context
+static GLuint texture(uint32_t name)
+{
+    return (name < numTextures) ? textures[name] : 0;
+}
+
+// quadric in this context, created on first use
+static GLUquadric *quadric(int i)
+{
+    if (i >= CAP_MAX_QUADRICS) {
+        fprintf(stderr, "glreplay: quadric %d at offset %ld, limit is %d!\n", i, pos-1, CAP_MAX_QUADRICS);
+        exit(EXIT_FAILURE);
+    }
+
+    if (quadrics[i] == NULL)
+        quadrics[i] = gluNewQuadric();
+
+    return quadrics[i];
+}
+
+// execute commands until the end of a frame, false at the end of the trace
+bool execute()
+{
+    int i, n;
+    GLfloat v[16];
+    GLuint names[64];
+
+    while (pos < traceLen) {
+        uint8_t op = u8();
+        ++commands;
+
+        switch (op) {
+            case CAP_SWAP:
+                return true;
+
+            case CAP_BEGIN:          glBegin(u32());                                  break;
+            case CAP_END:            glEnd();                                         break;
+            case CAP_VERTEX3I:       { GLint x = i32(), y = i32(), z = i32(); glVertex3i(x, y, z); } break;
+            case CAP_VERTEX3D:       { GLdouble x = f64(), y = f64(), z = f64(); glVertex3d(x, y, z); } break;
+            case CAP_NORMAL3F:       { GLfloat x = f32(), y = f32(), z = f32(); glNormal3f(x, y, z); } break;
+            case CAP_TEXCOORD2I:     { GLint s = i32(), t = i32(); glTexCoord2i(s, t); } break;
+            case CAP_RASTERPOS2I:    { GLint x = i32(), y = i32(); glRasterPos2i(x, y); } break;
+            case CAP_RASTERPOS3I:    { GLint x = i32(), y = i32(), z = i32(); glRasterPos3i(x, y, z); } break;
+            case CAP_BITMAPCHARACTER: { void *f = font(u8()); glutBitmapCharacter(f, i32()); } break;
+
+            case CAP_SPHERE: {
+                GLUquadric *q = quadric(u8());
+                GLdouble r = f64();
+                GLint sl = i32(), st = i32();
+                gluSphere(q, r, sl, st);
+                break;
+            }
+
+            case CAP_CYLINDER: {
+                GLUquadric *q = quadric(u8());
+                GLdouble b = f64(), t = f64(), h = f64();
+                GLint sl = i32(), st = i32();
+                gluCylinder(q, b, t, h, sl, st);
+                break;
+            }
+
+            case CAP_DISK: {
+                GLUquadric *q = quadric(u8());
+                GLdouble in = f64(), out = f64();
+                GLint sl = i32(), lp = i32();
+                gluDisk(q, in, out, sl, lp);
+                break;
+            }
+
+            case CAP_TEAPOT:         glutSolidTeapot(f64());                          break;
+
+            case CAP_TORUS: {
+                GLdouble in = f64(), out = f64();
+                GLint sd = i32(), rg = i32();
+                glutSolidTorus(in, out, sd, rg);
+                break;
+            }
+
+            case CAP_CLEAR:          glClear(u32());                                  break;
+
+            case CAP_DRAWARRAYS: {
+                GLenum format = u32(), mode = u32();
+                GLsizei count = i32();
+                uint32_t bytes = u32();
+
+                need(bytes);
+                if ((formatStride(format) == 0) || (count < 0) ||
+                    ((long)count * formatStride(format) > (long)bytes)) {
+                    fprintf(stderr, "glreplay: %d vertices don't fit in %u bytes at offset %ld!\n", count, bytes, pos);
+                    exit(EXIT_FAILURE);
+                }
+                glInterleavedArrays(format, 0, trace+pos);
+                glDrawArrays(mode, 0, count);
+                pos += bytes;
+                break;
+            }
+
+            case CAP_COLOR4D:        { GLdouble r = f64(), g = f64(), b = f64(), a = f64(); glColor4d(r, g, b, a); } break;
+            case CAP_MATERIALF:      { GLenum f = u32(), p = u32(); glMaterialf(f, p, f32()); } break;
+            case CAP_MATERIALFV:     { GLenum f = u32(), p = u32(); floats(v); glMaterialfv(f, p, v); } break;
+            case CAP_LIGHTF:         { GLenum l = u32(), p = u32(); glLightf(l, p, f32()); } break;
+            case CAP_LIGHTFV:        { GLenum l = u32(), p = u32(); floats(v); glLightfv(l, p, v); } break;
+            case CAP_LIGHTMODELI:    { GLenum p = u32(); glLightModeli(p, i32()); } break;
+            case CAP_LIGHTMODELFV:   { GLenum p = u32(); floats(v); glLightModelfv(p, v); } break;
+            case CAP_SHADEMODEL:     glShadeModel(u32());                             break;
+            case CAP_COLORMATERIAL:  { GLenum face = u32(); glColorMaterial(face, u32()); } break;
+            case CAP_MATRIXMODE:     glMatrixMode(u32());                             break;
+            case CAP_LOADIDENTITY:   glLoadIdentity();                                break;
+            case CAP_LOADMATRIXF:    floats(v); glLoadMatrixf(v);                     break;
+            case CAP_PUSHMATRIX:     glPushMatrix();                                  break;
+            case CAP_POPMATRIX:      glPopMatrix();                                   break;
+            case CAP_TRANSLATED:     { GLdouble x = f64(), y = f64(), z = f64(); glTranslated(x, y, z); } break;
+            case CAP_ROTATED:        { GLdouble a = f64(), x = f64(), y = f64(), z = f64(); glRotated(a, x, y, z); } break;
+            case CAP_SCALED:         { GLdouble x = f64(), y = f64(), z = f64(); glScaled(x, y, z); } break;
+
+            case CAP_FRUSTUM: {
+                GLdouble l = f64(), r = f64(), b = f64(), t = f64(), n = f64(), f = f64();
+                glFrustum(l, r, b, t, n, f);
+                break;
+            }
+
+            case CAP_ORTHO2D:        { GLdouble l = f64(), r = f64(), b = f64(), t = f64(); gluOrtho2D(l, r, b, t); } break;
+            case CAP_VIEWPORT:       { GLint x = i32(), y = i32(), w = i32(), h = i32(); glViewport(x, y, w, h); } break;
+            case CAP_PUSHATTRIB:     glPushAttrib(u32());                             break;
+            case CAP_POPATTRIB:      glPopAttrib();                                   break;
+            case CAP_ENABLE:         glEnable(u32());                                 break;
+            case CAP_DISABLE:        glDisable(u32());                                break;
+            case CAP_BLENDFUNC:      { GLenum s = u32(); glBlendFunc(s, u32()); } break;
+            case CAP_CULLFACE:       glCullFace(u32());                               break;
+            case CAP_POLYGONMODE:    { GLenum f = u32(); glPolygonMode(f, u32()); } break;
+            case CAP_HINT:           { GLenum t = u32(); glHint(t, u32()); } break;
+            case CAP_CLEARCOLOR:     { GLfloat r = f32(), g = f32(), b = f32(), a = f32(); glClearColor(r, g, b, a); } break;
+
+            case CAP_GENTEXTURES:
+                n = i32();
+                if (n > 64) {
+                    fprintf(stderr, "glreplay: %d textures generated at once, limit is 64.\n", n);
+                    exit(EXIT_FAILURE);
+                }
+                glGenTextures(n, names);
+                for (i = 0; i < n; ++i) {
+                    uint32_t name = u32();
+
+                    if (name >= numTextures) {
+                        textures = realloc(textures, sizeof(GLuint) * (name+1));
+                        memset(textures+numTextures, 0, sizeof(GLuint) * (name+1-numTextures));
+                        numTextures = name+1;
+                    }
+                    textures[name] = names[i];
+                }
+                break;
+
+            case CAP_BINDTEXTURE:    { GLenum t = u32(); glBindTexture(t, texture(u32())); } break;
+            case CAP_TEXPARAMETERI:  { GLenum t = u32(), p = u32(); glTexParameteri(t, p, i32()); } break;
+
+            case CAP_TEXIMAGE2D: {
+                GLenum target = u32();
+                GLint level = i32(), internal = i32();
+                GLsizei w = i32(), h = i32();
+                GLint border = i32();
+                GLenum format = u32(), type = u32();
+                uint32_t bytes = u32();
+
+                need(bytes);
+                glTexImage2D(target, level, internal, w, h, border, format, type,
+                             (bytes > 0) ? trace+pos : NULL);
+                pos += bytes;
+                break;
+            }
+
+            case CAP_NEWQUADRIC:     quadric(u8());                                   break;
+            case CAP_QUADRICNORMALS: { GLUquadric *q = quadric(u8()); gluQuadricNormals(q, u32()); } break;
+            case CAP_QUADRICORIENTATION: { GLUquadric *q = quadric(u8()); gluQuadricOrientation(q, u32()); } break;
+            case CAP_DISABLECLIENTSTATE: glDisableClientState(u32());                 break;
+
+            default:
+                fprintf(stderr, "glreplay: unknown command %d at offset %ld!\n", op, pos-1);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    return false;
+}
+
+// write results as JSON
+void report()
+{
+    int total = loops * header.count;
+    FILE *fp = stdout;
+
+    timeSort(submits, total);
+    timeSort(times, total);
+
+    if ((outFile != NULL) && (strcmp(outFile, "-") != 0)) {
+        fp = fopen(outFile, "w");
+        if (!fp) {
+            fprintf(stderr, "glreplay: couldn't open \"%s\"!\n", outFile);
+            fp = stdout;
+        }
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"trace\": \"%s\",\n", traceName);
+    fprintf(fp, "  \"renderer\": \"%s\",\n", (char *)glGetString(GL_RENDERER));
+    fprintf(fp, "  \"captured_frames\": %d,\n", header.count);
+    fprintf(fp, "  \"loops\": %d,\n", loops);
+    fprintf(fp, "  \"commands_per_frame\": %.1f,\n", (double)commands/total);
+    fprintf(fp, "  \"submit_p50_ms\": %.3f,\n", timePercentile(submits, total, 50.0));
+    fprintf(fp, "  \"submit_p95_ms\": %.3f,\n", timePercentile(submits, total, 95.0));
+    fprintf(fp, "  \"frame_p50_ms\": %.3f,\n", timePercentile(times, total, 50.0));
+    fprintf(fp, "  \"frame_p95_ms\": %.3f,\n", timePercentile(times, total, 95.0));
+    fprintf(fp, "  \"frame_p99_ms\": %.3f,\n", timePercentile(times, total, 99.0));
+    fprintf(fp, "  \"frame_max_ms\": %.3f\n", times[total-1]);
+    fprintf(fp, "}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+}
+
+// draw one captured frame per redisplay
+void display()
+{
+    double start, submitted;
+
+    // first time through bring the context up to the captured state
+    if (frameStart == 0) {
+        int skipped = 0;
+
+        while ((skipped < header.first) && execute())
+            ++skipped;
+
+        frameStart = pos;
+        commands   = 0;
+    }
+
+    // frames loop back to the first captured one
+    if (frame % header.count == 0)
+        pos = frameStart;
+
+    start = timeNow();
+    execute();
+    submitted = timeNow();
+
+    glutSwapBuffers();
+    glFinish();
+
+    submits[frame] = submitted - start;
+    times[frame]   = timeNow() - start;
+
+    if (++frame == loops * header.count) {
+        report();
+        exit(EXIT_SUCCESS);
+    }
+
+    glutPostRedisplay();
+}
+
+int main(int nargs, char *args[])
+{
+    int c;
+
+    glutInit(&nargs, args);
+
+    while ((c = getopt(nargs, args, "l:o:")) != -1) {
+        switch (c) {
+            case 'l': loops = atoi(optarg);     break;
+            case 'o': outFile = optarg;         break;
+            default:  usage(args[0]);
+        }
+    }
+
+    if ((optind != nargs-1) || (loops < 1))
+        usage(args[0]);
+
+    traceName = args[optind];
+    if (!load(traceName))
+        return EXIT_FAILURE;
+
+    submits = malloc(sizeof(double) * loops * header.count);
+    times   = malloc(sizeof(double) * loops * header.count);
+    if ((submits == NULL) || (times == NULL)) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d frame times.\n", loops * header.count);
+        return EXIT_FAILURE;
+    }
+
+    fonts[CAP_FONT_8_BY_13]        = GLUT_BITMAP_8_BY_13;
+    fonts[CAP_FONT_9_BY_15]        = GLUT_BITMAP_9_BY_15;
+    fonts[CAP_FONT_TIMES_ROMAN_10] = GLUT_BITMAP_TIMES_ROMAN_10;
+    fonts[CAP_FONT_TIMES_ROMAN_24] = GLUT_BITMAP_TIMES_ROMAN_24;
+    fonts[CAP_FONT_HELVETICA_10]   = GLUT_BITMAP_HELVETICA_10;
+    fonts[CAP_FONT_HELVETICA_12]   = GLUT_BITMAP_HELVETICA_12;
+    fonts[CAP_FONT_HELVETICA_18]   = GLUT_BITMAP_HELVETICA_18;
+
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
+    glutInitWindowSize((header.width > 0) ? header.width : 800,
+                       (header.height > 0) ? header.height : 600);
+    glutCreateWindow("glreplay");
+    glutDisplayFunc(display);
+
+    glutMainLoop();
+
+    return EXIT_SUCCESS;
+}
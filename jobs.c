@@ -0,0 +1,486 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Work stealing job system
+ *
+ *  A pool of worker threads, each with its own deque of jobs.  A
+ *  thread pushes and pops jobs at the bottom of its own deque and,
+ *  once that is empty, steals the oldest job from the top of
+ *  another's, so big pieces of work spread out while the small
+ *  ones split off them stay local.  A thread waiting for jobs to
+ *  finish runs jobs itself instead of blocking, which makes fork
+ *  and join nest freely.  On top of that are a parallel for that
+ *  splits a range in halves on demand and small graphs of jobs
+ *  that each start once the jobs they follow are done.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// high resolution timers
+#include "timing.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// prototypes and definitions
+#include "jobs.h"
+
+/* one thread's deque and totals, a cache line apart from the next */
+typedef struct {
+    pthread_mutex_t lock;
+    job             jobs[JOB_QUEUE_SIZE];
+    int             top, bottom;            /* stolen from the top, owned at the bottom */
+    _Atomic double  busy;                   /* ms spent running jobs */
+    double          busyMark;               /* busy at the last frame mark */
+    double          utilization;            /* busy fraction of the last frame */
+    atomic_long     run;
+    atomic_long     stolen;
+} __attribute__((aligned(64))) jobWorker;
+
+// slot 0 belongs to whichever thread submits from outside the pool
+jobWorker jobWorkers[JOB_MAX_WORKERS+1];
+pthread_t jobThreads[JOB_MAX_WORKERS+1];
+int       jobCount = 1;
+
+// slot of the calling thread and how deeply its jobs are nested
+__thread int jobSelf  = 0;
+__thread int jobDepth = 0;
+
+// idle workers sleep here until a job is pushed
+pthread_mutex_t jobSleepLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  jobWake      = PTHREAD_COND_INITIALIZER;
+atomic_int      jobSleepers  = 0;
+bool            jobQuit      = false;
+
+// start of the current utilization window
+double jobMarkTime = -1.0;
+
+// queue a job on the calling thread's deque, or run it if that is full
+static void jobPush(job *j)
+{
+    jobWorker *w = &jobWorkers[jobSelf];
+    bool queued = false;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom - w->top < JOB_QUEUE_SIZE) {
+        w->jobs[w->bottom & (JOB_QUEUE_SIZE-1)] = *j;
+        ++w->bottom;
+        queued = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    if (!queued) {
+        j->func(j->arg, j->begin, j->end);
+        atomic_fetch_sub(&j->done->pending, 1);
+        return;
+    }
+
+    if (atomic_load(&jobSleepers) > 0) {
+        pthread_mutex_lock(&jobSleepLock);
+        pthread_cond_signal(&jobWake);
+        pthread_mutex_unlock(&jobSleepLock);
+    }
+}
+
+// take the newest job from the bottom of a thread's own deque
+static bool jobPop(jobWorker *w, job *j)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom > w->top) {
+        --w->bottom;
+        *j = w->jobs[w->bottom & (JOB_QUEUE_SIZE-1)];
+        found = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return found;
+}
+
+// take the oldest job from the top of another thread's deque
+static bool jobSteal(jobWorker *w, job *j)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom > w->top) {
+        *j = w->jobs[w->top & (JOB_QUEUE_SIZE-1)];
+        ++w->top;
+        found = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return found;
+}
+
+// find a job, own ones first
+static bool jobFind(job *j)
+{
+    int i;
+
+    if (jobPop(&jobWorkers[jobSelf], j))
+        return true;
+
+    for (i = 1; i < jobCount; ++i)
+        if (jobSteal(&jobWorkers[(jobSelf+i) % jobCount], j)) {
+            atomic_fetch_add(&jobWorkers[jobSelf].stolen, 1);
+            return true;
+        }
+
+    return false;
+}
+
+// is any job waiting in any deque
+static bool jobQueued()
+{
+    int i;
+    bool queued = false;
+
+    for (i = 0; (i < jobCount) && !queued; ++i) {
+        pthread_mutex_lock(&jobWorkers[i].lock);
+        queued = jobWorkers[i].bottom > jobWorkers[i].top;
+        pthread_mutex_unlock(&jobWorkers[i].lock);
+    }
+
+    return queued;
+}
+
+// run a job, first leaving the far half of a long range for
+// others to steal until what is left is no longer than the grain
+static void jobExecute(job *j)
+{
+    jobWorker *w = &jobWorkers[jobSelf];
+    job rest;
+    double start = 0.0;
+
+    // nested jobs are already inside the outer job's time
+    if (jobDepth++ == 0)
+        start = timeNow();
+
+    while (j->end - j->begin > j->grain) {
+        rest = *j;
+        rest.begin = j->begin + (j->end - j->begin)/2;
+        j->end = rest.begin;
+
+        atomic_fetch_add(&j->done->pending, 1);
+        jobPush(&rest);
+    }
+
+    j->func(j->arg, j->begin, j->end);
+    atomic_fetch_add(&w->run, 1);
+
+    if (--jobDepth == 0)
+        atomic_store(&w->busy, atomic_load(&w->busy) + timeNow() - start);
+
+    atomic_fetch_sub(&j->done->pending, 1);
+}
+
+// worker thread, runs jobs and sleeps when there are none
+static void *jobWorkerLoop(void *arg)
+{
+    job j;
+    int spins = 0;
+
+    jobSelf = (int)(intptr_t)arg;
+    traceThreadName("jobs");
+
+    for (;;) {
+        if (jobFind(&j)) {
+            jobExecute(&j);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < JOB_SPINS) {
+            sched_yield();
+            continue;
+        }
+
+        // counted as asleep before looking again so no push is missed
+        pthread_mutex_lock(&jobSleepLock);
+        atomic_fetch_add(&jobSleepers, 1);
+        while (!jobQuit && !jobQueued())
+            pthread_cond_wait(&jobWake, &jobSleepLock);
+        atomic_fetch_sub(&jobSleepers, 1);
+        pthread_mutex_unlock(&jobSleepLock);
+
+        if (jobQuit)
+            break;
+        spins = 0;
+    }
+
+    return NULL;
+}
+
+// start workers, -1 for one per core besides the calling thread's
+bool jobInit(int workers)
+{
+    int i;
+
+    jobFree();
+
+    if (workers < 0)
+        workers = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    if (workers < 0)
+        workers = 0;
+    if (workers > JOB_MAX_WORKERS)
+        workers = JOB_MAX_WORKERS;
+
+    for (i = 0; i <= JOB_MAX_WORKERS; ++i) {
+        pthread_mutex_init(&jobWorkers[i].lock, NULL);
+        jobWorkers[i].top = jobWorkers[i].bottom = 0;
+        atomic_store(&jobWorkers[i].busy, 0.0);
+        jobWorkers[i].busyMark    = 0.0;
+        jobWorkers[i].utilization = 0.0;
+        atomic_store(&jobWorkers[i].run, 0);
+        atomic_store(&jobWorkers[i].stolen, 0);
+    }
+
+    jobQuit  = false;
+    jobCount = 1;
+    for (i = 1; i <= workers; ++i) {
+        if (pthread_create(&jobThreads[i], NULL, jobWorkerLoop, (void*)(intptr_t)i) != 0) {
+            fprintf(stderr, "warning: started only %d of %d job workers\n", i-1, workers);
+            break;
+        }
+        jobCount = i+1;
+    }
+
+    jobMarkTime = timeNow();
+
+    return true;
+}
+
+// stop the workers, jobs still queued are never run
+void jobFree()
+{
+    int i;
+
+    if (jobCount <= 1)
+        return;
+
+    pthread_mutex_lock(&jobSleepLock);
+    jobQuit = true;
+    pthread_cond_broadcast(&jobWake);
+    pthread_mutex_unlock(&jobSleepLock);
+
+    for (i = 1; i < jobCount; ++i)
+        pthread_join(jobThreads[i], NULL);
+    jobCount = 1;
+}
+
+// threads that run jobs, the one submitting them included
+int jobNumWorkers()
+{
+    return jobCount;
+}
+
+// run func on items begin..end-1 as one job on whichever thread gets
+// to it first, done counts it until it has finished
+void jobRun(jobFunc func, void *arg, int begin, int end, jobCounter *done)
+{
+    job j;
+
+    j.func  = func;
+    j.arg   = arg;
+    j.begin = begin;
+    j.end   = end;
+    j.grain = (end - begin > 1) ? end - begin : 1;
+    j.done  = done;
+
+    atomic_fetch_add(&done->pending, 1);
+    jobPush(&j);
+}
+
+// run jobs, from any deque, until every job counted by done has finished
+void jobWait(jobCounter *done)
+{
+    job j;
+
+    while (atomic_load(&done->pending) > 0) {
+        if (jobFind(&j))
+            jobExecute(&j);
+        else
+            sched_yield();
+    }
+}
+
+// run func over begin..end-1 in pieces of at most grain items,
+// split off as other threads come looking for work, and wait for all
+void jobParallelFor(jobFunc func, void *arg, int begin, int end, int grain)
+{
+    jobCounter done;
+    job j;
+
+    if (end <= begin)
+        return;
+
+    atomic_init(&done.pending, 1);
+
+    j.func  = func;
+    j.arg   = arg;
+    j.begin = begin;
+    j.end   = end;
+    j.grain = (grain > 0) ? grain : 1;
+    j.done  = &done;
+
+    jobExecute(&j);
+    jobWait(&done);
+}
+
+// empty a graph
+void jobGraphInit(jobGraph *g)
+{
+    g->numNodes = 0;
+    atomic_init(&g->done.pending, 0);
+}
+
+// add a step calling func(arg), returns its index or -1 if the graph is full
+int jobGraphAdd(jobGraph *g, void (*func)(void *arg), void *arg)
+{
+    jobNode *n;
+
+    if (g->numNodes == JOB_MAX_NODES) {
+        fprintf(stderr, "warning: more than %d steps in a job graph\n", JOB_MAX_NODES);
+        return -1;
+    }
+
+    n = &g->nodes[g->numNodes];
+    n->func      = func;
+    n->arg       = arg;
+    n->numBefore = 0;
+    n->numNext   = 0;
+    n->graph     = g;
+
+    return g->numNodes++;
+}
+
+// have a step start only once another is done
+void jobGraphAfter(jobGraph *g, int node, int before)
+{
+    jobNode *b;
+
+    if ((node < 0) || (before < 0))
+        return;
+
+    b = &g->nodes[before];
+    if (b->numNext == JOB_MAX_NEXT) {
+        fprintf(stderr, "warning: more than %d steps follow one job graph step\n", JOB_MAX_NEXT);
+        return;
+    }
+
+    b->next[b->numNext++] = node;
+    ++g->nodes[node].numBefore;
+}
+
+// run one step then start whatever it was the last to wait for
+static void jobGraphStep(void *arg, int begin, int end)
+{
+    jobNode *n = (jobNode*)arg;
+    jobNode *next;
+    int i;
+
+    n->func(n->arg);
+
+    for (i = 0; i < n->numNext; ++i) {
+        next = &n->graph->nodes[n->next[i]];
+        if (atomic_fetch_sub(&next->waiting, 1) == 1)
+            jobRun(jobGraphStep, next, 0, 1, &n->graph->done);
+    }
+}
+
+// run every step of a graph in order and wait for them all
+void jobGraphRun(jobGraph *g)
+{
+    int i;
+
+    for (i = 0; i < g->numNodes; ++i)
+        atomic_store(&g->nodes[i].waiting, g->nodes[i].numBefore);
+
+    for (i = 0; i < g->numNodes; ++i)
+        if (g->nodes[i].numBefore == 0)
+            jobRun(jobGraphStep, &g->nodes[i], 0, 1, &g->done);
+
+    jobWait(&g->done);
+}
+
+// end one frame's utilization window and start the next
+void jobFrameMark()
+{
+    int i;
+    double now = timeNow(), busy, window;
+
+    window = now - jobMarkTime;
+    if (window <= 0.0)
+        return;
+
+    for (i = 0; i < jobCount; ++i) {
+        busy = atomic_load(&jobWorkers[i].busy);
+        jobWorkers[i].utilization = (busy - jobWorkers[i].busyMark) / window;
+        jobWorkers[i].busyMark    = busy;
+    }
+
+    jobMarkTime = now;
+}
+
+// fraction of the last frame a worker spent running jobs,
+// worker 0 is the thread that submits them
+double jobUtilization(int worker)
+{
+    if ((worker < 0) || (worker >= jobCount))
+        return 0.0;
+
+    return jobWorkers[worker].utilization;
+}
+
+// jobs a worker has run
+long jobNumRun(int worker)
+{
+    if ((worker < 0) || (worker >= jobCount))
+        return 0;
+
+    return atomic_load(&jobWorkers[worker].run);
+}
+
+// jobs a worker took from another's deque
+long jobNumStolen(int worker)
+{
+    if ((worker < 0) || (worker >= jobCount))
+        return 0;
+
+    return atomic_load(&jobWorkers[worker].stolen);
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Work stealing job system
+ *
+ *  A pool of worker threads, each with its own deque of jobs.  A
+ *  thread pushes and pops jobs at the bottom of its own deque and,
+ *  once that is empty, steals the oldest job from the top of
+ *  another's, so big pieces of work spread out while the small
+ *  ones split off them stay local.  A thread waiting for jobs to
+ *  finish runs jobs itself instead of blocking, which makes fork
+ *  and join nest freely.  On top of that are a parallel for that
+ *  splits a range in halves on demand and small graphs of jobs
+ *  that each start once the jobs they follow are done.
+ */
+
+#ifndef JOBS_H
+    #define JOBS_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+    #include <stdatomic.h>
+
+    // worker threads besides the one submitting, -1 for one per spare core
+    #define JOB_DEFAULT_WORKERS -1
+    #define JOB_MAX_WORKERS     16
+
+    // jobs one deque holds, a power of two
+    #define JOB_QUEUE_SIZE 256
+
+    // fruitless looks for work before a worker sleeps
+    #define JOB_SPINS 64
+
+    // nodes in a graph and the jobs each may start
+    #define JOB_MAX_NODES 16
+    #define JOB_MAX_NEXT  8
+
+    /* work on items begin..end-1 of whatever arg points to */
+    typedef void (*jobFunc)(void *arg, int begin, int end);
+
+    /* jobs still running, waited on by jobWait */
+    typedef struct {
+        atomic_int pending;
+    } jobCounter;
+
+    /* one piece of work */
+    typedef struct {
+        jobFunc     func;
+        void       *arg;
+        int         begin, end;
+        int         grain;                  /* split ranges longer than this */
+        jobCounter *done;
+    } job;
+
+    /* one step of a graph */
+    typedef struct jobGraph jobGraph;
+    typedef struct {
+        void      (*func)(void *arg);
+        void       *arg;
+        int         numBefore;              /* steps it follows */
+        int         numNext;
+        int         next[JOB_MAX_NEXT];     /* steps that follow it */
+        atomic_int  waiting;                /* steps it still waits for */
+        jobGraph   *graph;
+    } jobNode;
+
+    /* steps run in dependency order, as parallel as it allows */
+    struct jobGraph {
+        int         numNodes;
+        jobNode     nodes[JOB_MAX_NODES];
+        jobCounter  done;
+    };
+
+    bool   jobInit(int workers);                         // start the workers
+    void   jobFree();                                    // stop the workers
+    int    jobNumWorkers();                              // threads running jobs, the submitter included
+    void   jobRun(jobFunc func, void *arg,               // run func(arg, begin, end) on some thread
+                  int begin, int end, jobCounter *done);
+    void   jobWait(jobCounter *done);                    // run jobs until done has none pending
+    void   jobParallelFor(jobFunc func, void *arg,       // split begin..end-1 into grain sized jobs and wait
+                          int begin, int end, int grain);
+    void   jobGraphInit(jobGraph *g);                    // empty a graph
+    int    jobGraphAdd(jobGraph *g,                      // add a step, returns its index
+                       void (*func)(void *arg), void *arg);
+    void   jobGraphAfter(jobGraph *g, int node,          // node starts once before is done
+                         int before);
+    void   jobGraphRun(jobGraph *g);                     // run every step and wait
+    void   jobFrameMark();                               // close one frame's utilization window
+    double jobUtilization(int worker);                   // busy fraction of a worker last frame
+    long   jobNumRun(int worker);                        // jobs a worker has run
+    long   jobNumStolen(int worker);                     // jobs a worker took from another
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
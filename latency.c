@@ -0,0 +1,255 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Input-to-photon latency measurement
+ *
+ *  Timestamps each input event, follows it to the first frame
+ *  whose swap shows the resulting camera change and reports the
+ *  latency distribution as JSON.  A synthetic injector can press
+ *  keys on a timer so the measurement runs unattended.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// 3d navigation
+#include "navigator.h"
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "latency.h"
+
+// run configuration
+bool  latRunning   = false;
+bool  latInjecting = false;
+int   latSamples   = LAT_DEFAULT_SAMPLES;
+char *latOut       = NULL;
+
+// events still waiting for their frame
+latEvent latPending[LAT_MAX_PENDING];
+int      latNumPending = 0;
+
+// measurements
+double *latTimes    = NULL;
+int     latNumTimes = 0;
+int     latExpired  = 0;
+int     latOverflow = 0;
+int     latInjected = 0;
+
+// configure the measurement
+// vsync is left alone since it is part of what we measure
+void latInit(int samples, char *outFile, bool inject)
+{
+    if (samples > 0)
+        latSamples = samples;
+
+    latOut       = outFile;
+    latInjecting = inject;
+
+    latTimes = malloc(sizeof(double) * latSamples);
+    if (latTimes == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d latency samples.\n", latSamples);
+        exit(EXIT_FAILURE);
+    }
+
+    latRunning = true;
+}
+
+// release the synthetic key, alternating direction keeps the camera in place
+static void latInjectRelease(int key)
+{
+    navInjectSpecial(key, false, 0);
+}
+
+// press a synthetic key and schedule the next one
+static void latInjectPress(int value)
+{
+    int key = (value & 1) ? GLUT_KEY_RIGHT : GLUT_KEY_LEFT;
+
+    if (!latRunning)
+        return;
+
+    ++latInjected;
+    navInjectSpecial(key, true, 0);
+
+    glutTimerFunc(LAT_INJECT_HOLD, latInjectRelease, key);
+    glutTimerFunc(LAT_INJECT_PERIOD, latInjectPress, value+1);
+}
+
+// begin injecting input
+void latStart()
+{
+    if (latInjecting)
+        glutTimerFunc(LAT_INJECT_PERIOD, latInjectPress, 0);
+}
+
+// is a measurement running
+bool latActive()
+{
+    return latRunning;
+}
+
+// note an input event
+// only presses and pointer motion start a change
+void latInput(int type, int key, int state)
+{
+    latEvent *e;
+
+    if (!latRunning)
+        return;
+
+    if ((type == NAV_INPUT_KEY_UP) || (type == NAV_INPUT_SPECIAL_UP))
+        return;
+
+    if ((type == NAV_INPUT_MOUSE) && (state != GLUT_DOWN))
+        return;
+
+    if (latNumPending == LAT_MAX_PENDING) {
+        ++latOverflow;
+        return;
+    }
+
+    e = &latPending[latNumPending++];
+    e->type    = type;
+    e->time    = timeNow();
+    e->version = navStateVersion();
+    e->drawn   = false;
+}
+
+// note the state being drawn
+// any event that has seen the camera change since it arrived
+// is reflected in this frame
+void latFrameBegin()
+{
+    int i;
+    long version = navStateVersion();
+
+    for (i = 0; i < latNumPending; ++i)
+        if (latPending[i].version != version)
+            latPending[i].drawn = true;
+}
+
+// post-swap call-back
+// finishing makes the timestamp mark when the frame is on its way to the screen
+void latFrameDone()
+{
+    int i, kept = 0;
+    double now;
+
+    if (!latRunning)
+        return;
+
+    glFinish();
+    now = timeNow();
+
+    for (i = 0; i < latNumPending; ++i) {
+        latEvent *e = &latPending[i];
+
+        if (e->drawn) {
+            if (latNumTimes < latSamples)
+                latTimes[latNumTimes++] = now - e->time;
+        }
+        else if (now - e->time > LAT_TIMEOUT)
+            ++latExpired;
+        else
+            latPending[kept++] = *e;
+    }
+    latNumPending = kept;
+
+    if (latNumTimes >= latSamples) {
+        latRunning = false;
+        latReport();
+        exit(EXIT_SUCCESS);
+    }
+}
+
+// write results as JSON
+void latReport()
+{
+    int i;
+    double total = 0.0;
+    double *sorted;
+    FILE *fp = stdout;
+
+    if (latNumTimes == 0) {
+        fprintf(stderr, "error: no latency samples collected!\n");
+        return;
+    }
+
+    sorted = malloc(sizeof(double) * latNumTimes);
+    if (sorted == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d latency samples.\n", latNumTimes);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(sorted, latTimes, sizeof(double) * latNumTimes);
+    timeSort(sorted, latNumTimes);
+
+    for (i = 0; i < latNumTimes; ++i)
+        total += latTimes[i];
+
+    if ((latOut != NULL) && (strcmp(latOut, "-") != 0)) {
+        fp = fopen(latOut, "w");
+        if (!fp) {
+            fprintf(stderr, "error: couldn't open \"%s\"!\n", latOut);
+            fp = stdout;
+        }
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"samples\": %d,\n", latNumTimes);
+    fprintf(fp, "  \"injected\": %s,\n", latInjecting ? "true" : "false");
+    fprintf(fp, "  \"injected_presses\": %d,\n", latInjected);
+    fprintf(fp, "  \"expired\": %d,\n", latExpired);
+    fprintf(fp, "  \"overflow\": %d,\n", latOverflow);
+    fprintf(fp, "  \"avg_ms\": %.3f,\n", total/latNumTimes);
+    fprintf(fp, "  \"min_ms\": %.3f,\n", sorted[0]);
+    fprintf(fp, "  \"p50_ms\": %.3f,\n", timePercentile(sorted, latNumTimes, 50.0));
+    fprintf(fp, "  \"p95_ms\": %.3f,\n", timePercentile(sorted, latNumTimes, 95.0));
+    fprintf(fp, "  \"p99_ms\": %.3f,\n", timePercentile(sorted, latNumTimes, 99.0));
+    fprintf(fp, "  \"max_ms\": %.3f\n", sorted[latNumTimes-1]);
+    fprintf(fp, "}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+
+    free(sorted);
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Input-to-photon latency measurement
+ *
+ *  Timestamps each input event, follows it to the first frame
+ *  whose swap shows the resulting camera change and reports the
+ *  latency distribution as JSON.  A synthetic injector can press
+ *  keys on a timer so the measurement runs unattended.
+ */
+
+#ifndef LATENCY_H
+    #define LATENCY_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // default number of latency samples collected
+    #define LAT_DEFAULT_SAMPLES 200
+
+    // input events tracked at once
+    #define LAT_MAX_PENDING 64
+
+    // ms after which an event that changed nothing is dropped
+    #define LAT_TIMEOUT 1000.0
+
+    // ms between synthetic key presses and how long each is held
+    #define LAT_INJECT_PERIOD 250
+    #define LAT_INJECT_HOLD   100
+
+    /* an input event waiting to reach the screen */
+    typedef struct {
+        int    type;        /* NAV_INPUT_* */
+        double time;        /* ms when the event arrived */
+        long   version;     /* navigator state version at arrival */
+        bool   drawn;       /* change is in the frame being drawn */
+    } latEvent;
+
+    void latInit(int samples, char *outFile, bool inject); // configure the measurement
+    void latStart();                                     // begin injecting input
+    bool latActive();                                    // is a measurement running
+    void latInput(int type, int key, int state);         // note an input event
+    void latFrameBegin();                                // note the state being drawn
+    void latFrameDone();                                 // post-swap call-back
+    void latReport();                                    // write results as JSON
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,335 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Single precision matrix stack
+ *
+ *  Keeps the modelview and projection matrices on our side as 4x4
+ *  floats, four lanes at a time where SSE is available, instead of
+ *  handing every translation and rotation to the driver in double
+ *  precision.  Matrices are column major like OpenGL's, the stack
+ *  operations follow their glPushMatrix, glRotated and friends
+ *  counterparts, and whichever matrices changed are loaded into
+ *  OpenGL with one call each right before something is drawn.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+
+// four lanes at a time where the compiler allows
+#ifdef __SSE__
+    #include <xmmintrin.h>
+#endif
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// prototypes and definitions
+#include "matrix.h"
+
+// per-frame gl call counters, must follow the OpenGL headers
+#include "glCounters.h"
+
+// the stacks and how deep each is
+matrix matStack[MAT_NUM_MODES][MAT_STACK_DEPTH];
+int    matDepth[MAT_NUM_MODES] = {0, 0};
+
+// stack being worked on
+int matCurrent = MAT_MODELVIEW;
+
+// tops that differ from what OpenGL holds
+bool matDirty[MAT_NUM_MODES] = {true, true};
+
+// OpenGL's names for the stacks
+GLenum const matGLModes[MAT_NUM_MODES] = {GL_MODELVIEW, GL_PROJECTION};
+
+// identity matrix
+void matIdentity(matrix *out)
+{
+    memset(out->m, 0, sizeof(out->m));
+    out->m[0] = out->m[5] = out->m[10] = out->m[15] = 1.0f;
+}
+
+// out = a * b, each column of the result is the columns
+// of a weighted by one column of b
+void matMultiply(matrix *out, const matrix *a, const matrix *b)
+{
+    int j;
+#ifdef __SSE__
+    __m128 a0 = _mm_load_ps(&a->m[0]);
+    __m128 a1 = _mm_load_ps(&a->m[4]);
+    __m128 a2 = _mm_load_ps(&a->m[8]);
+    __m128 a3 = _mm_load_ps(&a->m[12]);
+    __m128 c[4];
+
+    for (j = 0; j < 4; ++j)
+        c[j] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b->m[j*4+0])),
+                                     _mm_mul_ps(a1, _mm_set1_ps(b->m[j*4+1]))),
+                          _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b->m[j*4+2])),
+                                     _mm_mul_ps(a3, _mm_set1_ps(b->m[j*4+3]))));
+
+    for (j = 0; j < 4; ++j)
+        _mm_store_ps(&out->m[j*4], c[j]);
+#else
+    int i;
+    matrix t;
+
+    for (j = 0; j < 4; ++j)
+        for (i = 0; i < 4; ++i)
+            t.m[j*4+i] = a->m[0*4+i]*b->m[j*4+0] + a->m[1*4+i]*b->m[j*4+1] +
+                         a->m[2*4+i]*b->m[j*4+2] + a->m[3*4+i]*b->m[j*4+3];
+
+    *out = t;
+#endif
+}
+
+// transform a point, w taken as 1, out gets x, y, z and w
+void matTransformPoint(const matrix *m, const float *in, float *out)
+{
+    int i;
+
+    for (i = 0; i < 4; ++i)
+        out[i] = m->m[0*4+i]*in[0] + m->m[1*4+i]*in[1] + m->m[2*4+i]*in[2] + m->m[3*4+i];
+}
+
+// the top of the current stack, about to change
+static matrix *matWrite()
+{
+    matDirty[matCurrent] = true;
+    return &matStack[matCurrent][matDepth[matCurrent]];
+}
+
+// choose the stack the calls below work on
+void matMode(int mode)
+{
+    matCurrent = mode;
+}
+
+// replace the top with identity
+void matLoadIdentity()
+{
+    matIdentity(matWrite());
+}
+
+// replace the top
+void matLoad(const matrix *m)
+{
+    *matWrite() = *m;
+}
+
+// multiply the top by m on the right, as OpenGL does
+void matMult(const matrix *m)
+{
+    matrix *top = matWrite();
+
+    matMultiply(top, top, m);
+}
+
+// copy the top onto the stack, overflowing is ignored as in OpenGL
+void matPush()
+{
+    int d = matDepth[matCurrent];
+
+    if (d+1 == MAT_STACK_DEPTH) {
+        fprintf(stderr, "warning: matrix stack overflow\n");
+        return;
+    }
+
+    matStack[matCurrent][d+1] = matStack[matCurrent][d];
+    matDepth[matCurrent] = d+1;
+}
+
+// drop the top, underflowing is ignored as in OpenGL
+void matPop()
+{
+    if (matDepth[matCurrent] == 0) {
+        fprintf(stderr, "warning: matrix stack underflow\n");
+        return;
+    }
+
+    --matDepth[matCurrent];
+    matDirty[matCurrent] = true;
+}
+
+// translate, only the last column changes
+void matTranslate(float x, float y, float z)
+{
+    matrix *top = matWrite();
+#ifdef __SSE__
+    __m128 c = _mm_load_ps(&top->m[12]);
+
+    c = _mm_add_ps(c, _mm_mul_ps(_mm_load_ps(&top->m[0]), _mm_set1_ps(x)));
+    c = _mm_add_ps(c, _mm_mul_ps(_mm_load_ps(&top->m[4]), _mm_set1_ps(y)));
+    c = _mm_add_ps(c, _mm_mul_ps(_mm_load_ps(&top->m[8]), _mm_set1_ps(z)));
+    _mm_store_ps(&top->m[12], c);
+#else
+    int i;
+
+    for (i = 0; i < 4; ++i)
+        top->m[12+i] += top->m[i]*x + top->m[4+i]*y + top->m[8+i]*z;
+#endif
+}
+
+// rotate by angle degrees about the axis x, y, z
+void matRotate(float angle, float x, float y, float z)
+{
+    matrix r;
+    float len, c, s, t;
+
+    len = sqrtf(x*x + y*y + z*z);
+    if (len == 0.0f)
+        return;
+    x /= len;
+    y /= len;
+    z /= len;
+
+    c = cosf(angle * (float)(M_PI/180.0));
+    s = sinf(angle * (float)(M_PI/180.0));
+    t = 1.0f - c;
+
+    r.m[0] = x*x*t + c;    r.m[4] = x*y*t - z*s;  r.m[8]  = x*z*t + y*s;  r.m[12] = 0.0f;
+    r.m[1] = y*x*t + z*s;  r.m[5] = y*y*t + c;    r.m[9]  = y*z*t - x*s;  r.m[13] = 0.0f;
+    r.m[2] = z*x*t - y*s;  r.m[6] = z*y*t + x*s;  r.m[10] = z*z*t + c;    r.m[14] = 0.0f;
+    r.m[3] = 0.0f;         r.m[7] = 0.0f;         r.m[11] = 0.0f;         r.m[15] = 1.0f;
+
+    matMult(&r);
+}
+
+// scale, each of the first three columns by one factor
+void matScale(float x, float y, float z)
+{
+    matrix *top = matWrite();
+    int i;
+
+    for (i = 0; i < 4; ++i) {
+        top->m[i]   *= x;
+        top->m[4+i] *= y;
+        top->m[8+i] *= z;
+    }
+}
+
+// perspective projection
+void matFrustum(float l, float r, float b, float t, float n, float f)
+{
+    matrix p;
+
+    memset(p.m, 0, sizeof(p.m));
+    p.m[0]  = 2.0f*n / (r-l);
+    p.m[5]  = 2.0f*n / (t-b);
+    p.m[8]  = (r+l) / (r-l);
+    p.m[9]  = (t+b) / (t-b);
+    p.m[10] = -(f+n) / (f-n);
+    p.m[11] = -1.0f;
+    p.m[14] = -2.0f*f*n / (f-n);
+
+    matMult(&p);
+}
+
+// flat projection with depth from -1 to 1
+void matOrtho2D(float l, float r, float b, float t)
+{
+    matrix p;
+
+    matIdentity(&p);
+    p.m[0]  = 2.0f / (r-l);
+    p.m[5]  = 2.0f / (t-b);
+    p.m[10] = -1.0f;
+    p.m[12] = -(r+l) / (r-l);
+    p.m[13] = -(t+b) / (t-b);
+
+    matMult(&p);
+}
+
+// look from the eye toward the center with up roughly up
+void matLookAt(float ex, float ey, float ez, float cx, float cy, float cz,
+               float ux, float uy, float uz)
+{
+    matrix v;
+    float f[3], s[3], u[3], len;
+
+    f[0] = cx-ex;  f[1] = cy-ey;  f[2] = cz-ez;
+    len = sqrtf(f[0]*f[0] + f[1]*f[1] + f[2]*f[2]);
+    f[0] /= len;  f[1] /= len;  f[2] /= len;
+
+    // side is forward cross up, true up is side cross forward
+    s[0] = f[1]*uz - f[2]*uy;
+    s[1] = f[2]*ux - f[0]*uz;
+    s[2] = f[0]*uy - f[1]*ux;
+    len = sqrtf(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]);
+    s[0] /= len;  s[1] /= len;  s[2] /= len;
+
+    u[0] = s[1]*f[2] - s[2]*f[1];
+    u[1] = s[2]*f[0] - s[0]*f[2];
+    u[2] = s[0]*f[1] - s[1]*f[0];
+
+    matIdentity(&v);
+    v.m[0] =  s[0];  v.m[4] =  s[1];  v.m[8]  =  s[2];
+    v.m[1] =  u[0];  v.m[5] =  u[1];  v.m[9]  =  u[2];
+    v.m[2] = -f[0];  v.m[6] = -f[1];  v.m[10] = -f[2];
+
+    matMult(&v);
+    matTranslate(-ex, -ey, -ez);
+}
+
+// current matrix of a stack
+const matrix *matTop(int mode)
+{
+    return &matStack[mode][matDepth[mode]];
+}
+
+// load the matrices that changed since the last upload, called
+// right before drawing, OpenGL is left working on the modelview
+void matUpload()
+{
+    if (matDirty[MAT_PROJECTION]) {
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(matTop(MAT_PROJECTION)->m);
+        glMatrixMode(GL_MODELVIEW);
+        matDirty[MAT_PROJECTION] = false;
+    }
+
+    if (matDirty[MAT_MODELVIEW]) {
+        glLoadMatrixf(matTop(MAT_MODELVIEW)->m);
+        matDirty[MAT_MODELVIEW] = false;
+    }
+}
+
+// something else loaded OpenGL's matrices, reload both before drawing
+void matInvalidate()
+{
+    matDirty[MAT_MODELVIEW]  = true;
+    matDirty[MAT_PROJECTION] = true;
+}
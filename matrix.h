@@ -0,0 +1,93 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Single precision matrix stack
+ *
+ *  Keeps the modelview and projection matrices on our side as 4x4
+ *  floats, four lanes at a time where SSE is available, instead of
+ *  handing every translation and rotation to the driver in double
+ *  precision.  Matrices are column major like OpenGL's, the stack
+ *  operations follow their glPushMatrix, glRotated and friends
+ *  counterparts, and whichever matrices changed are loaded into
+ *  OpenGL with one call each right before something is drawn.
+ */
+
+#ifndef MATRIX_H
+    #define MATRIX_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // the two stacks
+    #define MAT_MODELVIEW  0
+    #define MAT_PROJECTION 1
+    #define MAT_NUM_MODES  2
+
+    // matrices each stack holds, OpenGL guarantees 32 and 2
+    #define MAT_STACK_DEPTH 32
+
+    /* column major 4x4, element [col*4+row] */
+    typedef struct {
+        float m[16];
+    } __attribute__((aligned(16))) matrix;
+
+    void    matIdentity(matrix *out);                    // identity matrix
+    void    matMultiply(matrix *out, const matrix *a,    // out = a * b, out may be a or b
+                        const matrix *b);
+    void    matTransformPoint(const matrix *m,           // transform a point, w taken as 1
+                              const float *in, float *out);
+    void    matMode(int mode);                           // stack the calls below work on
+    void    matLoadIdentity();                           // replace the top with identity
+    void    matLoad(const matrix *m);                    // replace the top
+    void    matMult(const matrix *m);                    // multiply the top by m on the right
+    void    matPush();                                   // copy the top onto the stack
+    void    matPop();                                    // drop the top
+    void    matTranslate(float x, float y, float z);     // like glTranslated
+    void    matRotate(float angle,                       // like glRotated, degrees about an axis
+                      float x, float y, float z);
+    void    matScale(float x, float y, float z);         // like glScaled
+    void    matFrustum(float l, float r, float b,        // like glFrustum
+                       float t, float n, float f);
+    void    matOrtho2D(float l, float r,                 // like gluOrtho2D
+                       float b, float t);
+    void    matLookAt(float ex, float ey, float ez,      // like gluLookAt
+                      float cx, float cy, float cz,
+                      float ux, float uy, float uz);
+    const matrix *matTop(int mode);                      // current matrix of a stack
+    void    matUpload();                                 // load changed matrices into OpenGL
+    void    matInvalidate();                             // OpenGL's matrices are unknown, reload both
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
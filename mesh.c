@@ -0,0 +1,526 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Compact vertex formats
+ *
+ *  Packs baked, indexed meshes for drawing: positions are stored
+ *  as 16 bit offsets from an origin, exact when they land on
+ *  whole units and otherwise quantized over the mesh bounds, and
+ *  texture coordinates as 16 bit integers.  Each array falls back
+ *  to floats by itself when the short form would lose too much,
+ *  and indices are 16 bit whenever there are few enough vertices.
+ *  Normals are left out, each draw of these meshes faces one way
+ *  and sets its normal once.
+ *
+ *  Before packing, the quads of each draw can be reordered so
+ *  vertices are reused while the GPU still has them transformed,
+ *  and the vertices renumbered in the order they are first drawn
+ *  so they are fetched front to back.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// GL call counters when built with COUNTERS=1
+#include "glCounters.h"
+
+// single precision matrix stack
+#include "matrix.h"
+
+// prototypes and definitions
+#include "mesh.h"
+
+// totals over every mesh packed, meshes are packed on the streaming workers
+atomic_int       meshCount = 0;
+atomic_llong     meshVertCount = 0;
+atomic_llong     meshIndexCount = 0;
+atomic_llong     meshRawBytes = 0;
+atomic_llong     meshBytes = 0;
+atomic_int       meshPosFormats[MESH_NUM_POS];
+atomic_int       meshShortTex = 0;
+atomic_int       meshFloatTex = 0;
+atomic_int       meshWideIndices = 0;
+atomic_llong     meshQuads = 0;
+atomic_llong     meshMissesBefore = 0;
+atomic_llong     meshMissesAfter = 0;
+atomic_llong     meshVertsDropped = 0;
+
+/* scratch space for reordering one mesh */
+typedef struct {
+    int     *live;                     /* quads left to draw around each vertex */
+    int     *stamp;                    /* when each vertex entered the cache */
+    int     *start;                    /* first quad around each vertex in adj */
+    int     *adj;                      /* quads around each vertex */
+    int     *dead;                     /* vertices used lately, to restart from */
+    int     *next;                     /* vertices of the last fan */
+    char    *done;                     /* quads drawn */
+    GLuint  *out;
+} meshWork;
+
+// are the positions within tolerance after quantizing
+static bool meshFitsQuantized(const GLfloat *verts, int n, int stride,
+                              const GLfloat *origin, GLfloat scale)
+{
+    int i, k;
+    GLfloat p;
+
+    for (i = 0; i < n; ++i)
+        for (k = 0; k < 3; ++k) {
+            p = verts[i*stride+k];
+            if (fabsf(origin[k] + scale*rintf((p-origin[k])/scale) - p) > MESH_TOLERANCE)
+                return false;
+        }
+
+    return true;
+}
+
+// pick the smallest position format that keeps the mesh in place
+static void meshChoosePositions(meshCompact *c, const GLfloat *verts, int stride)
+{
+    int i, k;
+    GLfloat lo[3], hi[3], extent = 0.0f;
+    bool whole = true;
+
+    // bounds, and whether every coordinate is a whole number,
+    // in one pass as this runs over the largest rooms
+    for (k = 0; k < 3; ++k)
+        lo[k] = hi[k] = verts[k];
+    for (i = 0; i < c->numVerts; ++i)
+        for (k = 0; k < 3; ++k) {
+            GLfloat p = verts[i*stride+k];
+            if (p < lo[k]) lo[k] = p;
+            if (p > hi[k]) hi[k] = p;
+            whole &= (p == (GLfloat)(int)p);
+        }
+
+    for (k = 0; k < 3; ++k) {
+        c->origin[k] = floorf((lo[k]+hi[k])/2.0f);
+        if (hi[k]-lo[k] > extent)
+            extent = hi[k]-lo[k];
+    }
+    c->scale = 1.0f;
+
+    // whole numbers stay whole after subtracting a whole origin
+    if (whole && (extent <= 65534.0f)) {
+        c->posFormat = MESH_POS_EXACT;
+        return;
+    }
+
+    for (k = 0; k < 3; ++k)
+        c->origin[k] = (lo[k]+hi[k])/2.0f;
+    c->scale = extent / 65534.0f;
+
+    if (meshFitsQuantized(verts, c->numVerts, stride, c->origin, c->scale)) {
+        c->posFormat = MESH_POS_QUANTIZED;
+        return;
+    }
+
+    c->origin[0] = c->origin[1] = c->origin[2] = 0.0f;
+    c->scale = 1.0f;
+    c->posFormat = MESH_POS_FLOAT;
+}
+
+// lowest and highest vertex a range of indices uses
+static void meshSpan(const GLuint *indices, int count, int *lo, int *hi)
+{
+    int i;
+
+    *lo = (count > 0) ? (int)indices[0] : 0;
+    *hi = *lo;
+    for (i = 1; i < count; ++i) {
+        if ((int)indices[i] < *lo) *lo = indices[i];
+        if ((int)indices[i] > *hi) *hi = indices[i];
+    }
+}
+
+// cache misses drawing count indices through a first in first out cache,
+// vertices numbered from lo
+static long meshCacheMisses(const GLuint *indices, int count, int lo, int span, int *stamp)
+{
+    int i, time = MESH_CACHE_SIZE+1;
+    long misses = 0;
+
+    memset(stamp, 0, span*sizeof(int));
+
+    for (i = 0; i < count; ++i)
+        if (time - stamp[indices[i]-lo] > MESH_CACHE_SIZE) {
+            stamp[indices[i]-lo] = time++;
+            ++misses;
+        }
+
+    return misses;
+}
+
+// reorder the quads of one range with Sander, Nehab and Barczak's
+// tipsify: draw every quad around a vertex, then fan around whichever
+// of the vertices just drawn will still be cached once its own quads
+// are, restarting from recently used vertices at a dead end,
+// vertices numbered from lo
+static void meshTipsify(GLuint *indices, int count, int lo, int span, meshWork *w)
+{
+    int i, j, k, q, v, fan, best, pri, bestPri;
+    int quads = count / MESH_QUAD, time = MESH_CACHE_SIZE+1, n = 0;
+    int numDead = 0, numNext, cursor = 0;
+
+    // quads around each vertex
+    memset(w->live, 0, span*sizeof(int));
+    for (i = 0; i < quads*MESH_QUAD; ++i)
+        ++w->live[indices[i]-lo];
+    w->start[0] = 0;
+    for (v = 0; v < span; ++v)
+        w->stamp[v] = w->start[v+1] = w->start[v] + w->live[v];
+    for (q = quads-1; q >= 0; --q)
+        for (k = 0; k < MESH_QUAD; ++k)
+            w->adj[--w->stamp[indices[q*MESH_QUAD+k]-lo]] = q;
+
+    memset(w->stamp, 0, span*sizeof(int));
+    memset(w->done, 0, quads);
+
+    fan = (quads > 0) ? (int)indices[0]-lo : -1;
+    while (fan >= 0) {
+        numNext = 0;
+        for (j = w->start[fan]; j < w->start[fan+1]; ++j) {
+            q = w->adj[j];
+            if (w->done[q])
+                continue;
+            w->done[q] = 1;
+
+            for (k = 0; k < MESH_QUAD; ++k) {
+                v = indices[q*MESH_QUAD+k] - lo;
+                w->out[n++] = v + lo;
+                w->dead[numDead++] = v;
+                w->next[numNext++] = v;
+                --w->live[v];
+                if (time - w->stamp[v] > MESH_CACHE_SIZE)
+                    w->stamp[v] = time++;
+            }
+        }
+
+        // the oldest vertex that survives its own fan
+        best = -1;
+        bestPri = -1;
+        for (j = 0; j < numNext; ++j) {
+            v = w->next[j];
+            if (w->live[v] <= 0)
+                continue;
+
+            pri = 0;
+            if (time - w->stamp[v] + (MESH_QUAD-1)*w->live[v] <= MESH_CACHE_SIZE)
+                pri = time - w->stamp[v];
+            if (pri > bestPri) {
+                bestPri = pri;
+                best = v;
+            }
+        }
+
+        // dead end, go back to a recent vertex or else on to the next one
+        while ((best < 0) && (numDead > 0))
+            if (w->live[w->dead[--numDead]] > 0)
+                best = w->dead[numDead];
+        for (; (best < 0) && (cursor < span); ++cursor)
+            if (w->live[cursor] > 0)
+                best = cursor;
+
+        fan = best;
+    }
+
+    memcpy(indices, w->out, n*sizeof(GLuint));
+}
+
+// reorder each range of quads for the vertex cache, then renumber
+// the vertices in the order they are first drawn, dropping those no
+// quad uses, returns the vertices left, untouched if out of memory
+int meshOptimize(GLfloat *verts, int numVerts, int stride, GLuint *indices,
+                 int numIndices, const int *first, const int *count, int numRanges)
+{
+    int i, n, lo, hi, longest = 0;
+    long before = 0, after = 0, quads = 0;
+    GLfloat *moved;
+    meshWork w;
+
+    for (i = 0; i < numRanges; ++i)
+        if (count[i] > longest)
+            longest = count[i];
+
+    w.live  = (int*)malloc((numVerts+1) * sizeof(int));
+    w.stamp = (int*)malloc((numVerts+1) * sizeof(int));
+    w.start = (int*)malloc((numVerts+1) * sizeof(int));
+    w.adj   = (int*)malloc((longest+1) * sizeof(int));
+    w.dead  = (int*)malloc((longest+1) * sizeof(int));
+    w.next  = (int*)malloc((longest+1) * sizeof(int));
+    w.done  = (char*)malloc(longest/MESH_QUAD + 1);
+    w.out   = (GLuint*)malloc((longest+1) * sizeof(GLuint));
+    moved   = (GLfloat*)malloc((numVerts*stride+1) * sizeof(GLfloat));
+
+    if ((w.live != NULL) && (w.stamp != NULL) && (w.start != NULL) && (w.adj != NULL) &&
+        (w.dead != NULL) && (w.next != NULL) && (w.done != NULL) && (w.out != NULL) &&
+        (moved != NULL)) {
+        for (i = 0; i < numRanges; ++i) {
+            meshSpan(indices+first[i], count[i], &lo, &hi);
+            before += meshCacheMisses(indices+first[i], count[i], lo, hi-lo+1, w.stamp);
+            meshTipsify(indices+first[i], count[i], lo, hi-lo+1, &w);
+            after  += meshCacheMisses(indices+first[i], count[i], lo, hi-lo+1, w.stamp);
+            quads  += count[i] / MESH_QUAD;
+        }
+
+        // fetch vertices front to back
+        memset(w.live, -1, numVerts*sizeof(int));
+        for (i = 0, n = 0; i < numIndices; ++i) {
+            if (w.live[indices[i]] < 0) {
+                w.live[indices[i]] = n;
+                memcpy(moved + n*stride, verts + indices[i]*stride, stride*sizeof(GLfloat));
+                ++n;
+            }
+            indices[i] = w.live[indices[i]];
+        }
+        memcpy(verts, moved, n*stride*sizeof(GLfloat));
+
+        atomic_fetch_add(&meshQuads, quads);
+        atomic_fetch_add(&meshMissesBefore, before);
+        atomic_fetch_add(&meshMissesAfter, after);
+        atomic_fetch_add(&meshVertsDropped, numVerts - n);
+        numVerts = n;
+    }
+
+    free(w.live); free(w.stamp); free(w.start); free(w.adj);
+    free(w.dead); free(w.next); free(w.done); free(w.out);
+    free(moved);
+
+    return numVerts;
+}
+
+// pack indexed v3f or t2f v3f vertices
+// NULL if out of memory
+meshCompact *meshCompress(const GLfloat *verts, int numVerts,
+                          const GLuint *indices, int numIndices, bool texCoords)
+{
+    int i, k, stride = texCoords ? 5 : 3, at = texCoords ? 2 : 0;
+    size_t texSize, indexSize;
+    GLfloat invScale;
+    meshCompact *c;
+    bool shortTex = true;
+
+    c = (meshCompact*)calloc(1, sizeof(meshCompact));
+    if (c == NULL)
+        return NULL;
+
+    c->numVerts   = numVerts;
+    c->numIndices = numIndices;
+
+    if (numVerts > 0)
+        meshChoosePositions(c, verts+at, stride);
+    else
+        c->posFormat = MESH_POS_EXACT;
+
+    // whole texture repeats fit in shorts
+    if (texCoords)
+        for (i = 0; (i < numVerts) && shortTex; ++i)
+            for (k = 0; k < 2; ++k) {
+                GLfloat t = verts[i*stride+k];
+                if ((t < -32768.0f) || (t > 32767.0f) || (t != (GLfloat)(int)t))
+                    shortTex = false;
+            }
+
+    c->posType   = (c->posFormat == MESH_POS_FLOAT) ? GL_FLOAT : GL_SHORT;
+    // shorts padded to four so every vertex starts on a four byte boundary
+    c->posStride = (c->posType == GL_SHORT) ? 4*sizeof(GLshort) : 3*sizeof(GLfloat);
+    c->texType   = !texCoords ? 0 : (shortTex ? GL_SHORT : GL_FLOAT);
+    c->indexType = (numVerts <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    texSize   = !texCoords ? 0 : 2*(shortTex ? sizeof(GLshort) : sizeof(GLfloat));
+    indexSize = (c->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+
+    c->pos     = malloc(numVerts*c->posStride + 1);
+    c->tex     = texCoords ? malloc(numVerts*texSize + 1) : NULL;
+    c->indices = malloc(numIndices*indexSize + 1);
+    if ((c->pos == NULL) || (texCoords && (c->tex == NULL)) || (c->indices == NULL)) {
+        meshFreeCompact(c);
+        return NULL;
+    }
+
+    invScale = 1.0f / c->scale;
+    for (i = 0; i < numVerts; ++i) {
+        const GLfloat *v = verts + i*stride;
+
+        if (c->posFormat == MESH_POS_EXACT) {
+            GLshort *p = (GLshort*)c->pos + 4*i;
+            for (k = 0; k < 3; ++k)
+                p[k] = (GLshort)(int)(v[at+k]-c->origin[k]);
+            p[3] = 0;
+        }
+        else if (c->posFormat == MESH_POS_QUANTIZED) {
+            GLshort *p = (GLshort*)c->pos + 4*i;
+            for (k = 0; k < 3; ++k)
+                p[k] = (GLshort)lrintf((v[at+k]-c->origin[k]) * invScale);
+            p[3] = 0;
+        }
+        else
+            memcpy((GLfloat*)c->pos + 3*i, v+at, 3*sizeof(GLfloat));
+
+        if (c->texType == GL_SHORT) {
+            ((GLshort*)c->tex)[2*i+0] = (GLshort)(int)v[0];
+            ((GLshort*)c->tex)[2*i+1] = (GLshort)(int)v[1];
+        }
+        else if (c->texType == GL_FLOAT)
+            memcpy((GLfloat*)c->tex + 2*i, v, 2*sizeof(GLfloat));
+    }
+
+    if (c->indexType == GL_UNSIGNED_SHORT)
+        for (i = 0; i < numIndices; ++i)
+            ((GLushort*)c->indices)[i] = (GLushort)indices[i];
+    else
+        memcpy(c->indices, indices, numIndices*sizeof(GLuint));
+
+    c->bytes    = sizeof(meshCompact) + numVerts*(c->posStride + texSize) + numIndices*indexSize;
+    c->rawBytes = numIndices*stride*sizeof(GLfloat);
+
+    atomic_fetch_add(&meshCount, 1);
+    atomic_fetch_add(&meshIndexCount, numIndices);
+    atomic_fetch_add(&meshVertCount, numVerts);
+    atomic_fetch_add(&meshRawBytes, c->rawBytes);
+    atomic_fetch_add(&meshBytes, c->bytes);
+    atomic_fetch_add(&meshPosFormats[c->posFormat], 1);
+    if (c->texType == GL_SHORT)
+        atomic_fetch_add(&meshShortTex, 1);
+    else if (c->texType == GL_FLOAT)
+        atomic_fetch_add(&meshFloatTex, 1);
+    if (c->indexType == GL_UNSIGNED_INT)
+        atomic_fetch_add(&meshWideIndices, 1);
+
+    return c;
+}
+
+// release a packed mesh
+void meshFreeCompact(meshCompact *c)
+{
+    if (c == NULL)
+        return;
+
+    free(c->pos);
+    free(c->tex);
+    free(c->indices);
+    free(c);
+}
+
+// push the modelview, undo the packing of positions
+// and point the vertex arrays at the mesh
+void meshBind(meshCompact *c)
+{
+    matMode(MAT_MODELVIEW);
+    matPush();
+    matTranslate(c->origin[0], c->origin[1], c->origin[2]);
+    if (c->scale != 1.0f) {
+        matScale(c->scale, c->scale, c->scale);
+        // the scale would shrink the normals too
+        glEnable(GL_NORMALIZE);
+    }
+    matUpload();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, c->posType, c->posStride, c->pos);
+    if (c->tex != NULL) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, c->texType, 0, c->tex);
+    }
+}
+
+// draw count indices starting at first
+void meshDraw(meshCompact *c, GLenum mode, int first, int count)
+{
+    size_t size = (c->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+
+    if (count > 0)
+        glDrawElements(mode, count, c->indexType, (const char*)c->indices + first*size);
+}
+
+// turn the arrays off and pop the modelview
+void meshUnbind(meshCompact *c)
+{
+    if (c->tex != NULL)
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    if (c->scale != 1.0f)
+        glDisable(GL_NORMALIZE);
+
+    matMode(MAT_MODELVIEW);
+    matPop();
+}
+
+// memory used by everything packed so far
+void meshReport(FILE *f)
+{
+    long long raw = atomic_load(&meshRawBytes), bytes = atomic_load(&meshBytes);
+    long long quads = atomic_load(&meshQuads);
+
+    fprintf(f, "mesh memory: %d meshes packed\n", atomic_load(&meshCount));
+    fprintf(f, "  vertices:  %lld, drawn through %lld indices\n",
+            atomic_load(&meshVertCount), atomic_load(&meshIndexCount));
+    fprintf(f, "  positions: %d exact 16 bit, %d quantized 16 bit, %d float\n",
+            atomic_load(&meshPosFormats[MESH_POS_EXACT]),
+            atomic_load(&meshPosFormats[MESH_POS_QUANTIZED]),
+            atomic_load(&meshPosFormats[MESH_POS_FLOAT]));
+    fprintf(f, "  texcoords: %d 16 bit, %d float\n",
+            atomic_load(&meshShortTex), atomic_load(&meshFloatTex));
+    fprintf(f, "  indices:   %d 16 bit, %d 32 bit\n",
+            atomic_load(&meshCount) - atomic_load(&meshWideIndices), atomic_load(&meshWideIndices));
+    fprintf(f, "  bytes:     %.2f MB packed from %.2f MB of float arrays (%.1f%%)\n",
+            bytes / 1048576.0, raw / 1048576.0, (raw > 0) ? 100.0*bytes/raw : 0.0);
+    if (quads > 0) {
+        // per triangle, as each quad is drawn as two
+        fprintf(f, "  ACMR:      %.3f before reordering, %.3f after, %d entry cache\n",
+                atomic_load(&meshMissesBefore) / (2.0*quads),
+                atomic_load(&meshMissesAfter) / (2.0*quads), MESH_CACHE_SIZE);
+        fprintf(f, "  unused:    %lld vertices dropped\n", atomic_load(&meshVertsDropped));
+    }
+}
+
+static void meshReportAtExit()
+{
+    meshReport(stdout);
+}
+
+// print the report when the program ends, however it ends
+void meshReportOnExit()
+{
+    atexit(meshReportAtExit);
+}
@@ -0,0 +1,121 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Compact vertex formats
+ *
+ *  Packs baked, indexed meshes for drawing: positions are stored
+ *  as 16 bit offsets from an origin, exact when they land on
+ *  whole units and otherwise quantized over the mesh bounds, and
+ *  texture coordinates as 16 bit integers.  Each array falls back
+ *  to floats by itself when the short form would lose too much,
+ *  and indices are 16 bit whenever there are few enough vertices.
+ *  Normals are left out, each draw of these meshes faces one way
+ *  and sets its normal once.
+ *
+ *  Before packing, the quads of each draw can be reordered so
+ *  vertices are reused while the GPU still has them transformed,
+ *  and the vertices renumbered in the order they are first drawn
+ *  so they are fetched front to back.
+ */
+
+#ifndef MESH_H
+    #define MESH_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdio.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    // how positions are stored
+    #define MESH_POS_EXACT     0       /* whole unit offsets from the origin */
+    #define MESH_POS_QUANTIZED 1       /* 16 bit steps across the bounds */
+    #define MESH_POS_FLOAT     2
+    #define MESH_NUM_POS       3
+
+    // largest error a quantized position may have, in world units
+    #define MESH_TOLERANCE 0.125
+
+    // corners of a quad, the primitive every mesh here is made of
+    #define MESH_QUAD 4
+
+    // post-transform vertex cache the quads are ordered for and
+    // the ACMR in the report is measured with, first in first out
+    #define MESH_CACHE_SIZE 16
+
+    /* indexed quads ready to draw */
+    typedef struct {
+        int      numVerts;                 /* after sharing */
+        int      numIndices;
+        int      posFormat;                /* MESH_POS_* */
+        GLenum   posType;                  /* GL_SHORT or GL_FLOAT */
+        GLsizei  posStride;
+        GLenum   texType;                  /* GL_SHORT, GL_FLOAT or 0 for none */
+        GLenum   indexType;                /* GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+        GLfloat  origin[3];                /* a vertex is at origin + scale*position */
+        GLfloat  scale;
+        void    *pos;
+        void    *tex;
+        void    *indices;
+        size_t   bytes;                    /* memory held */
+        size_t   rawBytes;                 /* as the float arrays it came from */
+    } meshCompact;
+
+    int  meshOptimize(GLfloat *verts, int numVerts,      // reorder each range of quads for the
+                      int stride, GLuint *indices,       // vertex cache, then the vertices by
+                      int numIndices, const int *first,  // first use, returns the vertices
+                      const int *count, int numRanges);  // still used
+    meshCompact *meshCompress(const GLfloat *verts,      // pack indexed v3f or t2f v3f vertices,
+                              int numVerts,              // NULL if out of memory
+                              const GLuint *indices,
+                              int numIndices, bool texCoords);
+    void meshFreeCompact(meshCompact *c);                // release a packed mesh
+    void meshBind(meshCompact *c);                       // push the modelview and set up the arrays
+    void meshDraw(meshCompact *c, GLenum mode,           // draw a range of indices
+                  int first, int count);
+    void meshUnbind(meshCompact *c);                     // turn the arrays off and pop the modelview
+    void meshReport(FILE *f);                            // memory used by everything packed so far
+    void meshReportOnExit();                             // print the report when the program ends
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,312 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  scimus-bench - micro-benchmarks for the museum's hot paths
+ *
+ *  Times PNG decoding, helix, floor and wall submission, the
+ *  sculpture updates and the navigator math in isolation with
+ *  a warm-up and repetition harness and writes the results as
+ *  JSON so releases can be compared.  Benchmarks that submit GL
+ *  need a display and are skipped without one.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// png loader library
+#include "pngLoader.h"
+
+// 3d navigation
+#include "navigator.h"
+
+// double helix
+#include "doubleHelix.h"
+
+// high resolution timers
+#include "timing.h"
+
+// museum scene, built without its main
+#include "scimus.h"
+
+// portal visibility
+#include "visibility.h"
+
+// background room streaming
+#include "stream.h"
+
+// static geometry batches
+#include "batch.h"
+
+// default warm-up and measured repetitions
+#define MB_WARMUP      20
+#define MB_REPETITIONS 200
+
+// shared glu quadric and the museum from scimus.c
+extern GLUquadric *quadric;
+extern scene       museum;
+
+// defined only when linked against the null gl backend
+bool nullglActive() __attribute__((weak));
+
+/* one benchmark */
+typedef struct {
+    char *name;
+    void (*func)(void);
+    int   inner;            /* calls per repetition */
+    bool  gl;               /* needs a GL context */
+} mbBenchmark;
+
+// decode a png and release it again
+static void mbDecode(char *fileName)
+{
+    glpngtexture *tex = genPNGTexture(fileName);
+
+    if (tex == NULL) {
+        fprintf(stderr, "scimus-bench: couldn't decode \"%s\"!\n", fileName);
+        exit(EXIT_FAILURE);
+    }
+
+    free(tex->texels);
+    free(tex);
+}
+
+static void mbDecodeSkyline()
+{
+    mbDecode("images/skyline2.png");
+}
+
+static void mbDecodeCeiling()
+{
+    mbDecode("images/ceiling_texture.png");
+}
+
+// a turn, a step forward and sideways, then back again
+// exercises the trigonometry and the wall clipping call-back
+static void mbNavigate()
+{
+    navMoveForward(64.0);
+    navMoveSideways(32.0);
+    navTurnHorizontal(1.5);
+    navTurnVertical(0.5);
+    navMoveForward(-64.0);
+    navMoveSideways(-32.0);
+    navTurnVertical(-0.5);
+}
+
+// bake the hall's shell the way the streaming workers do
+static void mbBakeRoom()
+{
+    streamFreeMesh(streamBake(&museum, 0, false));
+}
+
+// and again with its quads reordered for the vertex cache
+static void mbPolishRoom()
+{
+    streamFreeMesh(streamBake(&museum, 0, true));
+}
+
+mbBenchmark mbBenchmarks[] = {
+    {"png_decode_skyline",  mbDecodeSkyline,  1,    false},
+    {"png_decode_ceiling",  mbDecodeCeiling,  1,    false},
+    {"update_sculpture1",   updateSculpture1, 1000, false},
+    {"update_sculpture2",   updateSculpture2, 1000, false},
+    {"update_sculpture4",   updateSculpture4, 1000, false},
+    {"navigator_math",      mbNavigate,       1000, false},
+    {"bake_room",           mbBakeRoom,       1,    false},
+    {"polish_room",         mbPolishRoom,     1,    false},
+    {"draw_double_helix",   drawDoubleHelix,  1,    true},
+    {"draw_floor",          drawFloor,        1,    true},
+    {"draw_walls",          drawWalls,        1,    true}
+};
+
+#define MB_NUM_BENCHMARKS ((int)(sizeof(mbBenchmarks)/sizeof(mbBenchmarks[0])))
+
+// print usage and exit
+void usage(char *prog)
+{
+    fprintf(stderr, "usage: %s [-w warmup] [-r repetitions] [-f filter] [-o file] [-n]\n", prog);
+    fprintf(stderr, "  -w  untimed repetitions first, default %d\n", MB_WARMUP);
+    fprintf(stderr, "  -r  timed repetitions, default %d\n", MB_REPETITIONS);
+    fprintf(stderr, "  -f  only run benchmarks whose name contains filter\n");
+    fprintf(stderr, "  -o  write JSON to file instead of standard output\n");
+    fprintf(stderr, "  -n  skip benchmarks that need a display\n");
+    exit(EXIT_FAILURE);
+}
+
+// create a small window so GL benchmarks have a context
+bool initGL(int *nargs, char *args[])
+{
+    if ((getenv("DISPLAY") == NULL) && (nullglActive == NULL))
+        return false;
+
+    glutInit(nargs, args);
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
+    glutInitWindowSize(256, 256);
+    glutCreateWindow("scimus-bench");
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+
+    quadric = gluNewQuadric();
+    gluQuadricOrientation(quadric, GLU_OUTSIDE);
+    gluQuadricNormals(quadric, GLU_SMOOTH);
+
+    batchInit();
+
+    return true;
+}
+
+// time one benchmark, fills times with us per call
+void run(mbBenchmark *b, int warmup, int reps, double *times)
+{
+    int i, j;
+    double start;
+
+    for (i = 0; i < warmup; ++i) {
+        for (j = 0; j < b->inner; ++j)
+            b->func();
+
+        if (b->gl)
+            glFinish();
+    }
+
+    for (i = 0; i < reps; ++i) {
+        start = timeNow();
+        for (j = 0; j < b->inner; ++j)
+            b->func();
+        times[i] = 1000.0 * (timeNow() - start) / b->inner;
+
+        // drain the driver outside the timed region so only submission is measured
+        if (b->gl)
+            glFinish();
+    }
+}
+
+int main(int nargs, char *args[])
+{
+    int i, c;
+    int warmup = MB_WARMUP;
+    int reps   = MB_REPETITIONS;
+    bool noGL  = false;
+    bool haveGL;
+    bool first = true;
+    char *filter  = NULL;
+    char *outFile = NULL;
+    double *times;
+    FILE *fp = stdout;
+
+    while ((c = getopt(nargs, args, "w:r:f:o:n")) != -1) {
+        switch (c) {
+            case 'w': warmup = atoi(optarg);    break;
+            case 'r': reps = atoi(optarg);      break;
+            case 'f': filter = optarg;          break;
+            case 'o': outFile = optarg;         break;
+            case 'n': noGL = true;              break;
+            default:  usage(args[0]);
+        }
+    }
+
+    if ((warmup < 0) || (reps < 1))
+        usage(args[0]);
+
+    times = malloc(sizeof(double) * reps);
+    if (times == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d repetitions.\n", reps);
+        return EXIT_FAILURE;
+    }
+
+    haveGL = !noGL && initGL(&nargs, args);
+
+    initDoubleHelix();
+    if (!sceneLoad(&museum, SCENE_DEFAULT_FILE) || !visInit(&museum))
+        return EXIT_FAILURE;
+    navClipFunc(enforceWallClipping);
+
+    if (outFile != NULL) {
+        fp = fopen(outFile, "w");
+        if (!fp) {
+            fprintf(stderr, "scimus-bench: couldn't open \"%s\"!\n", outFile);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"warmup\": %d,\n", warmup);
+    fprintf(fp, "  \"repetitions\": %d,\n", reps);
+    fprintf(fp, "  \"renderer\": \"%s\",\n", haveGL ? (char *)glGetString(GL_RENDERER) : "none");
+    fprintf(fp, "  \"benchmarks\": [");
+
+    for (i = 0; i < MB_NUM_BENCHMARKS; ++i) {
+        mbBenchmark *b = &mbBenchmarks[i];
+
+        if ((filter != NULL) && (strstr(b->name, filter) == NULL))
+            continue;
+
+        fprintf(fp, "%s\n    {\"name\": \"%s\", ", first ? "" : ",", b->name);
+        first = false;
+
+        if (b->gl && !haveGL) {
+            fprintf(fp, "\"skipped\": true}");
+            fprintf(stderr, "%-20s skipped, no display\n", b->name);
+            continue;
+        }
+
+        run(b, warmup, reps, times);
+        timeSort(times, reps);
+
+        fprintf(fp, "\"calls\": %d, \"min_us\": %.3f, \"p50_us\": %.3f, \"p95_us\": %.3f, \"max_us\": %.3f}",
+                b->inner, times[0], timePercentile(times, reps, 50.0),
+                timePercentile(times, reps, 95.0), times[reps-1]);
+
+        fprintf(stderr, "%-20s p50 %10.3f us\n", b->name, timePercentile(times, reps, 50.0));
+    }
+
+    fprintf(fp, "\n  ]\n");
+    fprintf(fp, "}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+
+    free(times);
+
+    return EXIT_SUCCESS;
+}
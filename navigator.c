@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 // OpenGL and GLUT headers
 #ifdef __APPLE__
@@ -42,64 +43,115 @@
     #include <GL/gl.h>
     #include <GL/glu.h>
     #include <GL/glut.h>
+    #include <GL/glx.h>
 #endif
 
+// standard c string functions
+#include <string.h>
+
 // type defs and prototypes
 #include "navigator.h"
 
+// per-phase frame profiler
+#include "profiler.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// high resolution timers
+#include "timing.h"
+
+// demand driven redraws
+#include "redraw.h"
+
+// single precision matrix stack
+#include "matrix.h"
+
+// static geometry batches
+#include "batch.h"
+
 // debug level
 short navDebug = NAV_DEBUG;
 
 // window attributes
 int windowID;
-int winWidth  = DEFAULT_WIN_WIDTH;
-int winHeight = DEFAULT_WIN_HEIGHT;
+NAV_THREAD_LOCAL int winWidth  = DEFAULT_WIN_WIDTH;
+NAV_THREAD_LOCAL int winHeight = DEFAULT_WIN_HEIGHT;
 
 // current zoom
-GLdouble zoomLevel = DEFAULT_ZOOM_LEVEL;
+NAV_THREAD_LOCAL GLdouble zoomLevel = DEFAULT_ZOOM_LEVEL;
+
+// the projection has changed since it was last loaded
+NAV_THREAD_LOCAL bool projectionDirty = true;
 
 // camera variables
-GLdouble cameraLocX = DEFAULT_CAMERA_X;
-GLdouble cameraLocY = DEFAULT_CAMERA_Y;
-GLdouble cameraLocZ = DEFAULT_CAMERA_Z;
+NAV_THREAD_LOCAL GLdouble cameraLocX = DEFAULT_CAMERA_X;
+NAV_THREAD_LOCAL GLdouble cameraLocY = DEFAULT_CAMERA_Y;
+NAV_THREAD_LOCAL GLdouble cameraLocZ = DEFAULT_CAMERA_Z;
 
-GLdouble rotationH = DEFAULT_ROTATION_H;
-GLdouble rotationV = DEFAULT_ROTATION_V;
+NAV_THREAD_LOCAL GLdouble rotationH = DEFAULT_ROTATION_H;
+NAV_THREAD_LOCAL GLdouble rotationV = DEFAULT_ROTATION_V;
 
 // clipping status
 bool wallClipping = true;
 
 // show the origin
-bool showO = false;
+NAV_THREAD_LOCAL bool showO = false;
+
+// drawing is done by another thread
+bool detached = false;
 
 // mouse variables
 bool warpFlag = false;
 int mouseMode = IDLE;
 
+// pointer motion since the last frame and where the pointer was last seen
+int mouseDeltaX = 0;
+int mouseDeltaY = 0;
+int mouseLastX  = DEFAULT_WIN_WIDTH/2;
+int mouseLastY  = DEFAULT_WIN_HEIGHT/2;
+
 // keyboard variables
-bool smoothMotionLeft  = false;
-bool smoothMotionRight = false;
-bool smoothMotionUp    = false;
-bool smoothMotionDown  = false;
-bool smoothMotionZoom  = false;
-bool smoothMotionDuck  = false;
-bool ducking           = false;
-bool smoothMotionJump  = false;
-bool jumping           = false;
-bool smoothMotionOpen  = false;
-GLdouble turnUnit      = DEFAULT_TURN_UNIT;
-GLdouble moveUnit      = DEFAULT_MOVE_UNIT;
-GLdouble jumpUnit      = DEFAULT_JUMP_UNIT;
+bool held[NUM_MOTIONS];            // motions whose keys are down
+int  arrowMotion[4] = {0, 0, 0, 0}; // motion started by each arrow key
+bool jumping        = false;
+GLdouble turnRate   = DEFAULT_TURN_RATE;
+GLdouble moveRate   = DEFAULT_MOVE_RATE;
+GLdouble jumpSpeed  = JUMP_SPEED;
+double   lastStep   = 0.0;
+bool     resting    = true;
+
+// motion steps taken, read by the flight recorder on the render thread
+atomic_long motionTicks = 0;
+
+// camera state version, bumped on every change
+long stateVersion = 0;
+
+// injected events carry their own modifiers
+bool injecting    = false;
+int  injectedMods = 0;
+
+// accept input from glut, otherwise only injected events
+bool liveInput = true;
 
 // call-back functions
 void (*navDraw)(void) = navDefaultDrawFunc;
 void (*navClip)(GLdouble *x, GLdouble *y, GLdouble *z) = navDefaultClipFunc;
+GLdouble (*navStand)(GLdouble x, GLdouble z) = navDefaultStandFunc;
 void (*navKey)(unsigned char key, int x, int y)   = navDefaultKeyFunc;
 void (*navKeyUp)(unsigned char key, int x, int y) = navDefaultKeyUpFunc;
+void (*navSwap)(void) = navDefaultSwapFunc;
+void (*navInput)(int type, int key, int state, int x, int y) = navDefaultInputFunc;
+void (*navPrepare)(void) = navDefaultPrepareFunc;
+void (*navBufferSwap)(void) = glutSwapBuffers;
+
+static void navWake();
 
 // initialize navigator
 void navInit(int nargs, char *args[])
 {
+    TRACE_FUNC();
+
     // initialize glut & pass any args
     glutInit(&nargs, args);
 
@@ -131,8 +183,12 @@ void navInitDisplay()
     winWidth = glutGet(GLUT_WINDOW_WIDTH);
     winHeight = glutGet(GLUT_WINDOW_HEIGHT);
 
+    // a new context knows nothing of our matrices
+    matInvalidate();
+
     // initialize the perspective projection matrix
     navWindowResize(winWidth, winHeight);
+    navApplyProjection();
 
     // initialize the modelview matrix
     navUpdateCamera();
@@ -161,6 +217,12 @@ void navInitDisplay()
     // only show front faces
     glCullFace(GL_BACK);
     glEnable(GL_CULL_FACE);
+
+    // create gpu timers for this context
+    profInit();
+
+    // and find out whether it can multi-draw
+    batchInit();
 }
 
 // initialize mouse and keyboard
@@ -172,6 +234,9 @@ void navInitCallBacks()
     // set the window resize call-back
     glutReshapeFunc(navWindowResize);
 
+    // stop drawing while the window cannot be seen
+    glutWindowStatusFunc(redrawWindowStatus);
+
     // use crosshair for cursor
     //glutSetCursor(GLUT_CURSOR_FULL_CROSSHAIR);
     glutSetCursor(GLUT_CURSOR_NONE);
@@ -203,21 +268,144 @@ void navDefaultDrawFunc()
     // insert super-kewl draw function here
 }
 
-// draw to the display
+// prepare a frame and draw it unless another thread does
 void navDisplay()
 {
+    TRACE_FUNC();
+
+    redrawFrameBegin();
+
+    // move the camera and let the application catch up with it
+    navStep();
+    navPrepare();
+
+    if (!detached)
+        navRenderFrame();
+
+    redrawFrameEnd();
+}
+
+// draw and swap the frame, on whichever thread owns the context
+void navRenderFrame()
+{
+    TRACE_FUNC();
+
+    profFrameBegin();
+
     // clear the display
+    profBegin(PROF_CLEAR);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    profEnd(PROF_CLEAR);
+
+    profBegin(PROF_CAMERA);
+    if (projectionDirty)
+        navApplyProjection();
 
     navUpdateCamera();
 
     if (showO)
         navDrawOrigin();
+    profEnd(PROF_CAMERA);
 
     navDraw();
 
     // swap doubble buffers
-    glutSwapBuffers();
+    profBegin(PROF_SWAP);
+    {
+        TRACE_SCOPE("swapBuffers");
+        navBufferSwap();
+    }
+    profEnd(PROF_SWAP);
+
+    profFrameEnd();
+
+    navSwap();
+}
+
+// register a call-back run as each frame is prepared
+void navPrepareFunc(void (*func)(void))
+{
+    navPrepare = func;
+}
+
+void navDefaultPrepareFunc()
+{
+    // nothing to prepare
+}
+
+// leave drawing to another thread, the display call-back only prepares
+void navDetach(bool detach)
+{
+    detached = detach;
+}
+
+// register how the buffers are swapped
+void navBufferSwapFunc(void (*func)(void))
+{
+    navBufferSwap = func;
+}
+
+// register external post-swap call-back
+void navSwapFunc(void (*func)(void))
+{
+    navSwap = func;
+}
+
+void navDefaultSwapFunc()
+{
+    // nothing to do after a swap
+}
+
+// set the number of vertical retraces per buffer swap
+// an interval of 0 disables vsync where the driver allows it
+void navSetSwapInterval(int interval)
+{
+#ifndef __APPLE__
+    Display *dpy = glXGetCurrentDisplay();
+    GLXDrawable drawable = glXGetCurrentDrawable();
+    const char *ext;
+
+    if (dpy == NULL)
+        return;
+
+    ext = glXQueryExtensionsString(dpy, DefaultScreen(dpy));
+
+    // an advertised extension may still not resolve, as with some
+    // indirect contexts, so each is only used once it has
+    if ((ext != NULL) && (strstr(ext, "GLX_EXT_swap_control") != NULL)) {
+        void (*swapIntervalEXT)(Display*, GLXDrawable, int) =
+            (void (*)(Display*, GLXDrawable, int))
+            glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+        if (swapIntervalEXT != NULL) {
+            swapIntervalEXT(dpy, drawable, interval);
+            return;
+        }
+    }
+
+    if ((ext != NULL) && (strstr(ext, "GLX_MESA_swap_control") != NULL)) {
+        int (*swapIntervalMESA)(unsigned int) =
+            (int (*)(unsigned int))
+            glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+        if (swapIntervalMESA != NULL) {
+            swapIntervalMESA(interval);
+            return;
+        }
+    }
+
+    if ((ext != NULL) && (strstr(ext, "GLX_SGI_swap_control") != NULL) && (interval > 0)) {
+        // sgi does not allow an interval of 0
+        int (*swapIntervalSGI)(int) =
+            (int (*)(int))
+            glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalSGI");
+        if (swapIntervalSGI != NULL) {
+            swapIntervalSGI(interval);
+            return;
+        }
+    }
+
+    if (navDebug > 0)
+        fprintf(stderr, "swap interval control is not available.\n");
+#endif
 }
 
 // update our view of the world
@@ -226,9 +414,9 @@ void navUpdateCamera()
     // move camera around the scene
     // note, vertical rotation not implimented
     if (!CAMERA_UPDATE_MODE) {
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
-        gluLookAt(cameraLocX, cameraLocY, cameraLocZ,
+        matMode(MAT_MODELVIEW);
+        matLoadIdentity();
+        matLookAt(cameraLocX, cameraLocY, cameraLocZ,
                 cameraLocX-sin(rotationH*(M_PI/180.0)), cameraLocY, cameraLocZ-cos(rotationH*(M_PI/180.0)),
                 0.0, 1.0, 0.0);
     }
@@ -236,14 +424,14 @@ void navUpdateCamera()
     // move scene around the camera
     else if (CAMERA_UPDATE_MODE) {
         // load identity for modelview matrix
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
+        matMode(MAT_MODELVIEW);
+        matLoadIdentity();
         // apply our vertical rotation
-        glRotated(-rotationV, 1.0, 0.0, 0.0);
+        matRotate(-rotationV, 1.0, 0.0, 0.0);
         // apply our horizontal rotation
-        glRotated(-rotationH, 0.0, 1.0, 0.0);
+        matRotate(-rotationH, 0.0, 1.0, 0.0);
         // move to our current location
-        glTranslated(-cameraLocX, -cameraLocY, -cameraLocZ);
+        matTranslate(-cameraLocX, -cameraLocY, -cameraLocZ);
     }
 
     if (navDebug > 0) {
@@ -259,11 +447,12 @@ void navUpdateCamera()
 void navDrawOrigin()
 {
     // save current modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
+    matMode(MAT_MODELVIEW);
+    matPush();
 
     // draw x-axis
     glColor4d(1.0, 0.0, 0.0, 1.0);
+    matUpload();
     glBegin(GL_LINES);
         glVertex3d(0.0, 0.0, 0.0);
         glVertex3d(256.0, 0.0, 0.0);
@@ -284,23 +473,75 @@ void navDrawOrigin()
     glEnd();
 
     // restore modelview
-    glPopMatrix();
+    matPop();
 }
 
 // respond to window resize
-// reloads the perspective projection matrix
+// the projection is reloaded before the next frame
 void navWindowResize(int w, int h)
 {
-    double winRatio = (double)w / (double)h;
-
     winWidth  = w;
     winHeight = h;
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glFrustum(-zoomLevel*winRatio, zoomLevel*winRatio, -zoomLevel, zoomLevel, 512.0, 24000.0);
+    projectionDirty = true;
+}
+
+// load the perspective projection matrix and viewport
+void navApplyProjection()
+{
+    double winRatio = (double)winWidth / (double)winHeight;
+
+    matMode(MAT_PROJECTION);
+    matLoadIdentity();
+    matFrustum(-zoomLevel*winRatio, zoomLevel*winRatio, -zoomLevel, zoomLevel, NAV_NEAR_PLANE, NAV_FAR_PLANE);
 
-    glViewport(0, 0, (GLsizei)w, (GLsizei)h);
+    glViewport(0, 0, (GLsizei)winWidth, (GLsizei)winHeight);
+
+    projectionDirty = false;
+}
+
+// size of the window being drawn
+void navGetWindowSize(int *w, int *h)
+{
+    *w = winWidth;
+    *h = winHeight;
+}
+
+// copy out the view being drawn, returns the number of values
+int navSaveView(double *view)
+{
+    int n = 0;
+
+    view[n++] = cameraLocX;
+    view[n++] = cameraLocY;
+    view[n++] = cameraLocZ;
+    view[n++] = rotationH;
+    view[n++] = rotationV;
+    view[n++] = zoomLevel;
+    view[n++] = winWidth;
+    view[n++] = winHeight;
+    view[n++] = showO;
+
+    return n;
+}
+
+// draw from a view saved by navSaveView
+void navLoadView(double *view)
+{
+    cameraLocX = view[0];
+    cameraLocY = view[1];
+    cameraLocZ = view[2];
+    rotationH  = view[3];
+    rotationV  = view[4];
+
+    if ((zoomLevel != view[5]) || (winWidth != (int)view[6]) || (winHeight != (int)view[7])) {
+        zoomLevel = view[5];
+        winWidth  = (int)view[6];
+        winHeight = (int)view[7];
+        projectionDirty = true;
+    }
+
+    showO = view[8] != 0.0;
 }
 
 void navClipFunc(void (*func)(GLdouble *x, GLdouble *y, GLdouble *z))
@@ -316,15 +557,31 @@ void navDefaultClipFunc(GLdouble *x, GLdouble *y, GLdouble *z)
         *y = (-650)+(420);
 }
 
+void navStandFunc(GLdouble (*func)(GLdouble x, GLdouble z))
+{
+    navStand = func;
+}
+
+// default standing height
+// eye level everywhere
+GLdouble navDefaultStandFunc(GLdouble x, GLdouble z)
+{
+    return DEFAULT_CAMERA_Y;
+}
+
 // turn d degrees left
 void navTurnHorizontal(GLdouble d)
 {
+    ++stateVersion;
+
     rotationH = fmod((rotationH + d), 360.0);
 }
 
 // turn d degrees up
 void navTurnVertical(GLdouble d)
 {
+    ++stateVersion;
+
     if ((rotationV+d) >= MAX_VERT_ROT)
         rotationV = MAX_VERT_ROT;
     else if ((rotationV+d) <= -MAX_VERT_ROT)
@@ -336,6 +593,8 @@ void navTurnVertical(GLdouble d)
 // move d units forward
 void navMoveForward(GLdouble d)
 {
+    ++stateVersion;
+
     cameraLocX += -d*(GLdouble)sin(rotationH * (M_PI/180.0));
     cameraLocZ += -d*(GLdouble)cos(rotationH * (M_PI/180.0));
 
@@ -346,6 +605,8 @@ void navMoveForward(GLdouble d)
 // move d units sideways
 void navMoveSideways(GLdouble d)
 {
+    ++stateVersion;
+
     cameraLocX += -d*(GLdouble)cos(rotationH * (M_PI/180.0));
     cameraLocZ +=  d*(GLdouble)sin(rotationH * (M_PI/180.0));
 
@@ -356,6 +617,8 @@ void navMoveSideways(GLdouble d)
 // move d units up
 void navMoveUp(GLdouble d)
 {
+    ++stateVersion;
+
     cameraLocY += d;
 
     if (wallClipping == true)
@@ -365,7 +628,7 @@ void navMoveUp(GLdouble d)
 // zoom camera in or out
 void navZoom(GLdouble amount)
 {
-    double winRatio;
+    ++stateVersion;
 
     if ((zoomLevel - amount) <= 0)
         zoomLevel = 0.1;
@@ -374,11 +637,132 @@ void navZoom(GLdouble amount)
     else
         zoomLevel -= amount;
 
-    // initialize the perspective projection matrix
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    winRatio = (double)winWidth / (double)winHeight;
-    glFrustum(-zoomLevel*winRatio, zoomLevel*winRatio, -zoomLevel, zoomLevel, 512.0, 24000.0);
+    // the perspective projection is reloaded before the next frame
+    projectionDirty = true;
+}
+
+// place the camera at x, y, z facing h degrees horizontally and v vertically
+// bypasses clipping so scripted paths are reproduced exactly
+void navSetCamera(GLdouble x, GLdouble y, GLdouble z, GLdouble h, GLdouble v)
+{
+    ++stateVersion;
+
+    cameraLocX = x;
+    cameraLocY = y;
+    cameraLocZ = z;
+
+    rotationH = fmod(h, 360.0);
+    rotationV = v;
+}
+
+// query the current camera location and orientation
+void navGetCamera(GLdouble *x, GLdouble *y, GLdouble *z, GLdouble *h, GLdouble *v)
+{
+    *x = cameraLocX;
+    *y = cameraLocY;
+    *z = cameraLocZ;
+
+    *h = rotationH;
+    *v = rotationV;
+}
+
+// query the current view frustum
+// half extents of the near plane and its distance from the eye
+void navGetFrustum(GLdouble *halfWidth, GLdouble *halfHeight, GLdouble *zNear)
+{
+    *halfWidth  = zoomLevel * (double)winWidth / (double)winHeight;
+    *halfHeight = zoomLevel;
+    *zNear      = NAV_NEAR_PLANE;
+}
+
+// register an observer that sees every input event before it is handled
+void navInputFunc(void (*func)(int type, int key, int state, int x, int y))
+{
+    navInput = func;
+}
+
+void navDefaultInputFunc(int type, int key, int state, int x, int y)
+{
+    // nobody is watching
+}
+
+// version of the camera state, changes whenever the view does
+long navStateVersion()
+{
+    return stateVersion;
+}
+
+// modifiers of the event being handled
+int navModifiers()
+{
+    if (injecting)
+        return injectedMods;
+
+    return glutGetModifiers();
+}
+
+// inject a key press or release as if it came from glut
+void navInjectKey(unsigned char key, bool down, int mods)
+{
+    injecting    = true;
+    injectedMods = mods;
+
+    if (down)
+        navKeyboard(key, 0, 0);
+    else
+        navKeyboardUp(key, 0, 0);
+
+    injecting = false;
+}
+
+// inject a special key press or release as if it came from glut
+void navInjectSpecial(int key, bool down, int mods)
+{
+    injecting    = true;
+    injectedMods = mods;
+
+    if (down)
+        navKeyboardArrow(key, 0, 0);
+    else
+        navKeyboardArrowUp(key, 0, 0);
+
+    injecting = false;
+}
+
+// inject a mouse button event as if it came from glut
+void navInjectMouse(int button, int state, int x, int y)
+{
+    injecting    = true;
+    injectedMods = 0;
+
+    navMouse(button, state, x, y);
+
+    injecting = false;
+}
+
+// inject pointer motion as if it came from glut
+void navInjectMotion(int x, int y)
+{
+    injecting    = true;
+    injectedMods = 0;
+
+    navActiveMouse(x, y);
+
+    injecting = false;
+}
+
+// accept or ignore input from glut
+// while ignored the pointer is not warped either, injected
+// events already contain the motion each warp produced
+void navLiveInput(bool live)
+{
+    liveInput = live;
+}
+
+// number of smooth motion steps taken so far
+long navMotionTicks()
+{
+    return atomic_load(&motionTicks);
 }
 
 // register and external keyboard function
@@ -397,31 +781,39 @@ void navDefaultKeyFunc(unsigned char key, int x, int y)
 // respond to key press
 void navKeyboard(unsigned char key, int x, int y)
 {
+    TRACE_FUNC();
+
+    if (!liveInput && !injecting)
+        return;
+
+    navInput(NAV_INPUT_KEY, key, navModifiers(), x, y);
+
     if ((key == '+') || (key == '=')) {
-        smoothMotionZoom = true;
-        navSmoothMotion(ZOOM_IN);
+        held[ZOOM_IN] = true;
+        navWake();
     }
     if ((key == '-') || (key == '_')) {
-        smoothMotionZoom = true;
-        navSmoothMotion(ZOOM_OUT);
+        held[ZOOM_OUT] = true;
+        navWake();
     }
     if (key == 'c') {
         wallClipping = !wallClipping;
     }
     if ((key == 'j') || (key == 'J')) {
         if (!jumping) {
-            jumping = true;
-            smoothMotionJump = true;
-            navSmoothMotion(JUMP);
+            jumping   = true;
+            jumpSpeed = JUMP_SPEED;
+            navWake();
         }
     }
     if ((key == 'd') || (key == 'D')) {
-        smoothMotionDuck = true;
-        navSmoothMotion(DUCK);
+        held[DUCK] = true;
+        navWake();
     }
     if (key == 'o') {
         showO = !showO;
-        glutPostRedisplay();
+        ++stateVersion;
+        redrawPost(REDRAW_INPUT);
     }
     if (key == '0') {
         /*
@@ -436,7 +828,7 @@ void navKeyboard(unsigned char key, int x, int y)
         zoomLevel = DEFAULT_ZOOM_LEVEL;
         navZoom(0);
 
-        glutPostRedisplay();
+        redrawPost(REDRAW_INPUT);
     }
 
     navKey(key, x, y);
@@ -457,17 +849,21 @@ void navDefaultKeyUpFunc(unsigned char key, int x, int y)
 // respond to key release
 void navKeyboardUp(unsigned char key, int x, int y)
 {
+    TRACE_FUNC();
+
+    if (!liveInput && !injecting)
+        return;
+
+    navInput(NAV_INPUT_KEY_UP, key, navModifiers(), x, y);
+
     if ((key == '+') || (key == '='))
-        smoothMotionZoom = false;
+        held[ZOOM_IN] = false;
 
     if ((key == '-') || (key == '_'))
-        smoothMotionZoom = false;
-
-    if ((key == 'u') || (key == 'U'))
-        smoothMotionJump = false;
+        held[ZOOM_OUT] = false;
 
     if ((key == 'd') || (key == 'D'))
-        smoothMotionDuck = false;
+        held[DUCK] = false;
 
     navKeyUp(key, x, y);
 }
@@ -475,168 +871,190 @@ void navKeyboardUp(unsigned char key, int x, int y)
 // respond to arrow press
 void navKeyboardArrow(int key, int x, int y)
 {
-    int mod = glutGetModifiers();
-
-    turnUnit = DEFAULT_TURN_UNIT;
-    moveUnit = DEFAULT_MOVE_UNIT;
+    TRACE_FUNC();
 
-    if ((mod & GLUT_ACTIVE_SHIFT) == (GLUT_ACTIVE_SHIFT)) {
-        turnUnit *= 2.0;
-        moveUnit *= 2.0;
-    }
+    if (!liveInput && !injecting)
+        return;
 
-    if ((key == GLUT_KEY_LEFT) && (smoothMotionLeft == false)) {
-        smoothMotionLeft = true;
+    int mod = navModifiers();
+    bool alt;
 
-        if ((mod & GLUT_ACTIVE_ALT) == GLUT_ACTIVE_ALT)
-            navSmoothMotion(MOVE_LEFT);
-        else
-            navSmoothMotion(TURN_LEFT);
-    }
+    navInput(NAV_INPUT_SPECIAL, key, mod, x, y);
 
-    if ((key == GLUT_KEY_RIGHT) && (smoothMotionRight == false)) {
-        smoothMotionRight = true;
+    turnRate = DEFAULT_TURN_RATE;
+    moveRate = DEFAULT_MOVE_RATE;
 
-        if ((mod & GLUT_ACTIVE_ALT) == GLUT_ACTIVE_ALT)
-            navSmoothMotion(MOVE_RIGHT);
-        else
-            navSmoothMotion(TURN_RIGHT);
+    if ((mod & GLUT_ACTIVE_SHIFT) == (GLUT_ACTIVE_SHIFT)) {
+        turnRate *= 2.0;
+        moveRate *= 2.0;
     }
 
-    if ((key  == GLUT_KEY_UP) && (smoothMotionUp == false)) {
-        smoothMotionUp = true;
+    if ((key < GLUT_KEY_LEFT) || (key > GLUT_KEY_DOWN) || (arrowMotion[key-GLUT_KEY_LEFT] != 0))
+        return;
 
-        if ((mod & GLUT_ACTIVE_ALT) == GLUT_ACTIVE_ALT)
-            navSmoothMotion(TURN_UP);
-        else
-            navSmoothMotion(MOVE_FORWARD);
-    }
+    // alt moves sideways instead of turning and turns up and down
+    // instead of moving, for as long as the key is held
+    alt = ((mod & GLUT_ACTIVE_ALT) == GLUT_ACTIVE_ALT);
 
-    if ((key  == GLUT_KEY_DOWN) && (smoothMotionDown == false)) {
-        smoothMotionDown = true;
+    if (key == GLUT_KEY_LEFT)
+        arrowMotion[key-GLUT_KEY_LEFT] = alt ? MOVE_LEFT : TURN_LEFT;
+    else if (key == GLUT_KEY_RIGHT)
+        arrowMotion[key-GLUT_KEY_LEFT] = alt ? MOVE_RIGHT : TURN_RIGHT;
+    else if (key == GLUT_KEY_UP)
+        arrowMotion[key-GLUT_KEY_LEFT] = alt ? TURN_UP : MOVE_FORWARD;
+    else
+        arrowMotion[key-GLUT_KEY_LEFT] = alt ? TURN_DOWN : MOVE_BACKWARD;
 
-        if ((mod & GLUT_ACTIVE_ALT) == GLUT_ACTIVE_ALT)
-            navSmoothMotion(TURN_DOWN);
-        else
-            navSmoothMotion(MOVE_BACKWARD);
-    }
+    held[arrowMotion[key-GLUT_KEY_LEFT]] = true;
+    navWake();
 }
 
 // respond to arrow release
 void navKeyboardArrowUp(int key, int x, int y)
 {
-    if (key == GLUT_KEY_LEFT)
-        smoothMotionLeft = false;
+    TRACE_FUNC();
 
-    if (key == GLUT_KEY_RIGHT)
-        smoothMotionRight = false;
+    if (!liveInput && !injecting)
+        return;
 
-    if (key == GLUT_KEY_UP)
-        smoothMotionUp = false;
+    navInput(NAV_INPUT_SPECIAL_UP, key, navModifiers(), x, y);
 
-    if (key == GLUT_KEY_DOWN)
-        smoothMotionDown = false;
+    if ((key >= GLUT_KEY_LEFT) && (key <= GLUT_KEY_DOWN)) {
+        held[arrowMotion[key-GLUT_KEY_LEFT]] = false;
+        arrowMotion[key-GLUT_KEY_LEFT] = 0;
+    }
 }
 
-// animate keyboard motion
-void navSmoothMotion(int m)
+// start timing motion from now if everything was at rest,
+// otherwise a first frame after a long idle would jump ahead
+static void navWake()
 {
-    if (m == MOVE_FORWARD) {
-        navMoveForward(moveUnit);
-        if (smoothMotionUp)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
+    if (resting) {
+        lastStep = timeNow();
+        resting  = false;
     }
 
-    if (m == MOVE_BACKWARD) {
-        navMoveForward(-moveUnit);
-        if (smoothMotionDown)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    redrawPost(REDRAW_INPUT);
+}
 
-    if (m == MOVE_LEFT) {
-        navMoveSideways(moveUnit);
-        if (smoothMotionLeft)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+// integrate held keys, jumping, ducking and pointer motion over the
+// real time since the last frame, once per frame
+void navStep()
+{
+    TRACE_FUNC();
 
-    if (m == MOVE_RIGHT) {
-        navMoveSideways(-moveUnit);
-        if (smoothMotionRight)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    double now = timeNow();
+    GLdouble dt = (now - lastStep) / 1000.0;
+    GLdouble stand = navStand(cameraLocX, cameraLocZ);
+    bool moving;
+    int m;
 
-    if (m == TURN_LEFT) {
-        navTurnHorizontal(turnUnit);
-        if (smoothMotionLeft)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    lastStep = now;
+    if ((dt < 0.0) || (dt > MAX_MOTION_STEP))
+        dt = MAX_MOTION_STEP;
 
-    if (m == TURN_RIGHT) {
-        navTurnHorizontal(-turnUnit);
-        if (smoothMotionRight)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    moving = jumping || (cameraLocY != stand) || (mouseDeltaX != 0) || (mouseDeltaY != 0);
+    for (m = 0; m < NUM_MOTIONS; ++m)
+        moving = moving || held[m];
 
-    if (m == TURN_UP) {
-        navTurnVertical(turnUnit);
-        if (smoothMotionUp)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    resting = !moving;
+    if (!moving)
+        return;
 
-    if (m == TURN_DOWN) {
-        navTurnVertical(-turnUnit);
-        if (smoothMotionDown)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
+    atomic_fetch_add(&motionTicks, 1);
+
+    if (held[MOVE_FORWARD])
+        navMoveForward(moveRate*dt);
+    if (held[MOVE_BACKWARD])
+        navMoveForward(-moveRate*dt);
+    if (held[MOVE_LEFT])
+        navMoveSideways(moveRate*dt);
+    if (held[MOVE_RIGHT])
+        navMoveSideways(-moveRate*dt);
+
+    if (held[TURN_LEFT])
+        navTurnHorizontal(turnRate*dt);
+    if (held[TURN_RIGHT])
+        navTurnHorizontal(-turnRate*dt);
+    if (held[TURN_UP])
+        navTurnVertical(turnRate*dt);
+    if (held[TURN_DOWN])
+        navTurnVertical(-turnRate*dt);
+
+    if (held[ZOOM_IN])
+        navZoom(ZOOM_RATE*dt);
+    if (held[ZOOM_OUT])
+        navZoom(-ZOOM_RATE*dt);
+
+    // standing height where the visitor has moved to, a floor
+    // that drops away underfoot is fallen to
+    stand = navStand(cameraLocX, cameraLocZ);
+    if (!jumping && !held[DUCK] && (cameraLocY > stand)) {
+        jumping   = true;
+        jumpSpeed = 0.0;
     }
 
-    if (m == ZOOM_IN) {
-        navZoom(5.0);
-        if (smoothMotionZoom)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-    }
+    // fly up and fall back under gravity to standing height
+    if (jumping) {
+        jumpSpeed -= JUMP_GRAVITY*dt;
+        navMoveUp(jumpSpeed*dt);
 
-    if (m == ZOOM_OUT) {
-        navZoom(-5.0);
-        if (smoothMotionZoom)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
+        if (cameraLocY <= stand) {
+            cameraLocY = stand;
+            jumping = false;
+        }
     }
 
-    if (m == DUCK) {
-        if (smoothMotionDuck)
-            navMoveUp(-70.0);
-        else
-            navMoveUp(70.0);
-
-        if (smoothMotionDuck || (cameraLocY < 0.0))
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-        else
-            cameraLocY = 0.0;
+    // crouch while held and stand back up once released
+    if (held[DUCK])
+        navMoveUp(-DUCK_RATE*dt);
+    else if (!jumping && (cameraLocY < stand)) {
+        navMoveUp(DUCK_RATE*dt);
+        if (cameraLocY > stand)
+            cameraLocY = stand;
     }
 
-    if (m == JUMP) {
-        jumpUnit -= JUMP_DELTA;
-        navMoveUp(jumpUnit);
-
-        if (cameraLocY > 0.0)
-            glutTimerFunc(KEY_MOTION_DELAY, navSmoothMotion, m);
-        else {
-            cameraLocY = 0.0;
-            jumpUnit = DEFAULT_JUMP_UNIT;
-            /*if (smoothMotionJump)
-              glutTimerFunc(400, smoothMotion, m);
-              else*/
-            jumping = false;
+    // all the pointer motion since the last frame in one go
+    if ((mouseDeltaX != 0) || (mouseDeltaY != 0)) {
+        if (mouseMode == TURNING) {
+            navTurnHorizontal(0.2*mouseDeltaX);
+            navTurnVertical(0.2*mouseDeltaY);
         }
+        else if (mouseMode == ZOOMING) {
+            navZoom(mouseDeltaY);
+        }
+        else if (mouseMode == MOVING) {
+            navMoveSideways(4.5*mouseDeltaX);
+            navMoveForward(6.0*mouseDeltaY);
+        }
+
+        mouseDeltaX = 0;
+        mouseDeltaY = 0;
+
+        // one warp back to the middle per frame
+        warpFlag = true;
+        if (liveInput)
+            glutWarpPointer(winWidth/2, winHeight/2);
     }
 
-    glutPostRedisplay();
+    // keep drawing while anything is still moving
+    redrawPost(REDRAW_MOTION);
 }
 
 // respond to mouse clicks
 void navMouse(int button, int state, int x, int y)
 {
+    TRACE_FUNC();
+
+    if (!liveInput && !injecting)
+        return;
+
+    navInput(NAV_INPUT_MOUSE, button, state, x, y);
+
     if (state == GLUT_UP) {
         mouseMode = IDLE;
+        mouseDeltaX = 0;
+        mouseDeltaY = 0;
         //glutSetCursor(GLUT_CURSOR_CROSSHAIR);
     }
     else if (state == GLUT_DOWN) {
@@ -650,7 +1068,8 @@ void navMouse(int button, int state, int x, int y)
             mouseMode = TURNING;
 
         warpFlag = true;
-        glutWarpPointer(winWidth/2, winHeight/2);
+        if (liveInput)
+            glutWarpPointer(winWidth/2, winHeight/2);
 
         //glutSetCursor(GLUT_CURSOR_NONE);
     }
@@ -659,32 +1078,29 @@ void navMouse(int button, int state, int x, int y)
 // respond to mouse motion
 void navActiveMouse(int x, int y)
 {
-    // glutWarpPointer posts a mouse-motion event
-    // so we need to skip every warp
-    if (warpFlag) {
+    TRACE_FUNC();
+
+    if (!liveInput && !injecting)
+        return;
+
+    navInput(NAV_INPUT_MOTION, 0, 0, x, y);
+
+    // glutWarpPointer posts a mouse-motion event to the middle of
+    // the window, it moves nothing but motion is measured from there,
+    // replayed sessions contain the warps of the recording
+    if ((warpFlag || !liveInput) && (x == winWidth/2) && (y == winHeight/2)) {
         warpFlag = false;
+        mouseLastX = x;
+        mouseLastY = y;
         return;
     }
 
-    int mouseLocX = winWidth/2;
-    int mouseLocY = winHeight/2;
-
     if (mouseMode != IDLE) {
-        if (mouseMode == TURNING) {
-            navTurnHorizontal(0.2*(mouseLocX-x));
-            navTurnVertical(0.2*(mouseLocY-y));
-        }
-        else if (mouseMode == ZOOMING) {
-            navZoom(mouseLocY-y);
-        }
-        else if (mouseMode == MOVING) {
-            navMoveSideways(4.5*(mouseLocX-x));
-            navMoveForward(6.0*(mouseLocY-y));
-        }
-
-        glutPostRedisplay();
-
-        warpFlag = true;
-        glutWarpPointer(mouseLocX, mouseLocY);
+        mouseDeltaX += mouseLastX-x;
+        mouseDeltaY += mouseLastY-y;
+        navWake();
     }
+
+    mouseLastX = x;
+    mouseLastY = y;
 }
@@ -46,6 +46,8 @@
         #include <GL/glut.h>
     #endif
 
+    #include <stdbool.h>
+
     // default debug level
     #define NAV_DEBUG 0
 
@@ -74,13 +76,20 @@
     #define DUCK          11
     #define JUMP          12
     #define OPEN          13
+    #define NUM_MOTIONS   14
+
+    // keyboard motion in degrees or units per second
+    #define DEFAULT_TURN_RATE 62.5
+    #define DEFAULT_MOVE_RATE 3000.0
+    #define ZOOM_RATE         125.0
+    #define DUCK_RATE         1750.0
 
-    #define KEY_MOTION_DELAY  40
-    #define DEFAULT_TURN_UNIT 2.5
-    #define DEFAULT_MOVE_UNIT 120.0
+    // jump launch speed in units per second and gravity in units per second squared
+    #define JUMP_SPEED   4250.0
+    #define JUMP_GRAVITY 16875.0
 
-    #define DEFAULT_JUMP_UNIT 170.0
-    #define JUMP_DELTA        27.0
+    // longest time in seconds integrated in one frame
+    #define MAX_MOTION_STEP 0.1
 
     // default camera orientation
     #define DEFAULT_CAMERA_X 600.0
@@ -93,27 +102,56 @@
     // default zoom
     #define DEFAULT_ZOOM_LEVEL 256.0
 
+    // projection clip planes
+    #define NAV_NEAR_PLANE 512.0
+    #define NAV_FAR_PLANE  24000.0
+
     // move camera around scene 0
     // move scene around camera 1
     // 1 has more features
     #define CAMERA_UPDATE_MODE 1
 
+    // input event types reported to the input observer
+    // key events carry the glut modifiers as their state
+    #define NAV_INPUT_KEY        1
+    #define NAV_INPUT_KEY_UP     2
+    #define NAV_INPUT_SPECIAL    3
+    #define NAV_INPUT_SPECIAL_UP 4
+    #define NAV_INPUT_MOUSE      5
+    #define NAV_INPUT_MOTION     6
+
     // maximum vertical rotation
     #define MAX_VERT_ROT  15.0
 
     // use multisample anti-aliasing
     #define MULTISAMPLE_AA true
 
+    // state each thread keeps its own copy of, a render thread
+    // draws from the copy loaded out of the latest snapshot
+    #define NAV_THREAD_LOCAL __thread
+
+    // values in a saved view, camera, zoom, window size and origin
+    #define NAV_VIEW_SIZE 9
+
     void navInit(int nargs, char *args[]);               // initialize navigator
     void navInitWindow(int nargs, char *args[]);         // initialize our window
     void navInitDisplay();                               // initialize the OpenGL display
     void navInitCallBacks();                             // register glut call-backs
-    void navDisplay();                                   // draw to the display
+    void navDisplay();                                   // prepare and draw a frame
+    void navRenderFrame();                               // draw and swap the prepared frame
+    void navPrepareFunc(void (*func)(void));             // register a frame preparation call-back
+    void navDefaultPrepareFunc();                        // default preparation function
+    void navDetach(bool detached);                       // leave drawing to another thread
+    void navBufferSwapFunc(void (*func)(void));          // register how buffers are swapped
     void navUpdateCamera();                              // update our view of the world
     void navDrawFunc(void (*func)(void));                // register external display function
     void navDefaultDrawFunc();                           // default display function
     void navDrawOrigin();                                // draw the world origin
     void navWindowResize(int w, int h);                  // respond to window resize
+    void navApplyProjection();                           // load the projection and viewport
+    void navGetWindowSize(int *w, int *h);               // size of the window being drawn
+    int  navSaveView(double *view);                      // copy out the view being drawn
+    void navLoadView(double *view);                      // draw from a saved view
     void navTurnHorizontal(GLdouble d);                  // turn d degrees horizontally
     void navTurnVertical(GLdouble d);                    // turn d degrees vertically
     void navMoveForward(GLdouble d);                     // move d units forward
@@ -122,7 +160,34 @@
                             GLdouble *y, GLdouble *z));
     void navDefaultClipFunc(GLdouble *x,                 // default clipping function
                             GLdouble *y, GLdouble *z);
+    void navStandFunc(GLdouble (*func)(GLdouble x,       // register the standing eye height
+                                       GLdouble z));
+    GLdouble navDefaultStandFunc(GLdouble x,             // default standing height
+                                 GLdouble z);
     void navZoom(GLdouble amount);                       // zoom camera in or out
+    void navSetCamera(GLdouble x, GLdouble y,            // place the camera
+                      GLdouble z, GLdouble h, GLdouble v);
+    void navGetCamera(GLdouble *x, GLdouble *y,          // query the camera
+                      GLdouble *z, GLdouble *h, GLdouble *v);
+    void navGetFrustum(GLdouble *halfWidth,              // query the view frustum
+                       GLdouble *halfHeight, GLdouble *zNear);
+    void navSwapFunc(void (*func)(void));                // register a post-swap call-back
+    void navDefaultSwapFunc();                           // default post-swap function
+    void navSetSwapInterval(int interval);               // frames per swap, 0 disables vsync
+    void navInputFunc(void (*func)(int type, int key,    // register an input observer
+                      int state, int x, int y));
+    void navDefaultInputFunc(int type, int key,          // default input observer
+                             int state, int x, int y);
+    long navMotionTicks();                               // number of frames with motion so far
+    long navStateVersion();                              // changes whenever the view does
+    int  navModifiers();                                 // modifiers of the current event
+    void navInjectKey(unsigned char key, bool down,      // inject a key event
+                      int mods);
+    void navInjectSpecial(int key, bool down, int mods); // inject a special key event
+    void navInjectMouse(int button, int state,           // inject a mouse button event
+                        int x, int y);
+    void navInjectMotion(int x, int y);                  // inject pointer motion
+    void navLiveInput(bool live);                        // accept or ignore input from glut
 
     void navKeyboardFunc(void (*func)(unsigned char key, int x, int y));
     void navDefaultKeyFunc(unsigned char key, int x, int y);
@@ -134,7 +199,7 @@
 
     void navKeyboardArrow(int key, int x, int y);        // respond to arrow key press
     void navKeyboardArrowUp(int key, int x, int y);      // respond to arrow key release
-    void navSmoothMotion(int m);                         // animate keyboard motion
+    void navStep();                                      // integrate held keys and pointer motion
     void navMouse(int button, int state, int x, int y);  // respond to mouse clicks
     void navActiveMouse(int x, int y);                   // respond to mouse motion
 
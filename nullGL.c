@@ -0,0 +1,539 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Null GL backend
+ *
+ *  Stub GL, GLU, GLUT and GLX entry points that count calls and
+ *  do nothing else, plus a minimal glut main loop running the
+ *  timer, idle and display call-backs.  Linking against it in
+ *  place of the real libraries measures the CPU cost of scene
+ *  traversal and submission without a driver or a display.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+// OpenGL and GLUT headers, included so every stub is checked
+// against the real prototype
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+#include <GL/glx.h>
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "nullGL.h"
+
+// count one call to the enclosing entry point
+#define NULL_CALL(name) \
+    static int nullSlot_ = -1; \
+    if (nullSlot_ < 0) \
+        nullSlot_ = nullglSlot(name); \
+    ++nullCounts[nullSlot_].count
+
+/* calls to one entry point */
+typedef struct {
+    const char    *name;
+    unsigned long  count;
+} nullCount;
+
+/* a pending glut timer */
+typedef struct {
+    double  due;
+    long    order;                          /* keeps equal deadlines in order */
+    void  (*func)(int value);
+    int     value;
+} nullTimer;
+
+// call counts
+nullCount nullCounts[NULLGL_MAX_FUNCS];
+int       nullNumCounts = 0;
+long      nullFrames    = 0;
+
+// entry points are first called from more than one thread with a render thread
+pthread_mutex_t nullSlotLock = PTHREAD_MUTEX_INITIALIZER;
+
+// glut font handles, only their addresses matter
+void *glutStrokeRoman;
+void *glutStrokeMonoRoman;
+void *glutBitmap9By15;
+void *glutBitmap8By13;
+void *glutBitmapTimesRoman10;
+void *glutBitmapTimesRoman24;
+void *glutBitmapHelvetica10;
+void *glutBitmapHelvetica12;
+void *glutBitmapHelvetica18;
+
+// registered glut call-backs
+void (*nullDisplay)(void) = NULL;
+void (*nullReshape)(int w, int h) = NULL;
+void (*nullIdle)(void) = NULL;
+
+// main loop state
+bool      nullRedisplay = false;
+bool      nullResized   = true;
+int       nullWidth     = NULLGL_WIDTH;
+int       nullHeight    = NULLGL_HEIGHT;
+nullTimer nullTimers[NULLGL_MAX_TIMERS];
+int       nullNumTimers = 0;
+long      nullTimerOrder = 0;
+double    nullStart     = 0.0;
+
+// enabled capabilities so glIsEnabled answers consistently
+GLenum nullCaps[64];
+int    nullNumCaps = 0;
+
+// texture names handed out so far
+GLuint nullTextures = 0;
+
+// find or add the counter for an entry point
+static int nullglSlot(const char *name)
+{
+    int i;
+
+    pthread_mutex_lock(&nullSlotLock);
+
+    for (i = 0; i < nullNumCounts; ++i)
+        if (strcmp(nullCounts[i].name, name) == 0) {
+            pthread_mutex_unlock(&nullSlotLock);
+            return i;
+        }
+
+    if (nullNumCounts == NULLGL_MAX_FUNCS) {
+        fprintf(stderr, "Fatal Error:  More than %d null GL entry points.\n", NULLGL_MAX_FUNCS);
+        exit(EXIT_FAILURE);
+    }
+
+    nullCounts[nullNumCounts].name  = name;
+    nullCounts[nullNumCounts].count = 0;
+    i = nullNumCounts++;
+
+    pthread_mutex_unlock(&nullSlotLock);
+
+    return i;
+}
+
+// true when linked against the stubs
+bool nullglActive()
+{
+    return true;
+}
+
+// calls made to one entry point
+unsigned long nullglCalls(char *name)
+{
+    int i;
+
+    for (i = 0; i < nullNumCounts; ++i)
+        if (strcmp(nullCounts[i].name, name) == 0)
+            return nullCounts[i].count;
+
+    return 0;
+}
+
+// order counters busiest first
+static int nullglCompare(const void *a, const void *b)
+{
+    const nullCount *x = a, *y = b;
+
+    if (x->count != y->count)
+        return (x->count < y->count) ? 1 : -1;
+
+    return strcmp(x->name, y->name);
+}
+
+// print call counts per frame
+void nullglReport(FILE *fp)
+{
+    int i;
+    unsigned long total = 0;
+    long frames = (nullFrames > 0) ? nullFrames : 1;
+    nullCount sorted[NULLGL_MAX_FUNCS];
+
+    memcpy(sorted, nullCounts, sizeof(nullCount) * nullNumCounts);
+    qsort(sorted, nullNumCounts, sizeof(nullCount), nullglCompare);
+
+    for (i = 0; i < nullNumCounts; ++i)
+        total += sorted[i].count;
+
+    fprintf(fp, "null gl: %ld frames in %.1f ms, %lu calls, %.1f per frame\n",
+            nullFrames, timeNow()-nullStart, total, (double)total/frames);
+
+
+    for (i = 0; i < nullNumCounts; ++i)
+        fprintf(fp, "  %-28s %12lu %12.1f\n", sorted[i].name, sorted[i].count,
+                (double)sorted[i].count/frames);
+}
+
+static void nullglReportAtExit()
+{
+    nullglReport(stderr);
+}
+
+/*
+ *  GL
+ */
+
+void glBegin(GLenum mode)                                   { NULL_CALL("glBegin"); }
+void glEnd()                                                { NULL_CALL("glEnd"); }
+void glVertex3i(GLint x, GLint y, GLint z)                  { NULL_CALL("glVertex3i"); }
+void glVertex3d(GLdouble x, GLdouble y, GLdouble z)         { NULL_CALL("glVertex3d"); }
+void glNormal3f(GLfloat x, GLfloat y, GLfloat z)            { NULL_CALL("glNormal3f"); }
+void glTexCoord2i(GLint s, GLint t)                         { NULL_CALL("glTexCoord2i"); }
+void glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer) { NULL_CALL("glInterleavedArrays"); }
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)  { NULL_CALL("glDrawArrays"); }
+void glDisableClientState(GLenum array)                     { NULL_CALL("glDisableClientState"); }
+void glEnableClientState(GLenum array)                      { NULL_CALL("glEnableClientState"); }
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { NULL_CALL("glVertexPointer"); }
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { NULL_CALL("glTexCoordPointer"); }
+void glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer) { NULL_CALL("glNormalPointer"); }
+void glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { NULL_CALL("glColorPointer"); }
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) { NULL_CALL("glDrawElements"); }
+void glColor4d(GLdouble r, GLdouble g, GLdouble b, GLdouble a) { NULL_CALL("glColor4d"); }
+void glRasterPos2i(GLint x, GLint y)                        { NULL_CALL("glRasterPos2i"); }
+void glRasterPos3i(GLint x, GLint y, GLint z)               { NULL_CALL("glRasterPos3i"); }
+
+void glMaterialf(GLenum face, GLenum pname, GLfloat param)  { NULL_CALL("glMaterialf"); }
+void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) { NULL_CALL("glMaterialfv"); }
+void glLightf(GLenum light, GLenum pname, GLfloat param)    { NULL_CALL("glLightf"); }
+void glLightfv(GLenum light, GLenum pname, const GLfloat *params) { NULL_CALL("glLightfv"); }
+void glLightModeli(GLenum pname, GLint param)               { NULL_CALL("glLightModeli"); }
+void glLightModelfv(GLenum pname, const GLfloat *params)    { NULL_CALL("glLightModelfv"); }
+void glShadeModel(GLenum mode)                              { NULL_CALL("glShadeModel"); }
+void glColorMaterial(GLenum face, GLenum mode)              { NULL_CALL("glColorMaterial"); }
+
+void glMatrixMode(GLenum mode)                              { NULL_CALL("glMatrixMode"); }
+void glLoadIdentity()                                       { NULL_CALL("glLoadIdentity"); }
+void glLoadMatrixf(const GLfloat *m)                        { NULL_CALL("glLoadMatrixf"); }
+void glPushMatrix()                                         { NULL_CALL("glPushMatrix"); }
+void glPopMatrix()                                          { NULL_CALL("glPopMatrix"); }
+void glTranslated(GLdouble x, GLdouble y, GLdouble z)       { NULL_CALL("glTranslated"); }
+void glRotated(GLdouble a, GLdouble x, GLdouble y, GLdouble z) { NULL_CALL("glRotated"); }
+void glScaled(GLdouble x, GLdouble y, GLdouble z)           { NULL_CALL("glScaled"); }
+void glFrustum(GLdouble l, GLdouble r, GLdouble b, GLdouble t, GLdouble n, GLdouble f) { NULL_CALL("glFrustum"); }
+void glViewport(GLint x, GLint y, GLsizei w, GLsizei h)     { NULL_CALL("glViewport"); }
+
+void glPushAttrib(GLbitfield mask)                          { NULL_CALL("glPushAttrib"); }
+void glPopAttrib()                                          { NULL_CALL("glPopAttrib"); }
+void glBlendFunc(GLenum s, GLenum d)                        { NULL_CALL("glBlendFunc"); }
+void glCullFace(GLenum mode)                                { NULL_CALL("glCullFace"); }
+void glPolygonMode(GLenum face, GLenum mode)                { NULL_CALL("glPolygonMode"); }
+void glHint(GLenum target, GLenum mode)                     { NULL_CALL("glHint"); }
+void glClear(GLbitfield mask)                               { NULL_CALL("glClear"); }
+void glClearColor(GLclampf r, GLclampf g, GLclampf b, GLclampf a) { NULL_CALL("glClearColor"); }
+void glFinish()                                             { NULL_CALL("glFinish"); }
+
+void glEnable(GLenum cap)
+{
+    int i;
+
+    NULL_CALL("glEnable");
+
+    for (i = 0; i < nullNumCaps; ++i)
+        if (nullCaps[i] == cap)
+            return;
+
+    if (nullNumCaps < (int)(sizeof(nullCaps)/sizeof(nullCaps[0])))
+        nullCaps[nullNumCaps++] = cap;
+}
+
+void glDisable(GLenum cap)
+{
+    int i;
+
+    NULL_CALL("glDisable");
+
+    for (i = 0; i < nullNumCaps; ++i)
+        if (nullCaps[i] == cap) {
+            nullCaps[i] = nullCaps[--nullNumCaps];
+            return;
+        }
+}
+
+GLboolean glIsEnabled(GLenum cap)
+{
+    int i;
+
+    NULL_CALL("glIsEnabled");
+
+    for (i = 0; i < nullNumCaps; ++i)
+        if (nullCaps[i] == cap)
+            return GL_TRUE;
+
+    return GL_FALSE;
+}
+
+// an old version keeps the profiler's timer queries switched off
+const GLubyte *glGetString(GLenum name)
+{
+    NULL_CALL("glGetString");
+
+    switch (name) {
+        case GL_VENDOR:   return (const GLubyte *)"scimus";
+        case GL_RENDERER: return (const GLubyte *)"null";
+        case GL_VERSION:  return (const GLubyte *)"1.1 null";
+        default:          return (const GLubyte *)"";
+    }
+}
+
+void glGenTextures(GLsizei n, GLuint *textures)
+{
+    int i;
+
+    NULL_CALL("glGenTextures");
+
+    for (i = 0; i < n; ++i)
+        textures[i] = ++nullTextures;
+}
+
+void glBindTexture(GLenum target, GLuint texture)          { NULL_CALL("glBindTexture"); }
+void glTexParameteri(GLenum target, GLenum pname, GLint param) { NULL_CALL("glTexParameteri"); }
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                  GLint border, GLenum format, GLenum type, const GLvoid *pixels) { NULL_CALL("glTexImage2D"); }
+
+/*
+ *  GLU
+ */
+
+GLUquadric *gluNewQuadric()
+{
+    NULL_CALL("gluNewQuadric");
+
+    // opaque to callers, any unique address will do
+    return (GLUquadric *)calloc(1, 1);
+}
+
+void gluQuadricNormals(GLUquadric *q, GLenum normal)        { NULL_CALL("gluQuadricNormals"); }
+void gluQuadricOrientation(GLUquadric *q, GLenum orientation) { NULL_CALL("gluQuadricOrientation"); }
+void gluSphere(GLUquadric *q, GLdouble radius, GLint slices, GLint stacks) { NULL_CALL("gluSphere"); }
+void gluCylinder(GLUquadric *q, GLdouble base, GLdouble top, GLdouble height,
+                 GLint slices, GLint stacks)                { NULL_CALL("gluCylinder"); }
+void gluDisk(GLUquadric *q, GLdouble inner, GLdouble outer, GLint slices, GLint loops) { NULL_CALL("gluDisk"); }
+void gluOrtho2D(GLdouble l, GLdouble r, GLdouble b, GLdouble t) { NULL_CALL("gluOrtho2D"); }
+
+/*
+ *  GLX, no display so swap control is never found, multi-draw
+ *  is so batched submission is counted the way it runs on a driver
+ */
+
+static void nullMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                                  const void *const *indices, GLsizei drawcount)
+{
+    NULL_CALL("glMultiDrawElements");
+}
+
+Display *glXGetCurrentDisplay()                             { NULL_CALL("glXGetCurrentDisplay"); return NULL; }
+GLXDrawable glXGetCurrentDrawable()                         { NULL_CALL("glXGetCurrentDrawable"); return 0; }
+GLXContext glXGetCurrentContext()                           { NULL_CALL("glXGetCurrentContext"); return NULL; }
+Bool glXMakeCurrent(Display *dpy, GLXDrawable d, GLXContext ctx) { NULL_CALL("glXMakeCurrent"); return True; }
+void glXSwapBuffers(Display *dpy, GLXDrawable d)            { NULL_CALL("glXSwapBuffers"); ++nullFrames; }
+Status XInitThreads()                                       { NULL_CALL("XInitThreads"); return 1; }
+const char *glXQueryExtensionsString(Display *dpy, int screen) { NULL_CALL("glXQueryExtensionsString"); return ""; }
+
+void (*glXGetProcAddressARB(const GLubyte *name))(void)
+{
+    NULL_CALL("glXGetProcAddressARB");
+
+    if (strcmp((const char*)name, "glMultiDrawElementsEXT") == 0)
+        return (void (*)(void))nullMultiDrawElements;
+
+    return NULL;
+}
+
+/*
+ *  GLUT
+ */
+
+void glutInit(int *argc, char **argv)
+{
+    NULL_CALL("glutInit");
+
+    nullStart = timeNow();
+    atexit(nullglReportAtExit);
+}
+
+void glutInitDisplayMode(unsigned int mode)                 { NULL_CALL("glutInitDisplayMode"); }
+void glutInitWindowPosition(int x, int y)                   { NULL_CALL("glutInitWindowPosition"); }
+
+void glutInitWindowSize(int w, int h)
+{
+    NULL_CALL("glutInitWindowSize");
+
+    nullWidth  = w;
+    nullHeight = h;
+}
+
+int glutCreateWindow(const char *title)
+{
+    NULL_CALL("glutCreateWindow");
+
+    // a new window is reshaped and exposed
+    nullResized   = true;
+    nullRedisplay = true;
+
+    return 1;
+}
+
+int  glutGetWindow()                                        { NULL_CALL("glutGetWindow"); return 1; }
+void glutSetWindow(int window)                              { NULL_CALL("glutSetWindow"); }
+void glutSetCursor(int cursor)                              { NULL_CALL("glutSetCursor"); }
+void glutWarpPointer(int x, int y)                          { NULL_CALL("glutWarpPointer"); }
+void glutIgnoreKeyRepeat(int ignore)                        { NULL_CALL("glutIgnoreKeyRepeat"); }
+int  glutGetModifiers()                                     { NULL_CALL("glutGetModifiers"); return 0; }
+int  glutExtensionSupported(const char *name)               { NULL_CALL("glutExtensionSupported"); return strcmp(name, "GL_EXT_multi_draw_arrays") == 0; }
+int  glutGameModeGet(GLenum mode)                           { NULL_CALL("glutGameModeGet"); return 0; }
+int  glutEnterGameMode()                                    { NULL_CALL("glutEnterGameMode"); return 0; }
+void glutLeaveGameMode()                                    { NULL_CALL("glutLeaveGameMode"); }
+
+void glutReshapeWindow(int w, int h)
+{
+    NULL_CALL("glutReshapeWindow");
+
+    nullWidth   = w;
+    nullHeight  = h;
+    nullResized = true;
+}
+
+int glutGet(GLenum state)
+{
+    NULL_CALL("glutGet");
+
+    switch (state) {
+        case GLUT_WINDOW_WIDTH:  return nullWidth;
+        case GLUT_WINDOW_HEIGHT: return nullHeight;
+        case GLUT_ELAPSED_TIME:  return (int)(timeNow()-nullStart);
+        default:                 return 0;
+    }
+}
+
+void glutBitmapCharacter(void *font, int c)                 { NULL_CALL("glutBitmapCharacter"); }
+int  glutBitmapWidth(void *font, int c)                     { NULL_CALL("glutBitmapWidth"); return 8; }
+void glutSolidTeapot(double size)                           { NULL_CALL("glutSolidTeapot"); }
+void glutSolidTorus(double inner, double outer, GLint sides, GLint rings) { NULL_CALL("glutSolidTorus"); }
+
+void glutDisplayFunc(void (*func)(void))                    { NULL_CALL("glutDisplayFunc"); nullDisplay = func; }
+void glutReshapeFunc(void (*func)(int w, int h))            { NULL_CALL("glutReshapeFunc"); nullReshape = func; nullResized = true; }
+void glutIdleFunc(void (*func)(void))                       { NULL_CALL("glutIdleFunc"); nullIdle = func; }
+void glutKeyboardFunc(void (*func)(unsigned char k, int x, int y))   { NULL_CALL("glutKeyboardFunc"); }
+void glutKeyboardUpFunc(void (*func)(unsigned char k, int x, int y)) { NULL_CALL("glutKeyboardUpFunc"); }
+void glutSpecialFunc(void (*func)(int k, int x, int y))     { NULL_CALL("glutSpecialFunc"); }
+void glutSpecialUpFunc(void (*func)(int k, int x, int y))   { NULL_CALL("glutSpecialUpFunc"); }
+void glutMouseFunc(void (*func)(int b, int s, int x, int y)) { NULL_CALL("glutMouseFunc"); }
+void glutMotionFunc(void (*func)(int x, int y))             { NULL_CALL("glutMotionFunc"); }
+void glutWindowStatusFunc(void (*func)(int state))          { NULL_CALL("glutWindowStatusFunc"); }
+void glutPostRedisplay()                                    { NULL_CALL("glutPostRedisplay"); nullRedisplay = true; }
+
+void glutSwapBuffers()
+{
+    NULL_CALL("glutSwapBuffers");
+
+    ++nullFrames;
+}
+
+void glutTimerFunc(unsigned int ms, void (*func)(int value), int value)
+{
+    nullTimer *t;
+
+    NULL_CALL("glutTimerFunc");
+
+    if (nullNumTimers == NULLGL_MAX_TIMERS) {
+        fprintf(stderr, "Fatal Error:  More than %d null glut timers.\n", NULLGL_MAX_TIMERS);
+        exit(EXIT_FAILURE);
+    }
+
+    t = &nullTimers[nullNumTimers++];
+    t->due   = timeNow() + ms;
+    t->order = nullTimerOrder++;
+    t->func  = func;
+    t->value = value;
+}
+
+// index of the timer due first, -1 if none
+static int nullNextTimer()
+{
+    int i, next = -1;
+
+    for (i = 0; i < nullNumTimers; ++i)
+        if ((next < 0) || (nullTimers[i].due < nullTimers[next].due) ||
+            ((nullTimers[i].due == nullTimers[next].due) && (nullTimers[i].order < nullTimers[next].order)))
+            next = i;
+
+    return next;
+}
+
+// run timers, reshape, display and idle call-backs until nothing is left to do
+void glutMainLoop()
+{
+    int next;
+    double now;
+    nullTimer t;
+    struct timespec pause;
+
+    NULL_CALL("glutMainLoop");
+
+    while (true) {
+        if (nullResized && (nullReshape != NULL)) {
+            nullResized = false;
+            nullReshape(nullWidth, nullHeight);
+        }
+
+        // fire every timer that has come due
+        now = timeNow();
+        while (((next = nullNextTimer()) >= 0) && (nullTimers[next].due <= now)) {
+            t = nullTimers[next];
+            nullTimers[next] = nullTimers[--nullNumTimers];
+            t.func(t.value);
+        }
+
+        if (nullRedisplay && (nullDisplay != NULL)) {
+            nullRedisplay = false;
+            nullDisplay();
+        }
+        else if (nullIdle != NULL)
+            nullIdle();
+        else if (next >= 0) {
+            // sleep until the next timer
+            double wait = nullTimers[next].due - timeNow();
+
+            if (wait > 0.0) {
+                pause.tv_sec  = (time_t)(wait / 1000.0);
+                pause.tv_nsec = (long)((wait - 1000.0*pause.tv_sec) * 1.0e6);
+                nanosleep(&pause, NULL);
+            }
+        }
+        else
+            break;
+    }
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Null GL backend
+ *
+ *  Stub GL, GLU, GLUT and GLX entry points that count calls and
+ *  do nothing else, plus a minimal glut main loop running the
+ *  timer, idle and display call-backs.  Linking against it in
+ *  place of the real libraries measures the CPU cost of scene
+ *  traversal and submission without a driver or a display.
+ */
+
+#ifndef NULLGL_H
+    #define NULLGL_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdio.h>
+    #include <stdbool.h>
+
+    // distinct entry points counted
+    #define NULLGL_MAX_FUNCS 128
+
+    // pending glut timers
+    #define NULLGL_MAX_TIMERS 256
+
+    // size of the pretend window
+    #define NULLGL_WIDTH  1024
+    #define NULLGL_HEIGHT 768
+
+    bool          nullglActive();                        // true when linked against the stubs
+    unsigned long nullglCalls(char *name);               // calls made to one entry point
+    void          nullglReport(FILE *fp);                // print call counts per frame
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,529 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Software occlusion culling
+ *
+ *  Rasterizes the walls of the visible rooms into a small depth
+ *  buffer on the CPU each frame, split into screen tiles run as
+ *  jobs, then tests the bounding boxes of exhibits and windows
+ *  against it so whatever is hidden behind a wall, or out of
+ *  view, is never submitted.  Depth is stored as the reciprocal
+ *  of the view distance, larger is nearer.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// four pixels at a time where the compiler allows
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// portal visibility
+#include "visibility.h"
+
+// work stealing jobs
+#include "jobs.h"
+
+// prototypes and definitions
+#include "occlusion.h"
+
+// most portals in one wall that are cut out of its occluders
+#define OCC_MAX_WALL_PORTALS 32
+
+// scene whose walls occlude, NULL until initialized
+scene *occScene = NULL;
+
+// culling is on unless turned off for comparison
+bool occEnabled = true;
+
+// wall panels of every room
+occQuad *occQuads     = NULL;
+int      occNumQuads  = 0;
+int      occMaxQuads  = 0;
+int     *occRoomFirst = NULL;
+int     *occRoomCount = NULL;
+
+// this frame's triangles
+occTriangle *occTris    = NULL;
+int          occNumTris = 0;
+int          occMaxTris = 0;
+
+// depth buffer, 1/distance with 0 for nothing drawn
+float occDepth[OCC_HEIGHT][OCC_WIDTH] __attribute__((aligned(16)));
+
+// is the depth buffer from this frame
+bool occReady = false;
+
+// camera for this frame
+GLdouble occEye[3], occFwd[3], occRight[3], occUp[3];
+GLdouble occScaleX, occScaleY, occNear;
+
+// results for this frame, boxes may be tested from several jobs
+atomic_int occTested = 0;
+atomic_int occCulled = 0;
+
+// add a wall panel from u0 to u1 along a wall and v0 to v1 up it
+static void occAddPanel(sceneRoom *r, int wall, GLdouble u0, GLdouble u1, GLdouble v0, GLdouble v1)
+{
+    int i;
+    GLdouble u[4] = {u0, u1, u1, u0}, v[4] = {v0, v0, v1, v1};
+    GLfloat *c;
+
+    if ((u1 <= u0) || (v1 <= v0))
+        return;
+
+    if (occNumQuads == occMaxQuads) {
+        occMaxQuads = occMaxQuads ? 2*occMaxQuads : 256;
+        occQuads = (occQuad*)realloc(occQuads, occMaxQuads * sizeof(occQuad));
+        if (occQuads == NULL) {
+            fprintf(stderr, "Fatal Error:  Out of memory for occluders.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (i = 0; i < 4; ++i) {
+        c = occQuads[occNumQuads].corner[i];
+        switch (wall) {
+            case WALL_SOUTH: c[0] = r->x1-u[i]; c[2] = r->z1;      break;
+            case WALL_EAST:  c[0] = r->x1;      c[2] = r->z0+u[i]; break;
+            case WALL_WEST:  c[0] = r->x0;      c[2] = r->z1-u[i]; break;
+            default:         c[0] = r->x0+u[i]; c[2] = r->z0;      break;
+        }
+        c[1] = r->floor + v[i];
+    }
+
+    ++occNumQuads;
+}
+
+// break one wall into solid panels around its portals
+static void occAddWall(scene *s, sceneRoom *r, int wall)
+{
+    int i, j, k, n = 0;
+    GLdouble length, u = 0.0, offset;
+    scenePortal *p, *gap[OCC_MAX_WALL_PORTALS];
+
+    length = ((wall == WALL_NORTH) || (wall == WALL_SOUTH)) ? r->x1 - r->x0 : r->z1 - r->z0;
+
+    // portals along the wall from its left end, as seen from inside
+    for (k = r->firstPortal; (k < r->firstPortal + r->numPortals) && (n < OCC_MAX_WALL_PORTALS); ++k) {
+        p = &s->portals[k];
+        if (p->wall != wall)
+            continue;
+
+        for (i = n++; i > 0; --i) {
+            if (scenePortalOffset(r, gap[i-1]) <= scenePortalOffset(r, p))
+                break;
+            gap[i] = gap[i-1];
+        }
+        gap[i] = p;
+    }
+
+    for (j = 0; j < n; ++j) {
+        p      = gap[j];
+        offset = scenePortalOffset(r, p);
+
+        occAddPanel(r, wall, u, offset - p->width/2.0, 0.0, r->height);
+        occAddPanel(r, wall, offset - p->width/2.0, offset + p->width/2.0, 0.0, p->bottom);
+        occAddPanel(r, wall, offset - p->width/2.0, offset + p->width/2.0, p->bottom + p->height, r->height);
+
+        if (offset + p->width/2.0 > u)
+            u = offset + p->width/2.0;
+    }
+    occAddPanel(r, wall, u, length, 0.0, r->height);
+}
+
+// build the occluders of every room
+bool occInit(scene *s)
+{
+    int i, wall;
+
+    occFree();
+
+    occRoomFirst = (int*)malloc((s->numRooms+1) * sizeof(int));
+    occRoomCount = (int*)malloc((s->numRooms+1) * sizeof(int));
+    if ((occRoomFirst == NULL) || (occRoomCount == NULL)) {
+        fprintf(stderr, "error: out of memory for occlusion culling!\n");
+        occFree();
+        return false;
+    }
+
+    for (i = 0; i < s->numRooms; ++i) {
+        occRoomFirst[i] = occNumQuads;
+        for (wall = WALL_NORTH; wall <= WALL_WEST; ++wall)
+            occAddWall(s, &s->rooms[i], wall);
+        occRoomCount[i] = occNumQuads - occRoomFirst[i];
+    }
+
+    occScene = s;
+
+    return true;
+}
+
+// free the occluders
+void occFree()
+{
+    free(occQuads);
+    free(occRoomFirst);
+    free(occRoomCount);
+    free(occTris);
+
+    occQuads     = NULL;
+    occRoomFirst = NULL;
+    occRoomCount = NULL;
+    occTris      = NULL;
+    occNumQuads  = occMaxQuads = 0;
+    occNumTris   = occMaxTris  = 0;
+    occScene     = NULL;
+    occReady     = false;
+}
+
+// turn culling on or off, off passes every box
+void occEnable(bool enable)
+{
+    occEnabled = enable;
+}
+
+// world point relative to the eye in view space, x right, y up
+// and depth forward
+static void occView(GLfloat *p, GLdouble *out)
+{
+    GLdouble d[3] = {p[0]-occEye[0], p[1]-occEye[1], p[2]-occEye[2]};
+
+    out[0] = d[0]*occRight[0] + d[1]*occRight[1] + d[2]*occRight[2];
+    out[1] = d[0]*occUp[0]    + d[1]*occUp[1]    + d[2]*occUp[2];
+    out[2] = d[0]*occFwd[0]   + d[1]*occFwd[1]   + d[2]*occFwd[2];
+}
+
+// add a screen space triangle, dropping ones seen edge on
+static void occAddTriangle(GLdouble (*v)[3])
+{
+    int i;
+    GLdouble area;
+    occTriangle *t;
+
+    area = (v[1][0]-v[0][0])*(v[2][1]-v[0][1]) - (v[2][0]-v[0][0])*(v[1][1]-v[0][1]);
+    if (fabs(area) < 1.0e-6)
+        return;
+
+    if (occNumTris == occMaxTris) {
+        occMaxTris = occMaxTris ? 2*occMaxTris : 256;
+        occTris = (occTriangle*)realloc(occTris, occMaxTris * sizeof(occTriangle));
+        if (occTris == NULL) {
+            fprintf(stderr, "Fatal Error:  Out of memory for occluders.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // wind every triangle the same way so inside is positive
+    t = &occTris[occNumTris];
+    for (i = 0; i < 3; ++i) {
+        int j = (area > 0.0) ? i : (3-i) % 3;
+
+        t->x[i] = v[j][0];
+        t->y[i] = v[j][1];
+        t->z[i] = v[j][2];
+    }
+
+    t->x0 = floor(fmin(t->x[0], fmin(t->x[1], t->x[2])));
+    t->y0 = floor(fmin(t->y[0], fmin(t->y[1], t->y[2])));
+    t->x1 = ceil(fmax(t->x[0], fmax(t->x[1], t->x[2])));
+    t->y1 = ceil(fmax(t->y[0], fmax(t->y[1], t->y[2])));
+
+    if ((t->x1 < 0) || (t->y1 < 0) || (t->x0 >= OCC_WIDTH) || (t->y0 >= OCC_HEIGHT))
+        return;
+
+    ++occNumTris;
+}
+
+// clip an occluder to the near plane, project it and split it into triangles
+static void occSetupQuad(occQuad *q)
+{
+    int i, j, n = 0;
+    GLdouble view[4][3], poly[5][3], t;
+
+    for (i = 0; i < 4; ++i)
+        occView(q->corner[i], view[i]);
+
+    for (i = 0; i < 4; ++i) {
+        j = (i+1) % 4;
+
+        if (view[i][2] >= occNear)
+            memcpy(poly[n++], view[i], sizeof(poly[0]));
+
+        if ((view[i][2] >= occNear) != (view[j][2] >= occNear)) {
+            t = (occNear - view[i][2]) / (view[j][2] - view[i][2]);
+            poly[n][0] = view[i][0] + t*(view[j][0] - view[i][0]);
+            poly[n][1] = view[i][1] + t*(view[j][1] - view[i][1]);
+            poly[n][2] = occNear;
+            ++n;
+        }
+    }
+
+    if (n < 3)
+        return;
+
+    // to depth buffer pixels, keeping 1/depth which is linear on screen
+    for (i = 0; i < n; ++i) {
+        poly[i][0] = (poly[i][0]/poly[i][2]*occScaleX + 1.0) * 0.5 * OCC_WIDTH;
+        poly[i][1] = (poly[i][1]/poly[i][2]*occScaleY + 1.0) * 0.5 * OCC_HEIGHT;
+        poly[i][2] = 1.0 / poly[i][2];
+    }
+
+    for (i = 2; i < n; ++i) {
+        GLdouble tri[3][3];
+
+        memcpy(tri[0], poly[0],   sizeof(tri[0]));
+        memcpy(tri[1], poly[i-1], sizeof(tri[1]));
+        memcpy(tri[2], poly[i],   sizeof(tri[2]));
+        occAddTriangle(tri);
+    }
+}
+
+// draw every triangle into one tile of the depth buffer
+static void occRasterTile(int tile)
+{
+    int i, k, x, y, tx0, ty0, tx1, ty1, rx0, rx1, ry0, ry1;
+    float a[3], b[3], c[3], area, dzdx, dzdy, z0;
+    occTriangle *t;
+
+    tx0 = (tile % OCC_TILES_X) * OCC_TILE_WIDTH;
+    ty0 = (tile / OCC_TILES_X) * OCC_TILE_HEIGHT;
+    tx1 = tx0 + OCC_TILE_WIDTH  - 1;
+    ty1 = ty0 + OCC_TILE_HEIGHT - 1;
+
+    for (y = ty0; y <= ty1; ++y)
+        memset(&occDepth[y][tx0], 0, OCC_TILE_WIDTH * sizeof(float));
+
+    for (i = 0; i < occNumTris; ++i) {
+        t = &occTris[i];
+        if ((t->x1 < tx0) || (t->x0 > tx1) || (t->y1 < ty0) || (t->y0 > ty1))
+            continue;
+
+        // edge functions, positive inside
+        for (k = 0; k < 3; ++k) {
+            int j = (k+1) % 3;
+
+            a[k] = t->y[k] - t->y[j];
+            b[k] = t->x[j] - t->x[k];
+            c[k] = t->x[k]*t->y[j] - t->y[k]*t->x[j];
+        }
+
+        // depth plane
+        area = (t->x[1]-t->x[0])*(t->y[2]-t->y[0]) - (t->x[2]-t->x[0])*(t->y[1]-t->y[0]);
+        dzdx = ((t->z[1]-t->z[0])*(t->y[2]-t->y[0]) - (t->z[2]-t->z[0])*(t->y[1]-t->y[0])) / area;
+        dzdy = ((t->z[2]-t->z[0])*(t->x[1]-t->x[0]) - (t->z[1]-t->z[0])*(t->x[2]-t->x[0])) / area;
+        z0   = t->z[0] - dzdx*t->x[0] - dzdy*t->y[0];
+
+        // four pixel groups inside both the tile and the triangle
+        rx0 = (t->x0 > tx0) ? (t->x0 & ~3) : tx0;
+        rx1 = (t->x1 < tx1) ?  t->x1       : tx1;
+        ry0 = (t->y0 > ty0) ?  t->y0       : ty0;
+        ry1 = (t->y1 < ty1) ?  t->y1       : ty1;
+
+        for (y = ry0; y <= ry1; ++y) {
+            float yc = y + 0.5f;
+            float e0 = b[0]*yc + c[0], e1 = b[1]*yc + c[1], e2 = b[2]*yc + c[2];
+            float zr = dzdy*yc + z0;
+
+#ifdef __SSE2__
+            __m128 a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+            __m128 dz = _mm_set1_ps(dzdx), zero = _mm_setzero_ps();
+
+            for (x = rx0; x <= rx1; x += 4) {
+                __m128 xc   = _mm_set_ps(x+3.5f, x+2.5f, x+1.5f, x+0.5f);
+                __m128 in   = _mm_and_ps(_mm_and_ps(
+                                  _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, xc), _mm_set1_ps(e0)), zero),
+                                  _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, xc), _mm_set1_ps(e1)), zero)),
+                                  _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, xc), _mm_set1_ps(e2)), zero));
+                __m128 z    = _mm_add_ps(_mm_mul_ps(dz, xc), _mm_set1_ps(zr));
+                __m128 cur  = _mm_load_ps(&occDepth[y][x]);
+                __m128 near = _mm_max_ps(cur, z);
+
+                _mm_store_ps(&occDepth[y][x], _mm_or_ps(_mm_and_ps(in, near), _mm_andnot_ps(in, cur)));
+            }
+#else
+            for (x = rx0; x <= rx1; ++x) {
+                float xc = x + 0.5f, z = dzdx*xc + zr;
+
+                if ((a[0]*xc + e0 >= 0.0f) && (a[1]*xc + e1 >= 0.0f) && (a[2]*xc + e2 >= 0.0f) &&
+                    (z > occDepth[y][x]))
+                    occDepth[y][x] = z;
+            }
+#endif
+        }
+    }
+}
+
+// draw a run of tiles, one job's share
+static void occRasterTiles(void *arg, int begin, int end)
+{
+    int tile;
+
+    for (tile = begin; tile < end; ++tile)
+        occRasterTile(tile);
+}
+
+// draw the walls of the visible rooms as seen by a camera at x, y, z
+// facing h degrees horizontally and v vertically, with a near plane
+// zNear away of half extents halfWidth by halfHeight
+void occRender(GLdouble x, GLdouble y, GLdouble z, GLdouble h, GLdouble v,
+               GLdouble halfWidth, GLdouble halfHeight, GLdouble zNear)
+{
+    int i, k, room;
+    GLdouble sh, ch, sv, cv;
+
+    atomic_store(&occTested, 0);
+    atomic_store(&occCulled, 0);
+    occReady = false;
+
+    if (!occEnabled || (occScene == NULL))
+        return;
+
+    // eye axes in the world, as the visibility walk finds them
+    sh = sin(h * M_PI / 180.0);
+    ch = cos(h * M_PI / 180.0);
+    sv = sin(v * M_PI / 180.0);
+    cv = cos(v * M_PI / 180.0);
+
+    occEye[0]   = x;       occEye[1]   = y;    occEye[2]   = z;
+    occFwd[0]   = -cv*sh;  occFwd[1]   = sv;   occFwd[2]   = -cv*ch;
+    occRight[0] =  ch;     occRight[1] = 0.0;  occRight[2] = -sh;
+    occUp[0]    =  sv*sh;  occUp[1]    = cv;   occUp[2]    =  sv*ch;
+
+    occScaleX = zNear / halfWidth;
+    occScaleY = zNear / halfHeight;
+    occNear   = zNear;
+
+    // triangles from every wall that could be in view
+    occNumTris = 0;
+    for (i = 0; i < visNumRooms(); ++i) {
+        room = visRoom(i);
+        for (k = occRoomFirst[room]; k < occRoomFirst[room] + occRoomCount[room]; ++k)
+            occSetupQuad(&occQuads[k]);
+    }
+
+    // tiles share no pixels, each is a job of its own
+    jobParallelFor(occRasterTiles, NULL, 0, OCC_NUM_TILES, 1);
+
+    occReady = true;
+}
+
+// could any of the box from lo to hi be seen, false only when it is
+// out of view or behind the walls drawn this frame
+bool occTestBox(GLdouble *lo, GLdouble *hi)
+{
+    int i, x, y, x0, y0, x1, y1;
+    GLfloat corner[3];
+    GLdouble view[3], sx, sy, nearest = 0.0;
+    GLdouble minX = OCC_WIDTH, minY = OCC_HEIGHT, maxX = -1.0, maxY = -1.0;
+    float limit;
+
+    if (!occReady)
+        return true;
+
+    atomic_fetch_add(&occTested, 1);
+
+    for (i = 0; i < 8; ++i) {
+        corner[0] = (i & 1) ? hi[0] : lo[0];
+        corner[1] = (i & 2) ? hi[1] : lo[1];
+        corner[2] = (i & 4) ? hi[2] : lo[2];
+        occView(corner, view);
+
+        // reaching past the near plane, keep it
+        if (view[2] < occNear)
+            return true;
+
+        sx = (view[0]/view[2]*occScaleX + 1.0) * 0.5 * OCC_WIDTH;
+        sy = (view[1]/view[2]*occScaleY + 1.0) * 0.5 * OCC_HEIGHT;
+
+        if (sx < minX) minX = sx;
+        if (sx > maxX) maxX = sx;
+        if (sy < minY) minY = sy;
+        if (sy > maxY) maxY = sy;
+        if (1.0/view[2] > nearest)
+            nearest = 1.0/view[2];
+    }
+
+    // out of view altogether
+    if ((maxX < 0.0) || (maxY < 0.0) || (minX >= OCC_WIDTH) || (minY >= OCC_HEIGHT)) {
+        atomic_fetch_add(&occCulled, 1);
+        return false;
+    }
+
+    // whole four pixel groups covering the box on screen
+    x0 = (minX > 0.0) ? ((int)minX & ~3) : 0;
+    y0 = (minY > 0.0) ? (int)minY : 0;
+    x1 = (maxX < OCC_WIDTH-1)  ? (int)maxX : OCC_WIDTH-1;
+    y1 = (maxY < OCC_HEIGHT-1) ? (int)maxY : OCC_HEIGHT-1;
+
+    // seen wherever no wall is nearer than its nearest corner
+    limit = nearest * (1.0 + OCC_BIAS);
+    for (y = y0; y <= y1; ++y) {
+#ifdef __SSE2__
+        __m128 l = _mm_set1_ps(limit);
+
+        for (x = x0; x <= x1; x += 4)
+            if (_mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(&occDepth[y][x]), l)) != 0)
+                return true;
+#else
+        for (x = x0; x <= x1; ++x)
+            if (occDepth[y][x] <= limit)
+                return true;
+#endif
+    }
+
+    atomic_fetch_add(&occCulled, 1);
+    return false;
+}
+
+// boxes tested this frame
+int occNumTested()
+{
+    return atomic_load(&occTested);
+}
+
+// boxes found hidden this frame
+int occNumCulled()
+{
+    return atomic_load(&occCulled);
+}
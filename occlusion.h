@@ -0,0 +1,100 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Software occlusion culling
+ *
+ *  Rasterizes the walls of the visible rooms into a small depth
+ *  buffer on the CPU each frame, split into screen tiles run as
+ *  jobs, then tests the bounding boxes of exhibits and windows
+ *  against it so whatever is hidden behind a wall, or out of
+ *  view, is never submitted.  Depth is stored as the reciprocal
+ *  of the view distance, larger is nearer.
+ */
+
+#ifndef OCCLUSION_H
+    #define OCCLUSION_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // scene description
+    #include "scene.h"
+
+    // depth buffer size, the width a multiple of four
+    #define OCC_WIDTH  256
+    #define OCC_HEIGHT 128
+
+    // screen tiles, each rasterized as a job of its own
+    #define OCC_TILE_WIDTH  64
+    #define OCC_TILE_HEIGHT 32
+    #define OCC_TILES_X     (OCC_WIDTH / OCC_TILE_WIDTH)
+    #define OCC_TILES_Y     (OCC_HEIGHT / OCC_TILE_HEIGHT)
+    #define OCC_NUM_TILES   (OCC_TILES_X * OCC_TILES_Y)
+
+    // relative depth an occluder must be nearer by to hide a box
+    #define OCC_BIAS 0.001
+
+    /* one wall panel that blocks the view */
+    typedef struct {
+        GLfloat corner[4][3];       /* world space, in order around it */
+    } occQuad;
+
+    /* rasterizer triangle in depth buffer pixels */
+    typedef struct {
+        GLfloat x[3], y[3], z[3];   /* z is 1/distance */
+        int     x0, y0, x1, y1;     /* pixel bounds, inclusive */
+    } occTriangle;
+
+    bool occInit(scene *s);                              // build occluders
+    void occFree();                                      // free occluders
+    void occEnable(bool enable);                         // turn culling on or off
+    void occRender(GLdouble x, GLdouble y, GLdouble z,   // draw the visible walls from the camera
+                   GLdouble h, GLdouble v, GLdouble halfWidth,
+                   GLdouble halfHeight, GLdouble zNear);
+    bool occTestBox(GLdouble *lo, GLdouble *hi);         // could any of a box be seen
+    int  occNumTested();                                 // boxes tested this frame
+    int  occNumCulled();                                 // boxes found hidden this frame
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -30,11 +30,16 @@
 
 #include "pngLoader.h"
 
+// chrome trace markers
+#include "trace.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 
 glpngtexture *genPNGTexture(char *filename)
 {
+    TRACE_FUNC();
+
     png_byte magic[8];
     png_structp png_ptr;
     png_infop info_ptr;
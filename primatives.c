@@ -45,9 +45,20 @@
 // prototypes and definitions
 #include "primatives.h"
 
+// single precision matrix stack
+#include "matrix.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// per-frame gl call counters, must follow the OpenGL headers
+#include "glCounters.h"
+
 // draw a frustum with base w1, top width w2, and height h
 void drawFrustum(GLdouble w1, GLdouble w2, GLdouble h)
 {
+    TRACE_FUNC();
+
     int i;
 
     GLdouble a      = (w1 - w2) / 2.0;
@@ -56,17 +67,18 @@ void drawFrustum(GLdouble w1, GLdouble w2, GLdouble h)
     GLdouble w4     = sqrt(a*a+h*h);
 
     // draw frustum
-    glMatrixMode(GL_MODELVIEW);
+    matMode(MAT_MODELVIEW);
     for (i = 0; i < 4; ++i) {
-        glPushMatrix();
-            glRotated(i*90.0, 0.0, 1.0, 0.0);
-            glTranslated(0.0, 0.0, w1/2.0);
-            glRotated(-phi*(180.0/M_PI), 1.0, 0.0, 0.0);
+        matPush();
+            matRotate(i*90.0, 0.0, 1.0, 0.0);
+            matTranslate(0.0, 0.0, w1/2.0);
+            matRotate(-phi*(180.0/M_PI), 1.0, 0.0, 0.0);
             drawTrap(w1, w2, w4);
-        glPopMatrix();
+        matPop();
     }
 
     // draw cap
+    matUpload();
     glBegin(GL_QUADS);
         glNormal3f(0.0, 1.0, 0.0);
         glVertex3d(-w2/2.0, h,  w2/2.0);
@@ -81,6 +93,7 @@ void drawTrap(GLdouble w1, GLdouble w2, GLdouble h)
 {
     GLdouble a = (w1 - w2) / 2.0;
 
+    matUpload();
     glBegin(GL_QUADS);
         glNormal3f(0.0, 0.0, 1.0);
         glVertex3d( -w1/2.0,    0.0, 0.0);
@@ -89,3 +102,54 @@ void drawTrap(GLdouble w1, GLdouble w2, GLdouble h)
         glVertex3d((-w1/2.0)+a, h,   0.0);
     glEnd();
 }
+
+// add a frustum like drawFrustum to the object being baked,
+// its four sides and cap in the order drawFrustum draws them
+void bakeFrustum(batch *b, GLfloat w1, GLfloat w2, GLfloat h)
+{
+    int i, j, base;
+    GLfloat p[3], n[3];
+
+    GLdouble a   = (w1 - w2) / 2.0;
+    GLdouble phi = (M_PI_2) - atan2(h,a);
+
+    // corners of the side facing +z, base first
+    GLfloat const side[4][3] = {
+        {-w1/2.0, 0.0, w1/2.0},
+        { w1/2.0, 0.0, w1/2.0},
+        { w2/2.0, h,   w2/2.0},
+        {-w2/2.0, h,   w2/2.0}
+    };
+    GLfloat const cap[4][3] = {
+        {-w2/2.0, h,  w2/2.0},
+        { w2/2.0, h,  w2/2.0},
+        { w2/2.0, h, -w2/2.0},
+        {-w2/2.0, h, -w2/2.0}
+    };
+    GLfloat const up[3] = {0.0, 1.0, 0.0};
+
+    // each side is the first turned a quarter about y
+    for (i = 0; i < 4; ++i) {
+        GLdouble c = cos(i*M_PI_2), s = sin(i*M_PI_2);
+
+        n[0] = s*cos(phi);
+        n[1] = sin(phi);
+        n[2] = c*cos(phi);
+
+        base = b->numVerts;
+        for (j = 0; j < 4; ++j) {
+            p[0] =  c*side[j][0] + s*side[j][2];
+            p[1] =    side[j][1];
+            p[2] = -s*side[j][0] + c*side[j][2];
+            batchVertex(b, p, n, NULL);
+        }
+        batchTriangle(b, base, base+1, base+2);
+        batchTriangle(b, base, base+2, base+3);
+    }
+
+    base = b->numVerts;
+    for (j = 0; j < 4; ++j)
+        batchVertex(b, cap[j], up, NULL);
+    batchTriangle(b, base, base+1, base+2);
+    batchTriangle(b, base, base+2, base+3);
+}
@@ -46,6 +46,9 @@
         #include <GL/glut.h>
     #endif
 
+    // shared vertex arrays
+    #include "batch.h"
+
     // number of tessilations
     #define PRIMATIVE_RES 8
 
@@ -55,6 +58,9 @@
     // draw a frustum with base w1, top width w2, and height h
     void drawTrap(GLdouble w1, GLdouble w2, GLdouble h);
 
+    // add a frustum like drawFrustum to the object being baked
+    void bakeFrustum(batch *b, GLfloat w1, GLfloat w2, GLfloat h);
+
     #ifdef __cplusplus
         }
     #endif
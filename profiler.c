@@ -0,0 +1,409 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Per-phase CPU and GPU frame profiler
+ *
+ *  Each phase of a frame is bracketed by CPU timers and a pair
+ *  of GPU timestamp queries.  Queries are double-buffered so the
+ *  results of the previous frame are read while the current one
+ *  is being drawn, which avoids stalling the pipeline.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+    #include <GL/glext.h>
+    #include <GL/glx.h>
+#endif
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "profiler.h"
+
+// per-frame gl call counters
+#include "glCounters.h"
+
+// phase names, also used as debug group labels and csv columns
+char *profNames[PROF_NUM_PHASES] = {
+    "clear", "camera", "lights", "floor", "ceiling", "walls", "outside",
+    "sculpture1", "sculpture2", "sculpture3", "sculpture4", "sculpture5",
+    "glass", "hud", "swap", "visibility", "streaming", "occlusion"
+};
+
+// gpu timer and debug group entry points
+#ifndef __APPLE__
+PFNGLGENQUERIESPROC          profGenQueries          = NULL;
+PFNGLQUERYCOUNTERPROC        profQueryCounter        = NULL;
+PFNGLGETQUERYOBJECTIVPROC    profGetQueryObjectiv    = NULL;
+PFNGLGETQUERYOBJECTUI64VPROC profGetQueryObjectui64v = NULL;
+PFNGLPUSHDEBUGGROUPPROC      profPushDebugGroup      = NULL;
+PFNGLPOPDEBUGGROUPPROC       profPopDebugGroup       = NULL;
+#endif
+
+bool gpuTimers   = false;
+bool debugGroups = false;
+
+// query objects, a begin and end timestamp per phase per buffer
+GLuint profQueries[PROF_BUFFERS][PROF_NUM_PHASES][2];
+bool   profIssued[PROF_BUFFERS][PROF_NUM_PHASES];
+
+// cpu timings per buffer, kept until the matching gpu results arrive
+double profCPUStart[PROF_NUM_PHASES];
+double profCPU[PROF_BUFFERS][PROF_NUM_PHASES];
+double profFrameCPU[PROF_BUFFERS];
+long   profFrameNum[PROF_BUFFERS];
+
+// latest resolved results
+double lastCPU[PROF_NUM_PHASES];
+double lastGPU[PROF_NUM_PHASES];
+double lastFrame = 0.0;
+double lastWork  = 0.0;
+
+// smoothed results for the hud
+double avgCPU[PROF_NUM_PHASES];
+double avgGPU[PROF_NUM_PHASES];
+double avgFrame = 0.0;
+
+// frame bookkeeping
+long   profFrame     = 0;
+int    profBuf       = 0;
+double profLastFrame = 0.0;
+double profWorkStart = 0.0;
+
+// hud and csv state
+bool  showHUD = false;
+FILE *profCSV = NULL;
+
+// test for at least OpenGL major.minor
+static bool profVersion(int major, int minor)
+{
+    int maj = 0, min = 0;
+    const char *version = (const char*)glGetString(GL_VERSION);
+
+    if ((version == NULL) || (sscanf(version, "%d.%d", &maj, &min) != 2))
+        return false;
+
+    return (maj > major) || ((maj == major) && (min >= minor));
+}
+
+// create GPU queries for the current context
+// must be called again whenever the context is recreated
+void profInit()
+{
+    int i;
+
+    gpuTimers   = false;
+    debugGroups = false;
+
+    memset(profIssued, 0, sizeof(profIssued));
+    for (i = 0; i < PROF_NUM_PHASES; ++i) {
+        lastGPU[i] = -1.0;
+        avgGPU[i]  = -1.0;
+    }
+
+#ifndef __APPLE__
+    if (profVersion(3, 3) || glutExtensionSupported("GL_ARB_timer_query")) {
+        profGenQueries          = (PFNGLGENQUERIESPROC)glXGetProcAddressARB((const GLubyte*)"glGenQueries");
+        profQueryCounter        = (PFNGLQUERYCOUNTERPROC)glXGetProcAddressARB((const GLubyte*)"glQueryCounter");
+        profGetQueryObjectiv    = (PFNGLGETQUERYOBJECTIVPROC)glXGetProcAddressARB((const GLubyte*)"glGetQueryObjectiv");
+        profGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)glXGetProcAddressARB((const GLubyte*)"glGetQueryObjectui64v");
+
+        gpuTimers = (profGenQueries != NULL) && (profQueryCounter != NULL) &&
+                    (profGetQueryObjectiv != NULL) && (profGetQueryObjectui64v != NULL);
+    }
+
+    if (gpuTimers)
+        profGenQueries(PROF_BUFFERS*PROF_NUM_PHASES*2, &profQueries[0][0][0]);
+
+    if (profVersion(4, 3) || glutExtensionSupported("GL_KHR_debug")) {
+        profPushDebugGroup = (PFNGLPUSHDEBUGGROUPPROC)glXGetProcAddressARB((const GLubyte*)"glPushDebugGroup");
+        profPopDebugGroup  = (PFNGLPOPDEBUGGROUPPROC)glXGetProcAddressARB((const GLubyte*)"glPopDebugGroup");
+
+        debugGroups = (profPushDebugGroup != NULL) && (profPopDebugGroup != NULL);
+    }
+#endif
+}
+
+// start timing a phase
+void profBegin(int phase)
+{
+#ifdef COUNT_GL_CALLS
+    glcSetBucket(phase);
+#endif
+
+#ifndef __APPLE__
+    if (debugGroups)
+        profPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, phase, -1, profNames[phase]);
+
+    if (gpuTimers) {
+        profQueryCounter(profQueries[profBuf][phase][0], GL_TIMESTAMP);
+        profIssued[profBuf][phase] = true;
+    }
+#endif
+
+    profCPUStart[phase] = timeNow();
+}
+
+// stop timing a phase
+void profEnd(int phase)
+{
+    profCPU[profBuf][phase] += timeNow() - profCPUStart[phase];
+
+#ifndef __APPLE__
+    if (gpuTimers)
+        profQueryCounter(profQueries[profBuf][phase][1], GL_TIMESTAMP);
+
+    if (debugGroups)
+        profPopDebugGroup();
+#endif
+
+#ifdef COUNT_GL_CALLS
+    glcSetBucket(GLC_OTHER);
+#endif
+}
+
+// add the time of a phase run on another thread, cpu only
+void profAddCPU(int phase, double ms)
+{
+    profCPU[profBuf][phase] += ms;
+}
+
+// start a new frame in the current buffer
+void profFrameBegin()
+{
+    int i;
+
+    for (i = 0; i < PROF_NUM_PHASES; ++i) {
+        profCPU[profBuf][i] = 0.0;
+        profIssued[profBuf][i] = false;
+    }
+
+    profFrameNum[profBuf] = profFrame;
+    profWorkStart = timeNow();
+}
+
+// write one csv row for a resolved frame
+static void profWriteCSV(int buf, double *gpu)
+{
+    int i;
+
+    fprintf(profCSV, "%ld,%.4f", profFrameNum[buf], profFrameCPU[buf]);
+    for (i = 0; i < PROF_NUM_PHASES; ++i)
+        fprintf(profCSV, ",%.4f,%.4f", profCPU[buf][i], gpu[i]);
+    fprintf(profCSV, "\n");
+}
+
+// blend a new sample into a running average
+static double profSmooth(double avg, double sample)
+{
+    if (avg < 0.0)
+        return sample;
+
+    return avg + PROF_SMOOTHING*(sample - avg);
+}
+
+// close the current frame and resolve the previous one
+void profFrameEnd()
+{
+    int i;
+    int prev = (profBuf+1) % PROF_BUFFERS;
+    double now = timeNow();
+    double gpu[PROF_NUM_PHASES];
+
+    profFrameCPU[profBuf] = (profFrame > 0) ? now - profLastFrame : 0.0;
+    profLastFrame = now;
+    lastWork = now - profWorkStart;
+
+    lastFrame = profFrameCPU[profBuf];
+    avgFrame  = profSmooth(avgFrame, lastFrame);
+
+    for (i = 0; i < PROF_NUM_PHASES; ++i) {
+        lastCPU[i] = profCPU[profBuf][i];
+        avgCPU[i]  = profSmooth(avgCPU[i], lastCPU[i]);
+    }
+
+    // results of the previous frame should now be available
+    if (profFrame > 0) {
+        for (i = 0; i < PROF_NUM_PHASES; ++i) {
+            gpu[i] = -1.0;
+
+#ifndef __APPLE__
+            if (gpuTimers && profIssued[prev][i]) {
+                GLint available = 0;
+                GLuint64 start, end;
+
+                profGetQueryObjectiv(profQueries[prev][i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) {
+                    profGetQueryObjectui64v(profQueries[prev][i][0], GL_QUERY_RESULT, &start);
+                    profGetQueryObjectui64v(profQueries[prev][i][1], GL_QUERY_RESULT, &end);
+
+                    gpu[i]     = (end - start) / 1000000.0;
+                    lastGPU[i] = gpu[i];
+                    avgGPU[i]  = profSmooth(avgGPU[i], gpu[i]);
+                }
+            }
+#endif
+        }
+
+        if (profCSV != NULL)
+            profWriteCSV(prev, gpu);
+    }
+
+#ifdef COUNT_GL_CALLS
+    glcFrameEnd();
+#endif
+
+    ++profFrame;
+    profBuf = (profBuf+1) % PROF_BUFFERS;
+}
+
+// name of a phase
+char *profPhaseName(int phase)
+{
+    return profNames[phase];
+}
+
+// last cpu time of a phase in ms
+double profCPUTime(int phase)
+{
+    return lastCPU[phase];
+}
+
+// last gpu time of a phase in ms, -1 if unknown
+double profGPUTime(int phase)
+{
+    return lastGPU[phase];
+}
+
+// last frame time in ms
+double profFrameTime()
+{
+    return lastFrame;
+}
+
+// time spent drawing and swapping the last frame in ms
+double profFrameWork()
+{
+    return lastWork;
+}
+
+// are gpu timers available
+bool profGPUTimers()
+{
+    return gpuTimers;
+}
+
+// show or hide the hud
+void profToggleHUD()
+{
+    showHUD = !showHUD;
+}
+
+// is the hud visible
+bool profHUDVisible()
+{
+    return showHUD;
+}
+
+// draw the hud, one line per phase, starting at the top of the window
+// returns the y coordinate of the next free line
+int profDrawHUD(int height, void (*text)(int x, int y, char *t))
+{
+    int i;
+    int y = height - 2*PROF_HUD_LINE;
+    char line[80];
+
+    sprintf(line, "frame %7.2f ms  %6.1f fps%s", avgFrame,
+            (avgFrame > 0.0) ? 1000.0/avgFrame : 0.0, (profCSV != NULL) ? "  [csv]" : "");
+    text(10, y, line);
+    y -= PROF_HUD_LINE;
+
+    sprintf(line, "%-11s %8s %8s", "phase", "cpu ms", "gpu ms");
+    text(10, y, line);
+    y -= PROF_HUD_LINE;
+
+    for (i = 0; i < PROF_NUM_PHASES; ++i) {
+        if (avgGPU[i] >= 0.0)
+            sprintf(line, "%-11s %8.3f %8.3f", profNames[i], avgCPU[i], avgGPU[i]);
+        else
+            sprintf(line, "%-11s %8.3f %8s", profNames[i], avgCPU[i], "--");
+
+        text(10, y, line);
+        y -= PROF_HUD_LINE;
+    }
+
+    return y;
+}
+
+// start exporting resolved frames to a csv file
+bool profCSVOpen(char *fileName)
+{
+    int i;
+
+    profCSVClose();
+
+    profCSV = fopen(fileName, "w");
+    if (!profCSV) {
+        fprintf(stderr, "error: couldn't open \"%s\"!\n", fileName);
+        return false;
+    }
+
+    fprintf(profCSV, "frame,frame_ms");
+    for (i = 0; i < PROF_NUM_PHASES; ++i)
+        fprintf(profCSV, ",%s_cpu_ms,%s_gpu_ms", profNames[i], profNames[i]);
+    fprintf(profCSV, "\n");
+
+    return true;
+}
+
+// stop exporting to csv
+void profCSVClose()
+{
+    if (profCSV != NULL) {
+        fclose(profCSV);
+        profCSV = NULL;
+    }
+}
+
+// is csv export running
+bool profCSVActive()
+{
+    return profCSV != NULL;
+}
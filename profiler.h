@@ -0,0 +1,110 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Per-phase CPU and GPU frame profiler
+ *
+ *  Each phase of a frame is bracketed by CPU timers and a pair
+ *  of GPU timestamp queries.  Queries are double-buffered so the
+ *  results of the previous frame are read while the current one
+ *  is being drawn, which avoids stalling the pipeline.
+ */
+
+#ifndef PROFILER_H
+    #define PROFILER_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // frame phases
+    #define PROF_CLEAR       0
+    #define PROF_CAMERA      1
+    #define PROF_LIGHTS      2
+    #define PROF_FLOOR       3
+    #define PROF_CEILING     4
+    #define PROF_WALLS       5
+    #define PROF_OUTSIDE     6
+    #define PROF_SCULPTURE1  7
+    #define PROF_SCULPTURE2  8
+    #define PROF_SCULPTURE3  9
+    #define PROF_SCULPTURE4  10
+    #define PROF_SCULPTURE5  11
+    #define PROF_GLASS       12
+    #define PROF_HUD         13
+    #define PROF_SWAP        14
+    #define PROF_VISIBILITY  15
+    #define PROF_STREAMING   16
+    #define PROF_OCCLUSION   17
+    #define PROF_NUM_PHASES  18
+
+    // number of query sets in flight
+    #define PROF_BUFFERS 2
+
+    // weight of the newest sample in the hud averages
+    #define PROF_SMOOTHING 0.1
+
+    // hud line spacing in pixels
+    #define PROF_HUD_LINE 15
+
+    void   profInit();                                   // create GPU queries for this context
+    void   profBegin(int phase);                         // start timing a phase
+    void   profEnd(int phase);                           // stop timing a phase
+    void   profAddCPU(int phase, double ms);             // add cpu time of a phase timed elsewhere
+    void   profFrameBegin();                             // start a new frame
+    void   profFrameEnd();                               // resolve the previous frame
+    char  *profPhaseName(int phase);                     // name of a phase
+    double profCPUTime(int phase);                       // last cpu time of a phase in ms
+    double profGPUTime(int phase);                       // last gpu time of a phase in ms, -1 if unknown
+    double profFrameTime();                              // last frame time in ms
+    double profFrameWork();                              // last frame's draw and swap time in ms
+    bool   profGPUTimers();                              // are gpu timers available
+    void   profToggleHUD();                              // show or hide the hud
+    bool   profHUDVisible();                             // is the hud visible
+    int    profDrawHUD(int height,                       // draw hud lines, returns next y
+                       void (*text)(int x, int y, char *t));
+    bool   profCSVOpen(char *fileName);                  // start exporting to csv
+    void   profCSVClose();                               // stop exporting to csv
+    bool   profCSVActive();                              // is csv export running
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,219 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Demand driven redraw scheduling
+ *
+ *  Everything that changes the picture posts the cause of its
+ *  change here instead of asking glut for a redisplay directly.
+ *  Causes are collected until the next frame so any number of
+ *  them cost one frame, nothing is drawn when nothing changed or
+ *  while the window cannot be seen, and an optional frame rate
+ *  cap spaces frames out with a timer instead of drawing them.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "redraw.h"
+
+// causes by bit
+char *redrawNames[REDRAW_NUM_CAUSES] = {
+    "input", "motion", "animation", "window", "benchmark"
+};
+
+// shortest ms between frames, 0 for no cap
+double redrawInterval = 0.0;
+
+// causes waiting for the next frame and those of the frame being
+// drawn, which a render thread's heads-up display reads
+int        redrawPending = 0;
+atomic_int redrawCurrent = 0;
+
+// a redisplay or a cap timer has been asked of glut
+bool redrawPosted = false;
+bool redrawTimer  = false;
+
+// a frame is being prepared, causes posted meanwhile wait for it
+bool redrawDrawing = false;
+
+// can the window be seen
+bool redrawVisible = true;
+
+// may a frame start now, NULL if always
+bool (*redrawGate)(void) = NULL;
+
+// when the last frame began
+double redrawLast = 0.0;
+
+// totals, counted on the glut thread and read from any
+atomic_long redrawFrames = 0;
+atomic_long redrawPosts  = 0;
+
+// set the frame rate cap, 0 or less for none
+void redrawInit(double fpsCap)
+{
+    redrawInterval = (fpsCap > 0.0) ? 1000.0/fpsCap : 0.0;
+}
+
+static void redrawSchedule();
+
+// the cap has passed or the gate may have opened, try again
+static void redrawFire(int value)
+{
+    redrawTimer = false;
+
+    if (redrawPending != 0)
+        redrawSchedule();
+}
+
+// ask for the pending causes to be drawn as soon as allowed
+static void redrawSchedule()
+{
+    double wait;
+
+    if (redrawPosted || redrawTimer || redrawDrawing)
+        return;
+
+    // scripted frames are measured, never held back
+    if (!(redrawPending & REDRAW_BENCHMARK)) {
+        if (!redrawVisible)
+            return;
+
+        wait = redrawLast + redrawInterval - timeNow();
+        if ((wait <= 0.0) && (redrawGate != NULL) && !redrawGate())
+            wait = REDRAW_GATE_RETRY;
+
+        if (wait > 0.0) {
+            redrawTimer = true;
+            glutTimerFunc((unsigned int)ceil(wait), redrawFire, 0);
+            return;
+        }
+    }
+
+    // glut draws at most once however often this is posted
+    redrawPosted = true;
+    glutPostRedisplay();
+}
+
+// something changed, draw it soon
+void redrawPost(int cause)
+{
+    atomic_fetch_add(&redrawPosts, 1);
+
+    redrawPending |= cause;
+    redrawSchedule();
+}
+
+// register a check that a new frame may start, a render thread
+// uses it to keep frames from being prepared faster than drawn
+void redrawGateFunc(bool (*func)(void))
+{
+    redrawGate = func;
+}
+
+// a frame is being drawn, what it shows is no longer pending
+// glut also draws unasked when the window is exposed
+void redrawFrameBegin()
+{
+    atomic_fetch_add(&redrawFrames, 1);
+
+    atomic_store(&redrawCurrent, redrawPending ? redrawPending : REDRAW_WINDOW);
+    redrawPending = 0;
+    redrawPosted  = false;
+    redrawDrawing = true;
+    redrawLast    = timeNow();
+}
+
+// the frame is prepared, schedule whatever was posted during it
+void redrawFrameEnd()
+{
+    redrawDrawing = false;
+
+    if (redrawPending != 0)
+        redrawSchedule();
+}
+
+// glut window status call-back
+// stop drawing while hidden or covered, catch up once seen again
+void redrawWindowStatus(int state)
+{
+    redrawVisible = (state != GLUT_HIDDEN) && (state != GLUT_FULLY_COVERED);
+
+    if (redrawVisible)
+        redrawPost(REDRAW_WINDOW);
+}
+
+// causes of the frame being drawn
+int redrawCauses()
+{
+    return atomic_load(&redrawCurrent);
+}
+
+// names of a set of causes, space separated
+void redrawDescribe(int causes, char *out)
+{
+    int i;
+
+    out[0] = '\0';
+    for (i = 0; i < REDRAW_NUM_CAUSES; ++i) {
+        if (causes & (1 << i)) {
+            if (out[0] != '\0')
+                strcat(out, " ");
+            strcat(out, redrawNames[i]);
+        }
+    }
+}
+
+// frames drawn so far
+long redrawNumFrames()
+{
+    return atomic_load(&redrawFrames);
+}
+
+// redraws asked for so far, many fold into each frame
+long redrawNumPosts()
+{
+    return atomic_load(&redrawPosts);
+}
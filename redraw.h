@@ -0,0 +1,78 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Demand driven redraw scheduling
+ *
+ *  Everything that changes the picture posts the cause of its
+ *  change here instead of asking glut for a redisplay directly.
+ *  Causes are collected until the next frame so any number of
+ *  them cost one frame, nothing is drawn when nothing changed or
+ *  while the window cannot be seen, and an optional frame rate
+ *  cap spaces frames out with a timer instead of drawing them.
+ */
+
+#ifndef REDRAW_H
+    #define REDRAW_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // reasons to draw a frame
+    #define REDRAW_INPUT      0x01  /* key or mouse input */
+    #define REDRAW_MOTION     0x02  /* the camera is still moving */
+    #define REDRAW_ANIMATION  0x04  /* the exhibits are animating */
+    #define REDRAW_WINDOW     0x08  /* the window was uncovered or resized */
+    #define REDRAW_BENCHMARK  0x10  /* scripted frames, never throttled */
+    #define REDRAW_NUM_CAUSES 5
+
+    // longest description of a set of causes
+    #define REDRAW_MAX_DESCRIPTION 64
+
+    // ms between checks while the gate is closed
+    #define REDRAW_GATE_RETRY 1
+
+    void redrawInit(double fpsCap);                      // set the frame rate cap, 0 for none
+    void redrawPost(int cause);                          // something changed, draw it soon
+    void redrawGateFunc(bool (*func)(void));             // register a check that a frame may start
+    void redrawFrameBegin();                             // a frame is being drawn
+    void redrawFrameEnd();                               // the frame has been handed off
+    void redrawWindowStatus(int state);                  // glut window status call-back
+    int  redrawCauses();                                 // causes of the frame being drawn
+    void redrawDescribe(int causes, char *out);          // names of a set of causes
+    long redrawNumFrames();                              // frames drawn
+    long redrawNumPosts();                               // redraws asked for
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
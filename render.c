@@ -0,0 +1,322 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Render thread fed by scene snapshots
+ *
+ *  Input, camera motion and the animation clock stay on the glut
+ *  thread, which packs everything a frame needs into a snapshot
+ *  each time it prepares one.  A second thread owns the OpenGL
+ *  context and draws whichever snapshot is newest.  Snapshots
+ *  pass through a lock-free triple buffer: the glut thread fills
+ *  its back slot and swaps it for the middle one, the render
+ *  thread swaps the middle one for its front slot, and neither
+ *  ever waits on the other to read or write a snapshot.
+ */
+
+// cpu affinity
+#ifdef __linux__
+    #define _GNU_SOURCE
+    #include <sched.h>
+#endif
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+    #include <GL/glx.h>
+#endif
+
+// 3d navigation
+#include "navigator.h"
+
+// demand driven redraws
+#include "redraw.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// prototypes and definitions
+#include "render.h"
+
+// asked for, and started
+bool renderWanted  = false;
+bool renderRunning = false;
+
+// cpus to pin the glut and render threads to, -1 to leave alone
+int renderMainCpu   = -1;
+int renderThreadCpu = -1;
+
+// how snapshots are filled and drawn from
+int  (*renderSave)(double *state)        = NULL;
+void (*renderLoad)(double *state, int n) = NULL;
+
+// triple buffer, the glut thread owns the back slot, the render
+// thread the front one and the middle one is handed between them
+renderSnapshot renderSlots[RENDER_NUM_SLOTS];
+atomic_int     renderMiddle = 1;
+int            renderBack   = 0;
+int            renderFront  = 2;
+
+// the render thread sleeps here while there is nothing new to draw
+pthread_mutex_t renderLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  renderWake = PTHREAD_COND_INITIALIZER;
+pthread_t       renderThread;
+bool            renderQuit = false;
+
+// context handed to the render thread
+#ifndef __APPLE__
+Display     *renderDisplay  = NULL;
+GLXDrawable  renderDrawable = 0;
+GLXContext   renderContext  = NULL;
+#endif
+
+// totals, drawn counts on the render thread and the others on the
+// glut thread while the heads-up display reads them all
+atomic_long renderPublished = 0;
+atomic_long renderDrawn     = 0;
+atomic_long renderDropped   = 0;
+
+// pin the calling thread to a cpu
+static void renderPin(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (cpu < 0)
+        return;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        fprintf(stderr, "warning: could not pin a thread to cpu %d\n", cpu);
+#else
+    if (cpu >= 0)
+        fprintf(stderr, "warning: cpu affinity is not available here\n");
+#endif
+}
+
+// ask for a render thread, must come before glut opens the display
+// so xlib is made safe to call from both threads
+bool renderInit(int mainCpu, int renderCpu)
+{
+#ifdef __APPLE__
+    fprintf(stderr, "warning: a render thread needs glx, drawing on the main thread\n");
+    return false;
+#else
+    if (!XInitThreads()) {
+        fprintf(stderr, "warning: xlib is not thread safe, drawing on the main thread\n");
+        return false;
+    }
+
+    renderMainCpu   = mainCpu;
+    renderThreadCpu = renderCpu;
+    renderWanted    = true;
+
+    return true;
+#endif
+}
+
+// swap on the render thread without going through glut
+static void renderSwapBuffers()
+{
+#ifndef __APPLE__
+    if (renderDisplay != NULL) {
+        glXSwapBuffers(renderDisplay, renderDrawable);
+        return;
+    }
+#endif
+    glutSwapBuffers();
+}
+
+// draw the newest snapshot whenever there is one
+static void *renderLoop(void *arg)
+{
+    renderSnapshot *snap;
+    bool quit;
+
+    traceThreadName("render");
+    renderPin(renderThreadCpu);
+
+#ifndef __APPLE__
+    if (renderDisplay != NULL)
+        glXMakeCurrent(renderDisplay, renderDrawable, renderContext);
+#endif
+
+    for (;;) {
+        pthread_mutex_lock(&renderLock);
+        while (!renderQuit && !(atomic_load(&renderMiddle) & RENDER_FRESH))
+            pthread_cond_wait(&renderWake, &renderLock);
+        quit = renderQuit;
+        pthread_mutex_unlock(&renderLock);
+
+        if (quit)
+            break;
+
+        // take the middle slot, leaving the old front one in its place
+        renderFront = atomic_exchange(&renderMiddle, renderFront) & RENDER_SLOT_MASK;
+        snap = &renderSlots[renderFront];
+
+        renderLoad(snap->state, snap->n);
+        navRenderFrame();
+        atomic_fetch_add(&renderDrawn, 1);
+    }
+
+#ifndef __APPLE__
+    if (renderDisplay != NULL)
+        glXMakeCurrent(renderDisplay, None, NULL);
+#endif
+
+    return NULL;
+}
+
+// hand the current context to a new render thread, returns false
+// and leaves drawing on the calling thread if that is not possible
+bool renderStart()
+{
+    if (!renderWanted || (renderSave == NULL) || (renderLoad == NULL))
+        return false;
+
+#ifndef __APPLE__
+    renderDisplay  = glXGetCurrentDisplay();
+    renderDrawable = glXGetCurrentDrawable();
+    renderContext  = glXGetCurrentContext();
+
+    // a context is current on one thread at a time
+    if (renderDisplay != NULL)
+        glXMakeCurrent(renderDisplay, None, NULL);
+#endif
+
+    renderQuit = false;
+    if (pthread_create(&renderThread, NULL, renderLoop, NULL) != 0) {
+        fprintf(stderr, "warning: could not start the render thread, drawing on the main thread\n");
+#ifndef __APPLE__
+        if (renderDisplay != NULL)
+            glXMakeCurrent(renderDisplay, renderDrawable, renderContext);
+#endif
+        return false;
+    }
+
+    renderPin(renderMainCpu);
+
+    navDetach(true);
+    navBufferSwapFunc(renderSwapBuffers);
+    redrawGateFunc(renderReady);
+    renderRunning = true;
+
+    return true;
+}
+
+// stop the render thread and take the context back
+void renderFree()
+{
+    if (!renderRunning)
+        return;
+
+    pthread_mutex_lock(&renderLock);
+    renderQuit = true;
+    pthread_cond_signal(&renderWake);
+    pthread_mutex_unlock(&renderLock);
+
+    pthread_join(renderThread, NULL);
+
+#ifndef __APPLE__
+    if (renderDisplay != NULL)
+        glXMakeCurrent(renderDisplay, renderDrawable, renderContext);
+#endif
+
+    navDetach(false);
+    navBufferSwapFunc(glutSwapBuffers);
+    redrawGateFunc(NULL);
+    renderRunning = false;
+}
+
+// is a render thread drawing
+bool renderActive()
+{
+    return renderRunning;
+}
+
+// register how snapshots are filled and drawn from
+void renderStateFunc(int (*save)(double *state), void (*load)(double *state, int n))
+{
+    renderSave = save;
+    renderLoad = load;
+}
+
+// fill the back slot and make it the newest snapshot
+void renderPublish()
+{
+    renderSnapshot *snap = &renderSlots[renderBack];
+    int old;
+
+    snap->frame = atomic_fetch_add(&renderPublished, 1) + 1;
+    snap->n     = renderSave(snap->state);
+
+    old = atomic_exchange(&renderMiddle, renderBack | RENDER_FRESH);
+    if (old & RENDER_FRESH)
+        atomic_fetch_add(&renderDropped, 1);
+    renderBack = old & RENDER_SLOT_MASK;
+
+    pthread_mutex_lock(&renderLock);
+    pthread_cond_signal(&renderWake);
+    pthread_mutex_unlock(&renderLock);
+}
+
+// has the render thread taken the newest snapshot
+bool renderReady()
+{
+    return !(atomic_load(&renderMiddle) & RENDER_FRESH);
+}
+
+// snapshots made
+long renderNumPublished()
+{
+    return atomic_load(&renderPublished);
+}
+
+// frames drawn by the render thread
+long renderNumDrawn()
+{
+    return atomic_load(&renderDrawn);
+}
+
+// snapshots replaced before the render thread took them
+long renderNumDropped()
+{
+    return atomic_load(&renderDropped);
+}
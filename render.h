@@ -0,0 +1,82 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Render thread fed by scene snapshots
+ *
+ *  Input, camera motion and the animation clock stay on the glut
+ *  thread, which packs everything a frame needs into a snapshot
+ *  each time it prepares one.  A second thread owns the OpenGL
+ *  context and draws whichever snapshot is newest.  Snapshots
+ *  pass through a lock-free triple buffer: the glut thread fills
+ *  its back slot and swaps it for the middle one, the render
+ *  thread swaps the middle one for its front slot, and neither
+ *  ever waits on the other to read or write a snapshot.
+ */
+
+#ifndef RENDER_H
+    #define RENDER_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // most values in one snapshot
+    #define RENDER_MAX_STATE 64
+
+    // triple buffer slots, the middle index carries a fresh flag
+    #define RENDER_NUM_SLOTS  3
+    #define RENDER_SLOT_MASK  0x3
+    #define RENDER_FRESH      0x4
+
+    /* everything one frame is drawn from */
+    typedef struct {
+        long   frame;                       /* sequence number */
+        int    n;                           /* values used */
+        double state[RENDER_MAX_STATE];
+    } renderSnapshot;
+
+    bool renderInit(int mainCpu, int renderCpu);         // ask for a render thread, before glut starts
+    bool renderStart();                                  // hand the context to the render thread
+    void renderFree();                                   // stop the render thread
+    bool renderActive();                                 // is a render thread drawing
+    void renderStateFunc(int (*save)(double *state),     // register how snapshots are filled
+                         void (*load)(double *state, int n));
+    void renderPublish();                                // snapshot the state for the next frame
+    bool renderReady();                                  // has the last snapshot been taken
+    long renderNumPublished();                           // snapshots made
+    long renderNumDrawn();                               // frames drawn
+    long renderNumDropped();                             // snapshots replaced before being drawn
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,310 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Input recording and deterministic replay
+ *
+ *  Records every event reaching the navigator, keyed to the
+ *  animation tick it arrived in plus the ms since that tick,
+ *  along with the camera and animation state at the start of
+ *  the session.  Replay restores that state and re-injects the
+ *  events on the same schedule so a visitor session can be
+ *  rerun as a repeatable performance test.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// 3d navigation
+#include "navigator.h"
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "replay.h"
+
+// session state
+bool  replayRecordingNow = false;
+bool  replayReplaying    = false;
+FILE *replayFp           = NULL;
+char  replayName[256]    = "";
+
+// session header and loaded events
+replayHeader replayHdr;
+replayEvent *replayEvents    = NULL;
+int          replayNumEvents = 0;
+int          replayNext      = 0;
+
+// animation clock
+uint32_t replayTickCount = 0;
+double   replayTickTime  = 0.0;
+double   replayStartTime = 0.0;
+
+// animation state call-backs
+int  (*replaySave)(double *state) = NULL;
+void (*replayRestore)(double *state, int n) = NULL;
+
+// register animation state save and restore
+void replayStateFunc(int (*save)(double *state), void (*restore)(double *state, int n))
+{
+    replaySave    = save;
+    replayRestore = restore;
+}
+
+// start recording to file
+// the header is written once the scene is ready in replayStart
+bool replayRecord(char *fileName)
+{
+    replayFp = fopen(fileName, "wb");
+    if (!replayFp) {
+        fprintf(stderr, "error: couldn't open \"%s\" for recording!\n", fileName);
+        return false;
+    }
+
+    strncpy(replayName, fileName, sizeof(replayName)-1);
+    replayRecordingNow = true;
+    atexit(replayClose);
+
+    return true;
+}
+
+// load a session to replay
+bool replayLoad(char *fileName)
+{
+    FILE *fp;
+    replayEvent e;
+    int capacity = 0;
+
+    fp = fopen(fileName, "rb");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open replay \"%s\"!\n", fileName);
+        return false;
+    }
+
+    if ((fread(&replayHdr, sizeof(replayHdr), 1, fp) != 1) ||
+        (replayHdr.magic != REPLAY_MAGIC) ||
+        (replayHdr.version != REPLAY_VERSION) ||
+        (replayHdr.numState > REPLAY_MAX_STATE)) {
+        fprintf(stderr, "error: \"%s\" is not a scimus replay!\n", fileName);
+        fclose(fp);
+        return false;
+    }
+
+    replayNumEvents = 0;
+    while (fread(&e, sizeof(e), 1, fp) == 1) {
+        if (replayNumEvents == capacity) {
+            capacity = (capacity > 0) ? 2*capacity : 1024;
+            replayEvents = realloc(replayEvents, sizeof(replayEvent) * capacity);
+            if (replayEvents == NULL) {
+                fprintf(stderr, "Fatal Error:  Out of memory for %d replay events.\n", capacity);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        replayEvents[replayNumEvents++] = e;
+        if (e.type == REPLAY_END)
+            break;
+    }
+    fclose(fp);
+
+    if ((replayNumEvents == 0) || (replayEvents[replayNumEvents-1].type != REPLAY_END)) {
+        fprintf(stderr, "error: replay \"%s\" is truncated!\n", fileName);
+        return false;
+    }
+
+    strncpy(replayName, fileName, sizeof(replayName)-1);
+    replayReplaying = true;
+
+    return true;
+}
+
+// replay one event
+static void replayFire(int i)
+{
+    replayEvent *e = &replayEvents[i];
+
+    switch (e->type) {
+        case NAV_INPUT_KEY:
+            navInjectKey(e->key, true, e->state);
+            break;
+
+        case NAV_INPUT_KEY_UP:
+            navInjectKey(e->key, false, e->state);
+            break;
+
+        case NAV_INPUT_SPECIAL:
+            navInjectSpecial(e->key, true, e->state);
+            break;
+
+        case NAV_INPUT_SPECIAL_UP:
+            navInjectSpecial(e->key, false, e->state);
+            break;
+
+        case NAV_INPUT_MOUSE:
+            navInjectMouse(e->key, e->state, e->x, e->y);
+            break;
+
+        case NAV_INPUT_MOTION:
+            navInjectMotion(e->x, e->y);
+            break;
+
+        case REPLAY_END:
+            fprintf(stderr, "replay \"%s\": %d events over %u ticks in %.1f ms\n",
+                    replayName, replayNumEvents-1, replayTickCount, timeNow()-replayStartTime);
+            exit(EXIT_SUCCESS);
+    }
+}
+
+// schedule every event of the current tick at its offset
+static void replaySchedule()
+{
+    double elapsed = timeNow() - replayTickTime;
+
+    while ((replayNext < replayNumEvents) && (replayEvents[replayNext].tick <= replayTickCount)) {
+        double delay = replayEvents[replayNext].offset - elapsed;
+
+        glutTimerFunc((delay > 0.0) ? (unsigned int)(delay+0.5) : 0, replayFire, replayNext);
+        ++replayNext;
+    }
+}
+
+// restore state and begin
+// called once the window, textures and lighting are ready
+void replayStart()
+{
+    replayStartTime = replayTickTime = timeNow();
+    replayTickCount = 0;
+
+    if (replayRecordingNow) {
+        memset(&replayHdr, 0, sizeof(replayHdr));
+        replayHdr.magic   = REPLAY_MAGIC;
+        replayHdr.version = REPLAY_VERSION;
+        replayHdr.width   = glutGet(GLUT_WINDOW_WIDTH);
+        replayHdr.height  = glutGet(GLUT_WINDOW_HEIGHT);
+
+        navGetCamera(&replayHdr.camera[0], &replayHdr.camera[1], &replayHdr.camera[2],
+                     &replayHdr.camera[3], &replayHdr.camera[4]);
+
+        if (replaySave != NULL)
+            replayHdr.numState = replaySave(replayHdr.state);
+
+        fwrite(&replayHdr, sizeof(replayHdr), 1, replayFp);
+    }
+
+    if (replayReplaying) {
+        // the visitor's pointer and keys would change the outcome
+        navLiveInput(false);
+
+        if ((replayHdr.width  != glutGet(GLUT_WINDOW_WIDTH)) ||
+            (replayHdr.height != glutGet(GLUT_WINDOW_HEIGHT)))
+            glutReshapeWindow(replayHdr.width, replayHdr.height);
+
+        navSetCamera(replayHdr.camera[0], replayHdr.camera[1], replayHdr.camera[2],
+                     replayHdr.camera[3], replayHdr.camera[4]);
+
+        if (replayRestore != NULL)
+            replayRestore(replayHdr.state, replayHdr.numState);
+
+        replayNext = 0;
+        replaySchedule();
+    }
+}
+
+// note an animation tick
+void replayTick()
+{
+    ++replayTickCount;
+    replayTickTime = timeNow();
+
+    if (replayReplaying)
+        replaySchedule();
+}
+
+// note an input event
+void replayInput(int type, int key, int state, int x, int y)
+{
+    replayEvent e;
+
+    if (!replayRecordingNow)
+        return;
+
+    e.tick   = replayTickCount;
+    e.offset = timeNow() - replayTickTime;
+    e.type   = type;
+    e.state  = state;
+    e.key    = key;
+    e.x      = x;
+    e.y      = y;
+
+    fwrite(&e, sizeof(e), 1, replayFp);
+}
+
+// is a session being recorded
+bool replayRecording()
+{
+    return replayRecordingNow;
+}
+
+// is a session being replayed
+bool replayActive()
+{
+    return replayReplaying;
+}
+
+// finish the recording
+void replayClose()
+{
+    replayEvent e;
+
+    if (!replayRecordingNow)
+        return;
+
+    memset(&e, 0, sizeof(e));
+    e.tick   = replayTickCount;
+    e.offset = timeNow() - replayTickTime;
+    e.type   = REPLAY_END;
+
+    fwrite(&e, sizeof(e), 1, replayFp);
+    fclose(replayFp);
+
+    replayFp = NULL;
+    replayRecordingNow = false;
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Input recording and deterministic replay
+ *
+ *  Records every event reaching the navigator, keyed to the
+ *  animation tick it arrived in plus the ms since that tick,
+ *  along with the camera and animation state at the start of
+ *  the session.  Replay restores that state and re-injects the
+ *  events on the same schedule so a visitor session can be
+ *  rerun as a repeatable performance test.
+ */
+
+#ifndef REPLAY_H
+    #define REPLAY_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+    #include <stdint.h>
+
+    // file identification, "SCRP" and format version
+    #define REPLAY_MAGIC   0x50524353
+    #define REPLAY_VERSION 2
+
+    // animation state values saved in the header
+    #define REPLAY_MAX_STATE 32
+
+    // event type marking the end of a session
+    #define REPLAY_END 0
+
+    /* file header, host byte order */
+    typedef struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t numState;
+        int32_t  width, height;               /* window size */
+        double   camera[5];                   /* x, y, z, hrot, vrot */
+        double   state[REPLAY_MAX_STATE];     /* animation state */
+    } replayHeader;
+
+    /* one recorded event, 16 bytes */
+    typedef struct {
+        uint32_t tick;                        /* animation tick it arrived in */
+        float    offset;                      /* ms after that tick */
+        uint8_t  type;                        /* NAV_INPUT_* or REPLAY_END */
+        uint8_t  state;                       /* modifiers or button state */
+        int16_t  key;                         /* key or button */
+        int16_t  x, y;                        /* pointer location */
+    } replayEvent;
+
+    void replayStateFunc(int (*save)(double *state),     // register animation state save
+                         void (*restore)(double *state, int n)); // and restore
+    bool replayRecord(char *fileName);                   // start recording to file
+    bool replayLoad(char *fileName);                     // load a session to replay
+    void replayStart();                                  // restore state and begin
+    void replayTick();                                   // note an animation tick
+    void replayInput(int type, int key, int state,       // note an input event
+                     int x, int y);
+    bool replayRecording();                              // is a session being recorded
+    bool replayActive();                                 // is a session being replayed
+    void replayClose();                                  // finish the recording
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
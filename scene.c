@@ -0,0 +1,973 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Museum scene description
+ *
+ *  Rooms, the portals (doorways and windows) joining them, the
+ *  exhibits standing in them, the lights hanging over them and
+ *  the materials they are built from.  Scenes are read from a
+ *  text file for authoring or a binary file for fast loading,
+ *  or generated procedurally as a stress layout.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// tile size, eye level and exit stati
+#include "scimus.h"
+
+// prototypes and definitions
+#include "scene.h"
+
+// resting height of each sculpture above eye level
+GLdouble const sceneExhibitY[NUM_EXHIBIT_TYPES] = {
+    0.0, 0.0, 0.0, 200.0, 0.0, 0.0
+};
+
+// names used in scene files
+char *sceneExhibitNames[NUM_EXHIBIT_TYPES] = {
+    "orrery", "gimbal", "teapot", "piston", "helix", "painting"
+};
+
+char *sceneWallNames[4] = {
+    "north", "south", "east", "west"
+};
+
+char *sceneMaterialNames[NUM_MATERIALS] = {
+    "floor", "floor_alt", "ceiling", "wall", "window_frame",
+    "glass", "grass", "skyline", "painting_frame", "canvas"
+};
+
+// materials a scene starts out with
+sceneMaterial const sceneDefaultMaterials[NUM_MATERIALS] = {
+    {{0.4, 0.4, 0.4, 1.0},   {0.7, 0.7, 0.7, 1.0},    {0.9, 0.9, 0.9, 1.0},   100.0},
+    {{0.1, 0.4, 0.4, 1.0},   {0.1, 0.7, 0.7, 1.0},    {0.1, 0.9, 0.9, 1.0},   100.0},
+    {{0.6, 0.6, 0.6, 1.0},   {0.9, 0.9, 0.9, 1.0},    {0.0, 0.0, 0.0, 1.0},   100.0},
+    {{0.3, 0.3, 0.3, 1.0},   {0.2, 0.2, 0.2, 1.0},    {0.5, 0.5, 0.5, 1.0},   100.0},
+    {{0.2, 0.2, 0.2, 1.0},   {0.5, 0.5, 0.5, 1.0},    {0.8, 0.8, 0.8, 1.0},   100.0},
+    {{0.1, 0.1, 0.7, 0.25},  {0.1, 0.1, 0.7, 0.25},   {0.1, 0.1, 0.7, 0.25},  100.0},
+    {{0.0, 1.0, 0.0, 1.0},   {0.0, 1.0, 0.0, 1.0},    {0.0, 0.0, 0.0, 1.0},   100.0},
+    {{1.0, 1.0, 1.0, 1.0},   {1.0, 1.0, 1.0, 1.0},    {1.0, 1.0, 1.0, 1.0},     0.0},
+    {{0.25, 0.15, 0.05, 1.0}, {0.45, 0.30, 0.10, 1.0}, {0.10, 0.10, 0.10, 1.0}, 10.0},
+    {{0.8, 0.8, 0.8, 1.0},   {0.8, 0.8, 0.8, 1.0},    {0.0, 0.0, 0.0, 1.0},     0.0}
+};
+
+// grow an array to hold one more element
+static void *sceneGrow(void *array, int num, int *max, size_t size)
+{
+    if (num < *max)
+        return array;
+
+    *max  = (*max > 0) ? 2*(*max) : 16;
+    array = realloc(array, size * (*max));
+    if (array == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d scene elements.\n", *max);
+        exit(OUT_OF_MEM_ERROR);
+    }
+
+    return array;
+}
+
+// start an empty scene with the default materials
+void sceneInit(scene *s)
+{
+    memset(s, 0, sizeof(scene));
+
+    memcpy(s->materials, sceneDefaultMaterials, sizeof(s->materials));
+
+    s->outside[0] = SCENE_OUTSIDE_WIDTH;
+    s->outside[1] = SCENE_OUTSIDE_LENGTH;
+    s->outside[2] = SCENE_OUTSIDE_HEIGHT;
+}
+
+// release a scene
+void sceneFree(scene *s)
+{
+    free(s->rooms);
+    free(s->portals);
+    free(s->exhibits);
+    free(s->lights);
+
+    sceneInit(s);
+}
+
+// add a room, returns its index
+int sceneAddRoom(scene *s, GLdouble x0, GLdouble z0,
+                 GLdouble x1, GLdouble z1, GLdouble floor, GLdouble height)
+{
+    sceneRoom *r;
+
+    s->rooms = sceneGrow(s->rooms, s->numRooms, &s->maxRooms, sizeof(sceneRoom));
+
+    r = &s->rooms[s->numRooms];
+    r->x0 = x0;
+    r->z0 = z0;
+    r->x1 = x1;
+    r->z1 = z1;
+    r->floor  = floor;
+    r->height = height;
+    r->firstPortal = 0;
+    r->numPortals  = 0;
+
+    return s->numRooms++;
+}
+
+// add an opening to a room wall, center is the world x for
+// north and south walls and the world z for east and west walls
+int sceneAddPortal(scene *s, int room, int wall,
+                   GLdouble center, GLdouble width, GLdouble bottom,
+                   GLdouble height, int to, bool glass)
+{
+    scenePortal *p;
+
+    s->portals = sceneGrow(s->portals, s->numPortals, &s->maxPortals, sizeof(scenePortal));
+
+    p = &s->portals[s->numPortals];
+    p->room   = room;
+    p->wall   = wall;
+    p->center = center;
+    p->width  = width;
+    p->bottom = bottom;
+    p->height = height;
+    p->to     = to;
+    p->glass  = glass;
+
+    return s->numPortals++;
+}
+
+// distance along its wall from the left end, as seen from
+// inside room r, to the center of portal p
+GLdouble scenePortalOffset(sceneRoom *r, scenePortal *p)
+{
+    switch (p->wall) {
+        case WALL_SOUTH: return r->x1 - p->center;
+        case WALL_EAST:  return p->center - r->z0;
+        case WALL_WEST:  return r->z1 - p->center;
+        default:         return p->center - r->x0;
+    }
+}
+
+// add a sculpture or painting
+int sceneAddExhibit(scene *s, int type, int room,
+                    GLdouble x, GLdouble y, GLdouble z, GLdouble h)
+{
+    sceneExhibit *e;
+
+    s->exhibits = sceneGrow(s->exhibits, s->numExhibits, &s->maxExhibits, sizeof(sceneExhibit));
+
+    e = &s->exhibits[s->numExhibits];
+    e->type = type;
+    e->room = room;
+    e->x = x;
+    e->y = y;
+    e->z = z;
+    e->h = h;
+
+    return s->numExhibits++;
+}
+
+// add a light
+int sceneAddLight(scene *s, sceneLight *light)
+{
+    s->lights = sceneGrow(s->lights, s->numLights, &s->maxLights, sizeof(sceneLight));
+
+    s->lights[s->numLights] = *light;
+
+    return s->numLights++;
+}
+
+// group the portals of each room together, keeping the order
+// they were added in, must be called once everything is added
+void sceneFinish(scene *s)
+{
+    int i, j;
+    scenePortal *sorted;
+
+    for (i = 0; i < s->numRooms; ++i)
+        s->rooms[i].numPortals = 0;
+
+    for (i = 0; i < s->numPortals; ++i)
+        s->rooms[s->portals[i].room].numPortals++;
+
+    for (i = 0, j = 0; i < s->numRooms; ++i) {
+        s->rooms[i].firstPortal = j;
+        j += s->rooms[i].numPortals;
+        s->rooms[i].numPortals = 0;
+    }
+
+    if (s->numPortals == 0)
+        return;
+
+    sorted = malloc(sizeof(scenePortal) * s->numPortals);
+    if (sorted == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d portals.\n", s->numPortals);
+        exit(OUT_OF_MEM_ERROR);
+    }
+
+    for (i = 0; i < s->numPortals; ++i) {
+        sceneRoom *r = &s->rooms[s->portals[i].room];
+        sorted[r->firstPortal + r->numPortals++] = s->portals[i];
+    }
+
+    free(s->portals);
+    s->portals    = sorted;
+    s->maxPortals = s->numPortals;
+}
+
+// fill in a light
+static void sceneSetLight(sceneLight *l, GLfloat x, GLfloat y, GLfloat z,
+                          GLfloat const a[3], GLfloat const d[3], GLfloat const sp[3],
+                          GLfloat c, GLfloat lin, GLfloat q)
+{
+    int i;
+
+    for (i = 0; i < 3; ++i) {
+        l->ambient[i]  = a[i];
+        l->diffuse[i]  = d[i];
+        l->specular[i] = sp[i];
+        l->spotDirection[i] = 0.0;
+    }
+    l->ambient[3] = l->diffuse[3] = l->specular[3] = 1.0;
+
+    l->position[0] = x;
+    l->position[1] = y;
+    l->position[2] = z;
+    l->position[3] = 1.0;
+
+    l->attenuation[0] = c;
+    l->attenuation[1] = lin;
+    l->attenuation[2] = q;
+
+    l->spotDirection[2] = -1.0;
+    l->spotCutoff   = 180.0;
+    l->spotExponent = 0.0;
+}
+
+// index of a name in a table, -1 if it isn't there
+static int sceneLookup(char *name, char **names, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+        if (strcmp(name, names[i]) == 0)
+            return i;
+
+    return -1;
+}
+
+// make sure every reference in a scene points somewhere,
+// before sceneFinish follows them, reports the first problem found
+static bool sceneCheckRefs(scene *s, char *fileName)
+{
+    int i;
+    scenePortal *p;
+
+    if (s->numRooms == 0) {
+        fprintf(stderr, "error: scene \"%s\" has no rooms!\n", fileName);
+        return false;
+    }
+
+    for (i = 0; i < s->numPortals; ++i) {
+        p = &s->portals[i];
+        if ((p->room < 0) || (p->room >= s->numRooms) ||
+            (p->to < PORTAL_OUTSIDE) || (p->to >= s->numRooms) ||
+            (p->wall < WALL_NORTH) || (p->wall > WALL_WEST)) {
+            fprintf(stderr, "error: portal %d of \"%s\" joins rooms that don't exist!\n", i, fileName);
+            return false;
+        }
+    }
+
+    for (i = 0; i < s->numExhibits; ++i) {
+        if ((s->exhibits[i].room < 0) || (s->exhibits[i].room >= s->numRooms) ||
+            (s->exhibits[i].type < 0) || (s->exhibits[i].type >= NUM_EXHIBIT_TYPES)) {
+            fprintf(stderr, "error: exhibit %d of \"%s\" is in a room that doesn't exist!\n", i, fileName);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// make sure every room can be tiled, reports the first problem found
+static bool sceneCheckRooms(scene *s, char *fileName)
+{
+    int i;
+    sceneRoom *r;
+
+    for (i = 0; i < s->numRooms; ++i) {
+        r = &s->rooms[i];
+        if ((r->x1 <= r->x0) || (r->z1 <= r->z0) || (r->height <= 0) ||
+            (fmod(r->x1-r->x0, 512.0) != 0.0) || (fmod(r->z1-r->z0, 512.0) != 0.0) ||
+            (fmod(r->height, TILE_RES) != 0.0)) {
+            fprintf(stderr, "error: room %d of \"%s\" must span multiples of 512 "
+                    "with a height in multiples of %d!\n", i, fileName, TILE_RES);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// read a text scene, one element per line:
+//   outside  width length height
+//   material name  ambient(rgba) diffuse(rgba) specular(rgba) shininess
+//   room     x0 z0 x1 z1 floor height
+//   portal   room wall center width bottom height to [glass]
+//   exhibit  type room x y z [hrot]
+//   light    x y z  ambient(rgb) diffuse(rgb) specular(rgb)
+//            constant linear quadratic [spot dx dy dz cutoff exponent]
+// rooms are numbered from 0 in the order they appear, walls are
+// north, south, east or west and portals lead to a room or outside
+static bool sceneReadText(scene *s, FILE *fp, char *fileName)
+{
+    char line[512], key[16], name[32], wall[16], to[16], glass[16];
+    char *rest;
+    int  n, i, room, lineNum = 0;
+    GLdouble v[6];
+    GLfloat  *m;
+    sceneLight l;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ++lineNum;
+
+        if ((sscanf(line, "%15s%n", key, &n) < 1) || (key[0] == '#'))
+            continue;
+        rest = line + n;
+
+        if (strcmp(key, "outside") == 0) {
+            if (sscanf(rest, "%lf %lf %lf", &s->outside[0], &s->outside[1], &s->outside[2]) != 3)
+                break;
+        }
+        else if (strcmp(key, "material") == 0) {
+            if (sscanf(rest, "%31s%n", name, &n) < 1)
+                break;
+
+            i = sceneLookup(name, sceneMaterialNames, NUM_MATERIALS);
+            if (i < 0) {
+                fprintf(stderr, "error: unknown material \"%s\" in \"%s\" line %d\n", name, fileName, lineNum);
+                return false;
+            }
+
+            m = s->materials[i].ambient;
+            if (sscanf(rest+n, "%f %f %f %f %f %f %f %f %f %f %f %f %f",
+                       &m[0], &m[1], &m[2], &m[3],
+                       &s->materials[i].diffuse[0],  &s->materials[i].diffuse[1],
+                       &s->materials[i].diffuse[2],  &s->materials[i].diffuse[3],
+                       &s->materials[i].specular[0], &s->materials[i].specular[1],
+                       &s->materials[i].specular[2], &s->materials[i].specular[3],
+                       &s->materials[i].shininess) != 13)
+                break;
+        }
+        else if (strcmp(key, "room") == 0) {
+            if (sscanf(rest, "%lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+                break;
+
+            sceneAddRoom(s, v[0], v[1], v[2], v[3], v[4], v[5]);
+        }
+        else if (strcmp(key, "portal") == 0) {
+            n = sscanf(rest, "%d %15s %lf %lf %lf %lf %15s %15s",
+                       &room, wall, &v[0], &v[1], &v[2], &v[3], to, glass);
+            if ((n < 7) || ((n == 8) && (strcmp(glass, "glass") != 0)))
+                break;
+
+            i = sceneLookup(wall, sceneWallNames, 4);
+            if (i < 0)
+                break;
+
+            sceneAddPortal(s, room, i, v[0], v[1], v[2], v[3],
+                           (strcmp(to, "outside") == 0) ? PORTAL_OUTSIDE : atoi(to), n == 8);
+        }
+        else if (strcmp(key, "exhibit") == 0) {
+            v[3] = 0.0;
+            if (sscanf(rest, "%31s %d %lf %lf %lf %lf", name, &room, &v[0], &v[1], &v[2], &v[3]) < 5)
+                break;
+
+            i = sceneLookup(name, sceneExhibitNames, NUM_EXHIBIT_TYPES);
+            if (i < 0) {
+                fprintf(stderr, "error: unknown exhibit \"%s\" in \"%s\" line %d\n", name, fileName, lineNum);
+                return false;
+            }
+
+            sceneAddExhibit(s, i, room, v[0], v[1], v[2], v[3]);
+        }
+        else if (strcmp(key, "light") == 0) {
+            memset(&l, 0, sizeof(l));
+            l.position[3] = l.ambient[3] = l.diffuse[3] = l.specular[3] = 1.0;
+            l.spotDirection[2] = -1.0;
+            l.spotCutoff = 180.0;
+
+            n = sscanf(rest, "%f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %15s %f %f %f %f %f",
+                       &l.position[0], &l.position[1], &l.position[2],
+                       &l.ambient[0],  &l.ambient[1],  &l.ambient[2],
+                       &l.diffuse[0],  &l.diffuse[1],  &l.diffuse[2],
+                       &l.specular[0], &l.specular[1], &l.specular[2],
+                       &l.attenuation[0], &l.attenuation[1], &l.attenuation[2], name,
+                       &l.spotDirection[0], &l.spotDirection[1], &l.spotDirection[2],
+                       &l.spotCutoff, &l.spotExponent);
+            if ((n != 15) && ((n != 21) || (strcmp(name, "spot") != 0)))
+                break;
+
+            sceneAddLight(s, &l);
+        }
+        else {
+            fprintf(stderr, "error: unknown element \"%s\" in \"%s\" line %d\n", key, fileName, lineNum);
+            return false;
+        }
+    }
+
+    if (!feof(fp)) {
+        fprintf(stderr, "error: malformed %s in \"%s\" line %d: %s", key, fileName, lineNum, line);
+        return false;
+    }
+
+    return true;
+}
+
+// allocate exactly n elements of a scene array
+static void *sceneAlloc(int n, size_t size)
+{
+    void *array;
+
+    if (n <= 0)
+        return NULL;
+
+    array = malloc(size * n);
+    if (array == NULL) {
+        fprintf(stderr, "Fatal Error:  Out of memory for %d scene elements.\n", n);
+        exit(OUT_OF_MEM_ERROR);
+    }
+
+    return array;
+}
+
+// read a binary scene written by sceneSaveBinary
+static bool sceneReadBinary(scene *s, FILE *fp, char *fileName)
+{
+    sceneFileHeader hdr;
+    long start, end = -1;
+    double need;
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+        // bytes left after the header, the counts must fit in them
+        start = ftell(fp);
+        if ((start >= 0) && (fseek(fp, 0, SEEK_END) == 0))
+            end = ftell(fp);
+        if ((end < 0) || (fseek(fp, start, SEEK_SET) != 0))
+            end = -1;
+        else
+            end -= start;
+    }
+
+    need = (double)hdr.numRooms    * sizeof(sceneRoom)    + (double)hdr.numPortals * sizeof(scenePortal) +
+           (double)hdr.numExhibits * sizeof(sceneExhibit) + (double)hdr.numLights  * sizeof(sceneLight);
+
+    if ((end < 0) || (hdr.version != SCENE_VERSION) ||
+        (hdr.sizes[0] != sizeof(sceneRoom))    || (hdr.sizes[1] != sizeof(scenePortal)) ||
+        (hdr.sizes[2] != sizeof(sceneExhibit)) || (hdr.sizes[3] != sizeof(sceneLight)) ||
+        (hdr.sizes[4] != sizeof(sceneMaterial)) ||
+        (hdr.numRooms < 0) || (hdr.numPortals < 0) || (hdr.numExhibits < 0) || (hdr.numLights < 0) ||
+        (need > (double)end)) {
+        fprintf(stderr, "error: \"%s\" isn't a binary scene from this build!\n", fileName);
+        return false;
+    }
+
+    s->rooms    = sceneAlloc(hdr.numRooms,    sizeof(sceneRoom));
+    s->portals  = sceneAlloc(hdr.numPortals,  sizeof(scenePortal));
+    s->exhibits = sceneAlloc(hdr.numExhibits, sizeof(sceneExhibit));
+    s->lights   = sceneAlloc(hdr.numLights,   sizeof(sceneLight));
+    s->numRooms    = s->maxRooms    = hdr.numRooms;
+    s->numPortals  = s->maxPortals  = hdr.numPortals;
+    s->numExhibits = s->maxExhibits = hdr.numExhibits;
+    s->numLights   = s->maxLights   = hdr.numLights;
+    memcpy(s->outside, hdr.outside, sizeof(s->outside));
+
+    if ((fread(s->rooms,    sizeof(sceneRoom),    s->numRooms,    fp) != (size_t)s->numRooms)    ||
+        (fread(s->portals,  sizeof(scenePortal),  s->numPortals,  fp) != (size_t)s->numPortals)  ||
+        (fread(s->exhibits, sizeof(sceneExhibit), s->numExhibits, fp) != (size_t)s->numExhibits) ||
+        (fread(s->lights,   sizeof(sceneLight),   s->numLights,   fp) != (size_t)s->numLights)   ||
+        (fread(s->materials, sizeof(s->materials), 1, fp) != 1)) {
+        fprintf(stderr, "error: binary scene \"%s\" is truncated!\n", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+// read a scene from file, binary scenes are told apart by their magic
+bool sceneLoad(scene *s, char *fileName)
+{
+    FILE *fp;
+    uint32_t magic = 0;
+    bool ok;
+
+    sceneInit(s);
+
+    fp = fopen(fileName, "rb");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open scene \"%s\"!\n", fileName);
+        return false;
+    }
+
+    if ((fread(&magic, sizeof(magic), 1, fp) == 1) && (magic == SCENE_MAGIC)) {
+        rewind(fp);
+        ok = sceneReadBinary(s, fp, fileName);
+    }
+    else {
+        rewind(fp);
+        ok = sceneReadText(s, fp, fileName);
+    }
+    fclose(fp);
+
+    // portals are grouped by the rooms they name, so those
+    // have to exist before anything is done with them
+    if (ok)
+        ok = sceneCheckRefs(s, fileName);
+
+    if (ok) {
+        sceneFinish(s);
+        ok = sceneCheckRooms(s, fileName);
+    }
+
+    if (!ok)
+        sceneFree(s);
+
+    return ok;
+}
+
+// write a scene as text in the form sceneLoad reads
+bool sceneSaveText(scene *s, char *fileName)
+{
+    FILE *fp;
+    int i;
+    sceneMaterial *m;
+    scenePortal *p;
+    sceneExhibit *e;
+    sceneLight *l;
+
+    fp = fopen(fileName, "w");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open scene \"%s\" for writing!\n", fileName);
+        return false;
+    }
+
+    fprintf(fp, "# scimus scene\n\n");
+    fprintf(fp, "outside %.8g %.8g %.8g\n\n", s->outside[0], s->outside[1], s->outside[2]);
+
+    for (i = 0; i < NUM_MATERIALS; ++i) {
+        m = &s->materials[i];
+        fprintf(fp, "material %-14s  %g %g %g %g  %g %g %g %g  %g %g %g %g  %g\n", sceneMaterialNames[i],
+                m->ambient[0],  m->ambient[1],  m->ambient[2],  m->ambient[3],
+                m->diffuse[0],  m->diffuse[1],  m->diffuse[2],  m->diffuse[3],
+                m->specular[0], m->specular[1], m->specular[2], m->specular[3], m->shininess);
+    }
+    fprintf(fp, "\n");
+
+    for (i = 0; i < s->numRooms; ++i)
+        fprintf(fp, "room %.8g %.8g %.8g %.8g %.8g %.8g\n", s->rooms[i].x0, s->rooms[i].z0,
+                s->rooms[i].x1, s->rooms[i].z1, s->rooms[i].floor, s->rooms[i].height);
+    fprintf(fp, "\n");
+
+    for (i = 0; i < s->numPortals; ++i) {
+        p = &s->portals[i];
+        fprintf(fp, "portal %d %s %.8g %.8g %.8g %.8g ", p->room, sceneWallNames[p->wall],
+                p->center, p->width, p->bottom, p->height);
+        if (p->to == PORTAL_OUTSIDE)
+            fprintf(fp, "outside");
+        else
+            fprintf(fp, "%d", p->to);
+        fprintf(fp, "%s\n", p->glass ? " glass" : "");
+    }
+    fprintf(fp, "\n");
+
+    for (i = 0; i < s->numExhibits; ++i) {
+        e = &s->exhibits[i];
+        fprintf(fp, "exhibit %s %d %.8g %.8g %.8g %.8g\n", sceneExhibitNames[e->type],
+                e->room, e->x, e->y, e->z, e->h);
+    }
+    fprintf(fp, "\n");
+
+    for (i = 0; i < s->numLights; ++i) {
+        l = &s->lights[i];
+        fprintf(fp, "light %.8g %.8g %.8g  %g %g %g  %g %g %g  %g %g %g  %g %g %g",
+                l->position[0], l->position[1], l->position[2],
+                l->ambient[0],  l->ambient[1],  l->ambient[2],
+                l->diffuse[0],  l->diffuse[1],  l->diffuse[2],
+                l->specular[0], l->specular[1], l->specular[2],
+                l->attenuation[0], l->attenuation[1], l->attenuation[2]);
+        if (l->spotCutoff < 180.0)
+            fprintf(fp, "  spot %g %g %g %g %g", l->spotDirection[0], l->spotDirection[1],
+                    l->spotDirection[2], l->spotCutoff, l->spotExponent);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+// write a scene as a header followed by its arrays, host byte order
+bool sceneSaveBinary(scene *s, char *fileName)
+{
+    FILE *fp;
+    sceneFileHeader hdr;
+
+    fp = fopen(fileName, "wb");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open scene \"%s\" for writing!\n", fileName);
+        return false;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic    = SCENE_MAGIC;
+    hdr.version  = SCENE_VERSION;
+    hdr.sizes[0] = sizeof(sceneRoom);
+    hdr.sizes[1] = sizeof(scenePortal);
+    hdr.sizes[2] = sizeof(sceneExhibit);
+    hdr.sizes[3] = sizeof(sceneLight);
+    hdr.sizes[4] = sizeof(sceneMaterial);
+    hdr.numRooms    = s->numRooms;
+    hdr.numPortals  = s->numPortals;
+    hdr.numExhibits = s->numExhibits;
+    hdr.numLights   = s->numLights;
+    memcpy(hdr.outside, s->outside, sizeof(hdr.outside));
+
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(s->rooms,    sizeof(sceneRoom),    s->numRooms,    fp);
+    fwrite(s->portals,  sizeof(scenePortal),  s->numPortals,  fp);
+    fwrite(s->exhibits, sizeof(sceneExhibit), s->numExhibits, fp);
+    fwrite(s->lights,   sizeof(sceneLight),   s->numLights,   fp);
+    fwrite(s->materials, sizeof(s->materials), 1, fp);
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "error: couldn't finish writing scene \"%s\"!\n", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+// true if nothing opens in a room wall within half of along,
+// a world x on the north and south walls or z on the others
+static bool sceneWallClear(scene *s, int room, int wall, GLdouble along, GLdouble half)
+{
+    int i;
+    scenePortal *p;
+
+    for (i = 0; i < s->numPortals; ++i) {
+        p = &s->portals[i];
+        if ((p->room == room) && (p->wall == wall) &&
+            (fabs(p->center - along) < p->width/2.0 + half))
+            return false;
+    }
+
+    return true;
+}
+
+// lay out a grid of connected rooms for scale testing
+// rooms fill rows of about sqrt(rooms) from the window side, each
+// opening onto its neighbours through a doorway off to one side of
+// the shared wall, alternating like a chequerboard so no line of
+// sight runs straight down a row of rooms, and room 0 keeps the
+// window to the outside.  copies of every sculpture, then the
+// paintings and lights, are dealt out round-robin across the rooms.
+void sceneGenerate(scene *s, int rooms, int copies, int paintings, int lights)
+{
+    int i, j, k, n, numFree, cols, rows, col, row, room, wall;
+    int spots[3];
+    GLdouble x0, z0, x, z, along, side;
+    sceneRoom *r;
+    sceneLight l;
+
+    GLfloat const lightA[3] = {0.20, 0.20, 0.20};
+    GLfloat const lightD[3] = {0.6, 0.6, 0.6};
+
+    // sculpture spots, a 2x2 grid in each quarter of the room
+    GLdouble const spot[4] = {640.0, 1408.0, 2688.0, 3456.0};
+
+    // painting spots along each wall, the middle first
+    GLdouble const hang[3] = {2048.0, 1024.0, 3072.0};
+
+    if (rooms < 1)
+        rooms = 1;
+
+    sceneInit(s);
+
+    cols = (int)ceil(sqrt((double)rooms));
+    rows = (rooms + cols - 1) / cols;
+
+    for (i = 0; i < rooms; ++i) {
+        col = i % cols;
+        row = i / cols;
+
+        // centered on the origin like the hall
+        x0 = col*SCENE_ROOM_SIZE - cols*SCENE_ROOM_SIZE/2;
+        z0 = row*SCENE_ROOM_SIZE - rows*SCENE_ROOM_SIZE/2;
+
+        sceneAddRoom(s, x0, z0, x0+SCENE_ROOM_SIZE, z0+SCENE_ROOM_SIZE, FLOOR_LEVEL, SCENE_ROOM_HEIGHT);
+    }
+
+    // doorways to the east and south neighbours, one on each side
+    for (i = 0; i < rooms; ++i) {
+        r    = &s->rooms[i];
+        side = ((i % cols + i / cols) % 2) ? SCENE_ROOM_SIZE/4 : -SCENE_ROOM_SIZE/4;
+
+        if ((i % cols < cols-1) && (i+1 < rooms)) {
+            z = (r->z0 + r->z1) / 2.0 + side;
+            sceneAddPortal(s, i,   WALL_EAST, z, SCENE_DOOR_WIDTH, 0.0, SCENE_DOOR_HEIGHT, i+1, false);
+            sceneAddPortal(s, i+1, WALL_WEST, z, SCENE_DOOR_WIDTH, 0.0, SCENE_DOOR_HEIGHT, i,   false);
+        }
+
+        if (i+cols < rooms) {
+            x = (r->x0 + r->x1) / 2.0 - side;
+            sceneAddPortal(s, i,      WALL_SOUTH, x, SCENE_DOOR_WIDTH, 0.0, SCENE_DOOR_HEIGHT, i+cols, false);
+            sceneAddPortal(s, i+cols, WALL_NORTH, x, SCENE_DOOR_WIDTH, 0.0, SCENE_DOOR_HEIGHT, i,      false);
+        }
+    }
+
+    r = &s->rooms[0];
+    sceneAddPortal(s, 0, WALL_NORTH, r->x0 + SCENE_ROOM_SIZE/4, SCENE_WINDOW_WIDTH, SCENE_WINDOW_ELEV, SCENE_WINDOW_HEIGHT,
+                   PORTAL_OUTSIDE, true);
+
+    // sculptures, each pass over the rooms starts one room further
+    // on so no room ends up holding a single kind of sculpture.
+    // the first four in a room go one to a quarter
+    for (k = 0; k < copies*EXHIBIT_PAINTING; ++k) {
+        room = (k + k/rooms) % rooms;
+        n    = (k / rooms) % 16;
+        r    = &s->rooms[room];
+
+        sceneAddExhibit(s, k % EXHIBIT_PAINTING, room,
+                        r->x0 + spot[(n % 2)*2 + (n / 4) % 2],
+                        sceneExhibitY[k % EXHIBIT_PAINTING],
+                        r->z0 + spot[((n / 2) % 2)*2 + (n / 8)], 0.0);
+    }
+
+    // paintings hang at eye level on the inside of each wall,
+    // later passes using the spots no doorway or window takes
+    for (k = 0; k < paintings; ++k) {
+        room  = k % rooms;
+        n     = k / rooms;
+        wall  = n % 4;
+        r     = &s->rooms[room];
+
+        for (numFree = j = 0; j < 3; ++j) {
+            switch (wall) {
+                case WALL_NORTH: along = r->x0 + hang[j]; break;
+                case WALL_SOUTH: along = r->x1 - hang[j]; break;
+                case WALL_EAST:  along = r->z0 + hang[j]; break;
+                default:         along = r->z1 - hang[j]; break;
+            }
+            if (sceneWallClear(s, room, wall, along, PAINTING_WIDTH/2 + 64))
+                spots[numFree++] = j;
+        }
+        if (numFree == 0)
+            continue;
+        along = hang[spots[(n / 4) % numFree]];
+
+        switch (wall) {
+            case WALL_NORTH:
+                sceneAddExhibit(s, EXHIBIT_PAINTING, room, r->x0+along, 150.0, r->z0+4.0, 0.0);
+                break;
+            case WALL_SOUTH:
+                sceneAddExhibit(s, EXHIBIT_PAINTING, room, r->x1-along, 150.0, r->z1-4.0, 180.0);
+                break;
+            case WALL_EAST:
+                sceneAddExhibit(s, EXHIBIT_PAINTING, room, r->x1-4.0, 150.0, r->z0+along, -90.0);
+                break;
+            case WALL_WEST:
+                sceneAddExhibit(s, EXHIBIT_PAINTING, room, r->x0+4.0, 150.0, r->z1-along, 90.0);
+                break;
+        }
+    }
+
+    // lights hang over the quarters of each room
+    for (k = 0; k < lights; ++k) {
+        room = k % rooms;
+        n    = (k / rooms) % 4;
+        r    = &s->rooms[room];
+
+        sceneSetLight(&l, r->x0 + ((n % 2) ? 3072.0 : 1024.0), 512.0,
+                      r->z0 + ((n / 2) ? 3072.0 : 1024.0),
+                      lightA, lightD, lightD, 0.001, 0.0001, 0.0000005);
+        sceneAddLight(s, &l);
+    }
+
+    sceneFinish(s);
+}
+
+// index of the room containing x, z or -1 if none does
+int sceneRoomAt(scene *s, GLdouble x, GLdouble z)
+{
+    int i;
+    sceneRoom *r;
+
+    for (i = 0; i < s->numRooms; ++i) {
+        r = &s->rooms[i];
+        if ((x >= r->x0) && (x < r->x1) && (z >= r->z0) && (z < r->z1))
+            return i;
+    }
+
+    return -1;
+}
+
+// fill lights with the indices of the n lights closest to
+// x, y, z, nearest first, returns how many were found
+int sceneNearestLights(scene *s, GLdouble x, GLdouble y, GLdouble z, int *lights, int n)
+{
+    int i, j, found = 0;
+    GLdouble dx, dy, dz;
+    GLdouble dist[SCENE_GL_LIGHTS];
+
+    if (n > SCENE_GL_LIGHTS)
+        n = SCENE_GL_LIGHTS;
+    if (n < 1)
+        return 0;
+
+    // insertion into a short sorted list
+    for (i = 0; i < s->numLights; ++i) {
+        dx = s->lights[i].position[0] - x;
+        dy = s->lights[i].position[1] - y;
+        dz = s->lights[i].position[2] - z;
+        dx = dx*dx + dy*dy + dz*dz;
+
+        if ((found == n) && (dx >= dist[n-1]))
+            continue;
+
+        j = (found < n) ? found++ : n-1;
+        for (; (j > 0) && (dist[j-1] > dx); --j) {
+            dist[j]   = dist[j-1];
+            lights[j] = lights[j-1];
+        }
+        dist[j]   = dx;
+        lights[j] = i;
+    }
+
+    return found;
+}
+
+// store a camera stop at eye level
+static void sceneTourStop(GLdouble *point, GLdouble x, GLdouble z)
+{
+    point[0] = x;
+    point[1] = 0.0;
+    point[2] = z;
+    point[4] = 0.0;
+}
+
+// camera stops at the center of every room in a walk that only
+// steps between neighbouring rooms through the doorways joining
+// them, written as x y z hrot vrot into points, returns the
+// number of stops
+int sceneTour(scene *s, GLdouble *points, int max)
+{
+    int i, k, n = 0, room, next, step, cols;
+    GLdouble h, last = 0.0;
+    sceneRoom *r;
+    scenePortal *p;
+
+    if (s->numRooms == 0)
+        return 0;
+
+    // rooms per row, the first room whose row changes
+    for (cols = 1; cols < s->numRooms; ++cols)
+        if (s->rooms[cols].z0 != s->rooms[0].z0)
+            break;
+
+    // snake along the rows, taking the long way into a short last row
+    room = 0;
+    for (i = 0; (i < s->numRooms) && (n < max); ++i) {
+        next = (i / cols) * cols + (((i / cols) % 2) ? cols-1 - i % cols : i % cols);
+        if (next >= s->numRooms)
+            continue;
+
+        while ((room != next) && (n+1 < max)) {
+            if (room % cols != next % cols)
+                step = room + ((room % cols < next % cols) ? 1 : -1);
+            else
+                step = room + ((room < next) ? cols : -cols);
+
+            // the doorway on the way
+            r = &s->rooms[room];
+            for (k = r->firstPortal; k < r->firstPortal + r->numPortals; ++k) {
+                p = &s->portals[k];
+                if ((p->to != step) || p->glass)
+                    continue;
+
+                switch (p->wall) {
+                    case WALL_NORTH: sceneTourStop(&points[5*n++], p->center, r->z0); break;
+                    case WALL_SOUTH: sceneTourStop(&points[5*n++], p->center, r->z1); break;
+                    case WALL_EAST:  sceneTourStop(&points[5*n++], r->x1, p->center); break;
+                    case WALL_WEST:  sceneTourStop(&points[5*n++], r->x0, p->center); break;
+                }
+                break;
+            }
+
+            room = step;
+            r    = &s->rooms[room];
+            sceneTourStop(&points[5*n++], (r->x0 + r->x1) / 2.0, (r->z0 + r->z1) / 2.0);
+        }
+
+        if (n == 0) {
+            r = &s->rooms[room];
+            sceneTourStop(&points[0], (r->x0 + r->x1) / 2.0, (r->z0 + r->z1) / 2.0);
+            n = 1;
+        }
+    }
+
+    // face the next stop, hrot 0 faces -z and 90 faces -x,
+    // unwrapped so the spline never swings the long way round
+    for (i = 0; i < n; ++i) {
+        if (i+1 < n)
+            h = atan2(-(points[5*(i+1)+0] - points[5*i+0]),
+                      -(points[5*(i+1)+2] - points[5*i+2])) * 180.0 / M_PI;
+        else
+            h = last;
+
+        while (h - last >  180.0) h -= 360.0;
+        while (h - last < -180.0) h += 360.0;
+
+        points[5*i+3] = last = h;
+    }
+
+    return n;
+}
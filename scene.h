@@ -0,0 +1,209 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Museum scene description
+ *
+ *  Rooms, the portals (doorways and windows) joining them, the
+ *  exhibits standing in them, the lights hanging over them and
+ *  the materials they are built from.  Scenes are read from a
+ *  text file for authoring or a binary file for fast loading,
+ *  or generated procedurally as a stress layout.
+ */
+
+#ifndef SCENE_H
+    #define SCENE_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+    #include <stdint.h>
+
+    // scene loaded when none is given
+    #define SCENE_DEFAULT_FILE "scenes/museum.scene"
+
+    // binary scene identification
+    #define SCENE_MAGIC   0x424e4353u
+    #define SCENE_VERSION 1
+
+    // exhibit types, sculptures first so they index the exhibit names
+    #define EXHIBIT_ORRERY    0
+    #define EXHIBIT_GIMBAL    1
+    #define EXHIBIT_TEAPOT    2
+    #define EXHIBIT_PISTON    3
+    #define EXHIBIT_HELIX     4
+    #define EXHIBIT_PAINTING  5
+    #define NUM_EXHIBIT_TYPES 6
+
+    // room walls, north faces the window at -z
+    #define WALL_NORTH 0
+    #define WALL_SOUTH 1
+    #define WALL_EAST  2
+    #define WALL_WEST  3
+
+    // portal leading outside
+    #define PORTAL_OUTSIDE -1
+
+    // architectural materials
+    #define MAT_FLOOR          0
+    #define MAT_FLOOR_ALT      1
+    #define MAT_CEILING        2
+    #define MAT_WALL           3
+    #define MAT_WINDOW_FRAME   4
+    #define MAT_GLASS          5
+    #define MAT_GRASS          6
+    #define MAT_SKYLINE        7
+    #define MAT_PAINTING_FRAME 8
+    #define MAT_CANVAS         9
+    #define NUM_MATERIALS      10
+
+    // lights OpenGL can place at once
+    #define SCENE_GL_LIGHTS 8
+
+    // default view through the windows
+    #define SCENE_OUTSIDE_WIDTH   256*32
+    #define SCENE_OUTSIDE_LENGTH  256*5
+    #define SCENE_OUTSIDE_HEIGHT  256*16
+
+    // generated room, doorway and window dimensions
+    #define SCENE_ROOM_SIZE      4096
+    #define SCENE_ROOM_HEIGHT    1536
+    #define SCENE_DOOR_WIDTH     1024
+    #define SCENE_DOOR_HEIGHT    1280
+    #define SCENE_WINDOW_WIDTH   1024
+    #define SCENE_WINDOW_HEIGHT  640
+    #define SCENE_WINDOW_ELEV    384
+
+    // painting dimensions
+    #define PAINTING_WIDTH  768
+    #define PAINTING_HEIGHT 512
+
+    /* opening in a room wall */
+    typedef struct {
+        int      room;              /* room whose wall this is */
+        int      wall;              /* WALL_NORTH, ... */
+        GLdouble center;            /* world x or z of the opening center */
+        GLdouble width, bottom, height;
+        int      to;                /* room on the other side or PORTAL_OUTSIDE */
+        bool     glass;             /* glazed window rather than a doorway */
+    } scenePortal;
+
+    /* axis aligned room */
+    typedef struct {
+        GLdouble x0, z0, x1, z1;    /* floor plan, x0 < x1 and z0 < z1 */
+        GLdouble floor, height;
+        int      firstPortal, numPortals;
+    } sceneRoom;
+
+    /* sculpture or painting */
+    typedef struct {
+        int      type;              /* EXHIBIT_ORRERY, ... */
+        int      room;
+        GLdouble x, y, z;           /* placement */
+        GLdouble h;                 /* rotation about y, 0 faces +z */
+    } sceneExhibit;
+
+    /* point or spot light */
+    typedef struct {
+        GLfloat position[4];
+        GLfloat ambient[4], diffuse[4], specular[4];
+        GLfloat attenuation[3];     /* constant, linear, quadratic */
+        GLfloat spotDirection[3];
+        GLfloat spotCutoff;         /* 180 for a point light */
+        GLfloat spotExponent;
+    } sceneLight;
+
+    /* surface material */
+    typedef struct {
+        GLfloat ambient[4], diffuse[4], specular[4];
+        GLfloat shininess;
+    } sceneMaterial;
+
+    /* a whole museum */
+    typedef struct {
+        sceneRoom    *rooms;
+        scenePortal  *portals;
+        sceneExhibit *exhibits;
+        sceneLight   *lights;
+        int numRooms,    maxRooms;
+        int numPortals,  maxPortals;
+        int numExhibits, maxExhibits;
+        int numLights,   maxLights;
+        sceneMaterial materials[NUM_MATERIALS];
+        GLdouble outside[3];        /* width, length, height of the view */
+    } scene;
+
+    /* binary scene file header, element arrays follow in order */
+    typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sizes[5];          /* element sizes, to catch layout changes */
+        int32_t  numRooms, numPortals, numExhibits, numLights;
+        int32_t  reserved;
+        double   outside[3];
+    } sceneFileHeader;
+
+    void sceneInit(scene *s);                            // start an empty scene
+    void sceneFree(scene *s);                            // release a scene
+    int  sceneAddRoom(scene *s, GLdouble x0, GLdouble z0,    // add a room, returns its index
+                      GLdouble x1, GLdouble z1, GLdouble floor, GLdouble height);
+    int  sceneAddPortal(scene *s, int room, int wall,    // add an opening to a room wall
+                        GLdouble center, GLdouble width, GLdouble bottom,
+                        GLdouble height, int to, bool glass);
+    GLdouble scenePortalOffset(sceneRoom *r,             // portal center along its wall
+                               scenePortal *p);          // from the left, seen from inside
+    int  sceneAddExhibit(scene *s, int type, int room,   // add a sculpture or painting
+                         GLdouble x, GLdouble y, GLdouble z, GLdouble h);
+    int  sceneAddLight(scene *s, sceneLight *light);     // add a light
+    void sceneFinish(scene *s);                          // group portals by room
+    bool sceneLoad(scene *s, char *fileName);            // read a text or binary scene
+    bool sceneSaveText(scene *s, char *fileName);        // write a scene for authoring
+    bool sceneSaveBinary(scene *s, char *fileName);      // write a scene for fast loading
+    void sceneGenerate(scene *s, int rooms, int copies,  // procedural stress layout
+                       int paintings, int lights);
+    int  sceneRoomAt(scene *s, GLdouble x, GLdouble z);  // room containing a point, -1 if none
+    int  sceneNearestLights(scene *s, GLdouble x,        // closest lights to a point
+                            GLdouble y, GLdouble z, int *lights, int n);
+    int  sceneTour(scene *s, GLdouble *points, int max); // camera stops visiting every room
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
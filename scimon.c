@@ -0,0 +1,224 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  scimon - live monitor for scimus telemetry
+ *
+ *  Attaches read-only to the shared-memory block published by
+ *  scimus --telemetry and prints frame samples or per-interval
+ *  aggregates: frame rate, frame-time percentiles and histogram,
+ *  texture memory and the exhibit the visitor is standing at.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+// frame-time statistics
+#include "timing.h"
+
+// shared block layout
+#include "telemetry.h"
+
+// print usage and exit
+void usage(char *prog)
+{
+    fprintf(stderr, "usage: %s [-n name] [-i seconds] [-c count] [-f]\n", prog);
+    fprintf(stderr, "  -n  shared-memory name, default %s\n", TELEM_DEFAULT_NAME);
+    fprintf(stderr, "  -i  aggregation interval in seconds, default 1\n");
+    fprintf(stderr, "  -c  stop after count intervals\n");
+    fprintf(stderr, "  -f  follow, print every frame sample\n");
+    exit(EXIT_FAILURE);
+}
+
+// map the shared block read-only
+telemBlock *attach(char *name)
+{
+    int fd;
+    telemBlock *b;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "scimon: can't attach to %s, is scimus running with --telemetry?\n", name);
+        return NULL;
+    }
+
+    b = mmap(NULL, sizeof(telemBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (b == MAP_FAILED)
+        return NULL;
+
+    if ((__atomic_load_n(&b->magic, __ATOMIC_ACQUIRE) != TELEM_MAGIC) ||
+        (b->version != TELEM_VERSION) || (b->slots != TELEM_SLOTS)) {
+        fprintf(stderr, "scimon: %s has an unknown layout.\n", name);
+        munmap(b, sizeof(telemBlock));
+        return NULL;
+    }
+
+    return b;
+}
+
+// name of an exhibit
+char *exhibitName(telemBlock *b, int exhibit)
+{
+    if ((exhibit < 0) || (exhibit >= b->numExhibits))
+        return "-";
+
+    return b->exhibits[exhibit];
+}
+
+int main(int nargs, char *args[])
+{
+    int i, c;
+    int count = -1;
+    bool follow = false;
+    double interval = 1.0;
+    char *name = TELEM_DEFAULT_NAME;
+
+    telemBlock *b;
+    telemSample s;
+    uint64_t next, head;
+    uint64_t lastHist[TELEM_HIST_BINS];
+    double times[TELEM_SLOTS];
+
+    while ((c = getopt(nargs, args, "n:i:c:f")) != -1) {
+        switch (c) {
+            case 'n': name = optarg;             break;
+            case 'i': interval = atof(optarg);   break;
+            case 'c': count = atoi(optarg);      break;
+            case 'f': follow = true;             break;
+            default:  usage(args[0]);
+        }
+    }
+
+    if (interval <= 0.0)
+        usage(args[0]);
+
+    b = attach(name);
+    if (b == NULL)
+        return EXIT_FAILURE;
+
+    printf("attached to %s, scimus pid %d\n", name, b->pid);
+
+    next = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+    for (i = 0; i < TELEM_HIST_BINS; ++i)
+        lastHist[i] = b->hist[i];
+
+    if (!follow)
+        printf("%8s %8s %8s %8s %8s %10s  %s\n",
+               "frames", "fps", "avg ms", "p95 ms", "max ms", "tex MB", "exhibit");
+
+    while (count != 0) {
+        int n = 0, dropped = 0;
+        double first = 0.0, last = 0.0, total = 0.0;
+        uint64_t texBytes = 0;
+        int exhibit = -1;
+
+        usleep((useconds_t)(interval*1000000.0));
+
+        head = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+
+        // we fell behind by more than the ring holds
+        if (head - next > TELEM_SLOTS) {
+            dropped = (int)(head - next - TELEM_SLOTS);
+            next = head - TELEM_SLOTS;
+        }
+
+        for (; next < head; ++next) {
+            if (!telemRead(b, next, &s)) {
+                ++dropped;
+                continue;
+            }
+
+            if (follow)
+                printf("frame %8lu  t %10.1f ms  frame %7.2f ms  work %7.2f ms  tex %6.1f MB  %s\n",
+                       (unsigned long)s.frame, s.time, s.frameMs, s.workMs,
+                       s.textureBytes/1048576.0, exhibitName(b, s.exhibit));
+
+            if (n == 0)
+                first = s.time;
+            last = s.time;
+
+            times[n++] = s.frameMs;
+            total += s.frameMs;
+            texBytes = s.textureBytes;
+            exhibit  = s.exhibit;
+        }
+
+        if ((kill(b->pid, 0) != 0) && (errno == ESRCH)) {
+            printf("scimus has exited.\n");
+            break;
+        }
+
+        if (!follow) {
+            if (n > 0) {
+                timeSort(times, n);
+                printf("%8d %8.1f %8.2f %8.2f %8.2f %10.1f  %s",
+                       n, (last > first) ? 1000.0*(n-1)/(last-first) : 0.0,
+                       total/n, timePercentile(times, n, 95.0), times[n-1],
+                       texBytes/1048576.0, exhibitName(b, exhibit));
+            }
+            else
+                printf("%8d %8s %8s %8s %8s %10s  %s", 0, "-", "-", "-", "-", "-", "idle");
+
+            if (dropped > 0)
+                printf("  (%d dropped)", dropped);
+            printf("\n");
+
+            // frame-time histogram for this interval
+            printf("         ");
+            for (i = 0; i < TELEM_HIST_BINS; ++i) {
+                uint64_t h = __atomic_load_n(&b->hist[i], __ATOMIC_RELAXED);
+
+                if (i < TELEM_HIST_BINS-1)
+                    printf(" <=%.0f:%lu", b->histEdges[i], (unsigned long)(h - lastHist[i]));
+                else
+                    printf(" >%.0f:%lu", b->histEdges[i-1], (unsigned long)(h - lastHist[i]));
+
+                lastHist[i] = h;
+            }
+            printf("\n");
+        }
+
+        fflush(stdout);
+
+        if (count > 0)
+            --count;
+    }
+
+    munmap(b, sizeof(telemBlock));
+
+    return EXIT_SUCCESS;
+}
@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <ctype.h>
+#include <string.h>
 #include <stdbool.h>
 
 // OpenGL and GLUT headers
@@ -57,6 +58,66 @@
 // custom primative shapes
 #include "primatives.h"
 
+// flythrough benchmark
+#include "benchmark.h"
+
+// per-phase frame profiler
+#include "profiler.h"
+
+// chrome trace markers
+#include "trace.h"
+
+// frame hitch flight recorder
+#include "flightRecorder.h"
+
+// shared-memory telemetry
+#include "telemetry.h"
+
+// input-to-photon latency
+#include "latency.h"
+
+// input recording and replay
+#include "replay.h"
+
+// gl command-stream capture
+#include "glCapture.h"
+
+// rooms, exhibits and lights
+#include "scene.h"
+
+// portal visibility
+#include "visibility.h"
+
+// background room streaming
+#include "stream.h"
+
+// software occlusion culling
+#include "occlusion.h"
+
+// high resolution timers
+#include "timing.h"
+
+// fixed timestep simulation clock
+#include "simClock.h"
+
+// demand driven redraws
+#include "redraw.h"
+
+// render thread fed by snapshots
+#include "render.h"
+
+// work stealing jobs
+#include "jobs.h"
+
+// single precision matrix stack
+#include "matrix.h"
+
+// compact vertex formats
+#include "mesh.h"
+
+// static geometry batches
+#include "batch.h"
+
 // frame cap
 // removed for c compat, uncomment in animate as well
 // #include "saveFrame.h"
@@ -64,6 +125,9 @@
 // prototypes and macros
 #include "scimus.h"
 
+// per-frame gl call counters, must follow the OpenGL headers
+#include "glCounters.h"
+
 // debug level
 short debug = DEBUG;
 
@@ -71,7 +135,10 @@ short debug = DEBUG;
 glpngtexture *pix[MAX_NUM_PIX];
 int           numPix;
 
-bool showTextures = true;
+NAV_THREAD_LOCAL bool showTextures = true;
+
+// bytes of texture memory in use
+unsigned long texMemory = 0;
 
 // full screen mode status
 bool gameMode = false;
@@ -81,45 +148,115 @@ int gameWindowID;
 bool capture = false;
 
 // amount window is open
-bool glassIsOpening = false;
-GLdouble glassOpen  = 0;
+NAV_THREAD_LOCAL bool glassIsOpening = false;
+NAV_THREAD_LOCAL GLdouble glassOpen  = 0;
 
 GLUquadric *quadric;
 
 // animation variables
-bool animation = false; // are we currently animating
-bool frozen    = false; // is animation frozen
+NAV_THREAD_LOCAL bool frozen = false; // is animation frozen
+
+// animation state before and after the last simulation step
+double animPrev[ANIM_STATE_SIZE];
+double animCurr[ANIM_STATE_SIZE];
+
+// how each animation value is blended between steps,
+// 0 linearly, more than 0 as an angle wrapping at that
+// period and less than 0 not at all
+double const animPeriod[ANIM_STATE_SIZE] = {
+    2.0*M_PI, 0.0, 2.0*M_PI, 2.0*M_PI, 0.0,
+    360.0, 360.0, 360.0, 360.0,
+    0.0, 2.0*M_PI, -1.0,
+    0.0, -1.0,
+    -1.0, -1.0, -1.0
+};
 
 // sculpture1
-GLdouble earthTheta = 0.0;
-GLdouble earthDist  = 400.0;
-GLdouble moonTheta  = 0.0;
-GLdouble moonDist   = 75.0;
-GLdouble mercuryTheta = 0.0;
-GLdouble mercuryDist  = 300.0;
+NAV_THREAD_LOCAL GLdouble earthTheta = 0.0;
+NAV_THREAD_LOCAL GLdouble earthDist  = 400.0;
+NAV_THREAD_LOCAL GLdouble moonTheta  = 0.0;
+NAV_THREAD_LOCAL GLdouble moonDist   = 75.0;
+NAV_THREAD_LOCAL GLdouble mercuryTheta = 0.0;
+NAV_THREAD_LOCAL GLdouble mercuryDist  = 300.0;
 
 // sculpture2
-GLdouble diskRot[4] = {0.0, 90.0, 0.0, 120.0};
+NAV_THREAD_LOCAL GLdouble diskRot[4] = {0.0, 90.0, 0.0, 120.0};
 
 // sculpture3
-bool showHelix = true;
+NAV_THREAD_LOCAL bool showHelix = true;
 
 // sculpture4
-GLdouble pistHeight = 0.0;
-GLdouble crankTheta = 0.0;
+NAV_THREAD_LOCAL GLdouble pistHeight = 0.0;
+NAV_THREAD_LOCAL GLdouble crankTheta = 0.0;
 GLdouble const crankRadius  = 210.0;
 GLdouble const rodLength    = 300.0;
-bool showBurn = false;
-
+NAV_THREAD_LOCAL bool showBurn = false;
+
+// times each light was switched from the keyboard,
+// and the count the drawing thread has caught up with
+NAV_THREAD_LOCAL int lightFlips[8];
+int lightFlipsApplied[8];
+
+// exhibit names, used to tell where the visitor is
+char *exhibitNames[NUM_EXHIBITS] = {
+    "orrery", "gimbal", "teapot", "piston", "double helix"
+};
+
+// sculpture drawing by exhibit type
+void (*const drawSculpture[NUM_EXHIBITS])(void) = {
+    drawSculpture1, drawSculpture2, drawSculpture3, drawSculpture4, drawSculpture5
+};
+
+// half width, bottom and top of each sculpture about its placement
+GLdouble const exhibitBounds[NUM_EXHIBITS][3] = {
+    {560.0,  -700.0,  560.0},
+    {260.0,  -700.0,  260.0},
+    {560.0,  -700.0,  300.0},
+    {600.0, -1100.0,  600.0},
+    {800.0,  -700.0, 1000.0}
+};
+
+// the museum being drawn
+scene museum;
+
+// exhibits and portals that passed occlusion culling this frame
+bool *exhibitShown = NULL;
+bool *portalShown  = NULL;
+
+// every painting's frame and canvas in place, and each
+// exhibit's two records in the batch
+batch paintingBatch;
+int  *paintingDraws = NULL;
+
+// the stand under every sculpture in place, one class per kind
+// of sculpture and up to two records for each exhibit
+batch standBatch;
+int  *standDraws = NULL;
+
+// stand batch class by exhibit type
+int const standClass[NUM_EXHIBITS] = {
+    STAND_ORRERY, STAND_GIMBAL, STAND_TEAPOT, -1, -1
+};
+
+// scene light held by each OpenGL light, -1 if unused
+int lightSlot[SCENE_GL_LIGHTS];
+
+// room the visitor was last clipped to, -1 until known
+int visitorRoom = -1;
+
+#ifndef SCIMUS_NO_MAIN
 // main control loop
 int main(int nargs, char *args[])
 {
     // hard-coded texture file names
     char *p[2] = {
-        "images/skyline3.png",
+        "images/skyline2.png",
         "images/ceiling_texture.png",
     };
 
+    // parse our command-line options
+    parseArgs(nargs, args);
+
     // used for glu predefined shapes
     quadric = gluNewQuadric();
     gluQuadricOrientation(quadric, GLU_OUTSIDE);
@@ -134,6 +271,9 @@ int main(int nargs, char *args[])
     // initialize the display window
     navInit(nargs, args);
 
+    // draw at most once a vertical retrace, the benchmark turns this off
+    navSetSwapInterval(1);
+
     // initialize our pictures/textures 
     initTextures();
 
@@ -143,16 +283,227 @@ int main(int nargs, char *args[])
     // initialize scene lighting 
     initLighting();
 
+    // start the simulation clock from the initial state
+    simInit(ANI_RATE);
+    saveAnimState(animPrev);
+
+    // hand drawing to its own thread if asked
+    renderStart();
+
+    // start driving the camera if benchmarking
+    if (benchActive())
+        benchStart();
+
+    // start pressing keys if measuring latency unattended
+    if (latActive())
+        latStart();
+
+    // capture or restore the starting state of a session
+    if (replayRecording() || replayActive())
+        replayStart();
+
     // pass control to glut 
     glutMainLoop();
 
     // all went well 
     return 0;
 }
+#endif
+
+// parse command-line options
+// options we don't recognize are left for glut
+void parseArgs(int nargs, char *args[])
+{
+    int i;
+    int   frames       = 0;
+    char *pathFile     = NULL;
+    char *benchOutFile = NULL;
+    double hitchMs     = REC_DEFAULT_THRESHOLD;
+    char  *hitchDir    = NULL;
+    bool   telemetry   = false;
+    char  *telemName   = NULL;
+    int    latSamples  = -1;
+    char  *latOutFile  = NULL;
+    bool   latInject   = false;
+    char  *recordFile  = NULL;
+    char  *replayFile  = NULL;
+    char  *captureFile = NULL;
+    int    capFirst    = -1;
+    int    capCount    = -1;
+    int    stress[4]   = {0, 0, 0, 0};
+    bool   tour        = false;
+    char  *sceneFile   = SCENE_DEFAULT_FILE;
+    char  *sceneText   = NULL;
+    char  *sceneBinary = NULL;
+    bool   portals     = true;
+    int    workers     = STREAM_DEFAULT_WORKERS;
+    bool   occlusion   = true;
+    int    jobWorkers  = JOB_DEFAULT_WORKERS;
+    double fpsCap      = 0.0;
+    bool   threaded    = false;
+    int    cpus[2]     = {-1, -1};
+
+    for (i = 1; i < nargs; ++i) {
+        if ((strcmp(args[i], "--benchmark") == 0) && (i+1 < nargs))
+            pathFile = args[++i];
+        else if (strcmp(args[i], "--benchmark-tour") == 0)
+            tour = true;
+        else if ((strcmp(args[i], "--frames") == 0) && (i+1 < nargs))
+            frames = atoi(args[++i]);
+        else if ((strcmp(args[i], "--bench-out") == 0) && (i+1 < nargs))
+            benchOutFile = args[++i];
+        else if ((strcmp(args[i], "--profile-csv") == 0) && (i+1 < nargs))
+            profCSVOpen(args[++i]);
+        else if ((strcmp(args[i], "--trace") == 0) && (i+1 < nargs))
+            traceOpen(args[++i]);
+        else if ((strcmp(args[i], "--hitch-ms") == 0) && (i+1 < nargs))
+            hitchMs = atof(args[++i]);
+        else if ((strcmp(args[i], "--hitch-dir") == 0) && (i+1 < nargs))
+            hitchDir = args[++i];
+        else if (strcmp(args[i], "--telemetry") == 0)
+            telemetry = true;
+        else if ((strcmp(args[i], "--telemetry-name") == 0) && (i+1 < nargs)) {
+            telemetry = true;
+            telemName = args[++i];
+        }
+        else if ((strcmp(args[i], "--latency") == 0) && (i+1 < nargs))
+            latSamples = atoi(args[++i]);
+        else if ((strcmp(args[i], "--latency-out") == 0) && (i+1 < nargs))
+            latOutFile = args[++i];
+        else if (strcmp(args[i], "--latency-inject") == 0)
+            latInject = true;
+        else if ((strcmp(args[i], "--record") == 0) && (i+1 < nargs))
+            recordFile = args[++i];
+        else if ((strcmp(args[i], "--replay") == 0) && (i+1 < nargs))
+            replayFile = args[++i];
+        else if ((strcmp(args[i], "--capture") == 0) && (i+1 < nargs))
+            captureFile = args[++i];
+        else if ((strcmp(args[i], "--capture-frames") == 0) && (i+1 < nargs)) {
+            // first[:count]
+            if (sscanf(args[++i], "%d:%d", &capFirst, &capCount) < 1)
+                fprintf(stderr, "warning: ignoring malformed --capture-frames %s\n", args[i]);
+        }
+        else if ((strcmp(args[i], "--scene") == 0) && (i+1 < nargs))
+            sceneFile = args[++i];
+        else if ((strcmp(args[i], "--scene-save") == 0) && (i+1 < nargs))
+            sceneText = args[++i];
+        else if ((strcmp(args[i], "--scene-compile") == 0) && (i+1 < nargs))
+            sceneBinary = args[++i];
+        else if (strcmp(args[i], "--no-portals") == 0)
+            portals = false;
+        else if (strcmp(args[i], "--mesh-report") == 0)
+            meshReportOnExit();
+        else if ((strcmp(args[i], "--stream-workers") == 0) && (i+1 < nargs))
+            workers = atoi(args[++i]);
+        else if (strcmp(args[i], "--no-occlusion") == 0)
+            occlusion = false;
+        else if (((strcmp(args[i], "--jobs") == 0) || (strcmp(args[i], "--occlusion-threads") == 0)) && (i+1 < nargs))
+            jobWorkers = atoi(args[++i]);
+        else if ((strcmp(args[i], "--fps-cap") == 0) && (i+1 < nargs))
+            fpsCap = atof(args[++i]);
+        else if (strcmp(args[i], "--render-thread") == 0)
+            threaded = true;
+        else if ((strcmp(args[i], "--render-affinity") == 0) && (i+1 < nargs)) {
+            // main,render
+            threaded = true;
+            if (sscanf(args[++i], "%d,%d", &cpus[0], &cpus[1]) < 2)
+                fprintf(stderr, "warning: ignoring malformed --render-affinity %s\n", args[i]);
+        }
+        else if ((strcmp(args[i], "--stress") == 0) && (i+1 < nargs)) {
+            // rooms[,copies[,paintings[,lights]]]
+            if (sscanf(args[++i], "%d,%d,%d,%d", &stress[0], &stress[1], &stress[2], &stress[3]) < 1)
+                fprintf(stderr, "warning: ignoring malformed --stress %s\n", args[i]);
+        }
+    }
+
+    // the museum to draw
+    if (stress[0] > 0) {
+        sceneGenerate(&museum, stress[0], stress[1], stress[2], stress[3]);
+        printf("stress scene: %d rooms, %d portals, %d exhibits, %d lights\n",
+               museum.numRooms, museum.numPortals, museum.numExhibits, museum.numLights);
+    }
+    else if (!sceneLoad(&museum, sceneFile))
+        exit(SCENE_ERROR);
+
+    if ((sceneText != NULL) && !sceneSaveText(&museum, sceneText))
+        exit(SCENE_ERROR);
+
+    if ((sceneBinary != NULL) && !sceneSaveBinary(&museum, sceneBinary))
+        exit(SCENE_ERROR);
+
+    if (!visInit(&museum))
+        exit(OUT_OF_MEM_ERROR);
+    visEnable(portals);
+
+    if (!streamInit(&museum, workers))
+        fprintf(stderr, "warning: room streaming unavailable, drawing every room the slow way\n");
+
+    exhibitShown = (bool*)malloc((museum.numExhibits+1) * sizeof(bool));
+    portalShown  = (bool*)malloc((museum.numPortals+1) * sizeof(bool));
+    if ((exhibitShown == NULL) || (portalShown == NULL) || !occInit(&museum))
+        exit(OUT_OF_MEM_ERROR);
+    occEnable(occlusion);
+
+    if (!bakePaintings() || !bakeStands())
+        exit(OUT_OF_MEM_ERROR);
+
+    jobInit(jobWorkers);
+
+    redrawInit(fpsCap);
+
+    if (captureFile != NULL)
+        capOpen(captureFile, capFirst, capCount);
+
+    if ((recordFile != NULL) && (replayFile != NULL)) {
+        fprintf(stderr, "error: can't record and replay at the same time!\n");
+        exit(REPLAY_ERROR);
+    }
+
+    if ((recordFile != NULL) && !replayRecord(recordFile))
+        exit(REPLAY_ERROR);
+
+    if ((replayFile != NULL) && !replayLoad(replayFile))
+        exit(REPLAY_ERROR);
+
+    recInit(hitchMs, hitchDir);
+
+    if (telemetry && telemOpen(telemName))
+        for (i = 0; i < NUM_EXHIBITS; ++i)
+            telemExhibitName(i, exhibitNames[i]);
+
+    if ((latSamples >= 0) || latInject)
+        latInit(latSamples, latOutFile, latInject);
+
+    if (tour) {
+        benchPoint points[BENCH_MAX_POINTS];
+
+        if (!benchSetPath(points, sceneTour(&museum, (GLdouble*)points, BENCH_MAX_POINTS), "room tour"))
+            exit(BENCH_PATH_ERROR);
+
+        benchInit(frames, benchOutFile);
+    }
+    else if (pathFile != NULL) {
+        if (!benchLoadPath(pathFile))
+            exit(BENCH_PATH_ERROR);
+
+        benchInit(frames, benchOutFile);
+    }
+
+    // the tools below step, time or read back frames on the glut thread
+    if (threaded) {
+        if (benchActive() || latActive() || (captureFile != NULL) || replayRecording() || replayActive())
+            fprintf(stderr, "warning: the render thread can't be used with benchmarks, latency, "
+                            "capture or replay, drawing on the main thread\n");
+        else
+            renderInit(cpus[0], cpus[1]);
+    }
+}
 
 // load textures from file 
 void loadTextures(int n, char *picNames[])
 {
+    TRACE_FUNC();
+
     int i;  // general use counter 
 
     // set our global number of textures 
@@ -185,6 +536,8 @@ void loadTextures(int n, char *picNames[])
 // generate OpenGL textures from the loaded images 
 void initTextures()
 {
+    TRACE_FUNC();
+
     int i;
     GLuint ids[MAX_NUM_PIX];  // array holding our texture id's 
 
@@ -195,6 +548,11 @@ void initTextures()
     // generate numPix identifiers and store them in ids 
     glGenTextures(numPix, ids);
 
+    // re-uploads are a suspected cause of hitches
+    recCount(REC_TEXTURE_UPLOADS);
+
+    texMemory = 0;
+
     for (i = 0; i < numPix; ++i) {
         // give each texture the id assigned by glGenTextures 
         pix[i]->id = ids[i];
@@ -215,6 +573,10 @@ void initTextures()
         glTexImage2D(GL_TEXTURE_2D, 0, pix[i]->internalFormat,
                 pix[i]->width, pix[i]->height, 0, pix[i]->format,
                 GL_UNSIGNED_BYTE, pix[i]->texels);
+
+        // a full mipmap chain adds a third
+        texMemory += (unsigned long)pix[i]->width * pix[i]->height *
+                     pix[i]->internalFormat * ((i == 0) ? 4 : 3) / 3;
     }
 }
 
@@ -229,118 +591,276 @@ void initCallBacks()
     navKeyboardUpFunc(keyUp);
 
     navClipFunc(enforceWallClipping);
+    navStandFunc(standingHeight);
+
+    // watch input and finished frames
+    navInputFunc(inputObserved);
+    navSwapFunc(frameDone);
+
+    // catch animation up before each frame
+    navPrepareFunc(prepareFrame);
+
+    // sessions start from a saved animation state
+    replayStateFunc(saveAnimState, restoreAnimState);
+
+    // a render thread draws from snapshots of the view and animation
+    renderStateFunc(saveSnapshot, loadSnapshot);
+
+    // the benchmark advances animation on a fixed clock
+    if (benchActive())
+        benchStepFunc(stepAnimation);
+}
+
+// called after every buffer swap
+void frameDone()
+{
+    recFrameEnd();
+
+    if (telemActive())
+        telemPublish(profFrameTime(), profFrameWork(), texMemory, activeExhibit());
+
+    if (latActive())
+        latFrameDone();
+
+    // the benchmark drives each frame from the buffer swap
+    if (benchActive())
+        benchFrameDone();
+}
+
+// kind of sculpture the visitor is standing at, -1 if none
+int activeExhibit()
+{
+    int i, nearest = -1;
+    GLdouble x, y, z, h, v;
+    GLdouble dist, best = EXHIBIT_RADIUS*EXHIBIT_RADIUS;
+    sceneExhibit *e;
+
+    navGetCamera(&x, &y, &z, &h, &v);
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        e = &museum.exhibits[i];
+        if (e->type >= NUM_EXHIBITS)
+            continue;
+
+        dist = (x-e->x)*(x-e->x) + (z-e->z)*(z-e->z);
+
+        if (dist < best) {
+            best    = dist;
+            nearest = e->type;
+        }
+    }
+
+    return nearest;
+}
+
+// see every input event before the navigator handles it
+void inputObserved(int type, int key, int state, int x, int y)
+{
+    // pointer motion would crowd out the keys
+    if (type != NAV_INPUT_MOTION)
+        recNoteInput(type, key, state);
+
+    latInput(type, key, state);
+
+    replayInput(type, key, state, x, y);
 }
 
 // initialize scene lighting 
 void initLighting()
 {
+    TRACE_FUNC();
+
+    int i;
+
     // overall ambient lighting 
     GLfloat const ambient[4]  = {0.04, 0.04, 0.04, 1.0};
 
-    // ambient lighting from each light source 
-    GLfloat const colorA0[4]  = {0.20, 0.20, 0.01, 1.0};
-    GLfloat const colorA1[4]  = {0.25, 0.08, 0.01, 1.0};
-    GLfloat const colorA2[4]  = {0.90, 0.90, 0.90, 1.0};
-    GLfloat const colorA3[4]  = {0.90, 0.90, 0.90, 1.0};
-    GLfloat const colorA4[4]  = {0.20, 0.15, 0.15, 1.0};
-    GLfloat const colorA5[4]  = {0.20, 0.20, 0.20, 1.0};
-    GLfloat const colorA6[4]  = {0.20, 0.20, 0.20, 1.0};
-    GLfloat const colorA7[4]  = {0.20, 0.20, 0.20, 1.0};
-
-    // diffuse lighting from each light source 
-    GLfloat const colorD0[4]  = {0.9, 0.9, 0.0, 1.0};
-    GLfloat const colorD1[4]  = {0.9, 0.2, 0.0, 1.0};
-    GLfloat const colorD2[4]  = {0.9, 0.9, 0.9, 1.0};
-    GLfloat const colorD3[4]  = {0.9, 0.9, 0.9, 1.0};
-    GLfloat const colorD4[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorD5[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorD6[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorD7[4]  = {0.6, 0.6, 0.6, 1.0};
-
-    // specular lighting from each light source 
-    GLfloat const colorS0[4]  = {0.9, 0.9, 0.0, 1.0};
-    GLfloat const colorS1[4]  = {0.9, 0.2, 0.0, 1.0};
-    GLfloat const colorS2[4]  = {0.0, 0.0, 0.0, 1.0};
-    GLfloat const colorS3[4]  = {0.0, 0.0, 0.0, 1.0};
-    GLfloat const colorS4[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorS5[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorS6[4]  = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorS7[4]  = {0.6, 0.6, 0.6, 1.0};
-
     // setup lighting scheme 
     glEnable(GL_LIGHTING);
     // glEnable(GL_NORMALIZE);
     glShadeModel(GL_SMOOTH);
 
-    // enable all 8 light sources
-    glEnable(GL_LIGHT0);
-    glEnable(GL_LIGHT1);
-    glEnable(GL_LIGHT2);
-    glEnable(GL_LIGHT3);
-    glEnable(GL_LIGHT4);
-    glEnable(GL_LIGHT5);
-    glEnable(GL_LIGHT6);
-    glEnable(GL_LIGHT7);
-
     glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
     glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
 
-    // initialize light colors and attenuation
-    glLightf(GL_LIGHT0,  GL_CONSTANT_ATTENUATION,  0.500000);
-    glLightf(GL_LIGHT0,  GL_LINEAR_ATTENUATION,    0.000000);
-    glLightf(GL_LIGHT0,  GL_QUADRATIC_ATTENUATION, 0.000000);
-    glLightfv(GL_LIGHT0, GL_AMBIENT,  colorA0);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE,  colorD0);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, colorS0);
-
-    glLightf(GL_LIGHT1,  GL_CONSTANT_ATTENUATION,  0.001000);
-    glLightf(GL_LIGHT1,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT1,  GL_QUADRATIC_ATTENUATION, 0.0000004);
-    glLightfv(GL_LIGHT1, GL_AMBIENT,  colorA1);
-    glLightfv(GL_LIGHT1, GL_DIFFUSE,  colorD1);
-    glLightfv(GL_LIGHT1, GL_SPECULAR, colorS1);
-
-    glLightf(GL_LIGHT2,  GL_CONSTANT_ATTENUATION,  2.200000);
-    glLightf(GL_LIGHT2,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT2,  GL_QUADRATIC_ATTENUATION, 0.000000);
-    glLightfv(GL_LIGHT2, GL_AMBIENT,  colorA2);
-    glLightfv(GL_LIGHT2, GL_DIFFUSE,  colorD2);
-    glLightfv(GL_LIGHT2, GL_SPECULAR, colorS2);
-
-    glLightf(GL_LIGHT3,  GL_CONSTANT_ATTENUATION,  2.200000);
-    glLightf(GL_LIGHT3,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT3,  GL_QUADRATIC_ATTENUATION, 0.000000);
-    glLightfv(GL_LIGHT3, GL_AMBIENT,  colorA3);
-    glLightfv(GL_LIGHT3, GL_DIFFUSE,  colorD3);
-    glLightfv(GL_LIGHT3, GL_SPECULAR, colorS3);
-
-    glLightf(GL_LIGHT4,  GL_CONSTANT_ATTENUATION,  0.001000);
-    glLightf(GL_LIGHT4,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT4,  GL_QUADRATIC_ATTENUATION, 0.0000005);
-    glLightfv(GL_LIGHT4, GL_AMBIENT,  colorA4);
-    glLightfv(GL_LIGHT4, GL_DIFFUSE,  colorD4);
-    glLightfv(GL_LIGHT4, GL_SPECULAR, colorS4);
-
-    glLightf(GL_LIGHT5,  GL_CONSTANT_ATTENUATION,  0.001000);
-    glLightf(GL_LIGHT5,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT5,  GL_QUADRATIC_ATTENUATION, 0.0000005);
-    glLightfv(GL_LIGHT5, GL_AMBIENT,  colorA5);
-    glLightfv(GL_LIGHT5, GL_DIFFUSE,  colorD5);
-    glLightfv(GL_LIGHT5, GL_SPECULAR, colorS5);
-
-    glLightf(GL_LIGHT6,  GL_CONSTANT_ATTENUATION,  0.001000);
-    glLightf(GL_LIGHT6,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT6,  GL_QUADRATIC_ATTENUATION, 0.0000005);
-    glLightfv(GL_LIGHT6, GL_AMBIENT,  colorA6);
-    glLightfv(GL_LIGHT6, GL_DIFFUSE,  colorD6);
-    glLightfv(GL_LIGHT6, GL_SPECULAR, colorS6);
-
-    glLightf(GL_LIGHT7,  GL_CONSTANT_ATTENUATION,  0.001000);
-    glLightf(GL_LIGHT7,  GL_LINEAR_ATTENUATION,    0.000100);
-    glLightf(GL_LIGHT7,  GL_QUADRATIC_ATTENUATION, 0.0000005);
-    glLightfv(GL_LIGHT7, GL_AMBIENT,  colorA7);
-    glLightfv(GL_LIGHT7, GL_DIFFUSE,  colorD7);
-    glLightfv(GL_LIGHT7, GL_SPECULAR, colorS7);
+    // light sources are handed out as the camera moves
+    for (i = 0; i < SCENE_GL_LIGHTS; ++i) {
+        glDisable(GL_LIGHT0+i);
+        lightSlot[i] = -1;
+    }
+}
+
+// give an OpenGL light the colors and attenuation of a scene light
+void loadLight(GLenum slot, sceneLight *light)
+{
+    glLightf(slot,  GL_CONSTANT_ATTENUATION,  light->attenuation[0]);
+    glLightf(slot,  GL_LINEAR_ATTENUATION,    light->attenuation[1]);
+    glLightf(slot,  GL_QUADRATIC_ATTENUATION, light->attenuation[2]);
+    glLightfv(slot, GL_AMBIENT,  light->ambient);
+    glLightfv(slot, GL_DIFFUSE,  light->diffuse);
+    glLightfv(slot, GL_SPECULAR, light->specular);
+    glLightf(slot,  GL_SPOT_CUTOFF,   light->spotCutoff);
+    glLightf(slot,  GL_SPOT_EXPONENT, light->spotExponent);
+}
+
+// assign the properties of one of the scene's materials
+void applyMaterial(int material)
+{
+    sceneMaterial *m = &museum.materials[material];
+
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   m->ambient);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   m->diffuse);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  m->specular);
+    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, m->shininess);
+}
+
+// time one step of the frame's jobs, on whichever thread runs it
+void runFrameStep(void *arg)
+{
+    frameStep *step = (frameStep*)arg;
+    double start = timeNow();
+
+    TRACE_SCOPE(profPhaseName(step->phase));
+
+    step->func(step->cam);
+    profAddCPU(step->phase, timeNow() - start);
+}
+
+// run the cpu work of a frame as a graph of jobs, culling and
+// streaming both need the rooms visibility finds
+void runFrameJobs()
+{
+    frameCamera cam;
+    frameStep steps[3] = {
+        {PROF_VISIBILITY, computeVisibility, &cam},
+        {PROF_STREAMING,  streamCamera,      &cam},
+        {PROF_OCCLUSION,  cullExhibits,      &cam}
+    };
+    jobGraph graph;
+    int visible, stream, cull;
+
+    getFrameCamera(&cam);
+
+    jobGraphInit(&graph);
+    visible = jobGraphAdd(&graph, runFrameStep, &steps[0]);
+    stream = jobGraphAdd(&graph, runFrameStep, &steps[1]);
+    cull = jobGraphAdd(&graph, runFrameStep, &steps[2]);
+    jobGraphAfter(&graph, stream, visible);
+    jobGraphAfter(&graph, cull, visible);
+
+    jobGraphRun(&graph);
+    jobFrameMark();
+}
+
+// the camera this frame's jobs work from, they may run on threads
+// that do not share the navigator's view
+void getFrameCamera(frameCamera *cam)
+{
+    navGetCamera(&cam->x, &cam->y, &cam->z, &cam->h, &cam->v);
+    navGetFrustum(&cam->halfWidth, &cam->halfHeight, &cam->zNear);
+}
+
+// find the rooms visible from the camera this frame
+void computeVisibility(frameCamera *cam)
+{
+    visCompute(cam->x, cam->y, cam->z, cam->h, cam->v, cam->halfWidth, cam->halfHeight, cam->zNear);
+}
+
+// let room streaming follow the camera and load what it sees
+void streamCamera(frameCamera *cam)
+{
+    int i;
+
+    for (i = 0; i < visNumRooms(); ++i)
+        streamSee(visRoom(i));
+
+    streamUpdate(cam->x, cam->z);
+}
+
+// find which exhibits and windows in the visible rooms are not hidden
+void cullExhibits(frameCamera *cam)
+{
+    occRender(cam->x, cam->y, cam->z, cam->h, cam->v, cam->halfWidth, cam->halfHeight, cam->zNear);
+
+    jobParallelFor(cullExhibitRange, NULL, 0, museum.numExhibits, CULL_GRAIN);
+    jobParallelFor(cullPortalRange,  NULL, 0, museum.numPortals,  CULL_GRAIN);
+}
+
+// test exhibits begin..end-1 against the walls, one job's share
+void cullExhibitRange(void *arg, int begin, int end)
+{
+    int i;
+    GLdouble lo[3], hi[3], c, s;
+    sceneExhibit *e;
+
+    for (i = begin; i < end; ++i) {
+        e = &museum.exhibits[i];
+        exhibitShown[i] = false;
+        if (!visRoomVisible(e->room))
+            continue;
+
+        if (e->type == EXHIBIT_PAINTING) {
+            // the frame turned to face out of its wall
+            c = fabs(cos(e->h * M_PI / 180.0));
+            s = fabs(sin(e->h * M_PI / 180.0));
+            lo[0] = e->x - (c*(PAINTING_WIDTH/2+32) + s*48.0);
+            hi[0] = e->x + (c*(PAINTING_WIDTH/2+32) + s*48.0);
+            lo[2] = e->z - (s*(PAINTING_WIDTH/2+32) + c*48.0);
+            hi[2] = e->z + (s*(PAINTING_WIDTH/2+32) + c*48.0);
+            lo[1] = e->y - (PAINTING_HEIGHT/2+32);
+            hi[1] = e->y + (PAINTING_HEIGHT/2+32);
+        }
+        else if (e->type < NUM_EXHIBITS) {
+            lo[0] = e->x - exhibitBounds[e->type][0];
+            hi[0] = e->x + exhibitBounds[e->type][0];
+            lo[2] = e->z - exhibitBounds[e->type][0];
+            hi[2] = e->z + exhibitBounds[e->type][0];
+            lo[1] = e->y + exhibitBounds[e->type][1];
+            hi[1] = e->y + exhibitBounds[e->type][2];
+        }
+        else
+            continue;
+
+        exhibitShown[i] = occTestBox(lo, hi);
+    }
+}
+
+// test windows begin..end-1, the outside is only seen through them
+void cullPortalRange(void *arg, int begin, int end)
+{
+    int i, axis;
+    GLdouble lo[3], hi[3];
+    scenePortal *p;
+    sceneRoom   *r;
+
+    for (i = begin; i < end; ++i) {
+        p = &museum.portals[i];
+        portalShown[i] = false;
+        if ((!p->glass && (p->to != PORTAL_OUTSIDE)) || !visPortalVisible(i))
+            continue;
+
+        r = &museum.rooms[p->room];
+        axis = ((p->wall == WALL_NORTH) || (p->wall == WALL_SOUTH)) ? 2 : 0;
+        lo[1] = r->floor + p->bottom;
+        hi[1] = r->floor + p->bottom + p->height;
+
+        if (axis == 2) {
+            lo[0] = p->center - p->width/2;
+            hi[0] = p->center + p->width/2;
+            lo[2] = hi[2] = (p->wall == WALL_NORTH) ? r->z0 : r->z1;
+        }
+        else {
+            lo[2] = p->center - p->width/2;
+            hi[2] = p->center + p->width/2;
+            lo[0] = hi[0] = (p->wall == WALL_WEST) ? r->x0 : r->x1;
+        }
+
+        // a little depth either side of the wall
+        lo[axis] -= 16.0;
+        hi[axis] += 16.0;
+
+        portalShown[i] = occTestBox(lo, hi);
+    }
 }
 
 // test if x is a power of 2
@@ -353,155 +873,414 @@ int isPower2(int x)
 // draw to the display
 void draw()
 {
+    TRACE_FUNC();
+
+    int i;
+
+    // the camera for this frame is now fixed
+    if (latActive())
+        latFrameBegin();
+
+    // catch up with lights switched from the keyboard
+    for (i = 0; i < 8; ++i) {
+        if ((lightFlips[i] - lightFlipsApplied[i]) & 1) {
+            if (glIsEnabled(GL_LIGHT0+i))
+                glDisable(GL_LIGHT0+i);
+            else
+                glEnable(GL_LIGHT0+i);
+        }
+        lightFlipsApplied[i] = lightFlips[i];
+    }
+
+    // find the rooms the camera can see, keep the rooms around the
+    // visitor baked and skip whatever the walls hide
+    runFrameJobs();
+
     // place lighting in the scene
+    profBegin(PROF_LIGHTS);
     placeLights();
+    profEnd(PROF_LIGHTS);
 
     // draw the floor
+    profBegin(PROF_FLOOR);
     drawFloor();
+    profEnd(PROF_FLOOR);
 
     // draw the ceiling
+    profBegin(PROF_CEILING);
     drawCeiling();
+    profEnd(PROF_CEILING);
 
-    // draw the walls
+    // draw the walls and what hangs on them
+    profBegin(PROF_WALLS);
     drawWalls();
+    drawPaintings();
+    profEnd(PROF_WALLS);
 
     // draw the outside world
+    profBegin(PROF_OUTSIDE);
     drawOutside();
+    profEnd(PROF_OUTSIDE);
 
-    drawSculpture1();
-    drawSculpture2();
-    drawSculpture3();
-    drawSculpture4();
-    drawSculpture5();
+    // draw every copy of each sculpture
+    for (i = 0; i < NUM_EXHIBITS; ++i) {
+        profBegin(PROF_SCULPTURE1+i);
+        drawExhibits(i);
+        profEnd(PROF_SCULPTURE1+i);
+    }
 
     // draw the window
+    profBegin(PROF_GLASS);
     drawGlass();
+    profEnd(PROF_GLASS);
 
-    if (!animation && !frozen)
-        animate(1);
+    // draw the profiler overlay last so it sits on top
+    if (profHUDVisible()) {
+        profBegin(PROF_HUD);
+        drawHUD();
+        profEnd(PROF_HUD);
+    }
+
+    // back to the simulated state, a render thread only ever
+    // sees snapshots so there is nothing to go back to
+    if (!benchActive() && !renderActive())
+        loadAnimState(animCurr);
     /*
-       glMatrixMode(GL_MODELVIEW);
-       glPushMatrix();
-           glRotated(-90.0, 1.0, 0.0, 0.0);
+       matMode(MAT_MODELVIEW);
+       matPush();
+           matRotate(-90.0, 1.0, 0.0, 0.0);
            gluCylinder(quadric, 512.0, 512.0, 1024.0, 80, 80);
-       glPopMatrix();
+       matPop();
        */
 }
 
-// perform timed scene animation
-void animate(int i)
+// get the next frame ready before it is drawn
+void prepareFrame()
 {
+    // catch the simulation up and draw it part way to the next step,
+    // the benchmark advances animation on a fixed clock instead
+    if (!benchActive()) {
+        animate();
+        blendAnimState(simAlpha());
+    }
+
+    // hand the blended state to the render thread and go back
+    // to the simulated state straight away
+    if (renderActive()) {
+        renderPublish();
+        loadAnimState(animCurr);
+    }
+}
+
+// copy out everything a frame is drawn from, returns the number of values
+int saveSnapshot(double *state)
+{
+    int i, n;
+
+    n  = navSaveView(state);
+    n += saveAnimState(state+n);
+
+    for (i = 0; i < 8; ++i)
+        state[n++] = lightFlips[i];
+
+    return n;
+}
+
+// draw from a snapshot saved by saveSnapshot
+void loadSnapshot(double *state, int n)
+{
+    int i;
+
+    if (n != SNAPSHOT_SIZE) {
+        fprintf(stderr, "warning: render snapshot has %d values, expected %d\n", n, SNAPSHOT_SIZE);
+        return;
+    }
+
+    navLoadView(state);
+    state += NAV_VIEW_SIZE;
+
+    loadAnimState(state);
+    state += ANIM_STATE_SIZE;
+
+    for (i = 0; i < 8; ++i)
+        lightFlips[i] = (int)state[i];
+}
+
+// run the fixed simulation steps due since the last frame
+void animate()
+{
+    TRACE_FUNC();
+
+    int steps;
+
     /*
        if (capture)
        saveFrame(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
        */
 
-    if (!frozen) {
-        animation = true;
-        updateSculpture1();
-        updateSculpture2();
-        updateSculpture4();
-        openGlass();
-        glutPostRedisplay();
-        glutTimerFunc(ANI_RATE, animate, 1);
+    if (frozen) {
+        simPause();
+        return;
     }
-    else
-        animation = false;
+
+    for (steps = simAdvance(timeNow()); steps > 0; --steps) {
+        saveAnimState(animPrev);
+        recCount(REC_ANIMATE_TICKS);
+        replayTick();
+        stepAnimation();
+    }
+
+    // keep drawing at the display rate while anything moves
+    redrawPost(REDRAW_ANIMATION);
+}
+
+// put the state a fraction alpha of the way from the last step
+// to the current one, the current state is kept in animCurr
+void blendAnimState(double alpha)
+{
+    int i, n;
+    double blend[ANIM_STATE_SIZE], d;
+
+    n = saveAnimState(animCurr);
+
+    for (i = 0; i < n; ++i) {
+        d = animCurr[i] - animPrev[i];
+
+        if (animPeriod[i] < 0.0)
+            blend[i] = animCurr[i];
+        else if (animPeriod[i] > 0.0) {
+            if (d < 0.0)
+                d += animPeriod[i];
+            blend[i] = fmod(animPrev[i] + alpha*d, animPeriod[i]);
+        }
+        else
+            blend[i] = animPrev[i] + alpha*d;
+    }
+
+    loadAnimState(blend);
+}
+
+// advance every animation by a single step
+void stepAnimation()
+{
+    updateSculpture1();
+    updateSculpture2();
+    updateSculpture4();
+    openGlass();
+}
+
+// copy out all animation state, returns the number of values
+int saveAnimState(double *state)
+{
+    int i, n = 0;
+
+    state[n++] = earthTheta;
+    state[n++] = earthDist;
+    state[n++] = moonTheta;
+    state[n++] = mercuryTheta;
+    state[n++] = mercuryDist;
+
+    for (i = 0; i < 4; ++i)
+        state[n++] = diskRot[i];
+
+    state[n++] = pistHeight;
+    state[n++] = crankTheta;
+    state[n++] = showBurn;
+
+    state[n++] = glassOpen;
+    state[n++] = glassIsOpening;
+
+    state[n++] = frozen;
+    state[n++] = showHelix;
+    state[n++] = showTextures;
+
+    return n;
+}
+
+// restore animation state saved by saveAnimState
+void restoreAnimState(double *state, int n)
+{
+    if (n != ANIM_STATE_SIZE) {
+        fprintf(stderr, "warning: saved animation state has %d values, expected %d\n", n, ANIM_STATE_SIZE);
+        return;
+    }
+
+    loadAnimState(state);
+
+    // nothing to blend from until the next step
+    memcpy(animPrev, state, sizeof(animPrev));
+}
+
+// set every animation value from a full saved state
+void loadAnimState(double *state)
+{
+    int i, n = 0;
+
+    earthTheta   = state[n++];
+    earthDist    = state[n++];
+    moonTheta    = state[n++];
+    mercuryTheta = state[n++];
+    mercuryDist  = state[n++];
+
+    for (i = 0; i < 4; ++i)
+        diskRot[i] = state[n++];
+
+    pistHeight = state[n++];
+    crankTheta = state[n++];
+    showBurn   = state[n++] != 0.0;
+
+    glassOpen      = state[n++];
+    glassIsOpening = state[n++] != 0.0;
+
+    frozen       = state[n++] != 0.0;
+    showHelix    = state[n++] != 0.0;
+    showTextures = state[n++] != 0.0;
 }
 
 // place lights in the scene
+// when the scene has more lights than OpenGL can place at once
+// the ones nearest the camera are used, a light keeps its slot
+// for as long as it stays near so its colors are only loaded once
 void placeLights()
 {
-    // outside light locations
-    GLfloat const lightLoc0[4] = {0.0, 0.0, (ROOM_LENGTH/-2.0)+0.0, 1.0};
-    GLfloat const lightLoc1[4] = {0.0, 1024.0, (ROOM_LENGTH/-2.0)-1024.0, 1.0};
+    TRACE_FUNC();
 
-    GLfloat const lightLoc2[4] = {OUTSIDE_WIDTH/-2.0+1024.0,  (2.0*FLOOR_LEVEL)+OUTSIDE_HEIGHT-1024.0, (ROOM_LENGTH/-2.0)-OUTSIDE_LENGTH+1024.0, 1.0};
-    GLfloat const lightLoc3[4] = {OUTSIDE_WIDTH/ 2.0-1024.0,  (2.0*FLOOR_LEVEL)+OUTSIDE_HEIGHT-1024.0, (ROOM_LENGTH/-2.0)-OUTSIDE_LENGTH+1024.0, 1.0};
+    int i, j, n;
+    int near[SCENE_GL_LIGHTS];
+    bool placed;
+    GLdouble x, y, z, h, v;
+    sceneLight *light;
 
-    /*
-       glMatrixMode(GL_MODELVIEW);
-       glPushMatrix();
-           glTranslated(OUTSIDE_WIDTH/-2.0+1024.0,  (2.0*FLOOR_LEVEL)+OUTSIDE_HEIGHT-1024.0, (ROOM_LENGTH/-2.0)-OUTSIDE_LENGTH+1024.0);
-           gluSphere(quadric, 256.0, 60, 40);
-       glPopMatrix();
-
-       glPushMatrix();
-           glTranslated(OUTSIDE_WIDTH/ 2.0-1024.0,  (2.0*FLOOR_LEVEL)+OUTSIDE_HEIGHT-1024.0, (ROOM_LENGTH/-2.0)-OUTSIDE_LENGTH+1024.0);
-           gluSphere(quadric, 256.0, 60, 40);
-       glPopMatrix();
-       */    
-
-    // GLfloat const spotdir0[3] = {0.0, -cos(M_PI/4.0), cos(M_PI/4.0)};
-    GLfloat const spotdir0[3] = {0.0, -1.0, 2.5};
-
-    // inside light locations
-    GLfloat const lightLoc4[4] = {(ROOM_WIDTH/ 2.0)-512, 512, (ROOM_LENGTH/2.0)-(    ROOM_LENGTH/3.0), 1.0};
-    GLfloat const lightLoc5[4] = {(ROOM_WIDTH/-2.0)+512, 512, (ROOM_LENGTH/2.0)-(    ROOM_LENGTH/3.0), 1.0};
-    GLfloat const lightLoc6[4] = {(ROOM_WIDTH/ 2.0)-512, 512, (ROOM_LENGTH/2.0)-(2.0*ROOM_LENGTH/3.0), 1.0};
-    GLfloat const lightLoc7[4] = {(ROOM_WIDTH/-2.0)+512, 512, (ROOM_LENGTH/2.0)-(2.0*ROOM_LENGTH/3.0), 1.0};
-
-    // light 0 is has spotlight properties, it shines through the window
-    glLightfv(GL_LIGHT0, GL_POSITION, lightLoc0);
-    glLightf(GL_LIGHT0,  GL_SPOT_CUTOFF,           65.0);
-    glLightf(GL_LIGHT0,  GL_SPOT_EXPONENT,         35.0);
-    glLightfv(GL_LIGHT0, GL_SPOT_DIRECTION,        spotdir0);
-
-    // lights 1-3 are outside
-    glLightfv(GL_LIGHT1, GL_POSITION, lightLoc1);
-    glLightfv(GL_LIGHT2, GL_POSITION, lightLoc2);
-    glLightfv(GL_LIGHT3, GL_POSITION, lightLoc3);
-
-    // light 4-7 are inside
-    glLightfv(GL_LIGHT4, GL_POSITION, lightLoc4);
-    glLightfv(GL_LIGHT5, GL_POSITION, lightLoc5);
-    glLightfv(GL_LIGHT6, GL_POSITION, lightLoc6);
-    glLightfv(GL_LIGHT7, GL_POSITION, lightLoc7);
-}
-
-// draw a tiled floor in the scene
+    if (museum.numLights <= SCENE_GL_LIGHTS)
+        for (n = 0; n < museum.numLights; ++n)
+            near[n] = n;
+    else {
+        navGetCamera(&x, &y, &z, &h, &v);
+        n = sceneNearestLights(&museum, x, y, z, near, SCENE_GL_LIGHTS);
+    }
+
+    // free slots holding lights that are no longer near
+    for (i = 0; i < SCENE_GL_LIGHTS; ++i) {
+        placed = false;
+        for (j = 0; j < n; ++j)
+            if (lightSlot[i] == near[j])
+                placed = true;
+
+        if (!placed && (lightSlot[i] != -1)) {
+            glDisable(GL_LIGHT0+i);
+            lightSlot[i] = -1;
+        }
+    }
+
+    // move newly near lights into free slots
+    for (j = 0; j < n; ++j) {
+        for (i = 0; i < SCENE_GL_LIGHTS; ++i)
+            if (lightSlot[i] == near[j])
+                break;
+        if (i < SCENE_GL_LIGHTS)
+            continue;
+
+        for (i = 0; lightSlot[i] != -1; ++i)
+            ;
+        lightSlot[i] = near[j];
+        loadLight(GL_LIGHT0+i, &museum.lights[near[j]]);
+        glEnable(GL_LIGHT0+i);
+    }
+
+    // positions and spot directions go through the modelview
+    matUpload();
+    for (i = 0; i < SCENE_GL_LIGHTS; ++i) {
+        if (lightSlot[i] == -1)
+            continue;
+
+        light = &museum.lights[lightSlot[i]];
+        glLightfv(GL_LIGHT0+i, GL_POSITION, light->position);
+        if (light->spotCutoff < 180.0)
+            glLightfv(GL_LIGHT0+i, GL_SPOT_DIRECTION, light->spotDirection);
+    }
+}
+
+// draw a tiled floor in every visible room
 void drawFloor()
+{
+    TRACE_FUNC();
+
+    int i;
+    streamMesh *m;
+
+    for (i = 0; i < visNumRooms(); ++i) {
+        m = streamRoomMesh(visRoom(i));
+
+        // labels need the slow path
+        if (debug > 0) {
+            drawRoomFloor(&museum.rooms[visRoom(i)]);
+            continue;
+        }
+
+        // stand in until the room is baked, if it ever will be
+        if (m == NULL) {
+            if (streamActive())
+                drawRoomFloorQuad(&museum.rooms[visRoom(i)]);
+            else
+                drawRoomFloor(&museum.rooms[visRoom(i)]);
+            continue;
+        }
+
+        meshBind(m->shell);
+        glNormal3f(0.0, 1.0, 0.0);
+
+        applyMaterial(MAT_FLOOR);
+        meshDraw(m->shell, GL_QUADS, m->floorFirst[0], m->floorCount[0]);
+        applyMaterial(MAT_FLOOR_ALT);
+        meshDraw(m->shell, GL_QUADS, m->floorFirst[1], m->floorCount[1]);
+
+        meshUnbind(m->shell);
+    }
+}
+
+// draw the floor of one room as a single quad
+void drawRoomFloorQuad(sceneRoom *r)
+{
+    applyMaterial(MAT_FLOOR);
+
+    matUpload();
+    glBegin(GL_QUADS);
+        glNormal3f(0.0, 1.0, 0.0);
+        glVertex3d(r->x0, r->floor, r->z0);
+        glVertex3d(r->x0, r->floor, r->z1);
+        glVertex3d(r->x1, r->floor, r->z1);
+        glVertex3d(r->x1, r->floor, r->z0);
+    glEnd();
+}
+
+// draw the tiled floor of one room a vertex at a time
+void drawRoomFloor(sceneRoom *r)
 {
     int i, j, k, l;
 
-    char label[10] = "";
-
-    GLfloat const colorA1[4] = {0.4, 0.4, 0.4, 1.0};
-    GLfloat const colorD1[4] = {0.7, 0.7, 0.7, 1.0};
-    GLfloat const colorS1[4] = {0.9, 0.9, 0.9, 1.0};
-
-    GLfloat const colorA2[4] = {0.1, 0.4, 0.4, 1.0};
-    GLfloat const colorD2[4] = {0.1, 0.7, 0.7, 1.0};
-    GLfloat const colorS2[4] = {0.1, 0.9, 0.9, 1.0};
+    char label[24] = "";
 
     // save our current modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
+    matMode(MAT_MODELVIEW);
+    matPush();
     // turn the world upside down
-    glRotated(180.0, 1.0, 0.0, 0.0);
+    matRotate(180.0, 1.0, 0.0, 0.0);
     // translate to far corner of the room at floor level
-    glTranslated(ROOM_WIDTH/-2.0, -1.0*FLOOR_LEVEL, ROOM_LENGTH/-2.0);
+    matTranslate(r->x0, -1.0*r->floor, -1.0*r->z1);
+    matUpload();
 
     // draw the tiles
-    for (i = 0; i < ROOM_WIDTH/512; ++i) {
-        for (j = 0; j < ROOM_LENGTH/512; ++j) {
+    for (i = 0; i < (r->x1-r->x0)/512; ++i) {
+        for (j = 0; j < (r->z1-r->z0)/512; ++j) {
             if (debug > 0) {
                 sprintf(label, "(%d,%d)", i, j);
                 drawText(i*512, 0, j*512, label);
             }
 
-            if ((i+j)%2 == 0) {
-                glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA1);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD1);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS1);
-                glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
-            }
-            else {
-                glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA2);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD2);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS2);
-                glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
-            }
+            if ((i+j)%2 == 0)
+                applyMaterial(MAT_FLOOR);
+            else
+                applyMaterial(MAT_FLOOR_ALT);
 
             // draw tiles on x-z plane
             for (k = i*512/TILE_RES; k < (i+1)*512/TILE_RES; ++k)
@@ -519,34 +1298,88 @@ void drawFloor()
                 }
         }
     }
-    glPopMatrix();
+    matPop();
 }
 
-// draw a textured ceiling in the scene
+// draw a textured ceiling over every visible room
 void drawCeiling()
 {
-    int i, j;
-
-    GLfloat const colorA[4] = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorD[4] = {0.9, 0.9, 0.9, 1.0};
-    GLfloat const colorS[4] = {0.0, 0.0, 0.0, 1.0};
+    TRACE_FUNC();
 
-    // save our current modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
+    int i;
+    streamMesh *m;
 
     // assign material properties
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    applyMaterial(MAT_CEILING);
+
+    for (i = 0; i < visNumRooms(); ++i) {
+        m = streamRoomMesh(visRoom(i));
+        if (m == NULL) {
+            if (streamActive())
+                drawRoomCeilingQuad(&museum.rooms[visRoom(i)]);
+            else
+                drawRoomCeiling(&museum.rooms[visRoom(i)]);
+            continue;
+        }
+
+        if (showTextures)
+            glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, pix[numPix-1]->id);
+
+        meshBind(m->ceiling);
+        glNormal3f(0.0, -1.0, 0.0);
+        meshDraw(m->ceiling, GL_QUADS, 0, m->ceilingCount);
+        meshUnbind(m->ceiling);
+
+        if (showTextures)
+            glDisable(GL_TEXTURE_2D);
+    }
+}
+
+// draw the ceiling of one room as a single quad, repeating
+// the texture once every tile
+void drawRoomCeilingQuad(sceneRoom *r)
+{
+    GLint    s = (r->x1-r->x0)/512, t = (r->z1-r->z0)/512;
+    GLdouble y = r->floor + r->height;
+
+    if (showTextures)
+        glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, pix[numPix-1]->id);
+
+    matUpload();
+    glBegin(GL_QUADS);
+        glNormal3f(0.0, -1.0, 0.0);
+        glTexCoord2i(0, 0);
+        glVertex3d(r->x0, y, r->z0);
+        glTexCoord2i(s, 0);
+        glVertex3d(r->x1, y, r->z0);
+        glTexCoord2i(s, t);
+        glVertex3d(r->x1, y, r->z1);
+        glTexCoord2i(0, t);
+        glVertex3d(r->x0, y, r->z1);
+    glEnd();
+
+    if (showTextures)
+        glDisable(GL_TEXTURE_2D);
+}
+
+// draw the ceiling of one room a vertex at a time
+void drawRoomCeiling(sceneRoom *r)
+{
+    int i, j;
+
+    // save our current modelview
+    matMode(MAT_MODELVIEW);
+    matPush();
 
     // translate to far corner of the room at ceiling level
-    glTranslated(ROOM_WIDTH/-2.0, ROOM_HEIGHT+FLOOR_LEVEL, ROOM_LENGTH/-2.0);
+    matTranslate(r->x0, r->height+r->floor, r->z0);
+    matUpload();
 
     // draw the ceiling
-    for (i = 0; i < ROOM_WIDTH/512; ++i) {
-        for (j = 0; j < ROOM_LENGTH/512; ++j) {
+    for (i = 0; i < (r->x1-r->x0)/512; ++i) {
+        for (j = 0; j < (r->z1-r->z0)/512; ++j) {
             if (showTextures)
                 glEnable(GL_TEXTURE_2D);
             glBindTexture(GL_TEXTURE_2D, pix[numPix-1]->id);
@@ -571,189 +1404,236 @@ void drawCeiling()
         }
     }
 
-    glPopMatrix();
+    matPop();
+}
+
+// move to the lower left corner of a room wall as seen from inside
+// the room, so the wall runs along x and faces z, returns its length
+GLdouble enterWall(sceneRoom *r, int wall)
+{
+    matMode(MAT_MODELVIEW);
+
+    switch (wall) {
+        case WALL_SOUTH:
+            matTranslate(r->x1, r->floor, r->z1);
+            matRotate(180.0, 0.0, 1.0, 0.0);
+            return r->x1 - r->x0;
+
+        case WALL_EAST:
+            matTranslate(r->x1, r->floor, r->z0);
+            matRotate(-90.0, 0.0, 1.0, 0.0);
+            return r->z1 - r->z0;
+
+        case WALL_WEST:
+            matTranslate(r->x0, r->floor, r->z1);
+            matRotate(90.0, 0.0, 1.0, 0.0);
+            return r->z1 - r->z0;
+
+        default:
+            matTranslate(r->x0, r->floor, r->z0);
+            return r->x1 - r->x0;
+    }
+}
+
+// draw one column of wall panels from row j0 up to row j1
+void drawWallColumn(int i, int j0, int j1)
+{
+    int j;
+
+    if (j1 <= j0)
+        return;
+
+    matUpload();
+    glBegin(GL_QUAD_STRIP);
+    for (j = j0; j <= j1; ++j) {
+        glNormal3f(0.0, 0.0, 1.0);
+        glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
+        glNormal3f(0.0, 0.0, 1.0);
+        glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
+    }
+    glEnd();
 }
 
-// draw walls in the scene
+// draw walls around every visible room, leaving openings for the portals
 void drawWalls()
 {
-    int i, j;
+    TRACE_FUNC();
+
+    int i, wall;
+    streamMesh *m;
+
+    // inward facing normal of each wall
+    GLfloat const normal[4][3] = {
+        {0.0, 0.0, 1.0}, {0.0, 0.0, -1.0}, {-1.0, 0.0, 0.0}, {1.0, 0.0, 0.0}
+    };
 
     // material properties
-    GLfloat const colorA[4] = {0.3, 0.3, 0.3, 1.0};
-    GLfloat const colorD[4] = {0.2, 0.2, 0.2, 1.0};
-    GLfloat const colorS[4] = {0.5, 0.5, 0.5, 1.0};
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    applyMaterial(MAT_WALL);
 
-    // draw right wall
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    // rotate to face wall
-    glRotated(-90.0, 0.0, 1.0, 0.0);
-    // move to lower left corner
-    glTranslated(ROOM_LENGTH/-2.0, FLOOR_LEVEL, ROOM_WIDTH/-2.0);
-    // draw wall panels
-    for (i = 0; i < ROOM_LENGTH/TILE_RES; ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for(j = 0; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
-        }
-        glEnd();
-    }
-    glPopMatrix();
-
-    // draw left wall
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-
-    // rotate to face wall
-    glRotated(90.0, 0.0, 1.0, 0.0);
-
-    // move to lower left corner
-    glTranslated(ROOM_LENGTH/-2.0, FLOOR_LEVEL, ROOM_WIDTH/-2.0);
-
-    // draw wall panels
-    for (i = 0; i < ROOM_LENGTH/TILE_RES; ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for(j = 0; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
-        }
-        glEnd();
-    }
-    glPopMatrix();
-
-    // draw near wall
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-
-    // rotate to face wall
-    glRotated(180.0, 0.0, 1.0, 0.0);
-
-    // move to lower left corner
-    glTranslated(ROOM_WIDTH/-2.0, FLOOR_LEVEL, ROOM_LENGTH/-2.0);
-
-    // draw wall panels
-    for (i = 0; i < ROOM_WIDTH/TILE_RES; ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for (j = 0; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
-        }
-        glEnd();
-    }
-    glPopMatrix();
-
-    // draw far wall
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-
-    // rotate to face wall
-    // glRotated(0.0, 0.0, 1.0, 0.0);
-
-    // move to lower left corner
-    glTranslated(ROOM_WIDTH/-2.0, FLOOR_LEVEL, ROOM_LENGTH/-2.0);
-
-    // draw wall panels left of window
-    for (i = 0; i < ((ROOM_WIDTH/TILE_RES/2)-(GLASS_WIDTH/TILE_RES/2)); ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for (j = 0; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
+    for (i = 0; i < visNumRooms(); ++i) {
+        m = streamRoomMesh(visRoom(i));
+        if (m == NULL) {
+            if (streamActive())
+                drawRoomWallQuads(&museum.rooms[visRoom(i)]);
+            else
+                drawRoomWalls(&museum.rooms[visRoom(i)]);
+            continue;
         }
-        glEnd();
-    }
 
-    // draw wall panels above window
-    for (i = ((ROOM_WIDTH/TILE_RES/2)-(GLASS_WIDTH/TILE_RES/2));
-            i < ((ROOM_WIDTH/TILE_RES/2)+(GLASS_WIDTH/TILE_RES/2)); ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for (j = (GLASS_ELEV+GLASS_HEIGHT)/TILE_RES; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
+        meshBind(m->shell);
+        for (wall = WALL_NORTH; wall <= WALL_WEST; ++wall) {
+            glNormal3f(normal[wall][0], normal[wall][1], normal[wall][2]);
+            meshDraw(m->shell, GL_QUADS, m->wallFirst[wall], m->wallCount[wall]);
         }
-        glEnd();
+        meshUnbind(m->shell);
     }
+}
 
-    // draw wall panels right of window
-    for (i = ((ROOM_WIDTH/TILE_RES/2)+(GLASS_WIDTH/TILE_RES/2));
-            i < ROOM_WIDTH/TILE_RES; ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for (j = 0; j <= ROOM_HEIGHT/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
+// one wall panel from u0 to u1 along the wall and v0 to v1 up it,
+// between glBegin(GL_QUADS) and glEnd()
+void drawWallQuad(GLdouble u0, GLdouble u1, GLdouble v0, GLdouble v1)
+{
+    if ((u1 <= u0) || (v1 <= v0))
+        return;
+
+    glNormal3f(0.0, 0.0, 1.0);
+    glVertex3d(u0, v0, 0.0);
+    glVertex3d(u1, v0, 0.0);
+    glVertex3d(u1, v1, 0.0);
+    glVertex3d(u0, v1, 0.0);
+}
+
+// draw the walls of one room as the fewest quads that leave the
+// portals open, a solid stretch between portals and one quad
+// below and above each
+void drawRoomWallQuads(sceneRoom *r)
+{
+    int k, wall;
+    GLdouble length, u, left, right;
+    scenePortal *p, *next;
+
+    for (wall = WALL_NORTH; wall <= WALL_WEST; ++wall) {
+        matMode(MAT_MODELVIEW);
+        matPush();
+
+        // move to lower left corner
+        length = enterWall(r, wall);
+
+        matUpload();
+        glBegin(GL_QUADS);
+        for (u = 0.0; ; u = right) {
+            // the next portal along the wall
+            next = NULL;
+            for (k = 0; k < r->numPortals; ++k) {
+                p = &museum.portals[r->firstPortal+k];
+                if ((p->wall == wall) && (scenePortalOffset(r, p)-p->width/2.0 >= u) &&
+                    ((next == NULL) || (scenePortalOffset(r, p) < scenePortalOffset(r, next))))
+                    next = p;
+            }
+            if (next == NULL)
+                break;
+
+            left  = scenePortalOffset(r, next)-next->width/2.0;
+            right = scenePortalOffset(r, next)+next->width/2.0;
+            drawWallQuad(u, left, 0.0, r->height);
+            drawWallQuad(left, right, 0.0, next->bottom);
+            drawWallQuad(left, right, next->bottom+next->height, r->height);
         }
+        drawWallQuad(u, length, 0.0, r->height);
         glEnd();
+
+        matPop();
     }
+}
 
-    // draw wall panels below window
-    for (i = ((ROOM_WIDTH/TILE_RES/2)-(GLASS_WIDTH/TILE_RES/2));
-            i < ((ROOM_WIDTH/TILE_RES/2)+(GLASS_WIDTH/TILE_RES/2)); ++i) {
-        glBegin(GL_QUAD_STRIP);
-        for (j = 0; j <= GLASS_ELEV/TILE_RES; ++j) {
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i( i   *TILE_RES, j*TILE_RES, 0);
-            glNormal3f(0.0, 0.0, 1.0);
-            glVertex3i((i+1)*TILE_RES, j*TILE_RES, 0);
+// draw the walls of one room a vertex at a time
+void drawRoomWalls(sceneRoom *r)
+{
+    int i, j, k, wall;
+    GLdouble length, offset;
+    scenePortal *p;
+
+    for (wall = WALL_NORTH; wall <= WALL_WEST; ++wall) {
+        matMode(MAT_MODELVIEW);
+        matPush();
+
+        // move to lower left corner
+        length = enterWall(r, wall);
+
+        // draw wall panels, stopping below and starting again
+        // above any portal the column passes through
+        for (i = 0; i < length/TILE_RES; ++i) {
+            j = 0;
+            for (k = 0; k < r->numPortals; ++k) {
+                p = &museum.portals[r->firstPortal+k];
+                if (p->wall != wall)
+                    continue;
+
+                offset = scenePortalOffset(r, p);
+                if ((i*TILE_RES < offset-p->width/2.0) || ((i+1)*TILE_RES > offset+p->width/2.0))
+                    continue;
+
+                drawWallColumn(i, j, p->bottom/TILE_RES);
+                j = (p->bottom+p->height)/TILE_RES;
+            }
+            drawWallColumn(i, j, r->height/TILE_RES);
         }
-        glEnd();
-    }
 
-    glPopMatrix();
+        matPop();
+    }
 }
 
-// draw a glass window in the scene
+// draw the glass windows of every visible room
 void drawGlass()
 {
+    TRACE_FUNC();
+
+    int i;
+    scenePortal *p;
+
+    for (i = 0; i < museum.numPortals; ++i) {
+        p = &museum.portals[i];
+        if (p->glass && portalShown[i])
+            drawWindow(&museum.rooms[p->room], p);
+    }
+}
+
+// draw a glass window in a room wall
+void drawWindow(sceneRoom *r, scenePortal *p)
+{
+    TRACE_FUNC();
+
+    // every window opens together
+    GLdouble open = glassOpen*p->width;
+
     // save our current modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
+    matMode(MAT_MODELVIEW);
+    matPush();
 
     // translate to lower left corner of window
-    glTranslated(-GLASS_WIDTH/2.0, FLOOR_LEVEL+GLASS_ELEV, ROOM_LENGTH/-2.0);
+    enterWall(r, p->wall);
+    matTranslate(scenePortalOffset(r, p)-p->width/2.0, p->bottom, 0.0);
 
     // draw the frame
-    GLfloat const colorA[4] = {0.2, 0.2, 0.2, 1.0};
-    GLfloat const colorD[4] = {0.5, 0.5, 0.5, 1.0};
-    GLfloat const colorS[4] = {0.8, 0.8, 0.8, 1.0};
-
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    applyMaterial(MAT_WINDOW_FRAME);
 
+    matUpload();
     glBegin(GL_QUAD_STRIP);
         glNormal3f(1.0, 1.0, 0.0);
         glVertex3i(0, 0, -50);
         glVertex3i(0, 0, 0);
 
         glNormal3f(-1.0, 1.0, 0.0);
-        glVertex3i(GLASS_WIDTH, 0, -50);
-        glVertex3i(GLASS_WIDTH, 0, 0);
+        glVertex3d(p->width, 0.0, -50.0);
+        glVertex3d(p->width, 0.0, 0.0);
 
         glNormal3f(-1.0, -1.0, 0.0);
-        glVertex3i(GLASS_WIDTH, GLASS_HEIGHT, -50);
-        glVertex3i(GLASS_WIDTH, GLASS_HEIGHT, 0);
+        glVertex3d(p->width, p->height, -50.0);
+        glVertex3d(p->width, p->height, 0.0);
 
         glNormal3f(1.0, -1.0, 0.0);
-        glVertex3i(0, GLASS_HEIGHT, -50);
-        glVertex3i(0, GLASS_HEIGHT, 0);
+        glVertex3d(0.0, p->height, -50.0);
+        glVertex3d(0.0, p->height, 0.0);
 
         glNormal3f(1.0, 1.0, 0.0);
         glVertex3i(0, 0, -50);
@@ -763,39 +1643,34 @@ void drawGlass()
     // draw the window
     glDisable(GL_CULL_FACE);
 
-    GLfloat const wcolorA[4] = {0.1, 0.1, 0.7, 0.25};
-    GLfloat const wcolorD[4] = {0.1, 0.1, 0.7, 0.25};
-    GLfloat const wcolorS[4] = {0.1, 0.1, 0.7, 0.25};
-
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   wcolorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   wcolorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  wcolorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    applyMaterial(MAT_GLASS);
 
     glBegin(GL_QUADS);
         glNormal3f(0.0, 0.0, 1.0);
-        glVertex3d(0.0,                   0.0,          -50.0);
-        glVertex3d(GLASS_WIDTH+glassOpen, 0.0,          -50.0);
-        glVertex3d(GLASS_WIDTH+glassOpen, GLASS_HEIGHT, -50.0);
-        glVertex3d(0.0,                   GLASS_HEIGHT, -50.0);
+        glVertex3d(0.0,             0.0,       -50.0);
+        glVertex3d(p->width+open,   0.0,       -50.0);
+        glVertex3d(p->width+open,   p->height, -50.0);
+        glVertex3d(0.0,             p->height, -50.0);
     glEnd();
     glEnable(GL_CULL_FACE);
 
-    glPopMatrix();
+    matPop();
 }
 
 // update window animation
 void openGlass()
 {
+    TRACE_FUNC();
+
     if (glassIsOpening) {
-        if (glassOpen > -GLASS_WIDTH)
-            glassOpen -= 50.0*ANI_RATE/200.0;
+        if (glassOpen > -1.0)
+            glassOpen -= GLASS_OPEN_STEP;
         else
-            glassOpen = -GLASS_WIDTH;
+            glassOpen = -1.0;
     }
     else {
         if (glassOpen < 0)
-            glassOpen += 50.0*ANI_RATE/200.0;
+            glassOpen += GLASS_OPEN_STEP;
         else
             glassOpen = 0;
     }
@@ -803,15 +1678,7 @@ void openGlass()
 
 void drawSculpture1()
 {
-    int i;
-
-    GLfloat const coneColorA[4] = {0.33, 0.33, 0.33, 1.0};
-    GLfloat const coneColorD[4] = {0.78, 0.78, 0.78, 1.0};
-    GLfloat const coneColorS[4] = {0.90, 0.90, 0.90, 1.0};
-
-    /*GLfloat const coneColorA[4] = {0.4, 0.4, 0.4, 0.30};
-    GLfloat const coneColorD[4] = {0.4, 0.4, 0.4, 0.30};
-    GLfloat const coneColorS[4] = {1.0, 1.0, 1.0, 0.30};*/
+    TRACE_FUNC();
 
     GLfloat const sunColorA[4] = {0.6, 0.4, 0.1, 1.0};
     GLfloat const sunColorD[4] = {0.8, 0.6, 0.1, 1.0};
@@ -830,26 +1697,8 @@ void drawSculpture1()
     GLfloat const mercuryColorS[4] = {0.0, 0.0, 0.0, 1.0};
 
     // save modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    // the system is heliocentric
-    glTranslated((ROOM_WIDTH/2.0)-768.0, 0.0, (ROOM_LENGTH/2.0)-(2.0*ROOM_LENGTH/5.0));
-
-    // assign material properties
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   coneColorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   coneColorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  coneColorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 27.8f);
-
-    // draw the stand
-    glBegin(GL_TRIANGLE_FAN);
-    glNormal3f(0, 1.0, 0.0);
-    glVertex3d(0.0, 0.0, 0.0);
-    for (i = 0; i <= TILE_RES; ++i) {
-        glNormal3f(sin(i*2.0*M_PI/TILE_RES), 0.0, cos(i*2.0*M_PI/TILE_RES));
-        glVertex3d(100.0*sin(i*2.0*M_PI/TILE_RES), FLOOR_LEVEL, 100.0*cos(i*2.0*M_PI/TILE_RES));
-    }
-    glEnd();
+    matMode(MAT_MODELVIEW);
+    matPush();
 
     // assign material properties
     glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   sunColorA);
@@ -858,15 +1707,16 @@ void drawSculpture1()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
     // draw the sun
+    matUpload();
     gluSphere(quadric, 128.0, 60, 40);
 
     // tilted for viewing pleasure
-    glRotated(5.0, 0.0, 0.0, 1.0);
+    matRotate(5.0, 0.0, 0.0, 1.0);
 
-    glPushMatrix();
+    matPush();
 
     // move to earth's center
-    glTranslated(earthDist*sin(earthTheta), 0.0, earthDist*-cos(earthTheta));
+    matTranslate(earthDist*sin(earthTheta), 0.0, earthDist*-cos(earthTheta));
 
     // assign material properties
     glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   earthColorA);
@@ -875,10 +1725,11 @@ void drawSculpture1()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
     // draw the earth
+    matUpload();
     gluSphere(quadric, 32.0, 35, 25);
 
     // move to moon's center
-    glTranslated(moonDist*sin(moonTheta), 0.0, moonDist*-cos(moonTheta));
+    matTranslate(moonDist*sin(moonTheta), 0.0, moonDist*-cos(moonTheta));
 
     // assign material properties
     glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   moonColorA);
@@ -887,15 +1738,16 @@ void drawSculpture1()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 1.0f);
 
     // draw the moon
+    matUpload();
     gluSphere(quadric, 10.0, 20, 15);
 
-    glPopMatrix();
+    matPop();
 
     // draw mecury
-    glPushMatrix();
+    matPush();
 
     // move to mercury's center
-    glTranslated(mercuryDist*sin(mercuryTheta), 0.0, mercuryDist*-cos(mercuryTheta));
+    matTranslate(mercuryDist*sin(mercuryTheta), 0.0, mercuryDist*-cos(mercuryTheta));
 
     // assign material properties
     glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   mercuryColorA);
@@ -904,17 +1756,20 @@ void drawSculpture1()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 1.0f);
 
     // draw mercury
+    matUpload();
     gluSphere(quadric, 20.0, 20, 15);
 
-    glPopMatrix();
+    matPop();
 
     // restore modelview
-    glPopMatrix();
+    matPop();
 }
 
 // update sculpture1 animation
 void updateSculpture1()
 {
+    TRACE_FUNC();
+
     GLdouble const earth_semi_latus_rectum  = 350.0;
     GLdouble const earth_eccentricity       = 0.75;
 
@@ -935,6 +1790,8 @@ void updateSculpture1()
 
 void drawSculpture2()
 {
+    TRACE_FUNC();
+
     GLfloat const colorA1[4] = {0.1, 0.4, 0.1, 1.0};
     GLfloat const colorD1[4] = {0.1, 0.6, 0.1, 1.0};
     GLfloat const colorS1[4] = {0.1, 0.8, 0.1, 1.0};
@@ -951,17 +1808,12 @@ void drawSculpture2()
     GLfloat const colorD4[4] = {0.1, 0.6, 0.6, 1.0};
     GLfloat const colorS4[4] = {0.1, 0.8, 0.8, 1.0};
 
-    GLfloat const colorA5[4] = {0.4, 0.4, 0.4, 1.0};
-    GLfloat const colorD5[4] = {0.6, 0.6, 0.6, 1.0};
-    GLfloat const colorS5[4] = {0.8, 0.8, 0.8, 1.0};
+    matMode(MAT_MODELVIEW);
+    matPush();
+        matRotate(90.0, 0.0, 1.0, 0.0);
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-        glTranslated((ROOM_WIDTH/-2.0)+512, 0.0, (ROOM_LENGTH/2.0)-(2.0*ROOM_LENGTH/8.0));
-        glRotated(90.0, 0.0, 1.0, 0.0);
-
-        glPushMatrix();
-            glRotated(diskRot[0], 1.0, 0.0, 0.0);
+        matPush();
+            matRotate(diskRot[0], 1.0, 0.0, 0.0);
 
             glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA1);
             glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD1);
@@ -970,10 +1822,11 @@ void drawSculpture2()
 
             // gluDisk(quadric, 200.0, 220.0, 40, 60);
             glDisable(GL_CULL_FACE);
+            matUpload();
             glutSolidTorus(10.0, 210.0, 20, 50);
             glEnable(GL_CULL_FACE);
 
-            glRotated(diskRot[1], 0.0, 1.0, 0.0);
+            matRotate(diskRot[1], 0.0, 1.0, 0.0);
 
             glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA2);
             glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD2);
@@ -982,10 +1835,11 @@ void drawSculpture2()
 
             // gluDisk(quadric, 180.0, 200.0, 40, 60);
             glDisable(GL_CULL_FACE);
+            matUpload();
             glutSolidTorus(10.0, 190.0, 20, 50);
             glEnable(GL_CULL_FACE);
 
-            glRotated(diskRot[2], 1.0, 0.0, 0.0);
+            matRotate(diskRot[2], 1.0, 0.0, 0.0);
 
             glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA3);
             glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD3);
@@ -994,10 +1848,11 @@ void drawSculpture2()
 
             // gluDisk(quadric, 160.0, 180.0, 40, 60);
             glDisable(GL_CULL_FACE);
+            matUpload();
             glutSolidTorus(10.0, 170.0, 20, 50);
             glEnable(GL_CULL_FACE);
 
-            glRotated(diskRot[3], 0.0, 1.0, 0.0);
+            matRotate(diskRot[3], 0.0, 1.0, 0.0);
 
             glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA4);
             glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD4);
@@ -1006,42 +1861,19 @@ void drawSculpture2()
 
             // gluDisk(quadric, 140.0, 160.0, 40, 60);
             glDisable(GL_CULL_FACE);
+            matUpload();
             glutSolidTorus(10.0, 150.0, 20, 50);
             glEnable(GL_CULL_FACE);
-        glPopMatrix();
-
-        glPushMatrix();
-            glTranslated(-230.0, 0.0, 0.0);
-            glRotated(90.0, 1.0, 0.0, 0.0);
-
-            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA5);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD5);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS5);
-            glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
-
-            gluCylinder(quadric, 10.0, 10.0, -1.0*FLOOR_LEVEL, 20, 80);
-            gluSphere(quadric, 10.0, 10, 15);
-        glPopMatrix();
-
-        glPushMatrix();
-            glTranslated(230.0, 0.0, 0.0);
-            glRotated(90.0, 1.0, 0.0, 0.0);
+        matPop();
 
-            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA5);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD5);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS5);
-            glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
-
-            gluCylinder(quadric, 10.0, 10.0, -1.0*FLOOR_LEVEL, 20, 80);
-            gluSphere(quadric, 10.0, 10, 15);
-        glPopMatrix();
-
-    glPopMatrix();
+    matPop();
 }
 
 // update sculpture2 animation
 void updateSculpture2()
 {
+    TRACE_FUNC();
+
     int i;
 
     diskRot[0] += 05.0 * (ANI_RATE/200.0);
@@ -1055,6 +1887,8 @@ void updateSculpture2()
 
 void drawSculpture3()
 {
+    TRACE_FUNC();
+
     GLfloat const colorA[4] = {0.33, 0.22, 0.03, 1.0};
     GLfloat const colorD[4] = {0.78, 0.57, 0.11, 1.0};
     GLfloat const colorS[4] = {0.99, 0.91, 0.81, 1.0};
@@ -1065,29 +1899,24 @@ void drawSculpture3()
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    // place the sculpture
-    glTranslated((ROOM_WIDTH/-2.0)+512, 0.0, (ROOM_LENGTH/2.0)-(4.0*ROOM_LENGTH/8.0));
-
-    // draw the stand
-    glPushMatrix();
-    glTranslated(0.0, FLOOR_LEVEL, 0.0);
-    drawFrustum(512.0, 128.0, 512.0);
-    glPopMatrix();
+    matMode(MAT_MODELVIEW);
+    matPush();
 
-    glRotated(90.0, 0.0, 1.0, 0.0);
+    matRotate(90.0, 0.0, 1.0, 0.0);
     // glFrontFace(GL_CW);
     glDisable(GL_CULL_FACE);
+    matUpload();
     glutSolidTeapot(128.0);
     glEnable(GL_CULL_FACE);
     // glFrontFace(GL_CCW);
 
-    glPopMatrix();
+    matPop();
 }
 
 void drawSculpture4()
 {
+    TRACE_FUNC();
+
     GLfloat const metalColorA[4] = {0.4, 0.4, 0.4, 1.0};
     GLfloat const metalColorD[4] = {0.6, 0.6, 0.6, 1.0};
     GLfloat const metalColorS[4] = {0.6, 0.6, 0.6, 1.0};
@@ -1096,14 +1925,12 @@ void drawSculpture4()
     GLfloat const blockColorD[4] = {0.4, 0.4, 0.4, 0.30};
     GLfloat const blockColorS[4] = {1.0, 1.0, 1.0, 0.30};
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    // place the sculpture
-    glTranslated((ROOM_WIDTH/2.0)-512, 200.0, (ROOM_LENGTH/2.0)-(3.0*ROOM_LENGTH/5.0));
+    matMode(MAT_MODELVIEW);
+    matPush();
 
     // show the explosion
     if (0) {
-        glPushMatrix();
+        matPush();
 
         GLfloat const rColorA[4] = {0.4, 0.0, 0.0, 1.0};
         GLfloat const rColorD[4] = {0.8, 0.0, 0.0, 1.0};
@@ -1114,18 +1941,19 @@ void drawSculpture4()
         glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  rColorS);
         glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
-        glTranslated(0.0, -rodLength-420.0, 0.0);
+        matTranslate(0.0, -rodLength-420.0, 0.0);
 
         if (fabs(crankTheta) < (40.0*M_PI/180.0))
-            glScaled(1.0, 200.0/(pistHeight)+0.1, 1.0);
+            matScale(1.0, 200.0/(pistHeight)+0.1, 1.0);
         else 
-            glScaled(1.0, 0.9-200.0/(pistHeight)+0.1, 1.0);
+            matScale(1.0, 0.9-200.0/(pistHeight)+0.1, 1.0);
 
         printf("%f\n", (200.0/(pistHeight)));
 
+        matUpload();
         gluSphere(quadric, 256.0, 20, 30);
 
-        glPopMatrix();
+        matPop();
     }
 
     // make it a metallic grey
@@ -1135,66 +1963,74 @@ void drawSculpture4()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
     // draw piston assembly
-    glPushMatrix();
+    matPush();
 
     // attach to wall
-    glPushMatrix();
-    glTranslated(150.0, 0.0, 0.0);
-    glRotated(90.0, 0.0, 1.0, 0.0);
+    matPush();
+    matTranslate(150.0, 0.0, 0.0);
+    matRotate(90.0, 0.0, 1.0, 0.0);
 
+    matUpload();
     gluSphere(quadric, 50.0, 20, 30);
     gluCylinder(quadric, 50.0, 50.0, 362.0, 20, 30);
 
-    glPopMatrix();
+    matPop();
 
     // draw crank
-    glPushMatrix();
-    glTranslated(150.0, 0.0, 0.0);
-    glRotated(-crankTheta*180.0/M_PI+90.0, 1.0, 0.0, 0.0);
+    matPush();
+    matTranslate(150.0, 0.0, 0.0);
+    matRotate(-crankTheta*180.0/M_PI+90.0, 1.0, 0.0, 0.0);
 
+    matUpload();
     gluCylinder(quadric, 50.0, 50.0, crankRadius, 20, 30);
-    glTranslated(0.0, 0.0, crankRadius);
+    matTranslate(0.0, 0.0, crankRadius);
+    matUpload();
     gluSphere(quadric, 50.0, 20, 30);
 
-    glPopMatrix();
+    matPop();
 
     // give motion
-    glTranslated(0.0, -pistHeight, 0.0);
-    glRotated(90.0, 1.0, 0.0, 0.0);
+    matTranslate(0.0, -pistHeight, 0.0);
+    matRotate(90.0, 1.0, 0.0, 0.0);
 
     // draw piston
+    matUpload();
     gluCylinder(quadric, 256.0, 256.0, 128.0, 20, 30);
 
     // draw piston top
-    glRotated(180.0, 1.0, 0.0, 0.0);
+    matRotate(180.0, 1.0, 0.0, 0.0);
+    matUpload();
     gluDisk(quadric, 0.0, 256.0, 20, 30);
 
     // draw the push rod
-    glPushMatrix();
-    glRotated((asin(crankRadius*sin(crankTheta)/rodLength))*180.0/M_PI, 1.0, 0.0, 0.0);
+    matPush();
+    matRotate((asin(crankRadius*sin(crankTheta)/rodLength))*180.0/M_PI, 1.0, 0.0, 0.0);
+    matUpload();
     gluSphere(quadric, 50.0, 20, 30);
     gluCylinder(quadric, 50.0, 50.0, rodLength, 20, 30);
 
     // attach to crank
-    glTranslated(0.0, 0.0, rodLength);
-    glRotated(90.0, 0.0, 1.0, 0.0);
+    matTranslate(0.0, 0.0, rodLength);
+    matRotate(90.0, 0.0, 1.0, 0.0);
+    matUpload();
     gluSphere(quadric, 50.0, 20, 30);
     gluCylinder(quadric, 50.0, 50.0, 150.0, 20, 30);
 
-    glPopMatrix();
+    matPop();
 
     // draw piston bottom
-    glTranslated(0.0, 0.0, -128.0);
-    glRotated(-180.0, 1.0, 0.0, 0.0);
+    matTranslate(0.0, 0.0, -128.0);
+    matRotate(-180.0, 1.0, 0.0, 0.0);
+    matUpload();
     gluDisk(quadric, 0.0, 256.0, 20, 30);
 
-    glPopMatrix();
+    matPop();
 
     // draw the block
-    glPushMatrix();
+    matPush();
 
-    glTranslated(0.0, FLOOR_LEVEL-200, 0.0);
-    glRotated(-90.0, 1.0, 0.0, 0.0);
+    matTranslate(0.0, FLOOR_LEVEL-200, 0.0);
+    matRotate(-90.0, 1.0, 0.0, 0.0);
 
     // make it clear
     glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   blockColorA);
@@ -1203,16 +2039,19 @@ void drawSculpture4()
     glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
 
     glDisable(GL_CULL_FACE);
+    matUpload();
     gluCylinder(quadric, 260.0, 260.0, 670.0, 60, 80);
     glEnable(GL_CULL_FACE);
 
-    glPopMatrix();
+    matPop();
 
-    glPopMatrix();
+    matPop();
 }
 
 void updateSculpture4()
 {
+    TRACE_FUNC();
+
     crankTheta += (35.0*(M_PI/180.0)) * (ANI_RATE/200.0);
     crankTheta = fmod(crankTheta, 2.0*M_PI);
 
@@ -1228,44 +2067,332 @@ void updateSculpture4()
 // draw sculpture5
 void drawSculpture5()
 {
+    TRACE_FUNC();
+
     if (showHelix) {
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
+        matMode(MAT_MODELVIEW);
+        matPush();
 
-        glTranslated((ROOM_WIDTH/-2.0)+512, 0.0, (ROOM_LENGTH/2.0)-(6.0*ROOM_LENGTH/8.0));
-        glRotated(-95.0, 1.0, 0.0, 0.0);
-        glScaled(35.0, 35.0, 35.0);
+        matRotate(-95.0, 1.0, 0.0, 0.0);
+        matScale(35.0, 35.0, 35.0);
 
         // draw double helix
         drawDoubleHelix();
 
-        glPopMatrix();
+        matPop();
+    }
+}
+
+// draw every copy of one kind of sculpture
+void drawExhibits(int type)
+{
+    TRACE_FUNC();
+
+    int i;
+    sceneExhibit *e;
+
+    // one draw for every stand of this kind
+    drawStands(type);
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        e = &museum.exhibits[i];
+        if ((e->type != type) || !exhibitShown[i])
+            continue;
+
+        matMode(MAT_MODELVIEW);
+        matPush();
+        // place the sculpture
+        matTranslate(e->x, e->y, e->z);
+        if (e->h != 0.0)
+            matRotate(e->h, 0.0, 1.0, 0.0);
+
+        drawSculpture[type]();
+
+        matPop();
+    }
+}
+
+// place the stand under every sculpture in one batch
+// false if out of memory
+bool bakeStands()
+{
+    TRACE_FUNC();
+
+    int i, j, apex;
+    sceneExhibit *e;
+    GLfloat p[3], n[3];
+
+    GLfloat const up[3]     = {0.0, 1.0, 0.0};
+    GLfloat const origin[3] = {0.0, 0.0, 0.0};
+
+    batchCreate(&standBatch, 0);
+    standDraws = (int*)malloc((2*museum.numExhibits+1) * sizeof(int));
+    if (standDraws == NULL)
+        return false;
+
+    matMode(MAT_MODELVIEW);
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        e = &museum.exhibits[i];
+        standDraws[2*i] = standDraws[2*i+1] = -1;
+        if ((e->type >= NUM_EXHIBITS) || (standClass[e->type] < 0))
+            continue;
+
+        // place the sculpture
+        matPush();
+        matLoadIdentity();
+        matTranslate(e->x, e->y, e->z);
+        if (e->h != 0.0)
+            matRotate(e->h, 0.0, 1.0, 0.0);
+
+        switch (standClass[e->type]) {
+            // a cone down to the floor
+            case STAND_ORRERY:
+                batchBegin(&standBatch, STAND_ORRERY, matTop(MAT_MODELVIEW));
+                apex = batchVertex(&standBatch, origin, up, NULL);
+                for (j = 0; j <= TILE_RES; ++j) {
+                    n[0] = sin(j*2.0*M_PI/TILE_RES);
+                    n[1] = 0.0;
+                    n[2] = cos(j*2.0*M_PI/TILE_RES);
+                    p[0] = 100.0*n[0];
+                    p[1] = FLOOR_LEVEL;
+                    p[2] = 100.0*n[2];
+                    batchVertex(&standBatch, p, n, NULL);
+                    if (j > 0)
+                        batchTriangle(&standBatch, apex, standBatch.numVerts-2, standBatch.numVerts-1);
+                }
+                standDraws[2*i] = batchEnd(&standBatch);
+                break;
+
+            // a post either side of the rings
+            case STAND_GIMBAL:
+                matRotate(90.0, 0.0, 1.0, 0.0);
+                for (j = 0; j < 2; ++j) {
+                    matPush();
+                    matTranslate(j ? 230.0 : -230.0, 0.0, 0.0);
+                    matRotate(90.0, 1.0, 0.0, 0.0);
+
+                    batchBegin(&standBatch, STAND_GIMBAL, matTop(MAT_MODELVIEW));
+                    batchCylinder(&standBatch, 10.0, -1.0*FLOOR_LEVEL, 20, 80);
+                    batchSphere(&standBatch, 10.0, 10, 15);
+                    standDraws[2*i+j] = batchEnd(&standBatch);
+
+                    matPop();
+                }
+                break;
+
+            // a pedestal under the teapot
+            case STAND_TEAPOT:
+                matTranslate(0.0, FLOOR_LEVEL, 0.0);
+                batchBegin(&standBatch, STAND_TEAPOT, matTop(MAT_MODELVIEW));
+                bakeFrustum(&standBatch, 512.0, 128.0, 512.0);
+                standDraws[2*i] = batchEnd(&standBatch);
+                break;
+        }
+
+        matPop();
+    }
+
+    return batchFinish(&standBatch);
+}
+
+// stand up every copy of one kind of sculpture in one draw
+void drawStands(int type)
+{
+    TRACE_FUNC();
+
+    int i, cls = standClass[type], shown = 0;
+
+    // ambient, diffuse and specular of each class, then its shininess
+    GLfloat const colors[3][3][4] = {
+        {{0.33, 0.33, 0.33, 1.0}, {0.78, 0.78, 0.78, 1.0}, {0.90, 0.90, 0.90, 1.0}},
+        {{0.4,  0.4,  0.4,  1.0}, {0.6,  0.6,  0.6,  1.0}, {0.8,  0.8,  0.8,  1.0}},
+        {{0.33, 0.22, 0.03, 1.0}, {0.78, 0.57, 0.11, 1.0}, {0.99, 0.91, 0.81, 1.0}}
+    };
+    GLfloat const shininess[3] = {27.8f, 100.0f, 100.0f};
+
+    if (cls < 0)
+        return;
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        if ((museum.exhibits[i].type != type) || !exhibitShown[i])
+            continue;
+
+        batchQueue(&standBatch, standDraws[2*i]);
+        batchQueue(&standBatch, standDraws[2*i+1]);
+        ++shown;
+    }
+
+    if (shown == 0)
+        return;
+
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colors[cls][0]);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colors[cls][1]);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colors[cls][2]);
+    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, shininess[cls]);
+
+    // the stands are already in place
+    matMode(MAT_MODELVIEW);
+    matUpload();
+    batchBind(&standBatch);
+    batchSubmit(&standBatch, cls);
+    batchUnbind(&standBatch);
+}
+
+// place every painting in one batch, frames and canvases
+// false if out of memory
+bool bakePaintings()
+{
+    TRACE_FUNC();
+
+    int i;
+    sceneExhibit *e;
+
+    // corners of the frame, then of the canvas just proud of it
+    GLfloat const frame[4][3] = {
+        {PAINTING_WIDTH/-2-32, PAINTING_HEIGHT/-2-32, 0},
+        {PAINTING_WIDTH/ 2+32, PAINTING_HEIGHT/-2-32, 0},
+        {PAINTING_WIDTH/ 2+32, PAINTING_HEIGHT/ 2+32, 0},
+        {PAINTING_WIDTH/-2-32, PAINTING_HEIGHT/ 2+32, 0}
+    };
+    GLfloat const canvas[4][3] = {
+        {PAINTING_WIDTH/-2, PAINTING_HEIGHT/-2, 2},
+        {PAINTING_WIDTH/ 2, PAINTING_HEIGHT/-2, 2},
+        {PAINTING_WIDTH/ 2, PAINTING_HEIGHT/ 2, 2},
+        {PAINTING_WIDTH/-2, PAINTING_HEIGHT/ 2, 2}
+    };
+    GLfloat const tex[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    GLfloat const normal[3] = {0.0, 0.0, 1.0};
+
+    batchCreate(&paintingBatch, BATCH_TEXCOORDS);
+    paintingDraws = (int*)malloc((2*museum.numExhibits+1) * sizeof(int));
+    if (paintingDraws == NULL)
+        return false;
+
+    matMode(MAT_MODELVIEW);
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        e = &museum.exhibits[i];
+        paintingDraws[2*i] = paintingDraws[2*i+1] = -1;
+        if (e->type != EXHIBIT_PAINTING)
+            continue;
+
+        // hang the painting
+        matPush();
+        matLoadIdentity();
+        matTranslate(e->x, e->y, e->z);
+        if (e->h != 0.0)
+            matRotate(e->h, 0.0, 1.0, 0.0);
+
+        batchBegin(&paintingBatch, PAINTING_FRAME, matTop(MAT_MODELVIEW));
+        batchVertex(&paintingBatch, frame[0], normal, NULL);
+        batchVertex(&paintingBatch, frame[1], normal, NULL);
+        batchVertex(&paintingBatch, frame[2], normal, NULL);
+        batchVertex(&paintingBatch, frame[3], normal, NULL);
+        batchTriangle(&paintingBatch, paintingBatch.numVerts-4, paintingBatch.numVerts-3, paintingBatch.numVerts-2);
+        batchTriangle(&paintingBatch, paintingBatch.numVerts-4, paintingBatch.numVerts-2, paintingBatch.numVerts-1);
+        paintingDraws[2*i] = batchEnd(&paintingBatch);
+
+        batchBegin(&paintingBatch, PAINTING_CANVAS, matTop(MAT_MODELVIEW));
+        batchVertex(&paintingBatch, canvas[0], normal, tex[0]);
+        batchVertex(&paintingBatch, canvas[1], normal, tex[1]);
+        batchVertex(&paintingBatch, canvas[2], normal, tex[2]);
+        batchVertex(&paintingBatch, canvas[3], normal, tex[3]);
+        batchTriangle(&paintingBatch, paintingBatch.numVerts-4, paintingBatch.numVerts-3, paintingBatch.numVerts-2);
+        batchTriangle(&paintingBatch, paintingBatch.numVerts-4, paintingBatch.numVerts-2, paintingBatch.numVerts-1);
+        paintingDraws[2*i+1] = batchEnd(&paintingBatch);
+
+        matPop();
+    }
+
+    return batchFinish(&paintingBatch);
+}
+
+// hang every painting, the skyline doubles as the canvas,
+// one draw for all the frames and one for all the canvases
+void drawPaintings()
+{
+    TRACE_FUNC();
+
+    int i, shown = 0;
+
+    for (i = 0; i < museum.numExhibits; ++i) {
+        if ((museum.exhibits[i].type != EXHIBIT_PAINTING) || !exhibitShown[i])
+            continue;
+
+        batchQueue(&paintingBatch, paintingDraws[2*i]);
+        batchQueue(&paintingBatch, paintingDraws[2*i+1]);
+        ++shown;
     }
+
+    if (shown == 0)
+        return;
+
+    // the paintings are already in place
+    matMode(MAT_MODELVIEW);
+    matUpload();
+    batchBind(&paintingBatch);
+
+    // draw the frames
+    applyMaterial(MAT_PAINTING_FRAME);
+    batchSubmit(&paintingBatch, PAINTING_FRAME);
+
+    // draw the canvases
+    applyMaterial(MAT_CANVAS);
+
+    if (showTextures)
+        glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, pix[numPix-2]->id);
+
+    batchSubmit(&paintingBatch, PAINTING_CANVAS);
+
+    if (showTextures)
+        glDisable(GL_TEXTURE_2D);
+
+    batchUnbind(&paintingBatch);
 }
 
-// draw everything outside the room
+// draw the world outside every window in view
 void drawOutside()
 {
+    TRACE_FUNC();
+
+    int i;
+    scenePortal *p;
+
+    for (i = 0; i < museum.numPortals; ++i) {
+        p = &museum.portals[i];
+        if ((p->to == PORTAL_OUTSIDE) && portalShown[i])
+            drawView(&museum.rooms[p->room], p);
+    }
+}
+
+// draw the grass and skyline seen through a window
+void drawView(sceneRoom *r, scenePortal *p)
+{
+    TRACE_FUNC();
+
+    GLdouble width  = museum.outside[0];
+    GLdouble length = museum.outside[1];
+    GLdouble height = museum.outside[2];
+
     // save our current modelview
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    // move origin outside
-    glTranslated(OUTSIDE_WIDTH/-2.0, 2.0*FLOOR_LEVEL, ROOM_LENGTH/-2.0);
+    matMode(MAT_MODELVIEW);
+    matPush();
+    // move origin outside, the grass lies as far
+    // below the floor as the floor lies below eye level
+    enterWall(r, p->wall);
+    matTranslate(scenePortalOffset(r, p)-width/2.0, FLOOR_LEVEL, 0.0);
+    matUpload();
 
     // draw the grass
-    GLfloat const colorA[4] = {0.0, 1.0, 0.0, 1.0};
-    GLfloat const colorD[4] = {0.0, 1.0, 0.0, 1.0};
-    GLfloat const colorS[4] = {0.0, 0.0, 0.0, 1.0};
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   colorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   colorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  colorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 100.0f);
+    applyMaterial(MAT_GRASS);
 
     glBegin(GL_POLYGON);
-        glVertex3i(0,             0,  0         );
-        glVertex3i(OUTSIDE_WIDTH, 0,  0         );
-        glVertex3i(OUTSIDE_WIDTH, 0, -OUTSIDE_LENGTH);
-        glVertex3i(0,             0, -OUTSIDE_LENGTH);
+        glVertex3d(0.0,   0.0,  0.0   );
+        glVertex3d(width, 0.0,  0.0   );
+        glVertex3d(width, 0.0, -length);
+        glVertex3d(0.0,   0.0, -length);
     glEnd();
 
     // draw the skyline
@@ -1273,29 +2400,23 @@ void drawOutside()
         glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, pix[numPix-2]->id);
 
-    GLfloat const scolorA[4] = {1.0, 1.0, 1.0, 1.0};
-    GLfloat const scolorD[4] = {1.0, 1.0, 1.0, 1.0};
-    GLfloat const scolorS[4] = {1.0, 1.0, 1.0, 1.0};
-    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT,   scolorA);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE,   scolorD);
-    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR,  scolorS);
-    glMaterialf( GL_FRONT_AND_BACK, GL_SHININESS, 0.0f);
+    applyMaterial(MAT_SKYLINE);
 
     glBegin(GL_QUADS);
         glTexCoord2i(0, 0);
-        glVertex3i(0,             0,              -OUTSIDE_LENGTH);
+        glVertex3d(0.0,   0.0,    -length);
         glTexCoord2i(1, 0);
-        glVertex3i(OUTSIDE_WIDTH, 0,              -OUTSIDE_LENGTH);
+        glVertex3d(width, 0.0,    -length);
         glTexCoord2i(1, 1);
-        glVertex3i(OUTSIDE_WIDTH, OUTSIDE_HEIGHT, -OUTSIDE_LENGTH);
+        glVertex3d(width, height, -length);
         glTexCoord2i(0, 1);
-        glVertex3i(0,             OUTSIDE_HEIGHT, -OUTSIDE_LENGTH);
+        glVertex3d(0.0,   height, -length);
     glEnd();
 
     if (showTextures)
         glDisable(GL_TEXTURE_2D);
 
-    glPopMatrix();
+    matPop();
 }
 
 
@@ -1308,6 +2429,7 @@ void drawText(int x, int y, int z, char *text)
     char c;
 
     glColor4d(0.0, 0.0, 0.0, 1.0);
+    matUpload();
     c = text[0];
     for (i = 1; c != '\0'; ++i) {
         glRasterPos3i(x, y, z);
@@ -1317,40 +2439,116 @@ void drawText(int x, int y, int z, char *text)
     }
 }
 
+// draw 2d text at window coordinates x, y
+void drawText2d(int x, int y, char *text)
+{
+    int i;
+
+    matUpload();
+    glRasterPos2i(x, y);
+    for (i = 0; text[i] != '\0'; ++i)
+        glutBitmapCharacter(GLUT_BITMAP_8_BY_13, text[i]);
+}
+
+// draw the profiler overlay in window coordinates
+void drawHUD()
+{
+    TRACE_FUNC();
+
+    int w, h, y, i, n;
+    char line[128];
+    char causes[REDRAW_MAX_DESCRIPTION];
+
+    navGetWindowSize(&w, &h);
+
+    // flat, unlit and always on top
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+
+    matMode(MAT_PROJECTION);
+    matPush();
+    matLoadIdentity();
+    matOrtho2D(0.0, w, 0.0, h);
+
+    matMode(MAT_MODELVIEW);
+    matPush();
+    matLoadIdentity();
+
+    glColor4d(1.0, 1.0, 0.2, 1.0);
+    y = glcDrawHUD(profDrawHUD(h, drawText2d), drawText2d);
+
+    // how much of the museum portal culling let through
+    sprintf(line, "%-11s %4d of %d", "rooms", visNumRooms(), museum.numRooms);
+    drawText2d(10, y -= PROF_HUD_LINE, line);
+
+    // rooms baked in the background
+    sprintf(line, "%-11s %4d resident, %d pending, %.1f MB", "streaming",
+            streamNumResident(), streamNumPending(), streamBytes() / 1048576.0);
+    drawText2d(10, y -= PROF_HUD_LINE, line);
+
+    // exhibits and windows hidden behind walls
+    sprintf(line, "%-11s %4d of %d", "occlusion", occNumCulled(), occNumTested());
+    drawText2d(10, y -= PROF_HUD_LINE, line);
+
+    // how busy each thread running jobs was, the drawing thread first
+    n = sprintf(line, "%-11s", "jobs");
+    for (i = 0; (i < jobNumWorkers()) && (n < (int)sizeof(line) - 6); ++i)
+        n += sprintf(line+n, " %3.0f%%", 100.0*jobUtilization(i));
+    drawText2d(10, y -= PROF_HUD_LINE, line);
+
+    // why this frame was drawn
+    redrawDescribe(redrawCauses(), causes);
+    sprintf(line, "%-11s %s, %ld of %ld asked", "redraw", causes, redrawNumFrames(), redrawNumPosts());
+    drawText2d(10, y -= PROF_HUD_LINE, line);
+
+    // snapshots the render thread drew or never got to
+    if (renderActive()) {
+        sprintf(line, "%-11s %ld drawn, %ld dropped of %ld", "render",
+                renderNumDrawn(), renderNumDropped(), renderNumPublished());
+        drawText2d(10, y -= PROF_HUD_LINE, line);
+    }
+
+    matPop();
+    matMode(MAT_PROJECTION);
+    matPop();
+    matMode(MAT_MODELVIEW);
+
+    glPopAttrib();
+}
+
 // respond to key press
 void keyDown(unsigned char key, int x, int y)
 {
+    TRACE_FUNC();
+
     int i;
 
     if (isdigit(key)) {
         char keyStr[2];
         int  keyDigit = -1;
 
-        GLenum lights[8] =
-        {GL_LIGHT0, GL_LIGHT1, GL_LIGHT2, GL_LIGHT3,
-            GL_LIGHT4, GL_LIGHT5, GL_LIGHT6, GL_LIGHT7};
-
         keyStr[0] = key;
         keyStr[1] = '\0';
         keyDigit  = atoi(keyStr);
         for (i = 1; i <= 8; ++i) {
             if (keyDigit == i) {
-                if (glIsEnabled(lights[i-1]))
-                    glDisable(lights[i-1]);
-                else
-                    glEnable(lights[i-1]);
-
-                glutPostRedisplay();
+                // switched by whichever thread draws the next frame
+                ++lightFlips[i-1];
+                redrawPost(REDRAW_INPUT);
             }
         }
     }
 
     if (key == 'a') {
         frozen = !frozen;
-        glutPostRedisplay();
+        redrawPost(REDRAW_INPUT);
     }
 
-    if (key == 'f') {
+    if ((key == 'f') && renderActive())
+        fprintf(stderr, "Full screen mode is not available with a render thread.\n");
+    else if (key == 'f') {
         frozen = true;
         if (gameMode == false) {
             // check if environment supports full screen mode
@@ -1386,20 +2584,38 @@ void keyDown(unsigned char key, int x, int y)
         frozen = false;
     }
 
+    if (key == 'g')
+        glcDump(stdout);
+
     if (key == 'h') {
         showHelix = !showHelix;
-        glutPostRedisplay();
+        redrawPost(REDRAW_INPUT);
     }
 
     if (key == 'k')
         capture = !capture;
 
+    if (key == 'p') {
+        profToggleHUD();
+        redrawPost(REDRAW_INPUT);
+    }
+
+    if (key == 'P') {
+        if (profCSVActive())
+            profCSVClose();
+        else
+            profCSVOpen(PROFILE_CSV_FILE);
+    }
+
     if (key == 'q')
         cleanUpAndQuit();
 
+    if (key == 'r')
+        recDump("requested from the keyboard");
+
     if (key == 't') {
         showTextures = !showTextures;    
-        glutPostRedisplay();
+        redrawPost(REDRAW_INPUT);
     }
 
     if (key == 'w')
@@ -1409,25 +2625,153 @@ void keyDown(unsigned char key, int x, int y)
 // respond to key release
 void keyUp(unsigned char key, int x, int y)
 {
+    TRACE_FUNC();
+
     // do nothing
 }
 
-// don't allow the camera to go outside the walls
+// clamp a point into an axis aligned box
+void clampToBox(GLdouble *x, GLdouble *z, GLdouble x0, GLdouble z0, GLdouble x1, GLdouble z1)
+{
+    if (*x < x0) *x = x0;
+    if (*x > x1) *x = x1;
+    if (*z < z0) *z = z0;
+    if (*z > z1) *z = z1;
+}
+
+// walkable floor of a room, box 0 is its interior kept clear of
+// the walls and the rest are passages through its doorways,
+// returns the number of boxes written as x0 z0 x1 z1
+int walkableBoxes(int room, GLdouble (*box)[4], int max)
+{
+    int k, n = 1;
+    GLdouble margin = 512.0+WALL_CLIP_H, half;
+    sceneRoom *r = &museum.rooms[room];
+    scenePortal *p;
+
+    box[0][0] = r->x0+margin;
+    box[0][1] = r->z0+margin;
+    box[0][2] = r->x1-margin;
+    box[0][3] = r->z1-margin;
+
+    for (k = r->firstPortal; (k < r->firstPortal+r->numPortals) && (n < max); ++k) {
+        p = &museum.portals[k];
+        if (p->glass || (p->to == PORTAL_OUTSIDE))
+            continue;
+
+        half = p->width/2.0 - WALL_CLIP_H;
+        if (half <= 0.0)
+            continue;
+
+        switch (p->wall) {
+            case WALL_NORTH:
+                box[n][0] = p->center-half; box[n][1] = r->z0-margin;
+                box[n][2] = p->center+half; box[n][3] = r->z0+margin;
+                break;
+            case WALL_SOUTH:
+                box[n][0] = p->center-half; box[n][1] = r->z1-margin;
+                box[n][2] = p->center+half; box[n][3] = r->z1+margin;
+                break;
+            case WALL_EAST:
+                box[n][0] = r->x1-margin; box[n][1] = p->center-half;
+                box[n][2] = r->x1+margin; box[n][3] = p->center+half;
+                break;
+            case WALL_WEST:
+                box[n][0] = r->x0-margin; box[n][1] = p->center-half;
+                box[n][2] = r->x0+margin; box[n][3] = p->center+half;
+                break;
+        }
+        ++n;
+    }
+
+    return n;
+}
+
+// is x, z on the walkable floor of a room
+bool walkable(int room, GLdouble x, GLdouble z)
+{
+    int i, n;
+    GLdouble box[MAX_WALK_BOXES][4];
+
+    n = walkableBoxes(room, box, MAX_WALK_BOXES);
+    for (i = 0; i < n; ++i)
+        if ((x >= box[i][0]) && (x <= box[i][2]) && (z >= box[i][1]) && (z <= box[i][3]))
+            return true;
+
+    return false;
+}
+
+// don't allow the camera to go through the walls
+// visitors keep clear of the walls of the room they are in but
+// may walk on through its doorways into the neighbouring rooms
 void enforceWallClipping(GLdouble *x, GLdouble *y, GLdouble *z)
 {
-    if (*x > ((ROOM_WIDTH/2.0)-512.0-WALL_CLIP_H))
-        *x = ((ROOM_WIDTH/2.0)-512.0-WALL_CLIP_H);
-    if (*x < ((ROOM_WIDTH/-2.0)+512.0+WALL_CLIP_H))
-        *x = ((ROOM_WIDTH/-2.0)+512.0+WALL_CLIP_H);
-    if (*z > ((ROOM_LENGTH/2.0)-512.0-WALL_CLIP_H))
-        *z = ((ROOM_LENGTH/2.0)-512.0-WALL_CLIP_H);
-    if (*z < ((ROOM_LENGTH/-2.0)+512.0+WALL_CLIP_H))
-        *z = ((ROOM_LENGTH/-2.0)+512.0+WALL_CLIP_H);
+    int i, n, room;
+    GLdouble box[MAX_WALK_BOXES][4];
+    GLdouble bx, bz, best = -1.0, cx = *x, cz = *z, d;
+    sceneRoom *r;
+
+    if (museum.numRooms == 0)
+        return;
+
+    // the camera may have been placed without clipping
+    room = sceneRoomAt(&museum, *x, *z);
+    if ((room < 0) || !walkable(room, *x, *z)) {
+        if ((visitorRoom >= 0) && (visitorRoom < museum.numRooms) && walkable(visitorRoom, *x, *z))
+            room = visitorRoom;
+        else {
+            // slide along the nearest edge of where the visitor was
+            if ((visitorRoom >= 0) && (visitorRoom < museum.numRooms))
+                room = visitorRoom;
+            else if (room < 0)
+                room = 0;
+
+            n = walkableBoxes(room, box, MAX_WALK_BOXES);
+            for (i = 0; i < n; ++i) {
+                bx = *x;
+                bz = *z;
+                clampToBox(&bx, &bz, box[i][0], box[i][1], box[i][2], box[i][3]);
+
+                d = (bx-*x)*(bx-*x) + (bz-*z)*(bz-*z);
+                if ((best < 0.0) || (d < best)) {
+                    best = d;
+                    cx   = bx;
+                    cz   = bz;
+                }
+            }
+
+            *x = cx;
+            *z = cz;
+        }
+    }
+
+    // the room now underfoot, or the one walked out of
+    i = sceneRoomAt(&museum, *x, *z);
+    visitorRoom = (i >= 0) ? i : room;
+    r = &museum.rooms[visitorRoom];
+
+    if (*y > (r->floor+r->height-WALL_CLIP_V))
+        *y = (r->floor+r->height-WALL_CLIP_V);
+    if (*y < (r->floor+WALL_CLIP_V))
+        *y = r->floor+WALL_CLIP_V;
+}
+
+// eye level above the floor of the room at x, z, or the room last
+// walked out of, kept clear of the ceiling like wall clipping does
+GLdouble standingHeight(GLdouble x, GLdouble z)
+{
+    int room;
+    sceneRoom *r;
+
+    if (museum.numRooms == 0)
+        return DEFAULT_CAMERA_Y;
 
-    if (*y > (ROOM_HEIGHT+FLOOR_LEVEL-WALL_CLIP_V))
-        *y = (ROOM_HEIGHT+FLOOR_LEVEL-WALL_CLIP_V);
-    if (*y < (FLOOR_LEVEL+WALL_CLIP_V))
-        *y = FLOOR_LEVEL+WALL_CLIP_V;
+    room = sceneRoomAt(&museum, x, z);
+    if (room < 0)
+        room = (visitorRoom >= 0) ? visitorRoom : 0;
+    r = &museum.rooms[room];
+
+    return fmin(r->floor - FLOOR_LEVEL, r->floor + r->height - WALL_CLIP_V);
 }
 
 // clean up and exit
@@ -1439,5 +2783,16 @@ void cleanUpAndQuit()
     for (i = 0; i < numPix; ++i)
         free(pix[i]);
 
+    renderFree();
+    jobFree();
+    occFree();
+    streamFree();
+
+    visFree();
+    sceneFree(&museum);
+
+    // flush any profiler export
+    profCSVClose();
+
     exit(ALL_IS_WELL);
 }
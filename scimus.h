@@ -44,6 +44,9 @@
     // png loader library
     // #include "pngLoader.h"
 
+    // rooms, exhibits and lights
+    #include "scene.h"
+
     // default debug level
     #define DEBUG 0
 
@@ -54,72 +57,144 @@
     #define WALL_CLIP_H   140
     #define WALL_CLIP_V   420
 
-    // gallery dimensions
-    #define ROOM_WIDTH    512*8
-    #define ROOM_LENGTH   512*23
+    // most walkable boxes in a room, its interior and doorways
+    #define MAX_WALK_BOXES 16
+
+    // floor height below eye level, sculpture stands reach down to it
     #define FLOOR_LEVEL  -650
-    #define ROOM_HEIGHT   1536
 
-    // glass window dimensions
-    #define GLASS_WIDTH   1024
-    #define GLASS_HEIGHT  640
-    #define GLASS_ELEV    384
+    // fraction of a window that slides open each animation step
+    #define GLASS_OPEN_STEP  (50.0*ANI_RATE/200.0/1024.0)
 
-    // outside dimensions
-    #define OUTSIDE_WIDTH   256*32
-    #define OUTSIDE_LENGTH  256*5
-    #define OUTSIDE_HEIGHT  256*16
+    // number of exhibits and how close counts as visiting one
+    #define NUM_EXHIBITS    5
+    #define EXHIBIT_RADIUS  1536.0
 
     // width of smallest tile
     #define TILE_RES  16
 
-    // animation rate in ms/refresh
+    // ms per fixed simulation step
     #define ANI_RATE  100
 
+    // values in a saved animation state
+    #define ANIM_STATE_SIZE 17
+
+    // values in a render snapshot, the view, animation and light switches
+    #define SNAPSHOT_SIZE (NAV_VIEW_SIZE+ANIM_STATE_SIZE+8)
+
+    // exhibits or windows tested by one culling job
+    #define CULL_GRAIN 32
+
+    // material classes of the painting batch
+    #define PAINTING_FRAME  0
+    #define PAINTING_CANVAS 1
+
+    // material classes of the stand batch, -1 for a sculpture without one
+    #define STAND_ORRERY 0
+    #define STAND_GIMBAL 1
+    #define STAND_TEAPOT 2
+
+    /* the camera a frame's jobs work from */
+    typedef struct {
+        GLdouble x, y, z, h, v;
+        GLdouble halfWidth, halfHeight, zNear;
+    } frameCamera;
+
+    /* one step of a frame's cpu work and the phase it is timed as */
+    typedef struct {
+        int    phase;
+        void (*func)(frameCamera *cam);
+        frameCamera *cam;
+    } frameStep;
+
+    // default profiler csv export file
+    #define PROFILE_CSV_FILE "scimus-profile.csv"
+
     // exit stati
     #define ALL_IS_WELL       0
     #define MAX_TEX_ERROR     1
     #define IMAGE_SIZE_ERROR  2
     #define OUT_OF_MEM_ERROR  3
+    #define BENCH_PATH_ERROR  4
+    #define REPLAY_ERROR      5
+    #define SCENE_ERROR       6
 
-    /* wall paintings */
-    typedef struct {
-        /* center of painting */
-        GLdouble xcenter, ycenter, zcenter;
-        /* horizontal rotation */
-        GLdouble hrot;
-        /* pointer png texture */
-        glpngtexture *pic;
-    } painting;
-
+    void  parseArgs(int nargs, char *args[]);       // parse command-line options
     void  loadTextures(int n, char *picNames[]);    // load images from file
     void  initTextures();                           // create OpenGL textures from loaded images
     void  initLighting();                           // initialize scene lighting
-    void  initPaintings();                          // initialize painting locations
+    void  loadLight(GLenum slot, sceneLight *light);// load a light's colors
+    void  applyMaterial(int material);              // use a scene material
     void  initCallBacks();                          // initialize glut call-back functions
+    void  frameDone();                              // post-swap call-back
+    void  inputObserved(int type, int key,          // input observer call-back
+                        int state, int x, int y);
+    int   activeExhibit();                          // exhibit the visitor is at
     void  draw();                                   // draw to the display
-    void  animate(int i);                           // perform timed animation
+    void  runFrameStep(void *arg);                  // run and time one step of a frame's jobs
+    void  runFrameJobs();                           // run a frame's cpu work as jobs
+    void  getFrameCamera(frameCamera *cam);         // camera a frame's jobs work from
+    void  computeVisibility(frameCamera *cam);      // find the rooms in view
+    void  streamCamera(frameCamera *cam);           // let room streaming follow the camera
+    void  cullExhibits(frameCamera *cam);           // skip exhibits hidden behind walls
+    void  cullExhibitRange(void *arg,               // test a run of exhibits
+                           int begin, int end);
+    void  cullPortalRange(void *arg,                // test a run of windows
+                          int begin, int end);
+    void  prepareFrame();                           // get the next frame ready
+    int   saveSnapshot(double *state);              // copy out what a frame is drawn from
+    void  loadSnapshot(double *state, int n);       // draw from a saved snapshot
+    void  animate();                                // run the simulation steps due
+    void  blendAnimState(double alpha);             // blend the last two steps for drawing
+    void  stepAnimation();                          // advance animation one step
+    int   saveAnimState(double *state);             // copy out animation state
+    void  restoreAnimState(double *state, int n);   // restore saved animation state
+    void  loadAnimState(double *state);             // set animation values from a state
     void  placeLights();                            // place lights in the scene
-    void  drawFloor();                              // draw a tiled floor
-    void  drawCeiling();                            // draw the room ceiling
+    void  drawFloor();                              // draw the room floors
+    void  drawRoomFloorQuad(sceneRoom *r);          // draw one floor as a placeholder
+    void  drawRoomFloor(sceneRoom *r);              // draw one floor without streaming
+    void  drawCeiling();                            // draw the room ceilings
+    void  drawRoomCeilingQuad(sceneRoom *r);        // draw one ceiling as a placeholder
+    void  drawRoomCeiling(sceneRoom *r);            // draw one ceiling without streaming
+    GLdouble enterWall(sceneRoom *r, int wall);     // move to a wall corner
+    void  drawWallColumn(int i, int j0, int j1);    // draw a column of wall panels
     void  drawWalls();                              // draw the room walls
-    void  drawGlass();                              // draw the window
-    void  openGlass();                              // open the window
-    void  drawOutside();                            // draw the skyline
+    void  drawWallQuad(GLdouble u0, GLdouble u1,    // draw one wall panel
+                       GLdouble v0, GLdouble v1);
+    void  drawRoomWallQuads(sceneRoom *r);          // draw one room's walls as placeholders
+    void  drawRoomWalls(sceneRoom *r);              // draw one room's walls without streaming
+    void  drawGlass();                              // draw the windows
+    void  drawWindow(sceneRoom *r, scenePortal *p); // draw one window
+    void  openGlass();                              // open the windows
+    void  drawOutside();                            // draw the skylines
+    void  drawView(sceneRoom *r, scenePortal *p);   // draw the view out one window
     void  drawText(int x, int y, int z, char *t);   // draw 2d text
+    void  drawText2d(int x, int y, char *t);        // draw text at window coordinates
+    void  drawHUD();                                // draw the profiler overlay
     void  drawSculpture1();                         // draw the sculptures
     void  drawSculpture2();
     void  drawSculpture3();
     void  drawSculpture4();
     void  drawSculpture5();
-    void  drawPaintings();
+    void  drawExhibits(int type);                   // draw every copy of a sculpture
+    bool  bakeStands();                             // place every sculpture's stand in one batch
+    void  drawStands(int type);                     // stand up every copy of a sculpture
+    bool  bakePaintings();                          // place every painting in one batch
+    void  drawPaintings();                          // hang the paintings
     void  updateSculpture1();                       // update sculpture animation
     void  updateSculpture2();
     void  updateSculpture4();
     void  keyDown(unsigned char key, int x, int y); // respond to key press
     void  keyUp(unsigned char key, int x, int y);   // respond to key release
+    void  clampToBox(GLdouble *x, GLdouble *z,      // clamp a point into a box
+                     GLdouble x0, GLdouble z0, GLdouble x1, GLdouble z1);
+    int   walkableBoxes(int room,                   // walkable floor of a room
+                        GLdouble (*box)[4], int max);
+    bool  walkable(int room, GLdouble x, GLdouble z); // can the visitor stand here
     void  enforceWallClipping(GLdouble *x,          // wall clipping call-back
                       GLdouble *y, GLdouble *z);
+    GLdouble standingHeight(GLdouble x, GLdouble z);  // eye level over the floor at x, z
     void  cleanUpAndQuit();                         // clean up and exit
     int   isPower2(int x);                          // test if x is a power of 2
 
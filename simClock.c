@@ -0,0 +1,122 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Fixed timestep simulation clock
+ *
+ *  Turns real time into a whole number of fixed simulation steps
+ *  per frame, carrying the remainder over, so animation runs at
+ *  the same speed whatever the frame rate.  What is left over as
+ *  a fraction of a step is used to blend the last two simulated
+ *  states, so the exhibits move smoothly at the display rate.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdbool.h>
+
+// prototypes and definitions
+#include "simClock.h"
+
+// ms per simulation step
+double simStep = 100.0;
+
+// time of the last advance and the ms not yet simulated
+double simLast    = 0.0;
+double simPending = 0.0;
+bool   simRunning = false;
+
+// totals
+long   simSteps   = 0;
+double simLost    = 0.0;
+
+// start the clock, the first advance takes no steps
+void simInit(double step)
+{
+    if (step > 0.0)
+        simStep = step;
+
+    simPending = 0.0;
+    simRunning = false;
+    simSteps   = 0;
+    simLost    = 0.0;
+}
+
+// number of steps to simulate to catch up with now
+int simAdvance(double now)
+{
+    int steps;
+
+    // restarting, pick up from here rather than catching up
+    if (!simRunning) {
+        simLast    = now;
+        simRunning = true;
+        return 0;
+    }
+
+    if (now > simLast)
+        simPending += now - simLast;
+    simLast = now;
+
+    steps = (int)(simPending / simStep);
+    if (steps > SIM_MAX_STEPS) {
+        simLost   += simPending - SIM_MAX_STEPS*simStep;
+        simPending = SIM_MAX_STEPS*simStep;
+        steps      = SIM_MAX_STEPS;
+    }
+
+    simPending -= steps*simStep;
+    simSteps   += steps;
+
+    return steps;
+}
+
+// stop the clock, time until the next advance is not simulated
+void simPause()
+{
+    simRunning = false;
+}
+
+// how far into the next step now is, 0 just after a step up to 1
+double simAlpha()
+{
+    double alpha = simPending / simStep;
+
+    return (alpha < 1.0) ? alpha : 1.0;
+}
+
+// steps taken so far
+long simNumSteps()
+{
+    return simSteps;
+}
+
+// ms of real time dropped after long stalls
+double simDropped()
+{
+    return simLost;
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Fixed timestep simulation clock
+ *
+ *  Turns real time into a whole number of fixed simulation steps
+ *  per frame, carrying the remainder over, so animation runs at
+ *  the same speed whatever the frame rate.  What is left over as
+ *  a fraction of a step is used to blend the last two simulated
+ *  states, so the exhibits move smoothly at the display rate.
+ */
+
+#ifndef SIM_CLOCK_H
+    #define SIM_CLOCK_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // most steps taken in one frame, time beyond that is dropped
+    // so a long stall does not turn into a burst of catching up
+    #define SIM_MAX_STEPS 8
+
+    void   simInit(double step);                         // start the clock, step in ms
+    int    simAdvance(double now);                       // steps due at ms now
+    void   simPause();                                   // stop until the next advance
+    double simAlpha();                                   // fraction of a step since the last
+    long   simNumSteps();                                // steps taken so far
+    double simDropped();                                 // ms dropped after stalls
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,809 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Background room streaming
+ *
+ *  Bakes the floor, ceiling and wall panels of the rooms near the
+ *  visitor into vertex arrays on worker threads and frees them
+ *  again once the visitor has moved on.  Rooms are wanted by
+ *  their distance through the portal graph from the room the
+ *  camera is in and from the room its motion is heading for, so
+ *  neighbours are ready before they come into view.  The render
+ *  thread never waits on a worker: a room that is not resident
+ *  yet is simply drawn the slow way.
+ */
+
+// idle scheduling for the polishing thread
+#ifdef __linux__
+    #define _GNU_SOURCE
+    #include <sched.h>
+#endif
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// high resolution timers
+#include "timing.h"
+
+// tile resolution and error codes
+#include "scimus.h"
+
+// prototypes and definitions
+#include "stream.h"
+
+// scene being streamed, NULL when streaming is off
+scene *streamScene = NULL;
+
+// shared with the workers, guarded by streamLock
+pthread_mutex_t streamLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  streamWake = PTHREAD_COND_INITIALIZER;
+int         *streamState    = NULL;     /* residency of each room */
+streamMesh **streamBuilt    = NULL;     /* baked, waiting to be taken up */
+int         *streamQueue    = NULL;     /* rooms waiting for a worker */
+int         *streamPriority = NULL;     /* portals away, lowest first */
+int          streamQueued   = 0;
+int         *streamPolish   = NULL;     /* STREAM_ROUGH, POLISHING or POLISHED */
+streamMesh **streamRetired  = NULL;     /* meshes waiting to be freed */
+int          streamNumRetired = 0;
+bool         streamQuit     = false;
+
+// worker threads
+pthread_t streamThreads[STREAM_MAX_WORKERS];
+int       streamNumWorkers = 0;
+
+// thread baking resident rooms again, reordered for the vertex cache
+pthread_t streamPolisher;
+bool      streamPolisherRunning = false;
+
+// the frame's streaming job and drawing only, never the workers
+streamMesh **streamResident  = NULL;
+int         *streamDist      = NULL;    /* portals from the camera room */
+int         *streamAhead     = NULL;    /* portals from the room ahead */
+int         *streamBfs       = NULL;
+int         *streamSeen      = NULL;    /* update a room was last in view */
+int          streamTick      = 1;
+int          streamRoom      = -1;
+int          streamResidentCount = 0;
+int          streamPendingCount  = 0;
+size_t       streamResidentBytes = 0;
+
+// camera motion estimate
+GLdouble streamLastX, streamLastZ;
+GLdouble streamVelX = 0.0, streamVelZ = 0.0;
+double   streamLastTime = -1.0;
+
+static void *streamWorker(void *arg);
+static void *streamPolishWorker(void *arg);
+
+// start streaming a scene with some worker threads
+// no workers leaves every room to be drawn the slow way
+bool streamInit(scene *s, int workers)
+{
+    int i;
+
+    streamFree();
+
+    if (workers <= 0)
+        return true;
+    if (workers > STREAM_MAX_WORKERS)
+        workers = STREAM_MAX_WORKERS;
+
+    streamState    = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamBuilt    = (streamMesh**)calloc(s->numRooms+1, sizeof(streamMesh*));
+    streamQueue    = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamPriority = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamPolish   = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamRetired  = (streamMesh**)calloc(3*s->numRooms+1, sizeof(streamMesh*));
+    streamResident = (streamMesh**)calloc(s->numRooms+1, sizeof(streamMesh*));
+    streamDist     = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamAhead    = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamBfs      = (int*)calloc(s->numRooms+1, sizeof(int));
+    streamSeen     = (int*)calloc(s->numRooms+1, sizeof(int));
+
+    if ((streamState == NULL) || (streamBuilt == NULL) || (streamQueue == NULL) ||
+        (streamPriority == NULL) || (streamPolish == NULL) ||
+        (streamRetired == NULL) || (streamResident == NULL) ||
+        (streamDist == NULL) || (streamAhead == NULL) || (streamBfs == NULL) ||
+        (streamSeen == NULL)) {
+        fprintf(stderr, "error: out of memory for room streaming!\n");
+        streamFree();
+        return false;
+    }
+
+    streamScene = s;
+    streamQuit  = false;
+
+    for (i = 0; i < workers; ++i) {
+        if (pthread_create(&streamThreads[i], NULL, streamWorker, NULL) != 0) {
+            fprintf(stderr, "warning: started only %d of %d streaming workers\n", i, workers);
+            break;
+        }
+        ++streamNumWorkers;
+    }
+
+    if (streamNumWorkers == 0) {
+        streamFree();
+        return false;
+    }
+
+    if (pthread_create(&streamPolisher, NULL, streamPolishWorker, NULL) == 0)
+        streamPolisherRunning = true;
+    else
+        fprintf(stderr, "warning: rooms will not be reordered for the vertex cache\n");
+
+    return true;
+}
+
+// stop the workers and unload everything
+void streamFree()
+{
+    int i;
+
+    if (streamNumWorkers > 0) {
+        pthread_mutex_lock(&streamLock);
+        streamQuit = true;
+        pthread_cond_broadcast(&streamWake);
+        pthread_mutex_unlock(&streamLock);
+
+        for (i = 0; i < streamNumWorkers; ++i)
+            pthread_join(streamThreads[i], NULL);
+        streamNumWorkers = 0;
+
+        if (streamPolisherRunning)
+            pthread_join(streamPolisher, NULL);
+        streamPolisherRunning = false;
+    }
+
+    if (streamScene != NULL) {
+        for (i = 0; i < streamScene->numRooms; ++i) {
+            streamFreeMesh(streamBuilt[i]);
+            streamFreeMesh(streamResident[i]);
+        }
+        for (i = 0; i < streamNumRetired; ++i)
+            streamFreeMesh(streamRetired[i]);
+    }
+
+    free(streamState);
+    free(streamBuilt);
+    free(streamQueue);
+    free(streamPriority);
+    free(streamPolish);
+    free(streamRetired);
+    free(streamResident);
+    free(streamDist);
+    free(streamAhead);
+    free(streamBfs);
+    free(streamSeen);
+
+    streamState    = NULL;
+    streamBuilt    = NULL;
+    streamQueue    = NULL;
+    streamPriority = NULL;
+    streamPolish   = NULL;
+    streamRetired  = NULL;
+    streamResident = NULL;
+    streamDist     = NULL;
+    streamAhead    = NULL;
+    streamBfs      = NULL;
+    streamSeen     = NULL;
+
+    streamScene         = NULL;
+    streamQueued        = 0;
+    streamNumRetired    = 0;
+    streamRoom          = -1;
+    streamTick          = 1;
+    streamResidentCount = 0;
+    streamPendingCount  = 0;
+    streamResidentBytes = 0;
+    streamLastTime      = -1.0;
+}
+
+// world position of a point on a room wall, u along the wall
+// from the corner on the left as seen from inside and v up
+static void streamWallPoint(sceneRoom *r, int wall, GLdouble u, GLdouble v, GLfloat *out)
+{
+    switch (wall) {
+        case WALL_SOUTH: out[0] = r->x1-u; out[2] = r->z1;   break;
+        case WALL_EAST:  out[0] = r->x1;   out[2] = r->z0+u; break;
+        case WALL_WEST:  out[0] = r->x0;   out[2] = r->z1-u; break;
+        default:         out[0] = r->x0+u; out[2] = r->z0;   break;
+    }
+    out[1] = r->floor + v;
+}
+
+// corners of a wall, TILE_RES apart along it and up it
+static int streamWallGrid(sceneRoom *r, int wall, GLfloat *out)
+{
+    int i, j, n = 0;
+    GLdouble length = ((wall == WALL_NORTH) || (wall == WALL_SOUTH)) ? r->x1 - r->x0 : r->z1 - r->z0;
+
+    for (i = 0; i <= length/TILE_RES; ++i)
+        for (j = 0; j <= r->height/TILE_RES; ++j, ++n)
+            if (out != NULL)
+                streamWallPoint(r, wall, i*TILE_RES, j*TILE_RES, out+3*n);
+
+    return n;
+}
+
+// one column of wall panels from row j0 up to row j1, as indices
+// into a grid of corners starting at base, only counted when out is NULL
+static int streamWallColumn(sceneRoom *r, int i, int j0, int j1, GLuint base, GLuint *out)
+{
+    int j, n = 0;
+    GLuint rows = r->height/TILE_RES + 1;
+
+    for (j = j0; j < j1; ++j) {
+        if (out != NULL) {
+            out[n+0] = base +  i   *rows + j;
+            out[n+1] = base + (i+1)*rows + j;
+            out[n+2] = base + (i+1)*rows + j+1;
+            out[n+3] = base +  i   *rows + j+1;
+        }
+        n += 4;
+    }
+
+    return n;
+}
+
+// panels of one wall, stopping below and starting again above
+// any portal a column passes through, as drawWalls does
+static int streamWall(scene *s, sceneRoom *r, int wall, GLuint base, GLuint *out)
+{
+    int i, j, k, n = 0;
+    GLdouble length, offset;
+    scenePortal *p;
+
+    length = ((wall == WALL_NORTH) || (wall == WALL_SOUTH)) ? r->x1 - r->x0 : r->z1 - r->z0;
+
+    for (i = 0; i < length/TILE_RES; ++i) {
+        j = 0;
+        for (k = 0; k < r->numPortals; ++k) {
+            p = &s->portals[r->firstPortal+k];
+            if (p->wall != wall)
+                continue;
+
+            offset = scenePortalOffset(r, p);
+            if ((i*TILE_RES < offset-p->width/2.0) || ((i+1)*TILE_RES > offset+p->width/2.0))
+                continue;
+
+            n += streamWallColumn(r, i, j, p->bottom/TILE_RES, base, out ? out+n : NULL);
+            j = (p->bottom+p->height)/TILE_RES;
+        }
+        n += streamWallColumn(r, i, j, r->height/TILE_RES, base, out ? out+n : NULL);
+    }
+
+    return n;
+}
+
+// corners of the floor tiles, rows running back from the far side
+static int streamFloorGrid(sceneRoom *r, GLfloat *out)
+{
+    int k, l, n = 0;
+
+    for (k = 0; k <= (r->x1-r->x0)/TILE_RES; ++k)
+        for (l = 0; l <= (r->z1-r->z0)/TILE_RES; ++l, ++n)
+            if (out != NULL) {
+                out[3*n+0] = r->x0 + k*TILE_RES;
+                out[3*n+1] = r->floor;
+                out[3*n+2] = r->z1 - l*TILE_RES;
+            }
+
+    return n;
+}
+
+// floor tiles of one material, checkered by 512 unit squares,
+// as indices into the grid of corners at the start of the shell
+static int streamFloor(sceneRoom *r, int parity, GLuint *out)
+{
+    int i, j, k, l, n = 0;
+    GLuint rows = (r->z1-r->z0)/TILE_RES + 1;
+
+    for (i = 0; i < (r->x1-r->x0)/512; ++i)
+        for (j = 0; j < (r->z1-r->z0)/512; ++j) {
+            if ((i+j)%2 != parity)
+                continue;
+
+            for (k = i*512/TILE_RES; k < (i+1)*512/TILE_RES; ++k)
+                for (l = j*512/TILE_RES; l < (j+1)*512/TILE_RES; ++l) {
+                    if (out != NULL) {
+                        out[n+0] =  k   *rows + l;
+                        out[n+1] = (k+1)*rows + l;
+                        out[n+2] = (k+1)*rows + l+1;
+                        out[n+3] =  k   *rows + l+1;
+                    }
+                    n += 4;
+                }
+        }
+
+    return n;
+}
+
+// bake a room shell into vertex arrays, reordering its quads for
+// the vertex cache if asked, NULL if out of memory
+streamMesh *streamBake(scene *s, int room, bool optimize)
+{
+    int i, j, w, nx, nz, numVerts, numCorners, total;
+    int wallBase[4], first[6], count[6], zero = 0;
+    sceneRoom *r = &s->rooms[room];
+    streamMesh *m;
+    GLfloat *verts, *ceiling = NULL;
+    GLuint *indices, *tiles = NULL;
+
+    m = (streamMesh*)calloc(1, sizeof(streamMesh));
+    if (m == NULL)
+        return NULL;
+
+    // count, then fill, the floor corners come first and
+    // then the corners of each wall
+    numVerts = streamFloorGrid(r, NULL);
+    total = 0;
+    for (i = 0; i < 2; ++i) {
+        m->floorFirst[i] = total;
+        m->floorCount[i] = streamFloor(r, i, NULL);
+        total += m->floorCount[i];
+    }
+    for (w = WALL_NORTH; w <= WALL_WEST; ++w) {
+        wallBase[w] = numVerts;
+        numVerts += streamWallGrid(r, w, NULL);
+        m->wallFirst[w] = total;
+        m->wallCount[w] = streamWall(s, r, w, 0, NULL);
+        total += m->wallCount[w];
+    }
+
+    // ceiling tiles, one texture repeat each, counted across
+    // the room so neighbouring tiles share their corners
+    nx = (r->x1-r->x0)/512;
+    nz = (r->z1-r->z0)/512;
+    m->ceilingCount = 4*nx*nz;
+
+    // baked in floats, then packed
+    verts   = (GLfloat*)malloc(3*sizeof(GLfloat) * (numVerts+1));
+    indices = (GLuint*)malloc(sizeof(GLuint) * (total+1));
+    ceiling = (GLfloat*)malloc(5*sizeof(GLfloat) * ((nx+1)*(nz+1)));
+    tiles   = (GLuint*)malloc(sizeof(GLuint) * (m->ceilingCount+1));
+    if ((verts == NULL) || (indices == NULL) || (ceiling == NULL) || (tiles == NULL)) {
+        free(verts); free(indices); free(ceiling); free(tiles);
+        streamFreeMesh(m);
+        return NULL;
+    }
+
+    streamFloorGrid(r, verts);
+    for (i = 0; i < 2; ++i)
+        streamFloor(r, i, indices + m->floorFirst[i]);
+    for (w = WALL_NORTH; w <= WALL_WEST; ++w) {
+        streamWallGrid(r, w, verts + 3*wallBase[w]);
+        streamWall(s, r, w, wallBase[w], indices + m->wallFirst[w]);
+    }
+
+    for (i = 0; i <= nx; ++i)
+        for (j = 0; j <= nz; ++j) {
+            GLfloat *v = ceiling + 5*(i*(nz+1)+j);
+
+            v[0] = i;
+            v[1] = j;
+            v[2] = r->x0 + i*512;
+            v[3] = r->floor + r->height;
+            v[4] = r->z0 + j*512;
+        }
+    for (i = 0; i < nx; ++i)
+        for (j = 0; j < nz; ++j) {
+            GLuint *t = tiles + 4*(i*nz+j);
+
+            t[0] =  i   *(nz+1) + j;
+            t[1] = (i+1)*(nz+1) + j;
+            t[2] = (i+1)*(nz+1) + j+1;
+            t[3] =  i   *(nz+1) + j+1;
+        }
+
+    // reorder each draw's quads for the vertex cache
+    numCorners = (nx+1)*(nz+1);
+    if (optimize) {
+        for (i = 0; i < 2; ++i) {
+            first[i] = m->floorFirst[i];
+            count[i] = m->floorCount[i];
+        }
+        for (w = WALL_NORTH; w <= WALL_WEST; ++w) {
+            first[2+w] = m->wallFirst[w];
+            count[2+w] = m->wallCount[w];
+        }
+        numVerts   = meshOptimize(verts, numVerts, 3, indices, total, first, count, 6);
+        numCorners = meshOptimize(ceiling, numCorners, 5, tiles, m->ceilingCount,
+                                  &zero, &m->ceilingCount, 1);
+    }
+
+    m->shell   = meshCompress(verts, numVerts, indices, total, false);
+    m->ceiling = meshCompress(ceiling, numCorners, tiles, m->ceilingCount, true);
+    free(verts); free(indices); free(ceiling); free(tiles);
+    if ((m->shell == NULL) || (m->ceiling == NULL)) {
+        streamFreeMesh(m);
+        return NULL;
+    }
+    m->optimized = optimize;
+    m->bytes = sizeof(streamMesh) + m->shell->bytes + m->ceiling->bytes;
+
+    return m;
+}
+
+// release a baked room
+void streamFreeMesh(streamMesh *m)
+{
+    if (m == NULL)
+        return;
+
+    meshFreeCompact(m->shell);
+    meshFreeCompact(m->ceiling);
+    free(m);
+}
+
+
+// nearest resident room still in generation order, -1 if none
+static int streamNextPolish()
+{
+    int i, best = -1;
+
+    for (i = 0; i < streamScene->numRooms; ++i)
+        if ((streamState[i] == STREAM_RESIDENT) && (streamPolish[i] == STREAM_ROUGH) &&
+            (streamBuilt[i] == NULL) && (streamDist[i] >= 0) &&
+            ((best < 0) || (streamDist[i] < streamDist[best])))
+            best = i;
+
+    return best;
+}
+
+// worker thread, frees retired rooms and bakes queued ones
+static void *streamWorker(void *arg)
+{
+    int i, best, room;
+    streamMesh *m;
+
+    pthread_mutex_lock(&streamLock);
+
+    while (!streamQuit) {
+        // unloading first, it only gives memory back
+        if (streamNumRetired > 0) {
+            m = streamRetired[--streamNumRetired];
+            pthread_mutex_unlock(&streamLock);
+            streamFreeMesh(m);
+            pthread_mutex_lock(&streamLock);
+            continue;
+        }
+
+        if (streamQueued == 0) {
+            pthread_cond_wait(&streamWake, &streamLock);
+            continue;
+        }
+
+        // the nearest room waiting
+        best = 0;
+        for (i = 1; i < streamQueued; ++i)
+            if (streamPriority[i] < streamPriority[best])
+                best = i;
+
+        room = streamQueue[best];
+        streamQueue[best]    = streamQueue[--streamQueued];
+        streamPriority[best] = streamPriority[streamQueued];
+        streamState[room]    = STREAM_LOADING;
+
+        pthread_mutex_unlock(&streamLock);
+        m = streamBake(streamScene, room, false);
+        pthread_mutex_lock(&streamLock);
+
+        // the room may have been given up on while baking
+        if ((m != NULL) && (streamState[room] == STREAM_LOADING)) {
+            streamBuilt[room] = m;
+            streamState[room] = STREAM_READY;
+        }
+        else {
+            if (streamState[room] == STREAM_LOADING)
+                streamState[room] = STREAM_UNLOADED;
+
+            pthread_mutex_unlock(&streamLock);
+            streamFreeMesh(m);
+            pthread_mutex_lock(&streamLock);
+        }
+    }
+
+    pthread_mutex_unlock(&streamLock);
+
+    return NULL;
+}
+
+// polishing thread, bakes resident rooms again with their quads
+// reordered, on cpu time nothing else wants so it never takes time
+// from drawing or from baking rooms not yet resident
+static void *streamPolishWorker(void *arg)
+{
+    int room;
+    streamMesh *m;
+#if defined(__linux__) && defined(SCHED_IDLE)
+    struct sched_param param = {0};
+
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+    pthread_mutex_lock(&streamLock);
+
+    while (!streamQuit) {
+        room = streamNextPolish();
+        if (room < 0) {
+            pthread_cond_wait(&streamWake, &streamLock);
+            continue;
+        }
+
+        streamPolish[room] = STREAM_POLISHING;
+        pthread_mutex_unlock(&streamLock);
+        m = streamBake(streamScene, room, true);
+        pthread_mutex_lock(&streamLock);
+
+        // swapped in by streamUpdate, unless the
+        // room was unloaded, or loaded again, meanwhile
+        if ((m != NULL) && (streamState[room] == STREAM_RESIDENT) &&
+            (streamPolish[room] == STREAM_POLISHING) && (streamBuilt[room] == NULL))
+            streamBuilt[room] = m;
+        else {
+            if (streamPolish[room] == STREAM_POLISHING)
+                streamPolish[room] = STREAM_ROUGH;
+
+            pthread_mutex_unlock(&streamLock);
+            streamFreeMesh(m);
+            pthread_mutex_lock(&streamLock);
+        }
+    }
+
+    pthread_mutex_unlock(&streamLock);
+
+    return NULL;
+}
+
+// portals from a room to every other, -1 where unreachable
+static void streamDistances(int start, int *dist)
+{
+    int i, k, head = 0, tail = 0, room;
+    sceneRoom *r;
+    scenePortal *p;
+
+    for (i = 0; i < streamScene->numRooms; ++i)
+        dist[i] = -1;
+
+    if (start < 0)
+        return;
+
+    dist[start] = 0;
+    streamBfs[tail++] = start;
+
+    while (head < tail) {
+        room = streamBfs[head++];
+        if (dist[room] >= STREAM_KEEP)
+            continue;
+
+        r = &streamScene->rooms[room];
+        for (k = r->firstPortal; k < r->firstPortal + r->numPortals; ++k) {
+            p = &streamScene->portals[k];
+            if ((p->to != PORTAL_OUTSIDE) && (dist[p->to] < 0)) {
+                dist[p->to] = dist[room] + 1;
+                streamBfs[tail++] = p->to;
+            }
+        }
+    }
+}
+
+// remove a room from the queue
+static void streamDequeue(int room)
+{
+    int i;
+
+    for (i = 0; i < streamQueued; ++i)
+        if (streamQueue[i] == room) {
+            --streamQueued;
+            streamQueue[i]    = streamQueue[streamQueued];
+            streamPriority[i] = streamPriority[streamQueued];
+            return;
+        }
+}
+
+// hand a mesh to the workers to free
+static void streamRetire(streamMesh *m)
+{
+    if (m != NULL)
+        streamRetired[streamNumRetired++] = m;
+}
+
+// a room is in view this frame, call before streamUpdate
+void streamSee(int room)
+{
+    if (streamSeen != NULL)
+        streamSeen[room] = streamTick;
+}
+
+// follow the camera at x, z, call once a frame from the frame's streaming
+// job, never waits for a worker, if they hold the lock it tries next frame
+void streamUpdate(GLdouble x, GLdouble z)
+{
+    int i, room, ahead, want, pending = 0;
+    double now, dt;
+    bool wake = false;
+
+    if (streamScene == NULL)
+        return;
+
+    // smoothed camera velocity in units per millisecond
+    now = timeNow();
+    if (streamLastTime >= 0.0) {
+        dt = now - streamLastTime;
+        if (dt > 0.0) {
+            streamVelX += STREAM_SMOOTHING * ((x - streamLastX)/dt - streamVelX);
+            streamVelZ += STREAM_SMOOTHING * ((z - streamLastZ)/dt - streamVelZ);
+        }
+    }
+    streamLastX    = x;
+    streamLastZ    = z;
+    streamLastTime = now;
+
+    // the room the visitor is in and the one they are heading for
+    room = sceneRoomAt(streamScene, x, z);
+    if (room >= 0)
+        streamRoom = room;
+    ahead = sceneRoomAt(streamScene, x + streamVelX*STREAM_LOOKAHEAD,
+                        z + streamVelZ*STREAM_LOOKAHEAD);
+
+    if (pthread_mutex_trylock(&streamLock) != 0)
+        return;
+
+    streamDistances(streamRoom, streamDist);
+    streamDistances(ahead, streamAhead);
+
+    for (i = 0; i < streamScene->numRooms; ++i) {
+        // portals away, counting the room ahead one further
+        want = streamDist[i];
+        if ((streamAhead[i] >= 0) && ((want < 0) || (streamAhead[i]+1 < want)))
+            want = streamAhead[i]+1;
+
+        // rooms in view are wanted like the nearest neighbours however
+        // far the portals lead, and kept a while after they go out of view
+        if ((streamSeen[i] == streamTick) && ((want < 0) || (want > STREAM_RADIUS)))
+            want = STREAM_RADIUS;
+        else if ((streamSeen[i] > 0) && (streamTick - streamSeen[i] <= STREAM_LINGER) &&
+                 ((want < 0) || (want > STREAM_KEEP)))
+            want = STREAM_KEEP;
+
+        switch (streamState[i]) {
+            case STREAM_UNLOADED:
+                if ((want >= 0) && (want <= STREAM_RADIUS)) {
+                    streamQueue[streamQueued]      = i;
+                    streamPriority[streamQueued++] = want;
+                    streamState[i] = STREAM_QUEUED;
+                    wake = true;
+                }
+                break;
+
+            case STREAM_QUEUED:
+                if ((want < 0) || (want > STREAM_KEEP)) {
+                    streamDequeue(i);
+                    streamState[i] = STREAM_UNLOADED;
+                }
+                break;
+
+            case STREAM_LOADING:
+                if ((want < 0) || (want > STREAM_KEEP))
+                    streamState[i] = STREAM_UNLOADED;
+                break;
+
+            case STREAM_READY:
+                if ((want < 0) || (want > STREAM_KEEP)) {
+                    streamRetire(streamBuilt[i]);
+                    streamState[i] = STREAM_UNLOADED;
+                    wake = true;
+                }
+                else {
+                    streamResident[i] = streamBuilt[i];
+                    streamState[i]    = STREAM_RESIDENT;
+                    streamPolish[i]   = STREAM_ROUGH;
+                    ++streamResidentCount;
+                    streamResidentBytes += streamResident[i]->bytes;
+                    wake = true;
+                }
+                streamBuilt[i] = NULL;
+                break;
+
+            case STREAM_RESIDENT:
+                if ((want < 0) || (want > STREAM_KEEP)) {
+                    --streamResidentCount;
+                    streamResidentBytes -= streamResident[i]->bytes;
+                    streamRetire(streamResident[i]);
+                    streamRetire(streamBuilt[i]);
+                    streamResident[i] = NULL;
+                    streamBuilt[i]    = NULL;
+                    streamState[i]    = STREAM_UNLOADED;
+                    streamPolish[i]   = STREAM_ROUGH;
+                    wake = true;
+                }
+                else if (streamBuilt[i] != NULL) {
+                    // the reordered bake replaces the first one
+                    streamResidentBytes += streamBuilt[i]->bytes - streamResident[i]->bytes;
+                    streamRetire(streamResident[i]);
+                    streamResident[i] = streamBuilt[i];
+                    streamBuilt[i]    = NULL;
+                    streamPolish[i]   = STREAM_POLISHED;
+                    wake = true;
+                }
+                break;
+        }
+
+        if ((streamState[i] == STREAM_QUEUED) || (streamState[i] == STREAM_LOADING))
+            ++pending;
+    }
+    streamPendingCount = pending;
+    ++streamTick;
+
+    if (wake)
+        pthread_cond_broadcast(&streamWake);
+    pthread_mutex_unlock(&streamLock);
+}
+
+// are rooms being streamed, or all drawn the slow way
+bool streamActive()
+{
+    return streamScene != NULL;
+}
+
+// the baked shell of a room, NULL if it is not resident
+streamMesh *streamRoomMesh(int room)
+{
+    return (streamResident != NULL) ? streamResident[room] : NULL;
+}
+
+// rooms resident now
+int streamNumResident()
+{
+    return streamResidentCount;
+}
+
+// rooms queued or being baked
+int streamNumPending()
+{
+    return streamPendingCount;
+}
+
+// memory held by resident rooms
+size_t streamBytes()
+{
+    return streamResidentBytes;
+}
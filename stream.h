@@ -0,0 +1,131 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Background room streaming
+ *
+ *  Bakes the floor, ceiling and wall panels of the rooms near the
+ *  visitor into vertex arrays on worker threads and frees them
+ *  again once the visitor has moved on.  Rooms are wanted by
+ *  their distance through the portal graph from the room the
+ *  camera is in and from the room its motion is heading for, so
+ *  neighbours are ready before they come into view, and rooms
+ *  seen down a longer chain of portals are wanted as well.  The
+ *  render thread never waits on a worker: a room that is not
+ *  resident yet is drawn as a few large placeholder quads.  Rooms
+ *  are first baked as quickly as possible and, once no room is
+ *  waiting, baked again with their quads reordered for the
+ *  vertex cache.
+ */
+
+#ifndef STREAM_H
+    #define STREAM_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    // scene description
+    #include "scene.h"
+
+    // compact vertex formats
+    #include "mesh.h"
+
+    // worker threads
+    #define STREAM_DEFAULT_WORKERS 2
+    #define STREAM_MAX_WORKERS     16
+
+    // portals between the visitor and the rooms kept loaded,
+    // rooms further than STREAM_KEEP are unloaded
+    #define STREAM_RADIUS 1
+    #define STREAM_KEEP   2
+
+    // updates a room stays loaded after it was last in view
+    #define STREAM_LINGER 60
+
+    // milliseconds of motion to predict ahead
+    #define STREAM_LOOKAHEAD 750.0
+
+    // weight of the newest motion sample in the velocity estimate
+    #define STREAM_SMOOTHING 0.2
+
+    // room residency
+    #define STREAM_UNLOADED 0
+    #define STREAM_QUEUED   1              /* waiting for a worker */
+    #define STREAM_LOADING  2              /* being baked */
+    #define STREAM_READY    3              /* baked, not yet taken up */
+    #define STREAM_RESIDENT 4
+
+    // reordering of a resident room for the vertex cache
+    #define STREAM_ROUGH     0             /* baked in generation order */
+    #define STREAM_POLISHING 1             /* being baked again */
+    #define STREAM_POLISHED  2
+
+    /* baked room shell, indexed quads */
+    typedef struct {
+        meshCompact *shell;                /* floor and wall panels */
+        meshCompact *ceiling;              /* textured ceiling tiles */
+        int      floorFirst[2];            /* floor tiles of each material, in indices */
+        int      floorCount[2];
+        int      wallFirst[4];             /* panels of each wall */
+        int      wallCount[4];
+        int      ceilingCount;
+        bool     optimized;                /* quads reordered for the vertex cache */
+        size_t   bytes;
+    } streamMesh;
+
+    bool streamInit(scene *s, int workers);              // start streaming a scene
+    void streamFree();                                   // stop the workers and unload everything
+    bool streamActive();                                 // are rooms being streamed
+    void streamSee(int room);                            // a room is in view this frame
+    void streamUpdate(GLdouble x, GLdouble z);           // follow the camera, once a frame
+    streamMesh *streamRoomMesh(int room);                // baked room, NULL if not resident
+    streamMesh *streamBake(scene *s, int room,           // bake a room shell, reordered
+                           bool optimize);               // for the vertex cache or quickly
+    void streamFreeMesh(streamMesh *m);                  // release a baked room
+    int  streamNumResident();                            // rooms resident now
+    int  streamNumPending();                             // rooms queued or being baked
+    size_t streamBytes();                                // memory held by resident rooms
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
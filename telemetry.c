@@ -0,0 +1,168 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Shared-memory telemetry export
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "telemetry.h"
+
+// upper bound of each histogram bin in ms
+float const telemEdges[TELEM_HIST_BINS] = {
+    2.0, 4.0, 8.0, 12.0, 16.7, 20.0, 25.0, 33.3, 50.0, 66.7, 100.0, 1.0e9
+};
+
+telemBlock *telem = NULL;
+char  telemName[256] = "";
+double telemStart = 0.0;
+
+// create and map the shared block
+bool telemOpen(char *name)
+{
+    int i, fd;
+
+    if (name == NULL)
+        name = TELEM_DEFAULT_NAME;
+
+    fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("telemetry: shm_open");
+        return false;
+    }
+
+    if (ftruncate(fd, sizeof(telemBlock)) != 0) {
+        perror("telemetry: ftruncate");
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    telem = mmap(NULL, sizeof(telemBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (telem == MAP_FAILED) {
+        perror("telemetry: mmap");
+        telem = NULL;
+        shm_unlink(name);
+        return false;
+    }
+
+    memset(telem, 0, sizeof(telemBlock));
+    telem->version  = TELEM_VERSION;
+    telem->slots    = TELEM_SLOTS;
+    telem->histBins = TELEM_HIST_BINS;
+    telem->pid      = (int32_t)getpid();
+
+    for (i = 0; i < TELEM_HIST_BINS; ++i)
+        telem->histEdges[i] = telemEdges[i];
+
+    // readers check the magic last
+    __atomic_store_n(&telem->magic, TELEM_MAGIC, __ATOMIC_RELEASE);
+
+    strncpy(telemName, name, sizeof(telemName)-1);
+    telemStart = timeNow();
+
+    atexit(telemClose);
+
+    return true;
+}
+
+// unmap and remove the shared block
+void telemClose()
+{
+    if (telem == NULL)
+        return;
+
+    munmap(telem, sizeof(telemBlock));
+    shm_unlink(telemName);
+    telem = NULL;
+}
+
+// is telemetry being published
+bool telemActive()
+{
+    return telem != NULL;
+}
+
+// name an exhibit for readers
+void telemExhibitName(int exhibit, char *name)
+{
+    if ((telem == NULL) || (exhibit < 0) || (exhibit >= TELEM_MAX_EXHIBITS))
+        return;
+
+    strncpy(telem->exhibits[exhibit], name, TELEM_NAME_LEN-1);
+
+    if (exhibit >= telem->numExhibits)
+        telem->numExhibits = exhibit+1;
+}
+
+// publish a frame sample, wait-free for the single writer
+void telemPublish(float frameMs, float workMs, uint64_t textureBytes, int exhibit)
+{
+    int bin;
+    uint64_t i;
+    telemSample *s;
+
+    if (telem == NULL)
+        return;
+
+    i = telem->head;
+    s = &telem->ring[i % TELEM_SLOTS];
+
+    // mark the slot as being written
+    __atomic_store_n(&s->seq, 2*i+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    s->frame        = i;
+    s->time         = timeNow() - telemStart;
+    s->frameMs      = frameMs;
+    s->workMs       = workMs;
+    s->textureBytes = textureBytes;
+    s->exhibit      = exhibit;
+
+    __atomic_store_n(&s->seq, 2*i+2, __ATOMIC_RELEASE);
+
+    for (bin = 0; bin < TELEM_HIST_BINS-1; ++bin)
+        if (frameMs <= telemEdges[bin])
+            break;
+    __atomic_fetch_add(&telem->hist[bin], 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&telem->head, i+1, __ATOMIC_RELEASE);
+}
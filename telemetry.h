@@ -0,0 +1,118 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Shared-memory telemetry export
+ *
+ *  Each frame the renderer publishes a sample into a ring held in a
+ *  POSIX shared-memory block.  Samples are guarded by a sequence
+ *  number, odd while a sample is being written, so readers such as
+ *  scimon can copy them without locks and without ever blocking the
+ *  renderer.  This header also describes the block layout for readers.
+ */
+
+#ifndef TELEMETRY_H
+    #define TELEMETRY_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdint.h>
+    #include <stdbool.h>
+
+    // default shared-memory object name
+    #define TELEM_DEFAULT_NAME "/scimus-telemetry"
+
+    // block identification
+    #define TELEM_MAGIC   0x544d4353u
+    #define TELEM_VERSION 1
+
+    // samples in the ring, a power of 2
+    #define TELEM_SLOTS 1024
+
+    // frame-time histogram bins, the last bin is open ended
+    #define TELEM_HIST_BINS 12
+
+    // exhibits and their name length
+    #define TELEM_MAX_EXHIBITS 8
+    #define TELEM_NAME_LEN     16
+
+    /* one frame sample */
+    typedef struct {
+        uint64_t seq;           /* 2*index+1 while writing, 2*index+2 when done */
+        uint64_t frame;
+        double   time;          /* ms since publishing started */
+        float    frameMs;       /* ms since the previous swap */
+        float    workMs;        /* ms drawing and swapping */
+        uint64_t textureBytes;  /* texture memory in use */
+        int32_t  exhibit;       /* nearest exhibit, -1 if none */
+        int32_t  pad;
+    } telemSample;
+
+    /* the shared block */
+    typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slots;
+        uint32_t histBins;
+        int32_t  pid;
+        int32_t  numExhibits;
+        uint64_t head;                                  /* samples published so far */
+        float    histEdges[TELEM_HIST_BINS];            /* upper bound of each bin in ms */
+        uint64_t hist[TELEM_HIST_BINS];                 /* frames per bin since start */
+        char     exhibits[TELEM_MAX_EXHIBITS][TELEM_NAME_LEN];
+        telemSample ring[TELEM_SLOTS];
+    } telemBlock;
+
+    bool telemOpen(char *name);                          // create the shared block
+    void telemClose();                                   // remove the shared block
+    bool telemActive();                                  // is telemetry being published
+    void telemExhibitName(int exhibit, char *name);      // name an exhibit for readers
+    void telemPublish(float frameMs, float workMs,       // publish a frame sample
+                      uint64_t textureBytes, int exhibit);
+
+    // lock-free read of sample index i, false if it was overwritten
+    static inline bool telemRead(telemBlock *b, uint64_t i, telemSample *out)
+    {
+        telemSample *s = &b->ring[i % TELEM_SLOTS];
+        uint64_t before, after;
+
+        before = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        *out = *s;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+
+        return (before == after) && (before == 2*i+2);
+    }
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
@@ -0,0 +1,201 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Chrome trace-event CPU profiler
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// high resolution timers
+#include "timing.h"
+
+// prototypes and definitions
+#include "trace.h"
+
+/* a recorded event */
+typedef struct {
+    const char *name;
+    double ts, dur;         /* microseconds */
+    int    tid;
+    char   phase;           /* 'X' complete or 'M' thread name */
+} traceEvent;
+
+bool traceEnabled = false;
+
+// event buffer, filled lock-free by any thread
+traceEvent *traceEvents = NULL;
+long traceCount = 0;
+long traceDropped = 0;
+
+// output file and time origin
+char  *traceFile = NULL;
+double traceStart = 0.0;
+
+// cached kernel thread id
+static __thread int traceTid = 0;
+
+// kernel id of the calling thread
+static int traceThreadID()
+{
+    if (traceTid == 0)
+        traceTid = (int)syscall(SYS_gettid);
+
+    return traceTid;
+}
+
+// trace time in ms
+double traceClock()
+{
+    return timeNow() - traceStart;
+}
+
+// claim the next free event slot, NULL when full
+static traceEvent *traceSlot()
+{
+    long i = __atomic_fetch_add(&traceCount, 1, __ATOMIC_RELAXED);
+
+    if (i >= TRACE_MAX_EVENTS) {
+        __atomic_fetch_add(&traceDropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    return &traceEvents[i];
+}
+
+// start tracing, events are written to fileName at exit
+bool traceOpen(char *fileName)
+{
+    traceEvents = calloc(TRACE_MAX_EVENTS, sizeof(traceEvent));
+    if (traceEvents == NULL) {
+        fprintf(stderr, "error: out of memory for trace events!\n");
+        return false;
+    }
+
+    traceFile  = fileName;
+    traceStart = timeNow();
+    traceCount = 0;
+
+    traceEnabled = true;
+    traceThreadName("main");
+
+    atexit(traceClose);
+
+    return true;
+}
+
+// name the calling thread in the trace
+void traceThreadName(const char *name)
+{
+    traceEvent *e;
+
+    if (!traceEnabled)
+        return;
+
+    e = traceSlot();
+    if (e == NULL)
+        return;
+
+    e->name  = name;
+    e->ts    = 0.0;
+    e->dur   = 0.0;
+    e->tid   = traceThreadID();
+    e->phase = 'M';
+}
+
+// record a finished marker
+void traceRecord(traceMark *m)
+{
+    double end = traceClock();
+    traceEvent *e = traceSlot();
+
+    if (e == NULL)
+        return;
+
+    e->name  = m->name;
+    e->ts    = m->start * 1000.0;
+    e->dur   = (end - m->start) * 1000.0;
+    e->tid   = traceThreadID();
+    e->phase = 'X';
+}
+
+// write the trace as json and stop tracing
+void traceClose()
+{
+    long i, n;
+    bool first = true;
+    FILE *fp;
+    int pid = (int)getpid();
+
+    if (!traceEnabled)
+        return;
+
+    traceEnabled = false;
+
+    n = (traceCount < TRACE_MAX_EVENTS) ? traceCount : TRACE_MAX_EVENTS;
+
+    fp = fopen(traceFile, "w");
+    if (!fp) {
+        fprintf(stderr, "error: couldn't open \"%s\"!\n", traceFile);
+        return;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (i = 0; i < n; ++i) {
+        traceEvent *e = &traceEvents[i];
+
+        // a slot claimed by a thread that has not filled it yet
+        if (e->name == NULL)
+            continue;
+
+        if (!first)
+            fprintf(fp, ",\n");
+        first = false;
+
+        if (e->phase == 'M')
+            fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                    "\"args\": {\"name\": \"%s\"}}", pid, e->tid, e->name);
+        else
+            fprintf(fp, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, "
+                    "\"ts\": %.3f, \"dur\": %.3f}", e->name, pid, e->tid, e->ts, e->dur);
+    }
+    fprintf(fp, "\n]}\n");
+
+    fclose(fp);
+
+    if (traceDropped > 0)
+        fprintf(stderr, "trace: dropped %ld events, buffer holds %d.\n",
+                traceDropped, TRACE_MAX_EVENTS);
+
+    free(traceEvents);
+    traceEvents = NULL;
+}
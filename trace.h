@@ -0,0 +1,102 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Chrome trace-event CPU profiler
+ *
+ *  Scoped markers record complete ("X") events that are written as
+ *  Chrome trace-event JSON when the program exits.  Open the file in
+ *  Perfetto or chrome://tracing.  When tracing is not enabled a marker
+ *  costs a single branch, and building with -DNO_TRACE removes the
+ *  markers altogether.
+ */
+
+#ifndef TRACE_H
+    #define TRACE_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    #include <stdbool.h>
+
+    // maximum number of recorded events, later events are dropped
+    #define TRACE_MAX_EVENTS (1 << 20)
+
+    /* an open marker */
+    typedef struct {
+        const char *name;
+        double start;       /* ms, negative when not tracing */
+    } traceMark;
+
+    extern bool traceEnabled;
+
+    bool traceOpen(char *fileName);                      // start tracing to a file
+    void traceClose();                                   // write the trace and stop
+    void traceThreadName(const char *name);              // name the calling thread
+    void traceRecord(traceMark *m);                      // record a finished marker
+    double traceClock();                                 // trace time in ms
+
+    // start a marker
+    static inline traceMark traceBegin(const char *name)
+    {
+        traceMark m;
+
+        m.name  = name;
+        m.start = traceEnabled ? traceClock() : -1.0;
+
+        return m;
+    }
+
+    // finish a marker, called automatically at the end of its scope
+    static inline void traceEnd(traceMark *m)
+    {
+        if (m->start >= 0.0)
+            traceRecord(m);
+    }
+
+    #define TRACE_JOIN2(a, b) a ## b
+    #define TRACE_JOIN(a, b)  TRACE_JOIN2(a, b)
+
+    #ifndef NO_TRACE
+        // trace from here to the end of the enclosing block
+        #define TRACE_SCOPE(name) \
+            traceMark TRACE_JOIN(traceMark_, __LINE__) \
+            __attribute__((cleanup(traceEnd))) = traceBegin(name)
+    #else
+        #define TRACE_SCOPE(name)
+    #endif
+
+    // trace the rest of the enclosing function
+    #define TRACE_FUNC() TRACE_SCOPE(__func__)
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif
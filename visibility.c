@@ -0,0 +1,585 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Portal visibility
+ *
+ *  Finds the rooms the camera can see by walking the portal
+ *  graph out from the room it stands in, narrowing the view
+ *  frustum to each doorway or window it looks through.  A room
+ *  reached several ways is seen through the hull of all those
+ *  openings and walked once.  Rooms the walk never reaches are
+ *  not drawn.
+ */
+
+// standard c headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+
+// OpenGL and GLUT headers
+#ifdef __APPLE__
+    #include <GLUT/glut.h>
+#else
+    #include <GL/gl.h>
+    #include <GL/glu.h>
+    #include <GL/glut.h>
+#endif
+
+// prototypes and definitions
+#include "visibility.h"
+
+// largest polygon a portal clips down to
+#define VIS_MAX_VERTS (4 + VIS_MAX_PLANES)
+
+// scene being walked
+scene *visScene = NULL;
+
+// culling is on unless turned off for comparison
+bool visEnabled = true;
+
+// what was found visible this frame
+bool *visRoomFlag   = NULL;
+bool *visPortalFlag = NULL;
+int  *visRoomList   = NULL;
+int   visRoomCount  = 0;
+
+// window each room is seen through, convex on the near plane,
+// the fewest portals it is from the camera and how often its
+// window has grown
+GLdouble (*visWindow)[VIS_MAX_PLANES][2] = NULL;
+int       *visWindowVerts = NULL;
+int       *visRoomDepth   = NULL;
+int       *visRoomWalks   = NULL;
+
+// rooms waiting to be walked
+int  *visQueue  = NULL;
+bool *visQueued = NULL;
+int   visHead = 0, visTail = 0;
+
+// eye during a walk, its axes, near plane and the whole view
+GLdouble visEye[3], visFwd[3], visRight[3], visUp[3];
+GLdouble visNear;
+GLdouble visFull[4][2];
+
+// size visibility for a scene, everything starts out visible
+bool visInit(scene *s)
+{
+    visFree();
+
+    visScene      = s;
+    visRoomFlag   = (bool*)malloc((s->numRooms+1) * sizeof(bool));
+    visPortalFlag = (bool*)malloc((s->numPortals+1) * sizeof(bool));
+    visRoomList   = (int*)malloc((s->numRooms+1) * sizeof(int));
+
+    visWindow      = malloc((s->numRooms+1) * sizeof(visWindow[0]));
+    visWindowVerts = (int*)malloc((s->numRooms+1) * sizeof(int));
+    visRoomDepth   = (int*)malloc((s->numRooms+1) * sizeof(int));
+    visRoomWalks   = (int*)malloc((s->numRooms+1) * sizeof(int));
+    visQueue       = (int*)malloc((s->numRooms+1) * sizeof(int));
+    visQueued      = (bool*)malloc((s->numRooms+1) * sizeof(bool));
+
+    if ((visRoomFlag == NULL) || (visPortalFlag == NULL) || (visRoomList == NULL) ||
+        (visWindow == NULL) || (visWindowVerts == NULL) || (visRoomDepth == NULL) ||
+        (visRoomWalks == NULL) || (visQueue == NULL) || (visQueued == NULL)) {
+        fprintf(stderr, "error: out of memory for visibility!\n");
+        visFree();
+        return false;
+    }
+
+    visAll();
+
+    return true;
+}
+
+// release visibility state
+void visFree()
+{
+    free(visRoomFlag);
+    free(visPortalFlag);
+    free(visRoomList);
+    free(visWindow);
+    free(visWindowVerts);
+    free(visRoomDepth);
+    free(visRoomWalks);
+    free(visQueue);
+    free(visQueued);
+
+    visRoomFlag   = NULL;
+    visPortalFlag = NULL;
+    visRoomList   = NULL;
+
+    visWindow      = NULL;
+    visWindowVerts = NULL;
+    visRoomDepth   = NULL;
+    visRoomWalks   = NULL;
+    visQueue       = NULL;
+    visQueued      = NULL;
+    visRoomCount  = 0;
+    visScene      = NULL;
+}
+
+// turn portal culling on or off, off draws every room
+void visEnable(bool enable)
+{
+    visEnabled = enable;
+}
+
+// mark every room and portal visible
+void visAll()
+{
+    int i;
+
+    if (visScene == NULL)
+        return;
+
+    for (i = 0; i < visScene->numRooms; ++i) {
+        visRoomFlag[i] = true;
+        visRoomList[i] = i;
+    }
+    visRoomCount = visScene->numRooms;
+
+    for (i = 0; i < visScene->numPortals; ++i)
+        visPortalFlag[i] = true;
+}
+
+// cross product
+static void visCross(GLdouble *a, GLdouble *b, GLdouble *c)
+{
+    c[0] = a[1]*b[2] - a[2]*b[1];
+    c[1] = a[2]*b[0] - a[0]*b[2];
+    c[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+// plane through the eye and the edge a b, facing toward inside
+// the directions are relative to the eye
+static void visEdgePlane(GLdouble *plane, GLdouble *a, GLdouble *b, GLdouble *inside)
+{
+    GLdouble len;
+
+    visCross(a, b, plane);
+
+    if (plane[0]*inside[0] + plane[1]*inside[1] + plane[2]*inside[2] < 0.0) {
+        plane[0] = -plane[0];
+        plane[1] = -plane[1];
+        plane[2] = -plane[2];
+    }
+
+    // unit normals keep the slack meaningful
+    len = sqrt(plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2]);
+    if (len > 0.0) {
+        plane[0] /= len;
+        plane[1] /= len;
+        plane[2] /= len;
+    }
+
+    plane[3] = -(plane[0]*visEye[0] + plane[1]*visEye[1] + plane[2]*visEye[2]);
+}
+
+// bound a frustum by the eye and the edges of a convex polygon
+static void visPolygonFrustum(visFrustum *f, GLdouble (*poly)[3], int n)
+{
+    int i;
+    GLdouble dir[VIS_MAX_VERTS][3], center[3] = {0.0, 0.0, 0.0};
+
+    for (i = 0; i < n; ++i) {
+        dir[i][0] = poly[i][0] - visEye[0];
+        dir[i][1] = poly[i][1] - visEye[1];
+        dir[i][2] = poly[i][2] - visEye[2];
+
+        center[0] += dir[i][0];
+        center[1] += dir[i][1];
+        center[2] += dir[i][2];
+    }
+
+    for (i = 0; i < n; ++i)
+        visEdgePlane(f->plane[i], dir[i], dir[(i+1) % n], center);
+    f->numPlanes = n;
+}
+
+// clip a convex polygon against one plane, returns the new vertex count
+static int visClipPlane(GLdouble *plane, GLdouble (*in)[3], int n, GLdouble (*out)[3])
+{
+    int i, j, m = 0;
+    GLdouble di, dj, t;
+
+    for (i = 0; i < n; ++i) {
+        j  = (i+1) % n;
+        di = plane[0]*in[i][0] + plane[1]*in[i][1] + plane[2]*in[i][2] + plane[3];
+        dj = plane[0]*in[j][0] + plane[1]*in[j][1] + plane[2]*in[j][2] + plane[3];
+
+        if ((di >= -VIS_EPSILON) && (m < VIS_MAX_VERTS))
+            memcpy(out[m++], in[i], sizeof(out[0]));
+
+        // the edge crosses the plane
+        if (((di >= -VIS_EPSILON) != (dj >= -VIS_EPSILON)) && (m < VIS_MAX_VERTS)) {
+            t = di / (di - dj);
+            out[m][0] = in[i][0] + t*(in[j][0] - in[i][0]);
+            out[m][1] = in[i][1] + t*(in[j][1] - in[i][1]);
+            out[m][2] = in[i][2] + t*(in[j][2] - in[i][2]);
+            ++m;
+        }
+    }
+
+    return m;
+}
+
+// corners of a portal in world space and the eye's distance in
+// front of it, measured into the room the portal belongs to
+static GLdouble visPortalQuad(sceneRoom *r, scenePortal *p, GLdouble (*quad)[3], GLdouble *across)
+{
+    int i;
+    GLdouble w = p->width / 2.0, dist;
+    GLdouble y0 = r->floor + p->bottom, y1 = r->floor + p->bottom + p->height;
+
+    switch (p->wall) {
+        case WALL_SOUTH:
+            for (i = 0; i < 4; ++i) quad[i][2] = r->z1;
+            quad[0][0] = quad[3][0] = p->center - w;
+            quad[1][0] = quad[2][0] = p->center + w;
+            dist    = r->z1 - visEye[2];
+            *across = visEye[0] - p->center;
+            break;
+        case WALL_EAST:
+            for (i = 0; i < 4; ++i) quad[i][0] = r->x1;
+            quad[0][2] = quad[3][2] = p->center - w;
+            quad[1][2] = quad[2][2] = p->center + w;
+            dist    = r->x1 - visEye[0];
+            *across = visEye[2] - p->center;
+            break;
+        case WALL_WEST:
+            for (i = 0; i < 4; ++i) quad[i][0] = r->x0;
+            quad[0][2] = quad[3][2] = p->center - w;
+            quad[1][2] = quad[2][2] = p->center + w;
+            dist    = visEye[0] - r->x0;
+            *across = visEye[2] - p->center;
+            break;
+        default:
+            for (i = 0; i < 4; ++i) quad[i][2] = r->z0;
+            quad[0][0] = quad[3][0] = p->center - w;
+            quad[1][0] = quad[2][0] = p->center + w;
+            dist    = visEye[2] - r->z0;
+            *across = visEye[0] - p->center;
+            break;
+    }
+
+    quad[0][1] = quad[1][1] = y0;
+    quad[2][1] = quad[3][1] = y1;
+
+    return dist;
+}
+
+// where a point lands on the near plane, in eye right and up
+// coordinates, false if it is not in front of the eye
+static bool visProject(GLdouble *p, GLdouble *out)
+{
+    GLdouble d[3], depth;
+
+    d[0] = p[0] - visEye[0];
+    d[1] = p[1] - visEye[1];
+    d[2] = p[2] - visEye[2];
+
+    depth = d[0]*visFwd[0] + d[1]*visFwd[1] + d[2]*visFwd[2];
+    if (depth <= VIS_EPSILON)
+        return false;
+
+    out[0] = visNear * (d[0]*visRight[0] + d[1]*visRight[1] + d[2]*visRight[2]) / depth;
+    out[1] = visNear * (d[0]*visUp[0]    + d[1]*visUp[1]    + d[2]*visUp[2])    / depth;
+
+    return true;
+}
+
+// bound a frustum by the eye and a window on the near plane
+static void visWindowFrustum(visFrustum *f, GLdouble (*win)[2], int n)
+{
+    int i;
+    GLdouble corner[VIS_MAX_PLANES][3];
+
+    for (i = 0; i < n; ++i) {
+        corner[i][0] = visEye[0] + visNear*visFwd[0] + win[i][0]*visRight[0] + win[i][1]*visUp[0];
+        corner[i][1] = visEye[1] + visNear*visFwd[1] + win[i][0]*visRight[1] + win[i][1]*visUp[1];
+        corner[i][2] = visEye[2] + visNear*visFwd[2] + win[i][0]*visRight[2] + win[i][1]*visUp[2];
+    }
+
+    visPolygonFrustum(f, corner, n);
+}
+
+// turn of the path a b c, positive turning left
+static GLdouble visTurn(GLdouble *a, GLdouble *b, GLdouble *c)
+{
+    return (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0]);
+}
+
+// convex hull of n points, counter-clockwise into out which has
+// room for n+1, returns its vertex count
+static int visHull(GLdouble (*pts)[2], int n, GLdouble (*out)[2])
+{
+    int i, j, m = 0, lower;
+    GLdouble t[2];
+
+    // sort by x then y, n is small
+    for (i = 1; i < n; ++i)
+        for (j = i; (j > 0) && ((pts[j][0] < pts[j-1][0]) ||
+                    ((pts[j][0] == pts[j-1][0]) && (pts[j][1] < pts[j-1][1]))); --j) {
+            memcpy(t, pts[j], sizeof(t));
+            memcpy(pts[j], pts[j-1], sizeof(t));
+            memcpy(pts[j-1], t, sizeof(t));
+        }
+
+    // lower then upper chain
+    for (i = 0; i < n; ++i) {
+        while ((m >= 2) && (visTurn(out[m-2], out[m-1], pts[i]) <= 0.0))
+            --m;
+        memcpy(out[m++], pts[i], sizeof(t));
+    }
+    for (i = n-2, lower = m+1; i >= 0; --i) {
+        while ((m >= lower) && (visTurn(out[m-2], out[m-1], pts[i]) <= 0.0))
+            --m;
+        memcpy(out[m++], pts[i], sizeof(t));
+    }
+
+    return (m > 1) ? m-1 : m;
+}
+
+// is a point inside a counter-clockwise window
+static bool visInWindow(GLdouble (*win)[2], int n, GLdouble *pt)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+        if (visTurn(win[i], win[(i+1) % n], pt) < -VIS_EPSILON)
+            return false;
+
+    return true;
+}
+
+// the rectangle around n points, for windows with too many sides
+static int visBounds(GLdouble (*pts)[2], int n, GLdouble (*out)[2])
+{
+    int i;
+    GLdouble lo[2] = {pts[0][0], pts[0][1]}, hi[2] = {pts[0][0], pts[0][1]};
+
+    for (i = 1; i < n; ++i) {
+        lo[0] = fmin(lo[0], pts[i][0]);  hi[0] = fmax(hi[0], pts[i][0]);
+        lo[1] = fmin(lo[1], pts[i][1]);  hi[1] = fmax(hi[1], pts[i][1]);
+    }
+
+    out[0][0] = lo[0];  out[0][1] = lo[1];
+    out[1][0] = hi[0];  out[1][1] = lo[1];
+    out[2][0] = hi[0];  out[2][1] = hi[1];
+    out[3][0] = lo[0];  out[3][1] = hi[1];
+
+    return 4;
+}
+
+// a room is seen through a window n portals from the camera, mark it
+// visible and queue it to be walked unless it is already seen
+// through a window holding this one, otherwise the two windows are
+// merged so the room is walked once for every way it is reached
+static void visSee(int room, GLdouble (*win)[2], int n, int depth)
+{
+    int i, m = 0;
+    GLdouble pts[2*VIS_MAX_VERTS][2], hull[2*VIS_MAX_VERTS+1][2];
+
+    if (!visRoomFlag[room]) {
+        visRoomFlag[room] = true;
+        visRoomList[visRoomCount++] = room;
+        visRoomDepth[room] = depth;
+        visRoomWalks[room] = 0;
+    }
+    else {
+        for (i = 0; (i < n) && visInWindow(visWindow[room], visWindowVerts[room], win[i]); ++i)
+            ;
+        if ((i == n) && (visRoomDepth[room] <= depth))
+            return;
+
+        m = visWindowVerts[room];
+        memcpy(pts, visWindow[room], m * sizeof(pts[0]));
+        if (depth < visRoomDepth[room])
+            visRoomDepth[room] = depth;
+        ++visRoomWalks[room];
+    }
+
+    // the hull also winds a new window counter-clockwise
+    memcpy(pts + m, win, n * sizeof(pts[0]));
+    m = visHull(pts, m + n, hull);
+    if (m > VIS_MAX_PLANES)
+        m = visBounds(hull, m, hull);
+
+    // a window still growing after many walks opens all the way
+    if (visRoomWalks[room] >= VIS_MAX_WALKS) {
+        memcpy(hull, visFull, sizeof(visFull));
+        m = 4;
+    }
+
+    memcpy(visWindow[room], hull, m * sizeof(hull[0]));
+    visWindowVerts[room] = m;
+
+    if (!visQueued[room]) {
+        visQueued[room] = true;
+        visQueue[visTail] = room;
+        visTail = (visTail + 1) % (visScene->numRooms + 1);
+    }
+}
+
+// look out of a room through every portal seen within its window
+static void visWalk(int room)
+{
+    int i, k, n, depth = visRoomDepth[room];
+    GLdouble dist, across;
+    GLdouble poly[2][VIS_MAX_VERTS][3], win[VIS_MAX_VERTS][2];
+    visFrustum f;
+    sceneRoom   *r = &visScene->rooms[room];
+    scenePortal *p;
+
+    visWindowFrustum(&f, visWindow[room], visWindowVerts[room]);
+
+    for (k = r->firstPortal; k < r->firstPortal + r->numPortals; ++k) {
+        p    = &visScene->portals[k];
+        dist = visPortalQuad(r, p, poly[0], &across);
+
+        // only portals facing the eye lead anywhere new
+        if (dist < 0.0)
+            continue;
+
+        // the near plane cuts away the wall around a portal the
+        // eye is standing in, so everything behind it may show
+        if ((dist < 2.0*visNear) && (fabs(across) < p->width/2.0 + 2.0*visNear)) {
+            visPortalFlag[k] = true;
+            if ((p->to != PORTAL_OUTSIDE) && (depth < VIS_MAX_DEPTH))
+                visSee(p->to, visWindow[room], visWindowVerts[room], depth+1);
+            continue;
+        }
+
+        // what of the portal remains inside the frustum
+        n = 4;
+        for (i = 0; (i < f.numPlanes) && (n >= 3); ++i)
+            n = visClipPlane(f.plane[i], poly[i % 2], n, poly[(i+1) % 2]);
+        if (n < 3)
+            continue;
+
+        visPortalFlag[k] = true;
+        if ((p->to == PORTAL_OUTSIDE) || (depth >= VIS_MAX_DEPTH))
+            continue;
+
+        // look on through what is left of the opening, keeping the
+        // room's own window if it does not all lie ahead of the eye
+        for (i = 0; (i < n) && visProject(poly[f.numPlanes % 2][i], win[i]); ++i)
+            ;
+        if (i < n)
+            visSee(p->to, visWindow[room], visWindowVerts[room], depth+1);
+        else if (n > VIS_MAX_PLANES)
+            visSee(p->to, win, visBounds(win, n, win), depth+1);
+        else
+            visSee(p->to, win, n, depth+1);
+    }
+}
+
+// find the rooms and portals visible from a camera at x, y, z
+// facing h degrees horizontally and v vertically, with a near
+// plane zNear away of half extents halfWidth by halfHeight
+void visCompute(GLdouble x, GLdouble y, GLdouble z, GLdouble h, GLdouble v,
+                GLdouble halfWidth, GLdouble halfHeight, GLdouble zNear)
+{
+    int room;
+    GLdouble sh, ch, sv, cv;
+
+    if (visScene == NULL)
+        return;
+
+    room = sceneRoomAt(visScene, x, z);
+
+    // nothing to cull from, or nowhere to start
+    if (!visEnabled || (room < 0)) {
+        visAll();
+        return;
+    }
+
+    memset(visRoomFlag,   0, visScene->numRooms * sizeof(bool));
+    memset(visPortalFlag, 0, visScene->numPortals * sizeof(bool));
+    memset(visQueued,     0, visScene->numRooms * sizeof(bool));
+    visRoomCount = 0;
+    visHead = visTail = 0;
+
+    visEye[0] = x;
+    visEye[1] = y;
+    visEye[2] = z;
+    visNear   = zNear;
+
+    // eye axes in the world, the inverse of the navigator's
+    // view rotation, hrot 0 faces -z and 90 faces -x
+    sh = sin(h * M_PI / 180.0);
+    ch = cos(h * M_PI / 180.0);
+    sv = sin(v * M_PI / 180.0);
+    cv = cos(v * M_PI / 180.0);
+
+    visFwd[0]   = -cv*sh;  visFwd[1]   = sv;   visFwd[2]   = -cv*ch;
+    visRight[0] =  ch;     visRight[1] = 0.0;  visRight[2] = -sh;
+    visUp[0]    =  sv*sh;  visUp[1]    = cv;   visUp[2]    =  sv*ch;
+
+    // the whole near plane counter-clockwise from the bottom left
+    visFull[0][0] = -halfWidth;  visFull[0][1] = -halfHeight;
+    visFull[1][0] =  halfWidth;  visFull[1][1] = -halfHeight;
+    visFull[2][0] =  halfWidth;  visFull[2][1] =  halfHeight;
+    visFull[3][0] = -halfWidth;  visFull[3][1] =  halfHeight;
+
+    // breadth first, so every way into a room is usually merged
+    // into its window before the room is walked
+    visSee(room, visFull, 4, 0);
+    while (visHead != visTail) {
+        room = visQueue[visHead];
+        visHead = (visHead + 1) % (visScene->numRooms + 1);
+        visQueued[room] = false;
+        visWalk(room);
+    }
+}
+
+// number of rooms found visible
+int visNumRooms()
+{
+    return visRoomCount;
+}
+
+// the ith visible room, starting with the one holding the camera
+int visRoom(int i)
+{
+    return visRoomList[i];
+}
+
+// is a room visible
+bool visRoomVisible(int room)
+{
+    return (visRoomFlag == NULL) || visRoomFlag[room];
+}
+
+// is a portal visible
+bool visPortalVisible(int portal)
+{
+    return (visPortalFlag == NULL) || visPortalFlag[portal];
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************\
+* Copyright (c) 2007, Elliott Forney, http://www.elliottforney.com            *
+* All rights reserved.                                                        *
+*                                                                             *
+* Redistribution and use in source and binary forms, with or without          *
+* modification, are permitted provided that the following conditions are met: *
+*                                                                             *
+* 1. Redistributions of source code must retain the above copyright notice,   *
+*    this list of conditions and the following disclaimer.                    *
+*                                                                             *
+* 2. Redistributions in binary form must reproduce the above copyright        *
+*    notice, this list of conditions and the following disclaimer in the      *
+*    documentation and/or other materials provided with the distribution.     *
+*                                                                             *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  *
+* POSSIBILITY OF SUCH DAMAGE.                                                 *
+\*****************************************************************************/
+
+/*
+ *  Portal visibility
+ *
+ *  Finds the rooms the camera can see by walking the portal
+ *  graph out from the room it stands in, narrowing the view
+ *  frustum to each doorway or window it looks through.  A room
+ *  reached several ways is seen through the hull of all those
+ *  openings and walked once.  Rooms the walk never reaches are
+ *  not drawn.
+ */
+
+#ifndef VISIBILITY_H
+    #define VISIBILITY_H
+
+    // make c++ friendly
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+    // OpenGL and GLUT headers
+    #ifdef __APPLE__
+        #include <GLUT/glut.h>
+    #else
+        #include <GL/gl.h>
+        #include <GL/glu.h>
+        #include <GL/glut.h>
+    #endif
+
+    #include <stdbool.h>
+
+    // scene description
+    #include "scene.h"
+
+    // deepest chain of portals followed
+    #define VIS_MAX_DEPTH  16
+
+    // times a room's window may grow before it is opened fully
+    #define VIS_MAX_WALKS  8
+
+    // most planes bounding a narrowed frustum
+    #define VIS_MAX_PLANES 16
+
+    // slack for points lying on a plane
+    #define VIS_EPSILON    1.0e-6
+
+    /* convex view volume, planes through the eye facing inward */
+    typedef struct {
+        int      numPlanes;
+        GLdouble plane[VIS_MAX_PLANES][4];  /* a b c d, ax+by+cz+d >= 0 inside */
+    } visFrustum;
+
+    bool visInit(scene *s);                              // size visibility for a scene
+    void visFree();                                      // release visibility state
+    void visEnable(bool enable);                         // turn portal culling on or off
+    void visAll();                                       // mark everything visible
+    void visCompute(GLdouble x, GLdouble y, GLdouble z,  // find what the camera sees
+                    GLdouble h, GLdouble v, GLdouble halfWidth,
+                    GLdouble halfHeight, GLdouble zNear);
+    int  visNumRooms();                                  // number of visible rooms
+    int  visRoom(int i);                                 // ith visible room, camera room first
+    bool visRoomVisible(int room);                       // is a room visible
+    bool visPortalVisible(int portal);                   // is a portal visible
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif